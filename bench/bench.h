@@ -0,0 +1,48 @@
+// Shared helpers for the benchmark drivers in this directory.
+// Build a driver with optimizations and the target ISA, for example:
+//   cc -O2 -march=native -o bench_find bench/bench_find.c -lm
+// Each driver takes an optional size argument and prints one line per measurement.
+
+#ifndef _MEMCTX_BENCH_H_
+#define _MEMCTX_BENCH_H_
+
+// clock_gettime is POSIX, hidden by strict -std=c11; drivers include this header first
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Returns argv[index] as a number, or `fallback` when it is missing
+static inline size_t bench_arg(int argc, char **argv, int index, size_t fallback) {
+    return argc > index ? (size_t)strtoull(argv[index], NULL, 10) : fallback;
+}
+
+static inline uint64_t bench_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static inline void bench_report_rate(const char *name, double bytes, double seconds) {
+    printf("%-36s %10.1f MB/s\n", name, bytes / seconds / 1e6);
+}
+
+static inline void bench_report_time(const char *name, double seconds) {
+    printf("%-36s %10.1f ms\n", name, seconds * 1e3);
+}
+
+// Keeps results alive so the compiler cannot drop the measured work
+static volatile uint64_t bench_sink;
+
+#endif
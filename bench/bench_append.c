@@ -0,0 +1,46 @@
+// Many small appends with string_append and string_builder_append.
+// The time per append stays flat as the count grows, since capacity grows geometrically.
+// Usage: bench_append [largest append count]   (default 1000000)
+
+#include "bench.h"
+#include "../memctx_builder.h"
+
+int main(int argc, char **argv) {
+    size_t largest = bench_arg(argc, argv, 1, 1000000);
+
+    // Fragments of 1 to 16 bytes, like the pieces of a generated text
+    static const char *fragments[] = {"a", "key", "=", "value", ", ", "\n", "0123456789", "a longer piece.."};
+    char name[64];
+
+    for (size_t count = largest / 100; count <= largest; count *= 10) {
+        if (count == 0) continue;
+
+        MemContext *ctx = memctx();
+        double t = bench_now();
+        string str = string_init(ctx);
+        for (size_t i = 0; i < count; i++) {
+            str = string_append(str, fragments[i % 8]);
+        }
+        double seconds = bench_now() - t;
+        bench_sink += str.length;
+        snprintf(name, sizeof(name), "string_append x%zu", count);
+        bench_report_time(name, seconds);
+        printf("%-36s %10.1f ns\n", "  per append", seconds * 1e9 / (double)count);
+        memctx_free(ctx);
+
+        ctx = memctx();
+        t = bench_now();
+        string_builder *sb = string_builder_init(ctx);
+        for (size_t i = 0; i < count; i++) {
+            string_builder_append(sb, fragments[i % 8]);
+        }
+        string built = string_builder_build(sb);
+        seconds = bench_now() - t;
+        bench_sink += built.length;
+        snprintf(name, sizeof(name), "string_builder_append x%zu", count);
+        bench_report_time(name, seconds);
+        printf("%-36s %10.1f ns\n", "  per append", seconds * 1e9 / (double)count);
+        memctx_free(ctx);
+    }
+    return 0;
+}
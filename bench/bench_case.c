@@ -0,0 +1,98 @@
+// ASCII case conversion and case-insensitive comparison against tolower loops.
+// Usage: bench_case [megabytes processed per measurement]   (default 1024)
+
+#include "bench.h"
+#include <strings.h>
+#include "../memctx_strings.h"
+
+static void tolower_loop(char *dst, const char *src, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        dst[i] = (char)tolower((unsigned char)src[i]);
+    }
+}
+
+static bool equal_ci_loop(const char *a, const char *b, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    size_t total = bench_arg(argc, argv, 1, 1024) << 20;
+
+    // Mixed-case text with punctuation, in a buffer that stays in cache
+    size_t size = 64 << 10;
+    char *text = malloc(size);
+    char *upper = malloc(size);
+    char *out = calloc(size, 1);
+    uint64_t seed = 11;
+    for (size_t i = 0; i < size; i++) {
+        uint64_t r = bench_random(&seed) % 64;
+        text[i] = r < 26 ? (char)('a' + r) : r < 52 ? (char)('A' + r - 26) : " .,;:-_@[`{0123"[r - 52];
+        upper[i] = (char)toupper((unsigned char)text[i]);
+    }
+    size_t rounds = total / size;
+    MemContext *ctx = memctx();
+    substring in = {text, size, size, NULL};
+    double t;
+    uint64_t sum;
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        memcpy(out, text, size);
+        string_to_lower_in_place((substring){out, size, size, NULL});
+    }
+    bench_sink += (unsigned char)out[size / 2];
+    bench_report_rate("string_to_lower_in_place (+memcpy)", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        tolower_loop(out, text, size);
+    }
+    bench_sink += (unsigned char)out[size / 2];
+    bench_report_rate("tolower loop", (double)total, bench_now() - t);
+
+    // Allocating variant, resetting the arena every round
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        string lower = string_to_lower(ctx, in);
+        bench_sink += (unsigned char)lower.value[size / 2];
+        memctx_free(ctx);
+        ctx = memctx();
+    }
+    bench_report_rate("string_to_lower (alloc)", (double)total, bench_now() - t);
+
+    // Comparisons start at a varying offset so the calls cannot be hoisted out of the loop
+    size_t span = size - 64;
+
+    t = bench_now();
+    sum = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        sum += string_equal_ci(((substring){text + r % 64, span, span, NULL}), ((substring){upper + r % 64, span, span, NULL}));
+    }
+    bench_sink += sum;
+    bench_report_rate("string_equal_ci", (double)rounds * (double)span, bench_now() - t);
+
+    t = bench_now();
+    sum = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        sum += equal_ci_loop(text + r % 64, upper + r % 64, span);
+    }
+    bench_sink += sum;
+    bench_report_rate("tolower compare loop", (double)rounds * (double)span, bench_now() - t);
+
+    t = bench_now();
+    sum = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        sum += strncasecmp(text + r % 64, upper + r % 64, span) == 0;
+    }
+    bench_sink += sum;
+    bench_report_rate("strncasecmp", (double)rounds * (double)span, bench_now() - t);
+
+    memctx_free(ctx);
+    free(text);
+    free(upper);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,64 @@
+// csv_parse against a handwritten byte-at-a-time splitting loop.
+// Usage: bench_csv [megabytes of CSV]   (default 256)
+
+#include "bench.h"
+#include "../memctx_csv.h"
+
+// Splits rows and fields one byte at a time, handling quotes the same way as csv_parse,
+// and stores the field views in a flat array. Returns the number of fields.
+static size_t split_loop(const char *text, size_t length, substring *fields, size_t *rows) {
+    size_t count = 0;
+    size_t start = 0;
+    bool quoted = false;
+    *rows = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (!quoted && (c == ',' || c == '\n')) {
+            size_t end = c == '\n' && i > start && text[i - 1] == '\r' ? i - 1 : i;
+            fields[count++] = (substring){(char *)text + start, end - start, end - start, NULL};
+            if (c == '\n') (*rows)++;
+            start = i + 1;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char **argv) {
+    size_t size = bench_arg(argc, argv, 1, 256) << 20;
+
+    // Rows of an id, a name, a quoted address with a comma, a price and a date
+    char *text = malloc(size + 256);
+    size_t length = 0;
+    size_t field_count = 0;
+    uint64_t seed = 17;
+    while (length < size) {
+        uint64_t r = bench_random(&seed);
+        length += (size_t)sprintf(text + length, "%llu,user_%llu,\"%llu Main St, Apt %llu\",%llu.%02llu,2024-%02llu-%02llu\n",
+                                  (unsigned long long)(r % 1000000), (unsigned long long)(r >> 20) % 100000,
+                                  (unsigned long long)(r >> 8) % 9999, (unsigned long long)(r >> 40) % 500,
+                                  (unsigned long long)(r >> 12) % 1000, (unsigned long long)(r >> 24) % 100,
+                                  (unsigned long long)(r >> 30) % 12 + 1, (unsigned long long)(r >> 36) % 28 + 1);
+        field_count += 6;
+    }
+
+    MemContext *ctx = memctx();
+    string str = {text, length, length, ctx};
+    double t = bench_now();
+    csv_table *table = csv_parse(str, ',');
+    bench_report_rate("csv_parse", (double)length, bench_now() - t);
+    bench_sink += table ? table->field_count : 0;
+    memctx_free(ctx);
+
+    substring *fields = malloc(sizeof(substring) * field_count);
+    size_t row_count;
+    t = bench_now();
+    bench_sink += split_loop(text, length, fields, &row_count);
+    bench_report_rate("split loop", (double)length, bench_now() - t);
+    bench_sink += row_count;
+
+    free(fields);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Base64 and hex encoding and decoding against table-driven byte loops.
+// Usage: bench_encoding [megabytes processed per measurement]   (default 1024)
+
+#include "bench.h"
+#include "../memctx_strings.h"
+
+static const char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char hex_digits[] = "0123456789abcdef";
+
+static size_t base64_encode_loop(char *dst, const unsigned char *src, size_t length) {
+    char *out = dst;
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        uint32_t v = (uint32_t)src[i] << 16 | (uint32_t)src[i + 1] << 8 | src[i + 2];
+        *out++ = base64_alphabet[v >> 18];
+        *out++ = base64_alphabet[(v >> 12) & 63];
+        *out++ = base64_alphabet[(v >> 6) & 63];
+        *out++ = base64_alphabet[v & 63];
+    }
+    if (i < length) {
+        uint32_t v = (uint32_t)src[i] << 16 | (i + 1 < length ? (uint32_t)src[i + 1] << 8 : 0);
+        *out++ = base64_alphabet[v >> 18];
+        *out++ = base64_alphabet[(v >> 12) & 63];
+        *out++ = i + 1 < length ? base64_alphabet[(v >> 6) & 63] : '=';
+        *out++ = '=';
+    }
+    return (size_t)(out - dst);
+}
+
+static size_t base64_decode_loop(unsigned char *dst, const char *src, size_t length, const int8_t *table) {
+    unsigned char *out = dst;
+    while (length > 0 && src[length - 1] == '=') length--;
+    uint32_t v = 0;
+    int bits = 0;
+    for (size_t i = 0; i < length; i++) {
+        int8_t d = table[(unsigned char)src[i]];
+        if (d < 0) return 0;
+        v = v << 6 | (uint32_t)d;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            *out++ = (unsigned char)(v >> bits);
+        }
+    }
+    return (size_t)(out - dst);
+}
+
+static void hex_encode_loop(char *dst, const unsigned char *src, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        dst[2 * i] = hex_digits[src[i] >> 4];
+        dst[2 * i + 1] = hex_digits[src[i] & 15];
+    }
+}
+
+static bool hex_decode_loop(unsigned char *dst, const char *src, size_t length, const int8_t *table) {
+    for (size_t i = 0; i < length / 2; i++) {
+        int8_t hi = table[(unsigned char)src[2 * i]];
+        int8_t lo = table[(unsigned char)src[2 * i + 1]];
+        if ((hi | lo) < 0) return false;
+        dst[i] = (unsigned char)(hi << 4 | lo);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    size_t total = bench_arg(argc, argv, 1, 1024) << 20;
+
+    // Random bytes in a buffer that stays in cache, encoded once for the decoders
+    size_t size = 48 << 10;
+    unsigned char *data = malloc(size);
+    char *text = malloc(size * 2);
+    unsigned char *bytes = malloc(size);
+    uint64_t seed = 13;
+    for (size_t i = 0; i < size; i++) data[i] = (unsigned char)bench_random(&seed);
+
+    int8_t base64_table[256], hex_table[256];
+    memset(base64_table, -1, sizeof(base64_table));
+    memset(hex_table, -1, sizeof(hex_table));
+    for (int i = 0; i < 64; i++) base64_table[(unsigned char)base64_alphabet[i]] = (int8_t)i;
+    for (int i = 0; i < 16; i++) {
+        hex_table[(unsigned char)hex_digits[i]] = (int8_t)i;
+        hex_table[(unsigned char)toupper(hex_digits[i])] = (int8_t)i;
+    }
+
+    size_t rounds = total / size;
+    MemContext *ctx = memctx();
+    string in = {(char *)data, size, size, NULL};
+    string base64 = string_base64_encode(ctx, in);
+    string hex = string_hex_encode(ctx, in);
+    MemContext *work = memctx();
+    double t;
+
+    // Rates count the binary side, so encoders and decoders are comparable;
+    // the library variants allocate their output and reset the arena every round
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        string out = string_base64_encode(work, in);
+        bench_sink += (unsigned char)out.value[r % out.length];
+        memctx_free(work);
+        work = memctx();
+    }
+    bench_report_rate("string_base64_encode", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        size_t length = base64_encode_loop(text, data, size);
+        bench_sink += (unsigned char)text[r % length];
+    }
+    bench_report_rate("base64 encode loop", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        string out = string_base64_decode(work, base64);
+        bench_sink += (unsigned char)out.value[r % out.length];
+        memctx_free(work);
+        work = memctx();
+    }
+    bench_report_rate("string_base64_decode", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        size_t length = base64_decode_loop(bytes, base64.value, base64.length, base64_table);
+        bench_sink += bytes[r % length];
+    }
+    bench_report_rate("base64 decode loop", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        string out = string_hex_encode(work, in);
+        bench_sink += (unsigned char)out.value[r % out.length];
+        memctx_free(work);
+        work = memctx();
+    }
+    bench_report_rate("string_hex_encode", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        hex_encode_loop(text, data, size);
+        bench_sink += (unsigned char)text[r % (size * 2)];
+    }
+    bench_report_rate("hex encode loop", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        string out = string_hex_decode(work, hex);
+        bench_sink += (unsigned char)out.value[r % out.length];
+        memctx_free(work);
+        work = memctx();
+    }
+    bench_report_rate("string_hex_decode", (double)total, bench_now() - t);
+
+    t = bench_now();
+    for (size_t r = 0; r < rounds; r++) {
+        bench_sink += hex_decode_loop(bytes, hex.value, hex.length, hex_table);
+        bench_sink += bytes[r % size];
+    }
+    bench_report_rate("hex decode loop", (double)total, bench_now() - t);
+
+    memctx_free(work);
+    memctx_free(ctx);
+    free(data);
+    free(text);
+    free(bytes);
+    return 0;
+}
@@ -0,0 +1,55 @@
+// Substring search over a file loaded with string_read_file, against memmem and strstr.
+// Usage: bench_find [megabytes]   (default 1024)
+
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../memctx_strings.h"
+
+int main(int argc, char **argv) {
+    size_t size = bench_arg(argc, argv, 1, 1024) << 20;
+    const char *filename = "bench_find.txt";
+
+    // Log-like lines; the needles below never occur, so every search scans the whole input
+    FILE *f = fopen(filename, "wb");
+    if (!f) return 1;
+    uint64_t seed = 42;
+    char line[128];
+    for (size_t written = 0; written < size;) {
+        int n = snprintf(line, sizeof(line), "2025-01-%02u 12:%02u:%02u INFO request %llu served in %u ms\n",
+                         (unsigned)(bench_random(&seed) % 28 + 1), (unsigned)(seed % 60), (unsigned)(seed >> 8) % 60,
+                         (unsigned long long)(seed % 1000000), (unsigned)(seed >> 20) % 500);
+        fwrite(line, 1, (size_t)n, f);
+        written += (size_t)n;
+    }
+    fclose(f);
+
+    MemContext *ctx = memctx();
+    string text = string_read_file(ctx, filename);
+    remove(filename);
+    if (!text.value) return 1;
+
+    const char *needles[] = {"ERROR", "request 1234567 served", "INFO request 99 served in 1000 ms, retrying upstream"};
+    for (size_t i = 0; i < sizeof(needles) / sizeof(needles[0]); i++) {
+        const char *needle = needles[i];
+        size_t needle_length = strlen(needle);
+        char name[64];
+
+        double t = bench_now();
+        bench_sink += string_find(text, needle);
+        snprintf(name, sizeof(name), "string_find  (needle %zu)", needle_length);
+        bench_report_rate(name, (double)text.length, bench_now() - t);
+
+        t = bench_now();
+        bench_sink += (uintptr_t)memmem(text.value, text.length, needle, needle_length);
+        snprintf(name, sizeof(name), "memmem       (needle %zu)", needle_length);
+        bench_report_rate(name, (double)text.length, bench_now() - t);
+
+        t = bench_now();
+        bench_sink += (uintptr_t)strstr(text.value, needle);
+        snprintf(name, sizeof(name), "strstr       (needle %zu)", needle_length);
+        bench_report_rate(name, (double)text.length, bench_now() - t);
+    }
+
+    memctx_free(ctx);
+    return 0;
+}
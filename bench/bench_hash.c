@@ -0,0 +1,55 @@
+// string_hash against an FNV-1a loop, over keys of several sizes.
+// Usage: bench_hash [megabytes hashed per key size]   (default 512)
+
+#include "bench.h"
+#include "../memctx_strings.h"
+
+static uint64_t fnv1a(const char *value, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)value[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+int main(int argc, char **argv) {
+    size_t total = bench_arg(argc, argv, 1, 512) << 20;
+
+    size_t buffer_size = 1 << 20;
+    char *buffer = malloc(buffer_size + 4096);
+    uint64_t seed = 7;
+    for (size_t i = 0; i < buffer_size + 4096; i++) {
+        buffer[i] = (char)('a' + bench_random(&seed) % 26);
+    }
+
+    size_t sizes[] = {8, 16, 32, 64, 256, 4096};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s];
+        size_t count = total / size;
+        char name[64];
+
+        // Keys start at varying offsets inside a cached buffer
+        double t = bench_now();
+        uint64_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            substring key = {buffer + (i * 64 + i) % buffer_size, size, size, NULL};
+            sum += string_hash(key);
+        }
+        bench_sink += sum;
+        snprintf(name, sizeof(name), "string_hash (%zu bytes)", size);
+        bench_report_rate(name, (double)count * (double)size, bench_now() - t);
+
+        t = bench_now();
+        sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += fnv1a(buffer + (i * 64 + i) % buffer_size, size);
+        }
+        bench_sink += sum;
+        snprintf(name, sizeof(name), "fnv1a       (%zu bytes)", size);
+        bench_report_rate(name, (double)count * (double)size, bench_now() - t);
+    }
+
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,184 @@
+// map against a malloc-per-node chained hash table with the same hash function.
+// Usage: bench_map [keys]   (default 10000000)
+
+#include "bench.h"
+#include "../memctx_map.h"
+
+typedef struct chained_node {
+    substring key;
+    uint64_t hash;
+    void *value;
+    struct chained_node *next;
+} chained_node;
+
+typedef struct {
+    chained_node **buckets;
+    size_t capacity;
+    size_t length;
+} chained_map;
+
+static void chained_grow(chained_map *m) {
+    size_t capacity = m->capacity ? m->capacity * 2 : 16;
+    chained_node **buckets = calloc(capacity, sizeof(chained_node *));
+    for (size_t i = 0; i < m->capacity; i++) {
+        chained_node *node = m->buckets[i];
+        while (node) {
+            chained_node *next = node->next;
+            size_t b = node->hash & (capacity - 1);
+            node->next = buckets[b];
+            buckets[b] = node;
+            node = next;
+        }
+    }
+    free(m->buckets);
+    m->buckets = buckets;
+    m->capacity = capacity;
+}
+
+static void chained_set(chained_map *m, substring key, void *value) {
+    uint64_t hash = string_hash(key);
+    if (m->capacity) {
+        for (chained_node *node = m->buckets[hash & (m->capacity - 1)]; node; node = node->next) {
+            if (node->hash == hash && node->key.length == key.length && memcmp(node->key.value, key.value, key.length) == 0) {
+                node->value = value;
+                return;
+            }
+        }
+    }
+    if (m->length >= m->capacity) chained_grow(m);
+    chained_node *node = malloc(sizeof(chained_node));
+    size_t b = hash & (m->capacity - 1);
+    node->key = key;
+    node->hash = hash;
+    node->value = value;
+    node->next = m->buckets[b];
+    m->buckets[b] = node;
+    m->length++;
+}
+
+static void *chained_get(chained_map *m, substring key) {
+    uint64_t hash = string_hash(key);
+    for (chained_node *node = m->buckets[hash & (m->capacity - 1)]; node; node = node->next) {
+        if (node->hash == hash && node->key.length == key.length && memcmp(node->key.value, key.value, key.length) == 0) {
+            return node->value;
+        }
+    }
+    return NULL;
+}
+
+static bool chained_remove(chained_map *m, substring key) {
+    uint64_t hash = string_hash(key);
+    chained_node **link = &m->buckets[hash & (m->capacity - 1)];
+    for (chained_node *node = *link; node; link = &node->next, node = node->next) {
+        if (node->hash == hash && node->key.length == key.length && memcmp(node->key.value, key.value, key.length) == 0) {
+            *link = node->next;
+            free(node);
+            m->length--;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void chained_free(chained_map *m) {
+    for (size_t i = 0; i < m->capacity; i++) {
+        chained_node *node = m->buckets[i];
+        while (node) {
+            chained_node *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+    free(m->buckets);
+}
+
+int main(int argc, char **argv) {
+    size_t count = bench_arg(argc, argv, 1, 10000000);
+
+    // Keys like "user:00001234", looked up in a shuffled order
+    char *text = malloc(count * 16);
+    substring *keys = malloc(sizeof(substring) * count);
+    substring *misses = malloc(sizeof(substring) * count);
+    size_t *order = malloc(sizeof(size_t) * count);
+    for (size_t i = 0; i < count; i++) {
+        int n = snprintf(text + i * 16, 16, "user:%08zu", i);
+        keys[i] = (substring){text + i * 16, (size_t)n, (size_t)n, NULL};
+        misses[i] = (substring){text + i * 16 + 1, (size_t)n - 1, (size_t)n - 1, NULL};
+        order[i] = i;
+    }
+    uint64_t seed = 3;
+    for (size_t i = count - 1; i > 0; i--) {
+        size_t j = bench_random(&seed) % (i + 1);
+        size_t swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+    chained_map chained = {0};
+    double t;
+    uint64_t found;
+
+    t = bench_now();
+    for (size_t i = 0; i < count; i++) map_set(m, keys[i], (void *)(i + 1));
+    bench_report_time("map insert", bench_now() - t);
+    t = bench_now();
+    for (size_t i = 0; i < count; i++) chained_set(&chained, keys[i], (void *)(i + 1));
+    bench_report_time("chained insert", bench_now() - t);
+
+    // Touch the keys in lookup order once so the first timed pass does not pay for it
+    found = 0;
+    for (size_t i = 0; i < count; i++) found += (uint8_t)keys[order[i]].value[5];
+    bench_sink += found;
+
+    t = bench_now();
+    found = 0;
+    for (size_t i = 0; i < count; i++) found += map_get(m, keys[order[i]]) != NULL;
+    bench_sink += found;
+    bench_report_time("map lookup hit", bench_now() - t);
+    t = bench_now();
+    found = 0;
+    for (size_t i = 0; i < count; i++) found += chained_get(&chained, keys[order[i]]) != NULL;
+    bench_sink += found;
+    bench_report_time("chained lookup hit", bench_now() - t);
+
+    t = bench_now();
+    found = 0;
+    for (size_t i = 0; i < count; i++) found += map_get(m, misses[order[i]]) != NULL;
+    bench_sink += found;
+    bench_report_time("map lookup miss", bench_now() - t);
+    t = bench_now();
+    found = 0;
+    for (size_t i = 0; i < count; i++) found += chained_get(&chained, misses[order[i]]) != NULL;
+    bench_sink += found;
+    bench_report_time("chained lookup miss", bench_now() - t);
+
+    t = bench_now();
+    for (size_t i = 0; i < count; i += 2) map_remove(m, keys[order[i]]);
+    bench_report_time("map remove half", bench_now() - t);
+    t = bench_now();
+    for (size_t i = 0; i < count; i += 2) chained_remove(&chained, keys[order[i]]);
+    bench_report_time("chained remove half", bench_now() - t);
+
+    t = bench_now();
+    size_t iterator = 0;
+    void *value;
+    found = 0;
+    while (map_next(m, &iterator, NULL, &value)) found += (uintptr_t)value;
+    bench_sink += found;
+    bench_report_time("map iterate", bench_now() - t);
+
+    t = bench_now();
+    memctx_free(ctx);
+    bench_report_time("map free", bench_now() - t);
+    t = bench_now();
+    chained_free(&chained);
+    bench_report_time("chained free", bench_now() - t);
+
+    free(text);
+    free(keys);
+    free(misses);
+    free(order);
+    return 0;
+}
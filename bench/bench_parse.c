@@ -0,0 +1,87 @@
+// substring_to_i64 and substring_to_double against strtoll and strtod,
+// on comma-separated fields like those in a CSV file.
+// Usage: bench_parse [fields]   (default 10000000)
+
+#include "bench.h"
+#include "../memctx_strings.h"
+
+// Writes `count` fields separated by commas and returns views of them.
+// `kind` 0: integers, 1: short decimals (prices), 2: full-precision doubles
+static substring *make_fields(int kind, size_t count, char **text) {
+    char *buffer = malloc(count * 32);
+    substring *fields = malloc(sizeof(substring) * count);
+    uint64_t seed = 5 + (uint64_t)kind;
+    char *p = buffer;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t r = bench_random(&seed);
+        int n;
+        if (kind == 0) {
+            n = sprintf(p, "%lld", (long long)(r % 2000000001) - 1000000000);
+        } else if (kind == 1) {
+            n = sprintf(p, "%llu.%02llu", (unsigned long long)(r % 10000), (unsigned long long)(r >> 32) % 100);
+        } else {
+            n = sprintf(p, "%.17g", (double)(r >> 11) / 9007199254740992.0 * 1000.0);
+        }
+        fields[i] = (substring){p, (size_t)n, (size_t)n, NULL};
+        p[n] = ',';
+        p += n + 1;
+    }
+    *text = buffer;
+    return fields;
+}
+
+int main(int argc, char **argv) {
+    size_t count = bench_arg(argc, argv, 1, 10000000);
+    const char *names[] = {"integers", "prices", "doubles"};
+
+    for (int kind = 0; kind < 3; kind++) {
+        char *text;
+        substring *fields = make_fields(kind, count, &text);
+        size_t bytes = 0;
+        for (size_t i = 0; i < count; i++) bytes += fields[i].length + 1;
+        char name[64];
+        double t;
+        uint64_t sum = 0;
+
+        if (kind == 0) {
+            t = bench_now();
+            for (size_t i = 0; i < count; i++) {
+                int64_t value;
+                if (substring_to_i64(fields[i], &value) == STRING_PARSE_OK) sum += (uint64_t)value;
+            }
+            snprintf(name, sizeof(name), "substring_to_i64 (%s)", names[kind]);
+            bench_report_rate(name, (double)bytes, bench_now() - t);
+
+            t = bench_now();
+            for (size_t i = 0; i < count; i++) {
+                char *end;
+                sum += (uint64_t)strtoll(fields[i].value, &end, 10);
+            }
+            snprintf(name, sizeof(name), "strtoll          (%s)", names[kind]);
+            bench_report_rate(name, (double)bytes, bench_now() - t);
+        } else {
+            double total = 0;
+            t = bench_now();
+            for (size_t i = 0; i < count; i++) {
+                double value;
+                if (substring_to_double(fields[i], &value) == STRING_PARSE_OK) total += value;
+            }
+            snprintf(name, sizeof(name), "substring_to_double (%s)", names[kind]);
+            bench_report_rate(name, (double)bytes, bench_now() - t);
+
+            t = bench_now();
+            for (size_t i = 0; i < count; i++) {
+                char *end;
+                total += strtod(fields[i].value, &end);
+            }
+            snprintf(name, sizeof(name), "strtod              (%s)", names[kind]);
+            bench_report_rate(name, (double)bytes, bench_now() - t);
+            sum += (uint64_t)total;
+        }
+        bench_sink += sum;
+
+        free(text);
+        free(fields);
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+// regex_search against POSIX regexec, scanning text with no match so both read all of it.
+// Usage: bench_regex [megabytes of text]   (default 16)
+
+#define _POSIX_C_SOURCE 200809L
+#include "bench.h"
+#include <regex.h>
+#include "../memctx_regex.h"
+
+int main(int argc, char **argv) {
+    size_t size = bench_arg(argc, argv, 1, 16) << 20;
+
+    // Lowercase words and spaces, no digits
+    char *text = malloc(size + 1);
+    uint64_t seed = 23;
+    for (size_t i = 0; i < size; i++) {
+        uint64_t r = bench_random(&seed) % 32;
+        text[i] = r < 26 ? (char)('a' + r) : ' ';
+    }
+    text[size] = '\0';
+    substring str = {text, size, size, NULL};
+
+    const char *patterns[] = {
+        "zzyzx qq",
+        "(foo|bar|baz)[0-9]+",
+        "[a-z]+ing [0-9]",
+        "[0-9]{3}-[0-9]{4}",
+        "(a|aa)*b[0-9]",
+    };
+    MemContext *ctx = memctx();
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        char name[64];
+        double t = bench_now();
+        regex *re = regex_compile(ctx, patterns[i]);
+        bench_sink += regex_search(re, str);
+        snprintf(name, sizeof(name), "regex_search %s", patterns[i]);
+        bench_report_rate(name, (double)size, bench_now() - t);
+
+        regex_t posix;
+        t = bench_now();
+        if (regcomp(&posix, patterns[i], REG_EXTENDED | REG_NOSUB) != 0) continue;
+        bench_sink += regexec(&posix, text, 0, NULL, 0) == 0;
+        snprintf(name, sizeof(name), "regexec      %s", patterns[i]);
+        bench_report_rate(name, (double)size, bench_now() - t);
+        regfree(&posix);
+    }
+
+    memctx_free(ctx);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,65 @@
+// array_sort_strings against qsort with a memcmp comparator.
+// Usage: bench_sort [strings]   (default 2000000)
+
+#include "bench.h"
+#include "../memctx_strings.h"
+
+static int compare_strings(const void *a, const void *b) {
+    const string *x = *(const string *const *)a;
+    const string *y = *(const string *const *)b;
+    size_t length = x->length < y->length ? x->length : y->length;
+    int order = length > 0 ? memcmp(x->value, y->value, length) : 0;
+    if (order != 0) return order;
+    return (x->length > y->length) - (x->length < y->length);
+}
+
+int main(int argc, char **argv) {
+    size_t count = bench_arg(argc, argv, 1, 2000000);
+
+    // URLs with long shared prefixes, e-mail addresses and decimal numbers
+    MemContext *ctx = memctx();
+    string *strings = malloc(sizeof(string) * count);
+    uint64_t seed = 29;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t r = bench_random(&seed);
+        char buffer[96];
+        int n;
+        if (i % 3 == 0) {
+            n = snprintf(buffer, sizeof(buffer), "https://example.com/products/%llu/reviews/%llu",
+                         (unsigned long long)(r % 5000), (unsigned long long)(r >> 20) % 100000);
+        } else if (i % 3 == 1) {
+            n = snprintf(buffer, sizeof(buffer), "user%llu@mail%llu.example.org",
+                         (unsigned long long)(r % 1000000), (unsigned long long)(r >> 32) % 50);
+        } else {
+            n = snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)(r % 1000000000000ULL));
+        }
+        strings[i] = string_make(ctx, ((substring){buffer, (size_t)n, (size_t)n, NULL}));
+    }
+
+    array *sorted = array_init(ctx);
+    void **items = malloc(sizeof(void *) * count);
+    for (size_t i = 0; i < count; i++) {
+        array_append(sorted, &strings[i]);
+        items[i] = &strings[i];
+    }
+
+    double t = bench_now();
+    array_sort_strings(sorted);
+    bench_report_time("array_sort_strings", bench_now() - t);
+
+    t = bench_now();
+    qsort(items, count, sizeof(void *), compare_strings);
+    bench_report_time("qsort + memcmp", bench_now() - t);
+
+    for (size_t i = 0; i < count; i++) {
+        if (compare_strings(&sorted->items[i], &items[i]) != 0) {
+            printf("results differ at %zu\n", i);
+            return 1;
+        }
+    }
+
+    free(items);
+    free(strings);
+    memctx_free(ctx);
+    return 0;
+}
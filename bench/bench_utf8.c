@@ -0,0 +1,85 @@
+// UTF-8 validation: the scalar, SSSE3 and AVX2 kernels and string_utf8_valid,
+// which picks a kernel at compile time or, without -mavx2 on x86-64, from cpuid.
+// Usage: bench_utf8 [megabytes validated per measurement]   (default 1024)
+
+#include "bench.h"
+#include "../memctx_strings.h"
+
+typedef struct {
+    const char *name;
+    bool (*valid)(const unsigned char *value, size_t length);
+} utf8_kernel;
+
+static bool public_valid(const unsigned char *value, size_t length) {
+    return string_utf8_valid((string){(char *)value, length, length, NULL});
+}
+
+static void run(const char *input, const unsigned char *text, size_t size, size_t total) {
+    utf8_kernel kernels[4];
+    size_t count = 0;
+    kernels[count++] = (utf8_kernel){"scalar", __string_utf8_valid_scalar};
+    // Kernels built through target attributes only run if the CPU has the instructions
+#if defined(STRING_SIMD_DISPATCH)
+    if (__builtin_cpu_supports("ssse3")) kernels[count++] = (utf8_kernel){"ssse3", __string_utf8_valid_ssse3};
+    if (__builtin_cpu_supports("avx2")) kernels[count++] = (utf8_kernel){"avx2", __string_utf8_valid_avx2};
+#else
+#if defined(STRING_SIMD_SSSE3)
+    kernels[count++] = (utf8_kernel){"ssse3", __string_utf8_valid_ssse3};
+#endif
+#if defined(STRING_SIMD_AVX2)
+    kernels[count++] = (utf8_kernel){"avx2", __string_utf8_valid_avx2};
+#endif
+#endif
+    kernels[count++] = (utf8_kernel){"string_utf8_valid", public_valid};
+
+    size_t rounds = total / size;
+    for (size_t k = 0; k < count; k++) {
+        // Start at a varying offset so the call cannot be hoisted out of the loop
+        size_t span = size - 64;
+        uint64_t valid = 0;
+        double t = bench_now();
+        for (size_t r = 0; r < rounds; r++) {
+            valid += kernels[k].valid(text + r % 4, span);
+        }
+        double seconds = bench_now() - t;
+        bench_sink += valid;
+        if (valid != rounds) printf("%s rejected valid input\n", kernels[k].name);
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s (%s)", kernels[k].name, input);
+        bench_report_rate(name, (double)rounds * (double)span, seconds);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t total = bench_arg(argc, argv, 1, 1024) << 20;
+
+    // Buffers that stay in cache; the mixed one has one- to four-byte sequences.
+    // The measured spans start in the first 4 bytes and end in the last 64,
+    // so both ends of the mixed text are ASCII padding
+    size_t size = 64 << 10;
+    unsigned char *ascii = malloc(size);
+    unsigned char *mixed = malloc(size);
+    uint64_t seed = 23;
+    for (size_t i = 0; i < size; i++) {
+        ascii[i] = (unsigned char)(' ' + bench_random(&seed) % 95);
+    }
+
+    static const char *samples[] = {"a", "e", " ", "\xC3\xA9", "\xD0\x96", "\xE2\x82\xAC", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80"};
+    size_t length = 0;
+    while (length < 8) mixed[length++] = 'x';
+    while (length + 68 < size) {
+        const char *sample = samples[bench_random(&seed) % 8];
+        size_t n = strlen(sample);
+        memcpy(mixed + length, sample, n);
+        length += n;
+    }
+    while (length < size) mixed[length++] = 'x';
+
+    run("ascii", ascii, size, total);
+    run("mixed", mixed, size, total);
+
+    free(ascii);
+    free(mixed);
+    return 0;
+}
@@ -33,6 +33,16 @@
 #define MEMCTX_PAGE_SIZE 4069
 #endif
 
+// Blocks with less free space than this are not searched again by memctx_alloc
+#ifndef MEMCTX_SEARCH_MIN
+#define MEMCTX_SEARCH_MIN 64
+#endif
+
+// Blocks memctx_alloc looks at before it drops the oldest of them from later searches
+#ifndef MEMCTX_SEARCH_BLOCKS
+#define MEMCTX_SEARCH_BLOCKS 8
+#endif
+
 #define MEMCTX_DESC_FORMAT "%p: capacity: %zu consumed: %zu data: %p next: %p\n"
 
 typedef struct MemContext {
@@ -40,6 +50,7 @@ typedef struct MemContext {
     size_t capacity;
     size_t consumed;
     struct MemContext *next;
+    struct MemContext *search;  // First block memctx_alloc looks at, set in the first block only
 } MemContext;
 
 // - Main -
@@ -120,6 +131,17 @@ size_t memctx_open_file(MemContext *memctx, char **buffer, char *filename);
  */
 void   memctx_free_file(MemContext *ctx, char *memctx_file);
 
+/**
+ * Allocate a fully consumed block for file contents and link it to the end of a memory context.
+ * The buffer holds `size` bytes plus a null terminator, which is already set.
+ * The block can be released early with `memctx_free_file`.
+ *
+ * @param ctx Pointer to the memory context
+ * @param size Size of the file contents in bytes
+ * @return Pointer to the buffer, or NULL if ctx is NULL or allocation fails
+ */
+char*  __memctx_file_block(MemContext *ctx, size_t size);
+
 // - Diagnostics
 
 /**
@@ -162,6 +184,7 @@ MemContext* memctx(void) {
     }
 
     ctx->next = NULL;
+    ctx->search = ctx;
     return ctx;
 }
 
@@ -171,19 +194,30 @@ void* memctx_alloc(MemContext *ctx, size_t size) {
     // Align size to ensure proper alignment
     size_t aligned_size = (size + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
 
-    // Search for a block with enough space
-    MemContext *current = ctx;
+    // Search for a block with enough space, skipping the blocks known to be full
+    MemContext *current = ctx->search;
     MemContext *prev = NULL;
+    size_t searched = 0;
 
     while (current) {
         // Check if current block has enough space
-        if (current->capacity - current->consumed >= aligned_size) {
+        size_t available = current->capacity - current->consumed;
+        if (available >= aligned_size) {
             // Found a block with enough space
             void* ptr = (void*)((char*)current->data + current->consumed);
             current->consumed += aligned_size;
             return ptr;
         }
 
+        // A nearly full block at the start of the search is left out of later searches,
+        // and so is the oldest block for each one past MEMCTX_SEARCH_BLOCKS that could not fit the request,
+        // so a context with many blocks does not rescan them on every allocation
+        if (current == ctx->search && available < MEMCTX_SEARCH_MIN) {
+            ctx->search = current->next;
+        } else if (++searched > MEMCTX_SEARCH_BLOCKS) {
+            ctx->search = ctx->search->next;
+        }
+
         // Move to the next block
         prev = current;
         current = current->next;
@@ -209,9 +243,11 @@ void* memctx_alloc(MemContext *ctx, size_t size) {
     }
 
     new_block->next = NULL;
+    new_block->search = NULL;
 
     // Link the new block to the end of the list
     prev->next = new_block;
+    if (!ctx->search) ctx->search = new_block;
 
     // Return a pointer to the allocated memory in the new block
     return (void*)new_block->data;
@@ -314,43 +350,51 @@ size_t memctx_open_file(MemContext *ctx, char **buffer, char *filename) {
         return 0;
     }
 
-    // Create a new memory context block that's fully consumed
-    MemContext* file_block = (MemContext*)malloc(sizeof(MemContext));
-    if (!file_block) {
+    char *data = __memctx_file_block(ctx, (size_t)file_size);
+    if (!data) {
         fclose(file);
         *buffer = NULL;
         return 0;
     }
 
-    // File block is fully consumed
-    file_block->capacity = file_size;
-    file_block->consumed = file_size;
-    // Allocation size is a multiple of MEMCTX_PAGE_SIZE that can fit file_size + 1 for '\0'
-    // Keeping +1 -1 as a reminder.
-    size_t alloc_size = ((file_size + 1 + MEMCTX_PAGE_SIZE - 1) / MEMCTX_PAGE_SIZE) * MEMCTX_PAGE_SIZE;
-    file_block->data = (char*)malloc(alloc_size); // <- allocate aligned size, but track only file_size
-    file_block->next = NULL;
+    // Read file content into the buffer
+    size_t read_size = fread(data, 1, file_size, file);
+    fclose(file);
 
-    if (!file_block->data) {
-        free(file_block);
-        fclose(file);
+    if (read_size != (size_t)file_size) {
+        memctx_free_file(ctx, data);
         *buffer = NULL;
         return 0;
     }
 
-    // Read file content into the buffer
-    size_t read_size = fread(file_block->data, 1, file_size, file);
-    fclose(file);
+    *buffer = data;
+    return read_size;
+}
 
-    if (read_size != (size_t)file_size) {
-        free(file_block->data);
+char* __memctx_file_block(MemContext *ctx, size_t size) {
+    if (!ctx) return NULL;
+
+    // Create a new memory context block that's fully consumed
+    MemContext* file_block = (MemContext*)malloc(sizeof(MemContext));
+    if (!file_block) return NULL;
+
+    // File block is fully consumed
+    file_block->capacity = size;
+    file_block->consumed = size;
+    // Allocation size is a multiple of MEMCTX_PAGE_SIZE that can fit size + 1 for '\0'
+    // Keeping +1 -1 as a reminder.
+    size_t alloc_size = ((size + 1 + MEMCTX_PAGE_SIZE - 1) / MEMCTX_PAGE_SIZE) * MEMCTX_PAGE_SIZE;
+    file_block->data = (char*)malloc(alloc_size); // <- allocate aligned size, but track only size
+    file_block->next = NULL;
+    file_block->search = NULL;
+
+    if (!file_block->data) {
         free(file_block);
-        *buffer = NULL;
-        return 0;
+        return NULL;
     }
 
     // Make compatible with c string functions
-    file_block->data[file_size] = 0;
+    file_block->data[size] = 0;
 
     // Find the last block in the context
     MemContext *current = ctx;
@@ -361,8 +405,7 @@ size_t memctx_open_file(MemContext *ctx, char **buffer, char *filename) {
     // Link the new block to the end of the list
     current->next = file_block;
 
-    *buffer = (char *)file_block->data;
-    return read_size;
+    return file_block->data;
 }
 
 void memctx_free_file(MemContext *ctx, char *memctx_file) {
@@ -383,6 +426,8 @@ void memctx_free_file(MemContext *ctx, char *memctx_file) {
     if (prev) {
         prev->next = current->next;
     }
+    // The freed block may be where the search starts
+    ctx->search = ctx;
 
     // Free this block
     free(current->data);
@@ -0,0 +1,353 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all multi-pattern search functions (Aho-Corasick).
+
+#ifndef _MEMCTX_AHO_H_
+#define _MEMCTX_AHO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memctx.h"
+#include "memctx_arrays.h"
+#include "memctx_strings.h"
+
+#define AHO_NONE UINT32_MAX
+
+// Set in transition table entries of states where a pattern ends
+#define AHO_OUTPUT ((uint32_t)1 << 31)
+
+typedef struct memctx_aho_match {
+    size_t pattern;             // index of the pattern, in the order of `aho_add`
+    size_t start;               // offset of the match in the searched string
+    size_t length;
+} aho_match;
+
+typedef bool (*AhoCallback)(const aho_match *match, void *context);
+
+typedef struct memctx_aho {
+    array *patterns;            // substring* copies of the patterns
+
+    // Transitions of all states as one dense table, one row per state and one column per byte class.
+    // Entries are row offsets of the next state, with AHO_OUTPUT if a pattern ends there
+    uint32_t *table;
+    uint8_t classes[256];       // bytes that occur in no pattern share one class
+    size_t class_count;
+    size_t state_count;
+
+    uint32_t *first;            // by state: the longest pattern ending there, or AHO_NONE
+    uint32_t *suffix;           // by state: the longest proper suffix state with a pattern, or AHO_NONE
+    uint32_t *same;             // by pattern: the next pattern with the same text, or AHO_NONE
+    bool built;
+
+    MemContext *ctx;
+} aho;
+
+/**
+ * Initialize a new empty pattern set within the specified memory context.
+ *
+ * Parameters:
+ *  - ctx          The memory context for the patterns and the automaton.
+ *
+ * Returns the pattern set, or NULL if ctx is NULL or allocation fails.
+ */
+aho* aho_init(MemContext *ctx);
+
+/**
+ * Adds a pattern. The pattern is copied; patterns can repeat and can be prefixes
+ * or suffixes of each other.
+ *
+ * Parameters:
+ *  - ac           The pattern set.
+ *  - pattern      The pattern to add (can be either string or char*), not empty.
+ *
+ * Returns true if the pattern was added. The pattern index is the number of patterns added before it.
+ */
+#define aho_add(ac, pattern) __aho_add(ac, __string_arg(pattern))
+
+/**
+ * Builds the automaton. Searching builds it too if patterns were added since the last build;
+ * the previous automaton stays in the context until it is freed.
+ *
+ * The table takes 4 bytes per state and byte class, where states are at most the total length
+ * of the patterns and classes are the distinct bytes in them plus one.
+ *
+ * Parameters:
+ *  - ac           The pattern set.
+ *
+ * Returns true on success, false if ac is NULL or allocation fails.
+ */
+bool aho_build(aho *ac);
+
+/**
+ * Finds all occurrences of all patterns in one pass, including overlapping ones.
+ * Matches are reported in order of their end; matches that end at the same byte longest first.
+ *
+ * Parameters:
+ *  - ac           The pattern set.
+ *  - str          The string to search.
+ *  - callback     Called for each match, returns false to stop the search.
+ *  - context      Passed to the callback.
+ *
+ * Returns the number of matches reported.
+ */
+size_t aho_find_each(aho *ac, string str, AhoCallback callback, void *context);
+
+/**
+ * Finds all occurrences of all patterns, like `aho_find_each`.
+ *
+ * Parameters:
+ *  - ac           The pattern set.
+ *  - str          The string to search.
+ *
+ * Returns an array of **aho_match** pointers allocated in the string memory context,
+ * or NULL if the string has no context.
+ */
+array* aho_find_all(aho *ac, string str);
+
+bool __aho_add(aho *ac, substring pattern);
+
+/**
+ * Reports the patterns that end in the state with row offset `row` at `end`.
+ *
+ * Returns false if the callback stopped the search.
+ */
+bool __aho_report(aho *ac, uint32_t row, size_t end, AhoCallback callback, void *context, size_t *count);
+
+/**
+ * Appends a copy of the match to the array passed as context.
+ */
+bool __aho_collect(const aho_match *match, void *context);
+
+// - Implementation -
+
+aho* aho_init(MemContext *ctx) {
+    if (!ctx) return NULL;
+
+    aho *ac = (aho *)memctx_alloc(ctx, sizeof(aho));
+    if (!ac) return NULL;
+    memset(ac, 0, sizeof(aho));
+
+    ac->patterns = array_init(ctx);
+    if (!ac->patterns) return NULL;
+    ac->ctx = ctx;
+    return ac;
+}
+
+bool __aho_add(aho *ac, substring pattern) {
+    if (!ac || !pattern.value || pattern.length == 0) return false;
+
+    substring *copy = (substring *)memctx_alloc(ac->ctx, sizeof(substring));
+    char *value = (char *)memctx_alloc(ac->ctx, pattern.length + 1);
+    if (!copy || !value) return false;
+    memcpy(value, pattern.value, pattern.length);
+    value[pattern.length] = '\0';
+
+    copy->value = value;
+    copy->length = pattern.length;
+    copy->capacity = pattern.length + 1;
+    copy->ctx = ac->ctx;
+    array_append(ac->patterns, copy);
+    ac->built = false;
+    return true;
+}
+
+bool aho_build(aho *ac) {
+    if (!ac) return false;
+    ac->built = false;
+
+    size_t pattern_count = ac->patterns->length;
+    size_t max_states = 1;
+    bool used[256] = {false};
+    for (size_t i = 0; i < pattern_count; i++) {
+        substring *pattern = (substring *)array_item_at(ac->patterns, i);
+        max_states += pattern->length;
+        for (size_t k = 0; k < pattern->length; k++) {
+            used[(unsigned char)pattern->value[k]] = true;
+        }
+    }
+
+    // Each byte that occurs in a pattern gets its own class, the other bytes share the last one
+    size_t class_count = 0;
+    for (int b = 0; b < 256; b++) {
+        if (used[b]) ac->classes[b] = (uint8_t)class_count++;
+    }
+    if (class_count < 256) {
+        for (int b = 0; b < 256; b++) {
+            if (!used[b]) ac->classes[b] = (uint8_t)class_count;
+        }
+        class_count++;
+    }
+    if (max_states * class_count >= AHO_OUTPUT) return false;
+
+    // The trie and the automaton are built on state numbers, then stored as row offsets
+    uint32_t *next = (uint32_t *)malloc(sizeof(uint32_t) * max_states * class_count);
+    uint32_t *fail = (uint32_t *)malloc(sizeof(uint32_t) * max_states);
+    uint32_t *first = (uint32_t *)malloc(sizeof(uint32_t) * max_states);
+    uint32_t *queue = (uint32_t *)malloc(sizeof(uint32_t) * max_states);
+    uint32_t *same = pattern_count ? (uint32_t *)memctx_alloc(ac->ctx, sizeof(uint32_t) * pattern_count) : NULL;
+    bool ok = next && fail && first && queue && (same || pattern_count == 0);
+
+    size_t state_count = 1;
+    if (ok) {
+        memset(next, 0xFF, sizeof(uint32_t) * class_count);
+        first[0] = AHO_NONE;
+
+        // Patterns are added in reverse so that the chains of equal patterns keep their order
+        for (size_t i = pattern_count; i-- > 0;) {
+            substring *pattern = (substring *)array_item_at(ac->patterns, i);
+            uint32_t state = 0;
+            for (size_t k = 0; k < pattern->length; k++) {
+                uint32_t *target = &next[state * class_count + ac->classes[(unsigned char)pattern->value[k]]];
+                if (*target == AHO_NONE) {
+                    memset(&next[state_count * class_count], 0xFF, sizeof(uint32_t) * class_count);
+                    first[state_count] = AHO_NONE;
+                    *target = (uint32_t)state_count++;
+                }
+                state = *target;
+            }
+            same[i] = first[state];
+            first[state] = (uint32_t)i;
+        }
+    }
+
+    uint32_t *table = NULL, *states_first = NULL, *suffix = NULL;
+    if (ok) {
+        table = (uint32_t *)memctx_alloc(ac->ctx, sizeof(uint32_t) * state_count * class_count);
+        states_first = (uint32_t *)memctx_alloc(ac->ctx, sizeof(uint32_t) * state_count);
+        suffix = (uint32_t *)memctx_alloc(ac->ctx, sizeof(uint32_t) * state_count);
+        ok = table && states_first && suffix;
+    }
+
+    if (ok) {
+        // Breadth-first: a state's failure link is shorter, so its transitions are complete when needed
+        size_t head = 0, tail = 0;
+        fail[0] = 0;
+        suffix[0] = AHO_NONE;
+        for (size_t c = 0; c < class_count; c++) {
+            uint32_t child = next[c];
+            if (child == AHO_NONE) {
+                next[c] = 0;
+            } else {
+                fail[child] = 0;
+                suffix[child] = AHO_NONE;
+                queue[tail++] = child;
+            }
+        }
+        while (head < tail) {
+            uint32_t state = queue[head++];
+            uint32_t *row = &next[state * class_count];
+            const uint32_t *fail_row = &next[fail[state] * class_count];
+            for (size_t c = 0; c < class_count; c++) {
+                uint32_t child = row[c];
+                if (child == AHO_NONE) {
+                    row[c] = fail_row[c];
+                } else {
+                    uint32_t link = fail_row[c];
+                    fail[child] = link;
+                    suffix[child] = first[link] != AHO_NONE ? link : suffix[link];
+                    queue[tail++] = child;
+                }
+            }
+        }
+
+        for (size_t s = 0; s < state_count; s++) {
+            for (size_t c = 0; c < class_count; c++) {
+                uint32_t target = next[s * class_count + c];
+                bool output = first[target] != AHO_NONE || suffix[target] != AHO_NONE;
+                table[s * class_count + c] = (uint32_t)(target * class_count) | (output ? AHO_OUTPUT : 0);
+            }
+        }
+        memcpy(states_first, first, sizeof(uint32_t) * state_count);
+
+        ac->table = table;
+        ac->first = states_first;
+        ac->suffix = suffix;
+        ac->same = same;
+        ac->class_count = class_count;
+        ac->state_count = state_count;
+        ac->built = true;
+    }
+
+    free(next);
+    free(fail);
+    free(first);
+    free(queue);
+    return ok;
+}
+
+size_t aho_find_each(aho *ac, string str, AhoCallback callback, void *context) {
+    if (!ac || !str.value || !callback) return 0;
+    if (!ac->built && !aho_build(ac)) return 0;
+
+    const uint32_t *table = ac->table;
+    const uint8_t *classes = ac->classes;
+    const unsigned char *bytes = (const unsigned char *)str.value;
+    size_t count = 0;
+    uint32_t row = 0;
+    for (size_t i = 0; i < str.length; i++) {
+        row = table[row + classes[bytes[i]]];
+        if (row & AHO_OUTPUT) {
+            row &= ~AHO_OUTPUT;
+            if (!__aho_report(ac, row, i + 1, callback, context, &count)) break;
+        }
+    }
+    return count;
+}
+
+array* aho_find_all(aho *ac, string str) {
+    array *result = array_init(str.ctx);
+    if (!result) return NULL;
+    aho_find_each(ac, str, __aho_collect, result);
+    return result;
+}
+
+bool __aho_report(aho *ac, uint32_t row, size_t end, AhoCallback callback, void *context, size_t *count) {
+    // The state and its suffixes that end patterns, longest first
+    uint32_t state = (uint32_t)(row / ac->class_count);
+    if (ac->first[state] == AHO_NONE) state = ac->suffix[state];
+
+    for (; state != AHO_NONE; state = ac->suffix[state]) {
+        for (uint32_t p = ac->first[state]; p != AHO_NONE; p = ac->same[p]) {
+            substring *pattern = (substring *)array_item_at(ac->patterns, p);
+            aho_match match;
+            match.pattern = p;
+            match.start = end - pattern->length;
+            match.length = pattern->length;
+            (*count)++;
+            if (!callback(&match, context)) return false;
+        }
+    }
+    return true;
+}
+
+bool __aho_collect(const aho_match *match, void *context) {
+    array *result = (array *)context;
+    aho_match *copy = (aho_match *)memctx_alloc(result->ctx, sizeof(aho_match));
+    if (!copy) return false;
+    *copy = *match;
+    array_append(result, copy);
+    return true;
+}
+
+#endif
@@ -0,0 +1,770 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all string builder functions.
+
+#ifndef _MEMCTX_BUILDER_H_
+#define _MEMCTX_BUILDER_H_
+
+#include <stddef.h>
+#include <string.h>
+#include "memctx.h"
+#include "memctx_strings.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#define STRING_BUILDER_IOVEC 1
+#endif
+
+#ifndef STRING_BUILDER_CHUNK_SIZE
+#define STRING_BUILDER_CHUNK_SIZE 1024
+#endif
+
+#ifndef STRING_BUILDER_MAX_CHUNK_SIZE
+#define STRING_BUILDER_MAX_CHUNK_SIZE (1024 * 1024)
+#endif
+
+// Largest iovec count passed to a single writev call
+#ifndef STRING_BUILDER_IOV_MAX
+#define STRING_BUILDER_IOV_MAX 1024
+#endif
+
+typedef struct memctx_string_chunk {
+    char *data;
+    size_t length;
+    size_t capacity;
+    struct memctx_string_chunk *next;
+} string_chunk;
+
+typedef struct memctx_string_builder {
+    string_chunk *head;
+    string_chunk *tail;
+    size_t length;
+    size_t chunks;
+    size_t next_chunk_size;
+    char *flat;
+    MemContext *ctx;
+} string_builder;
+
+// File written to a temporary name, waiting to be renamed over its target
+typedef struct memctx_string_file {
+    char *path;
+    char *temp_path;
+    char *backup_path;
+    bool backup_moved;          // the target is renamed to backup_path instead of linked
+    int fd;
+    struct memctx_string_file *next;
+} string_file;
+
+typedef struct memctx_string_file_batch {
+    string_file *head;
+    string_file *tail;
+    size_t count;
+    bool failed;
+    MemContext *ctx;
+} string_file_batch;
+
+/**
+ * Initializes a new empty string builder.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *
+ * Returns a pointer to the builder, or NULL if ctx is NULL or allocation fails.
+ */
+string_builder* string_builder_init(MemContext *ctx);
+
+/**
+ * Copies `length` bytes to the end of the builder.
+ * Fragments are packed into chunks, nothing written earlier is copied again.
+ *
+ * Parameters:
+ *  - sb           The builder to append to.
+ *  - value        Pointer to the bytes to append.
+ *  - length       Number of bytes to append.
+ *
+ * Returns the new length of the builder, or 0 if sb is NULL.
+ */
+size_t __string_builder_append_n(string_builder *sb, const char *value, size_t length);
+
+/**
+ * Appends a string to the end of the builder.
+ *
+ * Returns the new length of the builder, or 0 if sb is NULL.
+ */
+size_t __string_builder_append_string(string_builder *sb, string value);
+
+/**
+ * Appends a null-terminated C string to the end of the builder.
+ *
+ * Returns the new length of the builder, or 0 if sb is NULL.
+ */
+size_t __string_builder_append_chars(string_builder *sb, const char *value);
+
+/**
+ * Appends a value to the end of the builder.
+ * Automatically selects the appropriate function based on the type of value.
+ *
+ * Parameters:
+ *  - sb           The builder to append to.
+ *  - value        The value to append (can be either string or char*).
+ *
+ * Returns the new length of the builder.
+ */
+#define string_builder_append(sb, value) _Generic((value), \
+    string:      __string_builder_append_string, \
+    char*:       __string_builder_append_chars, \
+    const char*: __string_builder_append_chars \
+)(sb, value)
+
+/**
+ * Flattens the builder content into a single null-terminated string.
+ * The result is allocated once with the exact size; the builder keeps it
+ * as its only chunk, so building again without appending does not copy.
+ * Appending to the builder afterwards does not modify the returned string,
+ * and appending to the returned string copies it instead of writing into the builder.
+ *
+ * Parameters:
+ *  - sb           The builder to flatten.
+ *
+ * Returns a string with the builder content,
+ * or an empty `string` object if sb is NULL or allocation fails.
+ */
+string string_builder_build(string_builder *sb);
+
+/**
+ * Resets the builder length to zero. Chunks are left in the memory context.
+ *
+ * Parameters:
+ *  - sb           The builder to clear.
+ */
+void string_builder_clear(string_builder *sb);
+
+#ifdef STRING_BUILDER_IOVEC
+/**
+ * Describes the builder content as an iovec list without flattening it,
+ * ready to be passed to `writev`.
+ *
+ * Parameters:
+ *  - sb           The builder to describe.
+ *  - iov          Receives an array of iovec allocated in the builder context.
+ *
+ * Returns the number of iovec entries, or 0 if sb is NULL, empty, or allocation fails.
+ */
+size_t string_builder_iovec(string_builder *sb, struct iovec **iov);
+
+/**
+ * Writes the whole string to a file descriptor.
+ * Short writes and interrupted calls are retried.
+ *
+ * Parameters:
+ *  - fd           The file descriptor or socket to write to.
+ *  - str          The string to write.
+ *
+ * Returns true if every byte was written, false on error (errno is set).
+ */
+bool string_write_fd(int fd, string str);
+
+/**
+ * Writes the builder content to a file descriptor with `writev`, without flattening it.
+ * Chunks are sent in groups of at most STRING_BUILDER_IOV_MAX, short writes are resumed.
+ *
+ * Parameters:
+ *  - sb           The builder to write.
+ *  - fd           The file descriptor or socket to write to.
+ *
+ * Returns true if every byte was written, false if sb is NULL or on error (errno is set).
+ */
+bool string_builder_writev(string_builder *sb, int fd);
+
+/**
+ * Atomically replaces a file with the content of a string.
+ * The content is written to a temporary file next to the target, synced,
+ * and renamed over the target, so readers see either the old or the new file.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for temporary paths.
+ *  - filename     Path to the file to be written.
+ *  - str          The content to write.
+ *
+ * Returns true on success. On failure the target is left untouched.
+ */
+bool string_write_file(MemContext *ctx, const char *filename, string str);
+
+/**
+ * Atomically replaces a file with the builder content. See `string_write_file`.
+ *
+ * Returns true on success, false if sb is NULL or on error.
+ */
+bool string_builder_write_file(string_builder *sb, const char *filename);
+
+/**
+ * Initializes a batch of atomic file writes.
+ * Files added to the batch are written to temporary files right away;
+ * `string_file_batch_commit` syncs them all before renaming any of them,
+ * so the cost of waiting for the device is paid once per batch.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *
+ * Returns a pointer to the batch, or NULL if ctx is NULL or allocation fails.
+ */
+string_file_batch* string_file_batch_init(MemContext *ctx);
+
+/**
+ * Writes a string to a temporary file that will replace `filename` on commit.
+ * The temporary file stays open until the batch is committed or aborted.
+ *
+ * Returns true on success. On failure the batch is marked as failed.
+ */
+bool string_file_batch_add(string_file_batch *batch, const char *filename, string str);
+
+/**
+ * Writes the builder content to a temporary file that will replace `filename` on commit.
+ *
+ * Returns true on success. On failure the batch is marked as failed.
+ */
+bool string_file_batch_add_builder(string_file_batch *batch, const char *filename, string_builder *sb);
+
+/**
+ * Syncs every file in the batch, renames them over their targets
+ * and syncs each containing directory once.
+ * If any write failed, nothing is renamed and the temporary files are removed.
+ * Existing targets are hard-linked to a backup name before the renames start;
+ * if a rename fails, the files already replaced are restored from their backups
+ * and the files that did not exist before are removed again.
+ * On file systems without hard links the target is renamed to the backup name instead,
+ * right before the new file takes its place, so readers can briefly find it missing.
+ * The rollback is not crash-safe: a crash in the middle of the renames can
+ * leave the batch partly applied, with the backups still next to the targets.
+ *
+ * Returns true if every file was replaced.
+ */
+bool string_file_batch_commit(string_file_batch *batch);
+
+/**
+ * Removes the temporary files of a batch without replacing any target.
+ */
+void string_file_batch_abort(string_file_batch *batch);
+
+/**
+ * Creates a temporary file for `filename` and adds it to the batch.
+ * The temporary file gets the permission bits of the target if it exists.
+ *
+ * Returns the new entry, or NULL if the file cannot be created.
+ */
+string_file* __string_file_batch_open(string_file_batch *batch, const char *filename);
+
+/**
+ * Unlinks the temporary and backup files that are still left in the batch.
+ */
+void __string_file_batch_remove(string_file_batch *batch);
+
+/**
+ * Returns the length of the directory part of `path`, or 0 if it has none.
+ */
+size_t __string_dirname_length(const char *path);
+
+/**
+ * Syncs the directory containing `path` so that a rename in it is durable.
+ */
+bool __string_sync_parent_dir(MemContext *ctx, const char *path);
+#endif
+
+/**
+ * Adds a chunk that can hold at least `size` bytes to the end of the builder.
+ *
+ * Returns the new chunk, or NULL if allocation fails.
+ */
+string_chunk* __string_builder_add_chunk(string_builder *sb, size_t size);
+
+// - Implementation -
+
+string_builder* string_builder_init(MemContext *ctx) {
+    if (!ctx) return NULL;
+
+    string_builder *sb = (string_builder *)memctx_alloc(ctx, sizeof(string_builder));
+    if (!sb) return NULL;
+
+    sb->head = NULL;
+    sb->tail = NULL;
+    sb->length = 0;
+    sb->chunks = 0;
+    sb->next_chunk_size = STRING_BUILDER_CHUNK_SIZE;
+    sb->flat = NULL;
+    sb->ctx = ctx;
+    return sb;
+}
+
+size_t __string_builder_append_n(string_builder *sb, const char *value, size_t length) {
+    if (!sb) return 0;
+    if (!value || length == 0) return sb->length;
+
+    sb->flat = NULL;
+
+    string_chunk *chunk = sb->tail;
+    size_t available = chunk ? chunk->capacity - chunk->length : 0;
+
+    // Fill what is left of the current chunk
+    if (available > 0) {
+        size_t part = length < available ? length : available;
+        memcpy(chunk->data + chunk->length, value, part);
+        chunk->length += part;
+        sb->length += part;
+        value += part;
+        length -= part;
+    }
+
+    // Put the rest into a new chunk
+    if (length > 0) {
+        chunk = __string_builder_add_chunk(sb, length);
+        if (!chunk) return sb->length;
+
+        memcpy(chunk->data, value, length);
+        chunk->length = length;
+        sb->length += length;
+    }
+
+    return sb->length;
+}
+
+size_t __string_builder_append_string(string_builder *sb, string value) {
+    return __string_builder_append_n(sb, value.value, value.length);
+}
+
+size_t __string_builder_append_chars(string_builder *sb, const char *value) {
+    if (!value) return sb ? sb->length : 0;
+    return __string_builder_append_n(sb, value, strlen(value));
+}
+
+string string_builder_build(string_builder *sb) {
+    string str = {0};
+    if (!sb) return str;
+
+    str.ctx = sb->ctx;
+
+    // Nothing was appended since the last build
+    if (sb->flat) {
+        str.value = sb->flat;
+        str.length = sb->length;
+        str.capacity = sb->length + 1;
+        return str;
+    }
+
+    size_t capacity = __string_fit_capacity(sb->length + 1);
+    char *value = (char *)memctx_alloc(sb->ctx, capacity);
+    if (!value) return str;
+
+    size_t offset = 0;
+    for (string_chunk *chunk = sb->head; chunk; chunk = chunk->next) {
+        memcpy(value + offset, chunk->data, chunk->length);
+        offset += chunk->length;
+    }
+    value[offset] = '\0';
+
+    // Keep the flat copy as the only chunk. It is marked full,
+    // so later appends open a new chunk instead of overwriting the terminator.
+    string_chunk *flat = (string_chunk *)memctx_alloc(sb->ctx, sizeof(string_chunk));
+    if (flat) {
+        flat->data = value;
+        flat->length = offset;
+        flat->capacity = offset;
+        flat->next = NULL;
+        sb->head = flat;
+        sb->tail = flat;
+        sb->chunks = 1;
+        sb->flat = value;
+    }
+
+    // The builder still owns the buffer, so appending to the result must reallocate
+    str.value = value;
+    str.length = offset;
+    str.capacity = offset + 1;
+    return str;
+}
+
+void string_builder_clear(string_builder *sb) {
+    if (!sb) return;
+    sb->head = NULL;
+    sb->tail = NULL;
+    sb->length = 0;
+    sb->chunks = 0;
+    sb->flat = NULL;
+}
+
+#ifdef STRING_BUILDER_IOVEC
+size_t string_builder_iovec(string_builder *sb, struct iovec **iov) {
+    *iov = NULL;
+    if (!sb || sb->length == 0) return 0;
+
+    *iov = (struct iovec *)memctx_alloc(sb->ctx, sizeof(struct iovec) * sb->chunks);
+    if (!*iov) return 0;
+
+    size_t count = 0;
+    for (string_chunk *chunk = sb->head; chunk; chunk = chunk->next) {
+        if (chunk->length == 0) continue;
+        (*iov)[count].iov_base = chunk->data;
+        (*iov)[count].iov_len = chunk->length;
+        count++;
+    }
+
+    return count;
+}
+
+bool string_write_fd(int fd, string str) {
+    const char *data = str.value;
+    size_t remaining = data ? str.length : 0;
+
+    while (remaining > 0) {
+        ssize_t written = write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        remaining -= (size_t)written;
+    }
+
+    return true;
+}
+
+bool string_builder_writev(string_builder *sb, int fd) {
+    if (!sb) return false;
+    if (sb->length == 0) return true;
+
+    struct iovec *iov;
+    size_t count = string_builder_iovec(sb, &iov);
+    if (count == 0) return false;
+
+    // The iovec list is our own copy, so it is advanced in place after short writes
+    size_t index = 0;
+    while (index < count) {
+        size_t group = count - index;
+        if (group > STRING_BUILDER_IOV_MAX) group = STRING_BUILDER_IOV_MAX;
+
+        ssize_t written = writev(fd, iov + index, (int)group);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        size_t left = (size_t)written;
+        while (index < count && left >= iov[index].iov_len) {
+            left -= iov[index].iov_len;
+            index++;
+        }
+        if (left > 0) {
+            iov[index].iov_base = (char *)iov[index].iov_base + left;
+            iov[index].iov_len -= left;
+        }
+    }
+
+    return true;
+}
+
+bool string_write_file(MemContext *ctx, const char *filename, string str) {
+    string_file_batch *batch = string_file_batch_init(ctx);
+    if (!batch) return false;
+
+    string_file_batch_add(batch, filename, str);
+    return string_file_batch_commit(batch);
+}
+
+bool string_builder_write_file(string_builder *sb, const char *filename) {
+    if (!sb) return false;
+
+    string_file_batch *batch = string_file_batch_init(sb->ctx);
+    if (!batch) return false;
+
+    string_file_batch_add_builder(batch, filename, sb);
+    return string_file_batch_commit(batch);
+}
+
+string_file_batch* string_file_batch_init(MemContext *ctx) {
+    if (!ctx) return NULL;
+
+    string_file_batch *batch = (string_file_batch *)memctx_alloc(ctx, sizeof(string_file_batch));
+    if (!batch) return NULL;
+
+    batch->head = NULL;
+    batch->tail = NULL;
+    batch->count = 0;
+    batch->failed = false;
+    batch->ctx = ctx;
+    return batch;
+}
+
+bool string_file_batch_add(string_file_batch *batch, const char *filename, string str) {
+    if (!batch) return false;
+
+    string_file *file = __string_file_batch_open(batch, filename);
+    if (!file) return false;
+
+    if (!string_write_fd(file->fd, str)) {
+        batch->failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool string_file_batch_add_builder(string_file_batch *batch, const char *filename, string_builder *sb) {
+    if (!batch) return false;
+    if (!sb) {
+        batch->failed = true;
+        return false;
+    }
+
+    string_file *file = __string_file_batch_open(batch, filename);
+    if (!file) return false;
+
+    if (!string_builder_writev(sb, file->fd)) {
+        batch->failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool string_file_batch_commit(string_file_batch *batch) {
+    if (!batch) return false;
+    if (batch->failed) {
+        string_file_batch_abort(batch);
+        return false;
+    }
+
+    // Sync all data first, then rename: a crash leaves either old files or complete new ones
+    bool ok = true;
+    for (string_file *file = batch->head; file; file = file->next) {
+        if (fsync(file->fd) != 0) ok = false;
+        if (close(file->fd) != 0) ok = false;
+        file->fd = -1;
+    }
+
+    if (!ok) {
+        string_file_batch_abort(batch);
+        return false;
+    }
+
+    // Keep the current targets under a second name so a failed rename can be undone
+    for (string_file *file = batch->head; file && ok; file = file->next) {
+        if (access(file->path, F_OK) != 0) continue;
+        memctx_snprintf(batch->ctx, &file->backup_path, "%s.bak", file->temp_path);
+        if (!file->backup_path) {
+            ok = false;
+        } else if (link(file->path, file->backup_path) != 0) {
+            // vfat and some network or FUSE mounts have no hard links
+            file->backup_moved = errno == EPERM || errno == ENOTSUP || errno == EOPNOTSUPP ||
+                                 errno == EXDEV || errno == ENOSYS;
+            if (!file->backup_moved) {
+                file->backup_path = NULL;
+                ok = false;
+            }
+        }
+    }
+
+    if (!ok) {
+        string_file_batch_abort(batch);
+        return false;
+    }
+
+    // Files before `renamed` have been replaced when the loop stops
+    string_file *renamed = batch->head;
+    for (; renamed; renamed = renamed->next) {
+        if (renamed->backup_moved && rename(renamed->path, renamed->backup_path) != 0) {
+            renamed->backup_path = NULL;
+            ok = false;
+            break;
+        }
+        if (rename(renamed->temp_path, renamed->path) != 0) {
+            if (renamed->backup_moved) {
+                rename(renamed->backup_path, renamed->path);
+                renamed->backup_path = NULL;
+            }
+            ok = false;
+            break;
+        }
+    }
+
+    if (!ok) {
+        for (string_file *file = batch->head; file != renamed; file = file->next) {
+            if (file->backup_path) {
+                rename(file->backup_path, file->path);
+                file->backup_path = NULL;
+            } else {
+                unlink(file->path);
+            }
+        }
+        string_file_batch_abort(batch);
+        return false;
+    }
+    __string_file_batch_remove(batch);
+
+    // Sync each directory once, however many files were renamed in it
+    for (string_file *file = batch->head; file; file = file->next) {
+        size_t dir_length = __string_dirname_length(file->path);
+        bool seen = false;
+        for (string_file *prev = batch->head; prev != file && !seen; prev = prev->next) {
+            seen = __string_dirname_length(prev->path) == dir_length &&
+                   memcmp(prev->path, file->path, dir_length) == 0;
+        }
+        if (!seen && !__string_sync_parent_dir(batch->ctx, file->path)) ok = false;
+    }
+
+    batch->head = NULL;
+    batch->tail = NULL;
+    batch->count = 0;
+    return ok;
+}
+
+void string_file_batch_abort(string_file_batch *batch) {
+    if (!batch) return;
+
+    for (string_file *file = batch->head; file; file = file->next) {
+        if (file->fd >= 0) close(file->fd);
+        file->fd = -1;
+    }
+    __string_file_batch_remove(batch);
+
+    batch->head = NULL;
+    batch->tail = NULL;
+    batch->count = 0;
+    batch->failed = false;
+}
+
+void __string_file_batch_remove(string_file_batch *batch) {
+    for (string_file *file = batch->head; file; file = file->next) {
+        if (file->temp_path) unlink(file->temp_path);
+        if (file->backup_path) unlink(file->backup_path);
+        file->temp_path = NULL;
+        file->backup_path = NULL;
+    }
+}
+
+string_file* __string_file_batch_open(string_file_batch *batch, const char *filename) {
+    if (!filename) {
+        batch->failed = true;
+        return NULL;
+    }
+
+    string_file *file = (string_file *)memctx_alloc(batch->ctx, sizeof(string_file));
+    string path = string_make(batch->ctx, filename);
+    if (!file || !path.value) {
+        batch->failed = true;
+        return NULL;
+    }
+
+    // The temporary file lives in the target directory, so rename never crosses file systems
+    // Batches may be opened from several threads at once
+    static unsigned long counter = 0;
+    char *temp_path = NULL;
+    int fd = -1;
+    for (int attempt = 0; attempt < 100 && fd < 0; attempt++) {
+        memctx_snprintf(batch->ctx, &temp_path, "%s.%ld.%lu.tmp", filename, (long)getpid(),
+                        __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED));
+        if (!temp_path) break;
+        fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd < 0 && errno != EEXIST) break;
+    }
+
+    if (fd < 0) {
+        batch->failed = true;
+        return NULL;
+    }
+
+    // Replacing a file must not change who can read it; a directory cannot be replaced by a file
+    struct stat target;
+    if (stat(filename, &target) == 0 &&
+        (S_ISDIR(target.st_mode) || chmod(temp_path, target.st_mode & 07777) != 0)) {
+        close(fd);
+        unlink(temp_path);
+        batch->failed = true;
+        return NULL;
+    }
+
+    file->path = path.value;
+    file->temp_path = temp_path;
+    file->backup_path = NULL;
+    file->backup_moved = false;
+    file->fd = fd;
+    file->next = NULL;
+
+    if (batch->tail) {
+        batch->tail->next = file;
+    } else {
+        batch->head = file;
+    }
+    batch->tail = file;
+    batch->count++;
+    return file;
+}
+
+size_t __string_dirname_length(const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (!slash) return 0;
+    return slash == path ? 1 : (size_t)(slash - path);
+}
+
+bool __string_sync_parent_dir(MemContext *ctx, const char *path) {
+    size_t length = __string_dirname_length(path);
+    string dir = length > 0 ? __string_make_n(ctx, path, length) : string_make(ctx, ".");
+    if (!dir.value) return false;
+
+    int fd = open(dir.value, O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+#endif
+
+string_chunk* __string_builder_add_chunk(string_builder *sb, size_t size) {
+    // Chunks grow geometrically up to STRING_BUILDER_MAX_CHUNK_SIZE,
+    // large fragments get a chunk of their own size
+    size_t capacity = sb->next_chunk_size;
+    if (capacity < size) capacity = size;
+    capacity = __string_fit_capacity(capacity);
+
+    string_chunk *chunk = (string_chunk *)memctx_alloc(sb->ctx, sizeof(string_chunk));
+    if (!chunk) return NULL;
+
+    chunk->data = (char *)memctx_alloc(sb->ctx, capacity);
+    if (!chunk->data) return NULL;
+    chunk->length = 0;
+    chunk->capacity = capacity;
+    chunk->next = NULL;
+
+    if (sb->tail) {
+        sb->tail->next = chunk;
+    } else {
+        sb->head = chunk;
+    }
+    sb->tail = chunk;
+    sb->chunks++;
+
+    if (sb->next_chunk_size < STRING_BUILDER_MAX_CHUNK_SIZE) {
+        sb->next_chunk_size *= 2;
+    }
+    return chunk;
+}
+
+#endif
@@ -0,0 +1,282 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all CSV functions.
+
+#ifndef _MEMCTX_CSV_H_
+#define _MEMCTX_CSV_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "memctx.h"
+#include "memctx_strings.h"
+
+// Parsed CSV text: the fields of all rows in one array, row after row
+typedef struct memctx_csv_table {
+    substring *fields;
+    size_t field_count;
+    size_t *rows;               // index of the first field of each row, then field_count
+    size_t length;              // number of rows
+    MemContext *ctx;
+} csv_table;
+
+typedef struct memctx_csv_parser {
+    string str;
+    char separator;
+    csv_table *table;
+    size_t field_start;
+} csv_parser;
+
+/**
+ * Parses CSV text (RFC 4180) into rows of fields.
+ * Fields are separated by `separator` and rows by "\n" or "\r\n".
+ * A field enclosed in double quotes may contain separators, newlines and
+ * doubled quotes (""), which stand for one quote.
+ * A newline at the very end does not start another row, an empty line is a row with one empty field.
+ * Malformed quoting is not rejected: such fields are returned as they are in the text.
+ *
+ * Parameters:
+ *  - str          The CSV text, e.g. from `string_read_file`.
+ *  - separator    The field separator, usually ',', ';' or '\t'.
+ *
+ * Returns a table allocated in the string memory context, or NULL if str has no context or allocation fails.
+ * Fields are **substring** views of `str` without quotes, stored in one array;
+ * only fields that contain doubled quotes are copied to be unescaped.
+ */
+csv_table* csv_parse(string str, char separator);
+
+/**
+ * Returns the number of fields in a row, or 0 if table is NULL or row is out of range.
+ */
+size_t csv_row_length(csv_table *table, size_t row);
+
+/**
+ * Returns the field at `row`, `column`, or NULL if table is NULL or either index is out of range.
+ */
+substring* csv_field(csv_table *table, size_t row, size_t column);
+
+/**
+ * Computes bit masks of quotes, separators and newlines for up to 64 bytes.
+ */
+void __csv_block_masks(const char *value, size_t length, char separator,
+                       uint64_t *quotes, uint64_t *separators, uint64_t *newlines);
+
+/**
+ * Adds the field that ends at `end` to the table, and ends the row at the end of a line.
+ */
+bool __csv_end_field(csv_parser *parser, size_t end, bool end_of_row);
+
+/**
+ * Returns the content of a quoted field, with doubled quotes unescaped into a copy if there are any.
+ */
+substring __csv_unquote(csv_parser *parser, size_t start, size_t end);
+
+/**
+ * Allocates a table with room for every field and row `str` can hold,
+ * counting each separator and newline as if none of them were quoted.
+ */
+csv_table* __csv_table_init(string str, char separator);
+
+// - Implementation -
+
+csv_table* csv_parse(string str, char separator) {
+    if (!str.ctx) return NULL;
+
+    csv_table *table = __csv_table_init(str, separator);
+    if (!table || !str.value || str.length == 0) return table;
+
+    csv_parser parser;
+    parser.str = str;
+    parser.separator = separator;
+    parser.table = table;
+    parser.field_start = 0;
+
+    // All ones while inside quotes at the end of the previous block
+    uint64_t inside = 0;
+
+    for (size_t block = 0; block < str.length; block += 64) {
+        size_t length = str.length - block < 64 ? str.length - block : 64;
+
+        uint64_t quotes, separators, newlines;
+        __csv_block_masks(str.value + block, length, separator, &quotes, &separators, &newlines);
+
+        // Quoted regions span from an opening quote up to the closing one;
+        // a doubled quote closes and reopens, so it stays inside
+        uint64_t quoted = __string_prefix_xor(quotes) ^ inside;
+        inside = (uint64_t)((int64_t)quoted >> 63);
+
+        uint64_t structural = (separators | newlines) & ~quoted;
+        while (structural) {
+            size_t position = block + __string_ctz64(structural);
+            if (!__csv_end_field(&parser, position, str.value[position] == '\n')) return NULL;
+            parser.field_start = position + 1;
+            structural &= structural - 1;
+        }
+    }
+
+    // The last row, unless the text ends with a newline
+    if (table->field_count > table->rows[table->length] || parser.field_start < str.length) {
+        if (!__csv_end_field(&parser, str.length, true)) return NULL;
+    }
+
+    return table;
+}
+
+size_t csv_row_length(csv_table *table, size_t row) {
+    if (!table || row >= table->length) return 0;
+    return table->rows[row + 1] - table->rows[row];
+}
+
+substring* csv_field(csv_table *table, size_t row, size_t column) {
+    if (column >= csv_row_length(table, row)) return NULL;
+    return &table->fields[table->rows[row] + column];
+}
+
+void __csv_block_masks(const char *value, size_t length, char separator,
+                       uint64_t *quotes, uint64_t *separators, uint64_t *newlines) {
+    uint64_t quote_mask = 0, separator_mask = 0, newline_mask = 0;
+    size_t i = 0;
+#if defined(STRING_SIMD_AVX2)
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i separator32 = _mm256_set1_epi8(separator);
+    const __m256i newline32 = _mm256_set1_epi8('\n');
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(value + i));
+        quote_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, quote32)) << i;
+        separator_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, separator32)) << i;
+        newline_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline32)) << i;
+    }
+#endif
+#if defined(STRING_SIMD_SSE2)
+    const __m128i quote16 = _mm_set1_epi8('"');
+    const __m128i separator16 = _mm_set1_epi8(separator);
+    const __m128i newline16 = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(value + i));
+        quote_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, quote16)) << i;
+        separator_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, separator16)) << i;
+        newline_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline16)) << i;
+    }
+#endif
+    for (; i < length; i++) {
+        if (value[i] == '"') quote_mask |= (uint64_t)1 << i;
+        if (value[i] == separator) separator_mask |= (uint64_t)1 << i;
+        if (value[i] == '\n') newline_mask |= (uint64_t)1 << i;
+    }
+
+    // A quote used as the separator is not a quote
+    if (separator == '"') quote_mask = 0;
+
+    *quotes = quote_mask;
+    *separators = separator_mask;
+    *newlines = newline_mask;
+}
+
+bool __csv_end_field(csv_parser *parser, size_t end, bool end_of_row) {
+    string str = parser->str;
+    csv_table *table = parser->table;
+    size_t start = parser->field_start;
+
+    // CRLF: the '\r' belongs to the line break
+    if (end_of_row && end > start && str.value[end - 1] == '\r') end--;
+
+    substring *field = &table->fields[table->field_count++];
+    if (end - start >= 2 && str.value[start] == '"' && str.value[end - 1] == '"') {
+        *field = __csv_unquote(parser, start + 1, end - 1);
+        if (!field->value) return false;
+    } else {
+        // Views get capacity equal to length, so appending to them never writes into the source
+        field->value = str.value + start;
+        field->length = end - start;
+        field->capacity = end - start;
+        field->ctx = str.ctx;
+    }
+
+    if (end_of_row) {
+        table->rows[++table->length] = table->field_count;
+    }
+    return true;
+}
+
+substring __csv_unquote(csv_parser *parser, size_t start, size_t end) {
+    string str = parser->str;
+    substring result;
+    result.ctx = str.ctx;
+
+    const char *quote = (const char *)memchr(str.value + start, '"', end - start);
+    if (!quote) {
+        result.value = str.value + start;
+        result.length = end - start;
+        result.capacity = end - start;
+        return result;
+    }
+
+    // Doubled quotes: copy, keeping one quote of each pair
+    char *value = (char *)memctx_alloc(str.ctx, end - start + 1);
+    if (!value) {
+        result.value = NULL;
+        return result;
+    }
+
+    size_t length = (size_t)(quote - (str.value + start));
+    memcpy(value, str.value + start, length);
+    for (size_t i = (size_t)(quote - str.value); i < end; i++) {
+        value[length++] = str.value[i];
+        if (str.value[i] == '"' && i + 1 < end && str.value[i + 1] == '"') i++;
+    }
+    value[length] = '\0';
+
+    result.value = value;
+    result.length = length;
+    result.capacity = end - start + 1;
+    return result;
+}
+
+csv_table* __csv_table_init(string str, char separator) {
+    // Sized up front, since copying the fields to grow the array costs as much as finding them
+    size_t structural = 0, newlines = 0;
+    for (size_t block = 0; str.value && block < str.length; block += 64) {
+        size_t length = str.length - block < 64 ? str.length - block : 64;
+
+        uint64_t quote_mask, separator_mask, newline_mask;
+        __csv_block_masks(str.value + block, length, separator, &quote_mask, &separator_mask, &newline_mask);
+        uint64_t any = separator_mask | newline_mask;
+        structural += __string_popcount((uint32_t)any) + __string_popcount((uint32_t)(any >> 32));
+        newlines += __string_popcount((uint32_t)newline_mask) + __string_popcount((uint32_t)(newline_mask >> 32));
+    }
+
+    csv_table *table = (csv_table *)memctx_alloc(str.ctx, sizeof(csv_table));
+    if (!table) return NULL;
+
+    // One field more than there are separators, one row offset more than there are rows
+    table->fields = (substring *)memctx_alloc(str.ctx, sizeof(substring) * (structural + 1));
+    table->rows = (size_t *)memctx_alloc(str.ctx, sizeof(size_t) * (newlines + 2));
+    if (!table->fields || !table->rows) return NULL;
+
+    table->field_count = 0;
+    table->rows[0] = 0;
+    table->length = 0;
+    table->ctx = str.ctx;
+    return table;
+}
+
+#endif
@@ -0,0 +1,218 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all string interning functions.
+
+#ifndef _MEMCTX_INTERN_H_
+#define _MEMCTX_INTERN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "memctx.h"
+#include "memctx_strings.h"
+
+// Number of table slots, must be a power of two
+#ifndef INTERN_POOL_INIT_CAPACITY
+#define INTERN_POOL_INIT_CAPACITY 64
+#endif
+
+// Interned payload layout: [header][characters]['\0'],
+// the string value points to the characters.
+typedef struct memctx_interned_header {
+    uint64_t hash;
+    size_t length;
+} interned_header;
+
+typedef struct memctx_intern_pool {
+    char **slots;
+    size_t count;
+    size_t capacity;
+    MemContext *ctx;
+} intern_pool;
+
+/**
+ * Initializes a new empty intern pool.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for the table and the interned strings.
+ *
+ * Returns a pointer to the pool, or NULL if ctx is NULL or allocation fails.
+ */
+intern_pool* intern_pool_init(MemContext *ctx);
+
+/**
+ * Returns the canonical copy of a string, adding it to the pool if needed.
+ *
+ * Parameters:
+ *  - pool         The intern pool.
+ *  - value        The string to intern.
+ *
+ * Returns the interned string, or an empty `string` object
+ * if pool is NULL, value is NULL, or allocation fails.
+ * Interned strings are shared and must not be modified in place.
+ */
+string __string_intern_string(intern_pool *pool, string value);
+
+/**
+ * Returns the canonical copy of a null-terminated C string,
+ * adding it to the pool if needed.
+ */
+string __string_intern_chars(intern_pool *pool, const char *value);
+
+/**
+ * Returns the canonical copy of a value, adding it to the pool if needed.
+ * Automatically selects the appropriate function based on the type of value.
+ *
+ * Parameters:
+ *  - pool         The intern pool.
+ *  - value        The value to intern (can be either string or char*).
+ *
+ * Returns the interned string.
+ */
+#define string_intern(pool, value) _Generic((value), \
+    string:      __string_intern_string, \
+    char*:       __string_intern_chars, \
+    const char*: __string_intern_chars \
+)(pool, value)
+
+/**
+ * Compares two strings interned in the same pool.
+ * Equal content means the same canonical buffer, so this is a pointer comparison.
+ */
+bool string_interned_equal(string a, string b);
+
+/**
+ * Returns the hash stored with an interned string.
+ * Calling this for strings that were not interned is undefined behavior.
+ */
+uint64_t string_interned_hash(string str);
+
+/**
+ * Rehashes the pool into a table with the specified number of slots.
+ */
+void __intern_pool_resize(intern_pool *pool, size_t capacity);
+
+// - Implementation -
+
+intern_pool* intern_pool_init(MemContext *ctx) {
+    if (!ctx) return NULL;
+
+    intern_pool *pool = (intern_pool *)memctx_alloc(ctx, sizeof(intern_pool));
+    if (!pool) return NULL;
+
+    pool->count = 0;
+    pool->capacity = INTERN_POOL_INIT_CAPACITY;
+    pool->ctx = ctx;
+    pool->slots = (char **)memctx_alloc(ctx, sizeof(char *) * pool->capacity);
+    if (!pool->slots) return NULL;
+    memset(pool->slots, 0, sizeof(char *) * pool->capacity);
+
+    return pool;
+}
+
+string __string_intern_string(intern_pool *pool, string value) {
+    string result = {0};
+    if (!pool || !value.value) return result;
+
+    // Keep load factor under 3/4
+    if ((pool->count + 1) * 4 > pool->capacity * 3) {
+        __intern_pool_resize(pool, pool->capacity * 2);
+        if (pool->count + 1 >= pool->capacity) return result;  // Resize failed
+    }
+
+    uint64_t hash = string_hash(value);
+    size_t mask = pool->capacity - 1;
+    size_t index = (size_t)hash & mask;
+
+    while (pool->slots[index]) {
+        char *slot = pool->slots[index];
+        interned_header *header = (interned_header *)slot - 1;
+        if (header->hash == hash && header->length == value.length &&
+            memcmp(slot, value.value, value.length) == 0) {
+            result.value = slot;
+            result.length = header->length;
+            result.capacity = header->length + 1;
+            result.ctx = pool->ctx;
+            return result;
+        }
+        index = (index + 1) & mask;
+    }
+
+    // Not found: copy the payload after its header
+    interned_header *header = (interned_header *)memctx_alloc(pool->ctx, sizeof(interned_header) + value.length + 1);
+    if (!header) return result;
+    header->hash = hash;
+    header->length = value.length;
+
+    char *slot = (char *)(header + 1);
+    memcpy(slot, value.value, value.length);
+    slot[value.length] = '\0';
+
+    pool->slots[index] = slot;
+    pool->count++;
+
+    result.value = slot;
+    result.length = value.length;
+    result.capacity = value.length + 1;
+    result.ctx = pool->ctx;
+    return result;
+}
+
+string __string_intern_chars(intern_pool *pool, const char *value) {
+    string str = {0};
+    if (!value) return str;
+
+    str.value = (char *)value;
+    str.length = strlen(value);
+    return __string_intern_string(pool, str);
+}
+
+bool string_interned_equal(string a, string b) {
+    return a.value == b.value;
+}
+
+uint64_t string_interned_hash(string str) {
+    return ((interned_header *)str.value - 1)->hash;
+}
+
+void __intern_pool_resize(intern_pool *pool, size_t capacity) {
+    char **slots = (char **)memctx_alloc(pool->ctx, sizeof(char *) * capacity);
+    if (!slots) return;
+    memset(slots, 0, sizeof(char *) * capacity);
+
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < pool->capacity; i++) {
+        char *slot = pool->slots[i];
+        if (!slot) continue;
+
+        size_t index = (size_t)((interned_header *)slot - 1)->hash & mask;
+        while (slots[index]) {
+            index = (index + 1) & mask;
+        }
+        slots[index] = slot;
+    }
+
+    pool->slots = slots;
+    pool->capacity = capacity;
+}
+
+#endif
@@ -0,0 +1,1128 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all JSON parsing and writing functions.
+
+#ifndef _MEMCTX_JSON_H_
+#define _MEMCTX_JSON_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "memctx.h"
+#include "memctx_strings.h"
+#include "memctx_builder.h"
+
+// Maximum nesting of arrays and objects
+#ifndef JSON_MAX_DEPTH
+#define JSON_MAX_DEPTH 1024
+#endif
+
+typedef enum memctx_json_type {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} json_type;
+
+typedef struct memctx_json_value json_value;
+typedef struct memctx_json_member json_member;
+
+struct memctx_json_value {
+    json_type type;
+    union {
+        bool boolean;
+        double number;
+        substring string;
+        struct {
+            json_value *items;
+            size_t length;
+        } array;
+        struct {
+            json_member *members;
+            size_t length;
+        } object;
+    };
+};
+
+struct memctx_json_member {
+    substring key;
+    json_value value;
+};
+
+typedef struct memctx_json_parser {
+    string str;
+    size_t *indices;            // offsets of structural characters, strings quotes and atoms
+    size_t count;
+    size_t next;
+    json_member *scratch;       // children of the containers being parsed
+    size_t scratch_length;
+    size_t scratch_capacity;
+    size_t depth;
+} json_parser;
+
+typedef struct memctx_json_writer {
+    string_builder *sb;
+    size_t depth;
+    bool comma;                 // the next value or key is preceded by a comma
+} json_writer;
+
+/**
+ * Parses a JSON document (RFC 8259).
+ * The document tree is allocated in the string memory context and is freed with it.
+ * Strings without escape sequences are **substring** views into `str`, which are not
+ * null-terminated; only strings with escape sequences are unescaped into copies.
+ *
+ * Parameters:
+ *  - str          The JSON text, e.g. from `string_read_file`.
+ *
+ * Returns the root value, or NULL if the text is not valid JSON (including invalid UTF-8),
+ * nesting is deeper than JSON_MAX_DEPTH, str has no context, or allocation fails.
+ */
+json_value* json_parse(string str);
+
+/**
+ * Looks up an object member by key. If the key occurs several times, the first one is returned.
+ *
+ * Parameters:
+ *  - object       The object value.
+ *  - key          The key (can be either string or char*).
+ *
+ * Returns the member value, or NULL if object is not an object or has no such key.
+ */
+#define json_get(object, key) __json_get(object, __string_arg(key))
+
+/**
+ * Returns an array item by index, or NULL if value is not an array or index is out of range.
+ */
+json_value* json_at(json_value *value, size_t index);
+
+json_value* __json_get(json_value *object, substring key);
+
+/**
+ * Creates a writer that appends JSON text to a string builder.
+ * Calls must form a single valid document: the writer inserts commas and colons,
+ * escapes strings and formats numbers, but does not check the order of calls.
+ *
+ * Parameters:
+ *  - sb           The builder to append to, see `string_builder_build` to get the text.
+ *
+ * Returns a writer allocated in the builder context, or NULL if sb is NULL or allocation fails.
+ */
+json_writer* json_writer_init(string_builder *sb);
+
+/**
+ * Starts or ends an object or an array.
+ */
+void json_write_object_begin(json_writer *w);
+void json_write_object_end(json_writer *w);
+void json_write_array_begin(json_writer *w);
+void json_write_array_end(json_writer *w);
+
+/**
+ * Writes an object key; the next call writes its value.
+ *
+ * Parameters:
+ *  - w            The writer.
+ *  - key          The key (can be either string or char*).
+ */
+#define json_write_key(w, key) __json_write_key(w, __string_arg(key))
+
+/**
+ * Writes a string value, escaping quotes, backslashes and control characters.
+ * The value is expected to be UTF-8 and is copied byte for byte otherwise.
+ *
+ * Parameters:
+ *  - w            The writer.
+ *  - value        The value (can be either string or char*). NULL is written as null.
+ */
+#define json_write_string(w, value) __json_write_string(w, __string_arg(value))
+
+/**
+ * Writes a number. Integers are formatted without printf; doubles are written with the
+ * fewest significant digits that read back to the same value, and non-finite doubles as null.
+ */
+void json_write_i64(json_writer *w, int64_t value);
+void json_write_u64(json_writer *w, uint64_t value);
+void json_write_double(json_writer *w, double value);
+
+/**
+ * Writes true, false or null.
+ */
+void json_write_bool(json_writer *w, bool value);
+void json_write_null(json_writer *w);
+
+void __json_write_key(json_writer *w, substring key);
+
+void __json_write_string(json_writer *w, substring value);
+
+/**
+ * Writes a comma if the previous value is at the same level.
+ */
+void __json_write_separator(json_writer *w);
+
+/**
+ * Appends the JSON string literal of `value`, with quotes.
+ */
+void __json_write_escaped(string_builder *sb, substring value);
+
+/**
+ * Returns the offset of the first byte that needs escaping, or `length` if there is none.
+ */
+size_t __json_escape_find(const char *value, size_t length);
+
+/**
+ * Formats an unsigned integer at the end of a 20-byte buffer.
+ *
+ * Returns the number of digits; they start at buffer + 20 - result.
+ */
+size_t __json_format_u64(uint64_t value, char *buffer);
+
+/**
+ * Formats a finite double into a buffer of at least 32 bytes.
+ *
+ * Returns the length of the text.
+ */
+size_t __json_format_double(double value, char *buffer);
+
+/**
+ * Finds the shortest decimal digits * 10^exponent that reads back as a positive finite double
+ * (Schubfach, R. Giulietti, "The Schubfach way to render doubles"). Among equally short
+ * candidates the one closest to the value wins, ties go to the even one.
+ */
+void __json_shortest_decimal(double value, uint64_t *digits, int *exponent);
+
+/**
+ * Multiplies the 126-bit g1 * 2^63 + g0 by cp and returns the upper bits, rounded to odd.
+ */
+uint64_t __json_round_to_odd(uint64_t g1, uint64_t g0, uint64_t cp);
+
+/**
+ * floor(e * log10(2)) and floor(e * log10(3/4 * 2)) for the exponents of doubles.
+ */
+int __json_floor_log10_pow2(int e);
+int __json_floor_log10_three_quarters_pow2(int e);
+
+/**
+ * Stage 1: builds the index of structural characters, string quotes and atom starts,
+ * 64 bytes at a time.
+ *
+ * Returns false if the text has an unterminated string or a control character inside a string.
+ */
+bool __json_index(json_parser *parser);
+
+/**
+ * Computes character class masks for a 64-byte block.
+ */
+void __json_block_masks(const char *block, uint64_t *quotes, uint64_t *backslashes,
+                        uint64_t *whitespace, uint64_t *operators, uint64_t *controls);
+
+/**
+ * Stage 2: parses the value starting at the next index into *value.
+ */
+bool __json_parse_value(json_parser *parser, json_value *value);
+
+bool __json_parse_container(json_parser *parser, json_value *value, bool is_object);
+
+bool __json_parse_string(json_parser *parser, substring *result);
+
+bool __json_parse_atom(json_parser *parser, size_t start, json_value *value);
+
+/**
+ * Checks the JSON number grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+bool __json_number_valid(const char *value, size_t length);
+
+/**
+ * Decodes the escape sequences of a string into `out`, which must hold `length` bytes.
+ *
+ * Returns the decoded length, or STRING_NOT_FOUND if an escape sequence is invalid.
+ */
+size_t __json_unescape(const char *value, size_t length, char *out);
+
+/**
+ * Returns the value of 4 hex digits, or -1 if one of them is not a hex digit.
+ */
+long __json_hex4(const char *p);
+
+/**
+ * Pushes a member onto the scratch stack.
+ */
+bool __json_push(json_parser *parser, json_member *member);
+
+// - Implementation -
+
+json_value* json_parse(string str) {
+    if (!str.ctx || !str.value) return NULL;
+    if (!string_utf8_valid(str)) return NULL;
+
+    json_parser parser;
+    parser.str = str;
+    parser.indices = NULL;
+    parser.count = 0;
+    parser.next = 0;
+    parser.scratch = NULL;
+    parser.scratch_length = 0;
+    parser.scratch_capacity = 0;
+    parser.depth = 0;
+
+    json_value *root = NULL;
+    if (__json_index(&parser) && parser.count > 0) {
+        root = (json_value *)memctx_alloc(str.ctx, sizeof(json_value));
+        if (root && (!__json_parse_value(&parser, root) || parser.next != parser.count)) {
+            root = NULL;
+        }
+    }
+
+    // The index and the scratch stack are only needed while parsing
+    free(parser.indices);
+    free(parser.scratch);
+    return root;
+}
+
+json_value* json_at(json_value *value, size_t index) {
+    if (!value || value->type != JSON_ARRAY || index >= value->array.length) return NULL;
+    return &value->array.items[index];
+}
+
+json_value* __json_get(json_value *object, substring key) {
+    if (!object || object->type != JSON_OBJECT || !key.value) return NULL;
+
+    for (size_t i = 0; i < object->object.length; i++) {
+        json_member *member = &object->object.members[i];
+        if (member->key.length == key.length && memcmp(member->key.value, key.value, key.length) == 0) {
+            return &member->value;
+        }
+    }
+    return NULL;
+}
+
+bool __json_index(json_parser *parser) {
+    const char *value = parser->str.value;
+    size_t length = parser->str.length;
+
+    size_t capacity = length / 8 + 64;
+    parser->indices = (size_t *)malloc(sizeof(size_t) * capacity);
+    if (!parser->indices) return false;
+
+    // State carried between blocks
+    bool escape_next = false;           // the block starts with an escaped character
+    uint64_t in_string = 0;             // all ones if the block starts inside a string
+    uint64_t previous_scalar = 0;       // 1 if the last byte of the previous block was part of an atom
+
+    for (size_t block = 0; block < length; block += 64) {
+        char padded[64];
+        const char *p = value + block;
+        if (length - block < 64) {
+            // Pad the tail with spaces, which are not structural
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, p, length - block);
+            p = padded;
+        }
+
+        uint64_t quotes, backslashes, whitespace, operators, controls;
+        __json_block_masks(p, &quotes, &backslashes, &whitespace, &operators, &controls);
+
+        // Characters preceded by an odd run of backslashes are escaped
+        uint64_t escaped = 0;
+        if (backslashes || escape_next) {
+            for (int i = 0; i < 64; i++) {
+                if (escape_next) {
+                    escaped |= (uint64_t)1 << i;
+                    escape_next = false;
+                } else if (backslashes & ((uint64_t)1 << i)) {
+                    escape_next = true;
+                }
+            }
+        }
+        quotes &= ~escaped;
+
+        // Bytes from an opening quote up to (not including) the closing quote
+        uint64_t strings = __string_prefix_xor(quotes) ^ in_string;
+        in_string = (uint64_t)((int64_t)strings >> 63);
+
+        if (controls & strings) return false;
+
+        uint64_t scalar = ~(whitespace | operators | quotes | strings);
+        uint64_t atoms = scalar & ~((scalar << 1) | previous_scalar);
+        previous_scalar = scalar >> 63;
+
+        uint64_t structural = (operators & ~strings) | quotes | atoms;
+        while (structural) {
+            if (parser->count == capacity) {
+                capacity *= 2;
+                size_t *indices = (size_t *)realloc(parser->indices, sizeof(size_t) * capacity);
+                if (!indices) return false;
+                parser->indices = indices;
+            }
+            parser->indices[parser->count++] = block + __string_ctz64(structural);
+            structural &= structural - 1;
+        }
+    }
+
+    return in_string == 0;
+}
+
+void __json_block_masks(const char *block, uint64_t *quotes, uint64_t *backslashes,
+                        uint64_t *whitespace, uint64_t *operators, uint64_t *controls) {
+    uint64_t quote_mask = 0, backslash_mask = 0, whitespace_mask = 0, operator_mask = 0, control_mask = 0;
+    size_t i = 0;
+#if defined(STRING_SIMD_AVX2)
+    for (; i < 64; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(block + i));
+        // '[' ']' and '{' '}' differ by 0x20
+        __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))));
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, _mm256_set1_epi8(0x1F)), chunk);
+
+        quote_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))) << i;
+        backslash_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))) << i;
+        whitespace_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws) << i;
+        operator_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+        control_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(control) << i;
+    }
+#elif defined(STRING_SIMD_SSE2)
+    for (; i < 64; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(block + i));
+        __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk);
+
+        quote_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << i;
+        backslash_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << i;
+        whitespace_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(ws) << i;
+        operator_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(op) << i;
+        control_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(control) << i;
+    }
+#endif
+    for (; i < 64; i++) {
+        unsigned char c = (unsigned char)block[i];
+        uint64_t bit = (uint64_t)1 << i;
+        if (c == '"') quote_mask |= bit;
+        if (c == '\\') backslash_mask |= bit;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') whitespace_mask |= bit;
+        if ((c | 0x20) == '{' || (c | 0x20) == '}' || c == ':' || c == ',') operator_mask |= bit;
+        if (c < 0x20) control_mask |= bit;
+    }
+
+    *quotes = quote_mask;
+    *backslashes = backslash_mask;
+    *whitespace = whitespace_mask;
+    *operators = operator_mask;
+    *controls = control_mask;
+}
+
+bool __json_parse_value(json_parser *parser, json_value *value) {
+    if (parser->next == parser->count) return false;
+
+    size_t position = parser->indices[parser->next++];
+    switch (parser->str.value[position]) {
+        case '{':
+            return __json_parse_container(parser, value, true);
+        case '[':
+            return __json_parse_container(parser, value, false);
+        case '"':
+            value->type = JSON_STRING;
+            return __json_parse_string(parser, &value->string);
+        case ']':
+        case '}':
+        case ':':
+        case ',':
+            return false;
+        default:
+            return __json_parse_atom(parser, position, value);
+    }
+}
+
+bool __json_parse_container(json_parser *parser, json_value *value, bool is_object) {
+    if (++parser->depth > JSON_MAX_DEPTH) return false;
+
+    const char *text = parser->str.value;
+    char close = is_object ? '}' : ']';
+    size_t base = parser->scratch_length;
+
+    if (parser->next < parser->count && text[parser->indices[parser->next]] == close) {
+        parser->next++;
+    } else {
+        for (;;) {
+            json_member member;
+            member.key.value = NULL;
+            member.key.length = 0;
+            member.key.capacity = 0;
+            member.key.ctx = NULL;
+
+            if (is_object) {
+                if (parser->next + 1 >= parser->count) return false;
+                if (text[parser->indices[parser->next++]] != '"') return false;
+                if (!__json_parse_string(parser, &member.key)) return false;
+                if (parser->next == parser->count || text[parser->indices[parser->next++]] != ':') return false;
+            }
+            if (!__json_parse_value(parser, &member.value)) return false;
+            if (!__json_push(parser, &member)) return false;
+
+            if (parser->next == parser->count) return false;
+            char separator = text[parser->indices[parser->next++]];
+            if (separator == close) break;
+            if (separator != ',') return false;
+        }
+    }
+
+    // Move the children from the scratch stack into an exact-size array
+    size_t length = parser->scratch_length - base;
+    MemContext *ctx = parser->str.ctx;
+    if (is_object) {
+        value->type = JSON_OBJECT;
+        value->object.length = length;
+        value->object.members = NULL;
+        if (length > 0) {
+            value->object.members = (json_member *)memctx_alloc(ctx, sizeof(json_member) * length);
+            if (!value->object.members) return false;
+            memcpy(value->object.members, parser->scratch + base, sizeof(json_member) * length);
+        }
+    } else {
+        value->type = JSON_ARRAY;
+        value->array.length = length;
+        value->array.items = NULL;
+        if (length > 0) {
+            value->array.items = (json_value *)memctx_alloc(ctx, sizeof(json_value) * length);
+            if (!value->array.items) return false;
+            for (size_t i = 0; i < length; i++) {
+                value->array.items[i] = parser->scratch[base + i].value;
+            }
+        }
+    }
+
+    parser->scratch_length = base;
+    parser->depth--;
+    return true;
+}
+
+bool __json_parse_string(json_parser *parser, substring *result) {
+    // The opening quote was consumed, the closing quote is the next index
+    if (parser->next == parser->count) return false;
+
+    size_t open = parser->indices[parser->next - 1];
+    size_t close = parser->indices[parser->next++];
+    const char *text = parser->str.value;
+    if (text[close] != '"') return false;
+
+    const char *value = text + open + 1;
+    size_t length = close - open - 1;
+    result->ctx = parser->str.ctx;
+
+    if (!memchr(value, '\\', length)) {
+        result->value = (char *)value;
+        result->length = length;
+        result->capacity = length;
+        return true;
+    }
+
+    // Unescaped text is never longer than the escaped text
+    char *out = (char *)memctx_alloc(parser->str.ctx, length + 1);
+    if (!out) return false;
+    size_t out_length = __json_unescape(value, length, out);
+    if (out_length == STRING_NOT_FOUND) return false;
+    out[out_length] = '\0';
+
+    result->value = out;
+    result->length = out_length;
+    result->capacity = length + 1;
+    return true;
+}
+
+bool __json_parse_atom(json_parser *parser, size_t start, json_value *value) {
+    const char *text = parser->str.value;
+    size_t length = parser->str.length;
+
+    // An atom ends at whitespace, an operator or a quote
+    size_t end = start;
+    while (end < length) {
+        unsigned char c = (unsigned char)text[end];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '"' ||
+            c == ',' || c == ':' || (c | 0x20) == '{' || (c | 0x20) == '}') break;
+        end++;
+    }
+
+    substring atom = {(char *)text + start, end - start, end - start, NULL};
+    if (atom.length == 4 && memcmp(atom.value, "null", 4) == 0) {
+        value->type = JSON_NULL;
+        return true;
+    }
+    if (atom.length == 4 && memcmp(atom.value, "true", 4) == 0) {
+        value->type = JSON_BOOL;
+        value->boolean = true;
+        return true;
+    }
+    if (atom.length == 5 && memcmp(atom.value, "false", 5) == 0) {
+        value->type = JSON_BOOL;
+        value->boolean = false;
+        return true;
+    }
+
+    if (!__json_number_valid(atom.value, atom.length)) return false;
+    value->type = JSON_NUMBER;
+    return substring_to_double(atom, &value->number) == STRING_PARSE_OK;
+}
+
+bool __json_number_valid(const char *value, size_t length) {
+    size_t i = 0;
+    if (i < length && value[i] == '-') i++;
+
+    if (i < length && value[i] == '0') {
+        i++;
+    } else if (i < length && value[i] >= '1' && value[i] <= '9') {
+        while (i < length && value[i] >= '0' && value[i] <= '9') i++;
+    } else {
+        return false;
+    }
+
+    if (i < length && value[i] == '.') {
+        i++;
+        size_t digits = i;
+        while (i < length && value[i] >= '0' && value[i] <= '9') i++;
+        if (i == digits) return false;
+    }
+
+    if (i < length && (value[i] == 'e' || value[i] == 'E')) {
+        i++;
+        if (i < length && (value[i] == '+' || value[i] == '-')) i++;
+        size_t digits = i;
+        while (i < length && value[i] >= '0' && value[i] <= '9') i++;
+        if (i == digits) return false;
+    }
+
+    return i == length;
+}
+
+long __json_hex4(const char *p) {
+    long result = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return -1;
+        result = result * 16 + digit;
+    }
+    return result;
+}
+
+size_t __json_unescape(const char *value, size_t length, char *out) {
+    size_t o = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (value[i] != '\\') {
+            out[o++] = value[i];
+            continue;
+        }
+
+        if (++i == length) return STRING_NOT_FOUND;
+        switch (value[i]) {
+            case '"':  out[o++] = '"';  break;
+            case '\\': out[o++] = '\\'; break;
+            case '/':  out[o++] = '/';  break;
+            case 'b':  out[o++] = '\b'; break;
+            case 'f':  out[o++] = '\f'; break;
+            case 'n':  out[o++] = '\n'; break;
+            case 'r':  out[o++] = '\r'; break;
+            case 't':  out[o++] = '\t'; break;
+            case 'u': {
+                if (length - i < 5) return STRING_NOT_FOUND;
+                long code = __json_hex4(value + i + 1);
+                if (code < 0) return STRING_NOT_FOUND;
+                i += 4;
+
+                // A high surrogate must be followed by an escaped low surrogate
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    if (length - i < 7 || value[i + 1] != '\\' || value[i + 2] != 'u') return STRING_NOT_FOUND;
+                    long low = __json_hex4(value + i + 3);
+                    if (low < 0xDC00 || low > 0xDFFF) return STRING_NOT_FOUND;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return STRING_NOT_FOUND;
+                }
+
+                if (code < 0x80) {
+                    out[o++] = (char)code;
+                } else if (code < 0x800) {
+                    out[o++] = (char)(0xC0 | (code >> 6));
+                    out[o++] = (char)(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    out[o++] = (char)(0xE0 | (code >> 12));
+                    out[o++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                    out[o++] = (char)(0x80 | (code & 0x3F));
+                } else {
+                    out[o++] = (char)(0xF0 | (code >> 18));
+                    out[o++] = (char)(0x80 | ((code >> 12) & 0x3F));
+                    out[o++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                    out[o++] = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                return STRING_NOT_FOUND;
+        }
+    }
+    return o;
+}
+
+bool __json_push(json_parser *parser, json_member *member) {
+    if (parser->scratch_length == parser->scratch_capacity) {
+        size_t capacity = parser->scratch_capacity ? parser->scratch_capacity * 2 : 64;
+        json_member *scratch = (json_member *)realloc(parser->scratch, sizeof(json_member) * capacity);
+        if (!scratch) return false;
+        parser->scratch = scratch;
+        parser->scratch_capacity = capacity;
+    }
+    parser->scratch[parser->scratch_length++] = *member;
+    return true;
+}
+
+json_writer* json_writer_init(string_builder *sb) {
+    if (!sb) return NULL;
+
+    json_writer *w = (json_writer *)memctx_alloc(sb->ctx, sizeof(json_writer));
+    if (!w) return NULL;
+
+    w->sb = sb;
+    w->depth = 0;
+    w->comma = false;
+    return w;
+}
+
+void json_write_object_begin(json_writer *w) {
+    if (!w) return;
+    __json_write_separator(w);
+    __string_builder_append_n(w->sb, "{", 1);
+    w->depth++;
+    w->comma = false;
+}
+
+void json_write_object_end(json_writer *w) {
+    if (!w) return;
+    __string_builder_append_n(w->sb, "}", 1);
+    w->depth--;
+    w->comma = true;
+}
+
+void json_write_array_begin(json_writer *w) {
+    if (!w) return;
+    __json_write_separator(w);
+    __string_builder_append_n(w->sb, "[", 1);
+    w->depth++;
+    w->comma = false;
+}
+
+void json_write_array_end(json_writer *w) {
+    if (!w) return;
+    __string_builder_append_n(w->sb, "]", 1);
+    w->depth--;
+    w->comma = true;
+}
+
+void __json_write_key(json_writer *w, substring key) {
+    if (!w) return;
+    __json_write_separator(w);
+    __json_write_escaped(w->sb, key);
+    __string_builder_append_n(w->sb, ":", 1);
+    w->comma = false;
+}
+
+void __json_write_string(json_writer *w, substring value) {
+    if (!w) return;
+    if (!value.value) {
+        json_write_null(w);
+        return;
+    }
+    __json_write_separator(w);
+    __json_write_escaped(w->sb, value);
+    w->comma = true;
+}
+
+void json_write_i64(json_writer *w, int64_t value) {
+    if (!w) return;
+    __json_write_separator(w);
+
+    char buffer[21];
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    size_t length = __json_format_u64(magnitude, buffer + 1);
+    char *start = buffer + 21 - length;
+    if (value < 0) {
+        *--start = '-';
+        length++;
+    }
+    __string_builder_append_n(w->sb, start, length);
+    w->comma = true;
+}
+
+void json_write_u64(json_writer *w, uint64_t value) {
+    if (!w) return;
+    __json_write_separator(w);
+
+    char buffer[20];
+    size_t length = __json_format_u64(value, buffer);
+    __string_builder_append_n(w->sb, buffer + 20 - length, length);
+    w->comma = true;
+}
+
+void json_write_double(json_writer *w, double value) {
+    if (!w) return;
+    if (!isfinite(value)) {
+        json_write_null(w);
+        return;
+    }
+    __json_write_separator(w);
+
+    char buffer[32];
+    size_t length = __json_format_double(value, buffer);
+    __string_builder_append_n(w->sb, buffer, length);
+    w->comma = true;
+}
+
+void json_write_bool(json_writer *w, bool value) {
+    if (!w) return;
+    __json_write_separator(w);
+    if (value) {
+        __string_builder_append_n(w->sb, "true", 4);
+    } else {
+        __string_builder_append_n(w->sb, "false", 5);
+    }
+    w->comma = true;
+}
+
+void json_write_null(json_writer *w) {
+    if (!w) return;
+    __json_write_separator(w);
+    __string_builder_append_n(w->sb, "null", 4);
+    w->comma = true;
+}
+
+void __json_write_separator(json_writer *w) {
+    if (w->comma) {
+        __string_builder_append_n(w->sb, ",", 1);
+    }
+}
+
+void __json_write_escaped(string_builder *sb, substring value) {
+    static const char hex[] = "0123456789abcdef";
+
+    __string_builder_append_n(sb, "\"", 1);
+
+    // Append runs that need no escaping as they are
+    const char *p = value.value;
+    size_t length = value.length;
+    while (length > 0) {
+        size_t run = __json_escape_find(p, length);
+        __string_builder_append_n(sb, p, run);
+        if (run == length) break;
+
+        unsigned char c = (unsigned char)p[run];
+        char escape[6] = {'\\', 0, 0, 0, 0, 0};
+        size_t escape_length = 2;
+        switch (c) {
+            case '"':  escape[1] = '"';  break;
+            case '\\': escape[1] = '\\'; break;
+            case '\b': escape[1] = 'b';  break;
+            case '\f': escape[1] = 'f';  break;
+            case '\n': escape[1] = 'n';  break;
+            case '\r': escape[1] = 'r';  break;
+            case '\t': escape[1] = 't';  break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex[c >> 4];
+                escape[5] = hex[c & 15];
+                escape_length = 6;
+                break;
+        }
+        __string_builder_append_n(sb, escape, escape_length);
+
+        p += run + 1;
+        length -= run + 1;
+    }
+
+    __string_builder_append_n(sb, "\"", 1);
+}
+
+size_t __json_escape_find(const char *value, size_t length) {
+    size_t i = 0;
+#if defined(STRING_SIMD_AVX2)
+    for (; i + 32 <= length; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(value + i));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, _mm256_set1_epi8(0x1F)), chunk));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+        if (mask) return i + __string_ctz(mask);
+    }
+#endif
+#if defined(STRING_SIMD_SSE2)
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(value + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+        if (mask) return i + __string_ctz(mask);
+    }
+#endif
+    for (; i < length; i++) {
+        unsigned char c = (unsigned char)value[i];
+        if (c == '"' || c == '\\' || c < 0x20) return i;
+    }
+    return length;
+}
+
+// "00" "01" ... "99"
+static const char __json_digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+size_t __json_format_u64(uint64_t value, char *buffer) {
+    char *p = buffer + 20;
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--p = __json_digit_pairs[pair + 1];
+        *--p = __json_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        *--p = __json_digit_pairs[pair + 1];
+        *--p = __json_digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return (size_t)(buffer + 20 - p);
+}
+
+size_t __json_format_double(double value, char *buffer) {
+    size_t length = 0;
+    if (signbit(value)) {
+        buffer[length++] = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        buffer[length++] = '0';
+        return length;
+    }
+
+    // Values with up to 3 decimals, like prices, are m / 10^k for an exact integer m;
+    // the smallest such k gives the shortest digits without the general algorithm.
+    // Below 2^50 the spacing of doubles near value is under 10^-k / 2, so no other
+    // m reads back to value and m is also the closest candidate
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    for (int k = 0; k <= 3; k++) {
+        double scaled = value * __string_pow10[k];
+        if (scaled >= 1125899906842624.0) break;   // 2^50
+        uint64_t m = (uint64_t)(scaled + 0.5);
+        if ((double)m / __string_pow10[k] == value) {
+            mantissa = m;
+            exponent = -k;
+            break;
+        }
+    }
+    if (mantissa == 0) {
+        __json_shortest_decimal(value, &mantissa, &exponent);
+    }
+
+    char digits[20];
+    size_t count = __json_format_u64(mantissa, digits);
+    const char *first = digits + 20 - count;
+    int point = (int)count + exponent;   // digits before the decimal point
+
+    if (exponent >= 0 && point <= 16) {
+        // Integers below 10^16: ddd000
+        memcpy(buffer + length, first, count);
+        length += count;
+        for (int i = 0; i < exponent; i++) buffer[length++] = '0';
+    } else if (exponent < 0 && point > 0) {
+        // ddd.ddd
+        memcpy(buffer + length, first, (size_t)point);
+        length += (size_t)point;
+        buffer[length++] = '.';
+        memcpy(buffer + length, first + point, count - (size_t)point);
+        length += count - (size_t)point;
+    } else if (exponent < 0 && -exponent <= 17) {
+        // 0.000ddd
+        buffer[length++] = '0';
+        buffer[length++] = '.';
+        for (int i = point; i < 0; i++) buffer[length++] = '0';
+        memcpy(buffer + length, first, count);
+        length += count;
+    } else {
+        // d.ddde+x, like %g
+        buffer[length++] = first[0];
+        if (count > 1) {
+            buffer[length++] = '.';
+            memcpy(buffer + length, first + 1, count - 1);
+            length += count - 1;
+        }
+        int e = point - 1;
+        buffer[length++] = 'e';
+        buffer[length++] = e < 0 ? '-' : '+';
+        char e_digits[20];
+        size_t e_count = __json_format_u64((uint64_t)(e < 0 ? -e : e), e_digits);
+        memcpy(buffer + length, e_digits + 20 - e_count, e_count);
+        length += e_count;
+    }
+    return length;
+}
+
+void __json_shortest_decimal(double value, uint64_t *digits, int *exponent) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint64_t t = bits & (((uint64_t)1 << 52) - 1);
+    int bq = (int)(bits >> 52) & 0x7FF;
+
+    // value = c * 2^q
+    const uint64_t c_min = (uint64_t)1 << 52;
+    uint64_t c;
+    int q;
+    if (bq != 0) {
+        c = c_min | t;
+        q = bq - 1075;
+        // Integers below 2^53 are their own shortest form
+        if (q < 0 && q > -53 && (c & (((uint64_t)1 << -q) - 1)) == 0) {
+            c >>= -q;
+            int e = 0;
+            while (c % 10 == 0) {
+                c /= 10;
+                e++;
+            }
+            *digits = c;
+            *exponent = e;
+            return;
+        }
+    } else {
+        c = t;
+        q = -1074;
+    }
+
+    // The rounding interval is (cbl, cbr) * 2^(q-2), narrower below at powers of two
+    uint64_t out = c & 1;
+    uint64_t cb = c << 2;
+    uint64_t cbr = cb + 2;
+    uint64_t cbl;
+    int k;
+    if (c != c_min || q == -1074) {
+        cbl = cb - 2;
+        k = __json_floor_log10_pow2(q);
+    } else {
+        cbl = cb - 1;
+        k = __json_floor_log10_three_quarters_pow2(q);
+    }
+    int h = q + __memctx_floor_log2_pow10(-k) + 2;
+    const uint64_t *g = __memctx_pow10_g[k - MEMCTX_POW10_K_MIN];
+
+    // The bounds and the value scaled by 10^-k, with 2 fraction bits
+    uint64_t vb = __json_round_to_odd(g[0], g[1], cb << h);
+    uint64_t vbl = __json_round_to_odd(g[0], g[1], cbl << h);
+    uint64_t vbr = __json_round_to_odd(g[0], g[1], cbr << h);
+
+    uint64_t s = vb >> 2;
+    if (s >= 10) {
+        // One digit fewer, if exactly one of its neighbours is inside the interval
+        uint64_t sp10 = s / 10 * 10;
+        uint64_t tp10 = sp10 + 10;
+        bool upin = vbl + out <= sp10 << 2;
+        bool wpin = (tp10 << 2) + out <= vbr;
+        if (upin != wpin) {
+            c = upin ? sp10 : tp10;
+            goto trim;
+        }
+    }
+    {
+        uint64_t next = s + 1;
+        bool uin = vbl + out <= s << 2;
+        bool win = (next << 2) + out <= vbr;
+        if (uin != win) {
+            c = uin ? s : next;
+        } else {
+            // Both or neither are inside: take the closer one, the even one on a tie
+            int64_t cmp = (int64_t)(vb - ((s + next) << 1));
+            c = cmp < 0 || (cmp == 0 && (s & 1) == 0) ? s : next;
+        }
+    }
+
+trim:
+    // Short decimals come out padded to 16 or 17 digits; drop the zeros in large steps first
+    while (c % 100000000 == 0) {
+        c /= 100000000;
+        k += 8;
+    }
+    if (c % 10000 == 0) {
+        c /= 10000;
+        k += 4;
+    }
+    if (c % 100 == 0) {
+        c /= 100;
+        k += 2;
+    }
+    if (c % 10 == 0) {
+        c /= 10;
+        k++;
+    }
+    *digits = c;
+    *exponent = k;
+}
+
+uint64_t __json_round_to_odd(uint64_t g1, uint64_t g0, uint64_t cp) {
+    // g * cp = g1 * cp * 2^63 + g0 * cp; the result is that product over 2^127
+    uint64_t x0 = g0, x1 = cp;
+    __string_hash_multiply(&x0, &x1);
+    uint64_t y0 = g1, y1 = cp;
+    __string_hash_multiply(&y0, &y1);
+    const uint64_t low63 = ((uint64_t)1 << 63) - 1;
+    uint64_t z = (y0 >> 1) + x1;
+    uint64_t vbp = y1 + (z >> 63);
+    // Set the lowest bit when any bits below were dropped
+    return vbp | (((z & low63) + low63) >> 63);
+}
+
+int __json_floor_log10_pow2(int e) {
+    // Multiplying by 2^41 log10(2) rounded down; the bias keeps the shift on non-negative values
+    return (int)((uint64_t)((int64_t)e * 661971961083LL + ((int64_t)1 << 52)) >> 41) - (1 << 11);
+}
+
+int __json_floor_log10_three_quarters_pow2(int e) {
+    return (int)((uint64_t)((int64_t)e * 661971961083LL - 274743187321LL + ((int64_t)1 << 52)) >> 41) - (1 << 11);
+}
+
+#endif
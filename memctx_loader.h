@@ -0,0 +1,678 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all asynchronous file loading functions.
+// Reads are submitted through io_uring on Linux, or handed to a pool of threads elsewhere.
+
+#ifndef _MEMCTX_LOADER_H_
+#define _MEMCTX_LOADER_H_
+
+// io_uring is reached through syscall(), which unistd.h declares only with _DEFAULT_SOURCE.
+// The macro takes effect only before the first system header, so include this header first
+// (or build with -D_DEFAULT_SOURCE); otherwise the loader uses its thread pool.
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "memctx.h"
+#include "memctx_strings.h"
+
+#if defined(__linux__) && defined(__has_include) && defined(__USE_MISC)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#define FILE_LOADER_IO_URING_SUPPORTED 1
+#endif
+#endif
+
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+#ifndef IORING_FEAT_SINGLE_MMAP
+#define IORING_FEAT_SINGLE_MMAP (1U << 0)
+#endif
+#endif
+
+// Files read at the same time when no queue depth is given
+#ifndef FILE_LOADER_DEPTH
+#define FILE_LOADER_DEPTH 32
+#endif
+
+// Threads started by the fallback backend, at most one per queued read
+#ifndef FILE_LOADER_THREADS_MAX
+#define FILE_LOADER_THREADS_MAX 8
+#endif
+
+// Largest single read request; larger files are read in several requests
+#ifndef FILE_LOADER_READ_MAX
+#define FILE_LOADER_READ_MAX (1 << 30)
+#endif
+
+typedef enum {
+    FILE_LOADER_AUTO,           // io_uring if the kernel allows it, threads otherwise
+    FILE_LOADER_IO_URING,
+    FILE_LOADER_THREADS
+} file_loader_backend;
+
+typedef struct memctx_loaded_file {
+    string content;             // file content in its own context block, empty value on error
+    const char *filename;
+    size_t index;               // order in which the file was added
+    int error;                  // 0, or the errno value of the failed call
+} loaded_file;
+
+typedef struct memctx_file_request {
+    char *filename;
+    size_t index;
+    int fd;
+    char *data;
+    size_t size;
+    size_t done;                // bytes read so far
+    int error;
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    struct iovec iov;           // read by the kernel until the request completes
+    bool reading;               // handed to the ring, completion not reaped yet
+    struct memctx_file_request *added_next;     // next request added to the loader
+#endif
+    struct memctx_file_request *next;
+} file_request;
+
+typedef struct memctx_file_loader {
+    file_loader_backend backend;
+    size_t depth;
+    size_t count;               // files added
+    size_t in_flight;           // files opened and not yet returned
+
+    file_request *pending;      // added, not opened yet
+    file_request *pending_tail;
+    file_request *ready;        // finished without a read (errors, empty files)
+    file_request *ready_tail;
+
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    int ring_fd;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned to_submit;
+    int ring_error;             // errno that made the ring unusable, 0 while it works
+    file_request *added;        // every request, to find the ones the ring still holds
+#endif
+
+    pthread_t *threads;
+    size_t thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    file_request *work;         // waiting for a thread
+    file_request *work_tail;
+    file_request *done;         // read by a thread
+    file_request *done_tail;
+    bool stop;
+
+    MemContext *ctx;
+} file_loader;
+
+/**
+ * Initializes a file loader. Files are loaded into their own blocks of the memory context,
+ * like `string_read_file`, and can be released early with `string_free_file`.
+ * The context itself is only used by the calling thread.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - depth        The number of files read at the same time, FILE_LOADER_DEPTH if 0.
+ *  - backend      FILE_LOADER_AUTO, or a backend to require.
+ *
+ * Returns a pointer to the loader, or NULL if ctx is NULL,
+ * the required backend is unavailable, or allocation fails.
+ */
+file_loader* file_loader_init(MemContext *ctx, size_t depth, file_loader_backend backend);
+
+/**
+ * Queues a file for loading. Up to `depth` files are opened and read at a time,
+ * the rest wait until earlier files are returned by `file_loader_next`.
+ *
+ * Parameters:
+ *  - loader       The loader.
+ *  - filename     Path to the file to be read. The path is copied.
+ *
+ * Returns true if the file was queued. Errors opening or reading it are reported by `file_loader_next`.
+ */
+bool file_loader_add(file_loader *loader, const char *filename);
+
+/**
+ * Waits for the next file to finish loading. Files are returned in completion order,
+ * not in the order they were added.
+ *
+ * Parameters:
+ *  - loader       The loader.
+ *  - file         Receives the loaded file, or the error that stopped it.
+ *
+ * Returns true if a file was returned, false when every added file has been returned.
+ */
+bool file_loader_next(file_loader *loader, loaded_file *file);
+
+/**
+ * Waits for reads in progress, closes open files and releases the io_uring instance or threads.
+ * Files already returned stay in the memory context. Must be called before the context is freed.
+ *
+ * Parameters:
+ *  - loader       The loader to close.
+ */
+void file_loader_close(file_loader *loader);
+
+/**
+ * Opens queued files, allocates their blocks and submits their reads, up to the queue depth.
+ */
+void __file_loader_fill(file_loader *loader);
+
+/**
+ * Submits a read for the rest of a request. Returns false if it cannot be submitted.
+ */
+bool __file_loader_submit(file_loader *loader, file_request *request);
+
+/**
+ * Waits for a read to finish. Short reads are submitted again.
+ * If the ring cannot be waited on, every read it holds fails with the errno of the failed call.
+ * Returns the finished request, or NULL if nothing is in progress.
+ */
+file_request* __file_loader_wait(file_loader *loader);
+
+/**
+ * Closes the request file and moves the result to `file`.
+ */
+void __file_loader_finish(file_loader *loader, file_request *request, loaded_file *file);
+
+/**
+ * Appends a request to a singly linked queue.
+ */
+void __file_loader_push(file_request **head, file_request **tail, file_request *request);
+
+/**
+ * Removes the first request of a queue. Returns NULL if the queue is empty.
+ */
+file_request* __file_loader_pop(file_request **head, file_request **tail);
+
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+/**
+ * Sets up an io_uring instance with room for `depth` reads. Returns false if the kernel refuses it.
+ */
+bool __file_loader_uring_setup(file_loader *loader);
+
+/**
+ * Fails every read the ring still holds with `error` and moves it to the ready queue.
+ * Their blocks are left to the context, since the kernel may still write to them.
+ */
+void __file_loader_uring_fail(file_loader *loader, int error);
+
+void __file_loader_uring_release(file_loader *loader);
+#endif
+
+/**
+ * Starts the fallback reader threads. Returns false if no thread can be started.
+ */
+bool __file_loader_threads_start(file_loader *loader);
+
+/**
+ * Body of a fallback reader thread: reads whole files until the loader stops.
+ */
+void* __file_loader_thread(void *arg);
+
+// - Implementation -
+
+file_loader* file_loader_init(MemContext *ctx, size_t depth, file_loader_backend backend) {
+    if (!ctx) return NULL;
+
+    file_loader *loader = (file_loader *)memctx_alloc(ctx, sizeof(file_loader));
+    if (!loader) return NULL;
+
+    memset(loader, 0, sizeof(file_loader));
+    loader->depth = depth ? depth : FILE_LOADER_DEPTH;
+    loader->ctx = ctx;
+
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    loader->ring_fd = -1;
+    if (backend != FILE_LOADER_THREADS && __file_loader_uring_setup(loader)) {
+        loader->backend = FILE_LOADER_IO_URING;
+        return loader;
+    }
+#endif
+    if (backend == FILE_LOADER_IO_URING) return NULL;
+
+    loader->backend = FILE_LOADER_THREADS;
+    if (!__file_loader_threads_start(loader)) return NULL;
+    return loader;
+}
+
+bool file_loader_add(file_loader *loader, const char *filename) {
+    if (!loader || !filename) return false;
+
+    file_request *request = (file_request *)memctx_alloc(loader->ctx, sizeof(file_request));
+    string name = string_make(loader->ctx, filename);
+    if (!request || !name.value) return false;
+
+    memset(request, 0, sizeof(file_request));
+    request->filename = name.value;
+    request->index = loader->count++;
+    request->fd = -1;
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    request->added_next = loader->added;
+    loader->added = request;
+#endif
+
+    __file_loader_push(&loader->pending, &loader->pending_tail, request);
+    __file_loader_fill(loader);
+    return true;
+}
+
+bool file_loader_next(file_loader *loader, loaded_file *file) {
+    if (!loader || !file) return false;
+
+    __file_loader_fill(loader);
+
+    file_request *request = __file_loader_pop(&loader->ready, &loader->ready_tail);
+    if (!request) request = __file_loader_wait(loader);
+    if (!request) return false;
+
+    __file_loader_finish(loader, request, file);
+    __file_loader_fill(loader);
+    return true;
+}
+
+void file_loader_close(file_loader *loader) {
+    if (!loader) return;
+
+    file_request *request;
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    if (loader->backend == FILE_LOADER_IO_URING) {
+        // The kernel writes into context blocks until each read completes;
+        // wait only stops once the ring holds no read, so the release below is safe
+        while ((request = __file_loader_wait(loader)) != NULL) {
+            loaded_file ignored;
+            __file_loader_finish(loader, request, &ignored);
+        }
+        __file_loader_uring_release(loader);
+    }
+#endif
+    if (loader->backend == FILE_LOADER_THREADS && loader->threads) {
+        pthread_mutex_lock(&loader->lock);
+        loader->stop = true;
+        pthread_cond_broadcast(&loader->work_ready);
+        pthread_mutex_unlock(&loader->lock);
+
+        for (size_t i = 0; i < loader->thread_count; i++) {
+            pthread_join(loader->threads[i], NULL);
+        }
+        pthread_mutex_destroy(&loader->lock);
+        pthread_cond_destroy(&loader->work_ready);
+        pthread_cond_destroy(&loader->work_done);
+        loader->threads = NULL;
+
+        while ((request = __file_loader_pop(&loader->work, &loader->work_tail)) != NULL) {
+            if (request->fd >= 0) close(request->fd);
+        }
+        while ((request = __file_loader_pop(&loader->done, &loader->done_tail)) != NULL) {
+            if (request->fd >= 0) close(request->fd);
+        }
+    }
+
+    while ((request = __file_loader_pop(&loader->ready, &loader->ready_tail)) != NULL) {
+        if (request->fd >= 0) close(request->fd);
+    }
+    loader->pending = NULL;
+    loader->pending_tail = NULL;
+    loader->in_flight = 0;
+}
+
+void __file_loader_fill(file_loader *loader) {
+    while (loader->pending && loader->in_flight < loader->depth) {
+        file_request *request = __file_loader_pop(&loader->pending, &loader->pending_tail);
+        loader->in_flight++;
+
+        struct stat info;
+        request->fd = open(request->filename, O_RDONLY);
+        if (request->fd < 0 || fstat(request->fd, &info) != 0) {
+            request->error = errno;
+        } else if (!S_ISREG(info.st_mode)) {
+            request->error = S_ISDIR(info.st_mode) ? EISDIR : EINVAL;
+        } else {
+            // Allocated here, so the context is only touched by the calling thread
+            request->size = (size_t)info.st_size;
+            request->data = __memctx_file_block(loader->ctx, request->size);
+            if (!request->data) request->error = ENOMEM;
+        }
+
+        if (request->error || request->size == 0 || !__file_loader_submit(loader, request)) {
+            __file_loader_push(&loader->ready, &loader->ready_tail, request);
+        }
+    }
+
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    if (loader->backend == FILE_LOADER_IO_URING && loader->to_submit > 0 && !loader->ring_error) {
+        long submitted = syscall(__NR_io_uring_enter, loader->ring_fd, loader->to_submit, 0, 0, NULL, 0);
+        if (submitted > 0) loader->to_submit -= (unsigned)submitted;
+    }
+#endif
+}
+
+bool __file_loader_submit(file_loader *loader, file_request *request) {
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    if (loader->backend == FILE_LOADER_IO_URING) {
+        if (loader->ring_error) {
+            request->error = loader->ring_error;
+            return false;
+        }
+
+        size_t length = request->size - request->done;
+        if (length > FILE_LOADER_READ_MAX) length = FILE_LOADER_READ_MAX;
+        request->iov.iov_base = request->data + request->done;
+        request->iov.iov_len = length;
+
+        // Only this thread produces entries, the kernel consumes them
+        unsigned tail = *loader->sq_tail;
+        unsigned index = tail & *loader->sq_mask;
+        struct io_uring_sqe *sqe = &loader->sqes[index];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = request->fd;
+        sqe->off = request->done;
+        sqe->addr = (uint64_t)(uintptr_t)&request->iov;
+        sqe->len = 1;
+        sqe->user_data = (uint64_t)(uintptr_t)request;
+        loader->sq_array[index] = index;
+        __atomic_store_n(loader->sq_tail, tail + 1, __ATOMIC_RELEASE);
+        loader->to_submit++;
+        request->reading = true;
+        return true;
+    }
+#endif
+    pthread_mutex_lock(&loader->lock);
+    __file_loader_push(&loader->work, &loader->work_tail, request);
+    pthread_cond_signal(&loader->work_ready);
+    pthread_mutex_unlock(&loader->lock);
+    return true;
+}
+
+file_request* __file_loader_wait(file_loader *loader) {
+    size_t waiting = loader->in_flight;
+    for (file_request *request = loader->ready; request; request = request->next) waiting--;
+    if (waiting == 0) return NULL;
+
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    if (loader->backend == FILE_LOADER_IO_URING) {
+        for (;;) {
+            unsigned head = *loader->cq_head;
+            if (head != __atomic_load_n(loader->cq_tail, __ATOMIC_ACQUIRE)) {
+                struct io_uring_cqe *cqe = &loader->cqes[head & *loader->cq_mask];
+                file_request *request = (file_request *)(uintptr_t)cqe->user_data;
+                int result = cqe->res;
+                __atomic_store_n(loader->cq_head, head + 1, __ATOMIC_RELEASE);
+                request->reading = false;
+
+                if (result < 0) {
+                    request->error = -result;
+                } else if (result == 0) {
+                    request->error = EIO;    // the file was truncated while reading
+                } else {
+                    request->done += (size_t)result;
+                    if (request->done < request->size && __file_loader_submit(loader, request)) {
+                        __file_loader_fill(loader);
+                        continue;
+                    }
+                }
+                return request;
+            }
+
+            long entered = syscall(__NR_io_uring_enter, loader->ring_fd, loader->to_submit, 1,
+                                   IORING_ENTER_GETEVENTS, NULL, 0);
+            if (entered >= 0) {
+                loader->to_submit -= (unsigned)entered;
+            } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                __file_loader_uring_fail(loader, errno);
+                return __file_loader_pop(&loader->ready, &loader->ready_tail);
+            }
+        }
+    }
+#endif
+    pthread_mutex_lock(&loader->lock);
+    while (!loader->done) {
+        pthread_cond_wait(&loader->work_done, &loader->lock);
+    }
+    file_request *request = __file_loader_pop(&loader->done, &loader->done_tail);
+    pthread_mutex_unlock(&loader->lock);
+    return request;
+}
+
+void __file_loader_finish(file_loader *loader, file_request *request, loaded_file *file) {
+    if (request->fd >= 0) {
+        close(request->fd);
+        request->fd = -1;
+    }
+    loader->in_flight--;
+
+    file->filename = request->filename;
+    file->index = request->index;
+    file->error = request->error;
+    file->content = (string){0};
+    file->content.ctx = loader->ctx;
+
+    if (request->error) {
+        if (request->data) memctx_free_file(loader->ctx, request->data);
+        return;
+    }
+
+    // Empty files have no block of their own
+    if (request->size == 0) {
+        file->content = string_init(loader->ctx);
+        return;
+    }
+
+    file->content.value = request->data;
+    file->content.length = request->size;
+    file->content.capacity = request->size + 1;
+}
+
+void __file_loader_push(file_request **head, file_request **tail, file_request *request) {
+    request->next = NULL;
+    if (*tail) {
+        (*tail)->next = request;
+    } else {
+        *head = request;
+    }
+    *tail = request;
+}
+
+file_request* __file_loader_pop(file_request **head, file_request **tail) {
+    file_request *request = *head;
+    if (!request) return NULL;
+
+    *head = request->next;
+    if (!*head) *tail = NULL;
+    request->next = NULL;
+    return request;
+}
+
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+bool __file_loader_uring_setup(file_loader *loader) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    long fd = syscall(__NR_io_uring_setup, (unsigned)loader->depth, &params);
+    if (fd < 0) return false;
+    loader->ring_fd = (int)fd;
+
+    loader->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    loader->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (loader->cq_ring_size > loader->sq_ring_size) loader->sq_ring_size = loader->cq_ring_size;
+        loader->cq_ring_size = loader->sq_ring_size;
+    }
+
+    loader->sq_ring = mmap(NULL, loader->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           loader->ring_fd, IORING_OFF_SQ_RING);
+    if (loader->sq_ring == MAP_FAILED) {
+        loader->sq_ring = NULL;
+        __file_loader_uring_release(loader);
+        return false;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        loader->cq_ring = loader->sq_ring;
+    } else {
+        loader->cq_ring = mmap(NULL, loader->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                               loader->ring_fd, IORING_OFF_CQ_RING);
+        if (loader->cq_ring == MAP_FAILED) {
+            loader->cq_ring = NULL;
+            __file_loader_uring_release(loader);
+            return false;
+        }
+    }
+
+    loader->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    loader->sqes = (struct io_uring_sqe *)mmap(NULL, loader->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                               loader->ring_fd, IORING_OFF_SQES);
+    if (loader->sqes == MAP_FAILED) {
+        loader->sqes = NULL;
+        __file_loader_uring_release(loader);
+        return false;
+    }
+
+    char *sq = (char *)loader->sq_ring;
+    char *cq = (char *)loader->cq_ring;
+    loader->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    loader->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    loader->sq_array = (unsigned *)(sq + params.sq_off.array);
+    loader->cq_head = (unsigned *)(cq + params.cq_off.head);
+    loader->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    loader->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    loader->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    // The kernel may round the depth up, never down
+    if (params.sq_entries < loader->depth) loader->depth = params.sq_entries;
+    return true;
+}
+
+void __file_loader_uring_fail(file_loader *loader, int error) {
+    loader->ring_error = error;
+    loader->to_submit = 0;
+    for (file_request *request = loader->added; request; request = request->added_next) {
+        if (!request->reading) continue;
+        request->reading = false;
+        request->error = error;
+        request->data = NULL;
+        __file_loader_push(&loader->ready, &loader->ready_tail, request);
+    }
+}
+
+void __file_loader_uring_release(file_loader *loader) {
+    if (loader->sqes) munmap(loader->sqes, loader->sqes_size);
+    if (loader->cq_ring && loader->cq_ring != loader->sq_ring) munmap(loader->cq_ring, loader->cq_ring_size);
+    if (loader->sq_ring) munmap(loader->sq_ring, loader->sq_ring_size);
+    if (loader->ring_fd >= 0) close(loader->ring_fd);
+
+    loader->sqes = NULL;
+    loader->cq_ring = NULL;
+    loader->sq_ring = NULL;
+    loader->ring_fd = -1;
+}
+#endif
+
+bool __file_loader_threads_start(file_loader *loader) {
+    size_t count = loader->depth < FILE_LOADER_THREADS_MAX ? loader->depth : FILE_LOADER_THREADS_MAX;
+    loader->threads = (pthread_t *)memctx_alloc(loader->ctx, sizeof(pthread_t) * count);
+    if (!loader->threads) return false;
+
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->work_ready, NULL);
+    pthread_cond_init(&loader->work_done, NULL);
+
+    for (size_t i = 0; i < count; i++) {
+        if (pthread_create(&loader->threads[i], NULL, __file_loader_thread, loader) != 0) break;
+        loader->thread_count++;
+    }
+
+    if (loader->thread_count == 0) {
+        pthread_mutex_destroy(&loader->lock);
+        pthread_cond_destroy(&loader->work_ready);
+        pthread_cond_destroy(&loader->work_done);
+        loader->threads = NULL;
+        return false;
+    }
+    return true;
+}
+
+void* __file_loader_thread(void *arg) {
+    file_loader *loader = (file_loader *)arg;
+
+    pthread_mutex_lock(&loader->lock);
+    for (;;) {
+        while (!loader->work && !loader->stop) {
+            pthread_cond_wait(&loader->work_ready, &loader->lock);
+        }
+        if (loader->stop) break;
+
+        file_request *request = __file_loader_pop(&loader->work, &loader->work_tail);
+        pthread_mutex_unlock(&loader->lock);
+
+        // Each file is read by one thread, from its start, so the file offset is enough
+        while (request->done < request->size) {
+            size_t length = request->size - request->done;
+            if (length > FILE_LOADER_READ_MAX) length = FILE_LOADER_READ_MAX;
+
+            ssize_t result = read(request->fd, request->data + request->done, length);
+            if (result < 0) {
+                if (errno == EINTR) continue;
+                request->error = errno;
+                break;
+            }
+            if (result == 0) {
+                request->error = EIO;    // the file was truncated while reading
+                break;
+            }
+            request->done += (size_t)result;
+        }
+
+        pthread_mutex_lock(&loader->lock);
+        __file_loader_push(&loader->done, &loader->done_tail, request);
+        pthread_cond_signal(&loader->work_done);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,366 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all map functions.
+
+#ifndef _MEMCTX_MAP_H_
+#define _MEMCTX_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "memctx.h"
+#include "memctx_strings.h"
+
+// Number of slots, must be a multiple of MAP_GROUP_SIZE and a power of two
+#ifndef MAP_INIT_CAPACITY
+#define MAP_INIT_CAPACITY 16
+#endif
+
+#define MAP_GROUP_SIZE 16
+
+// Control byte values; full slots store the low 7 bits of the key hash
+#define MAP_CTRL_EMPTY   ((int8_t)-128)
+#define MAP_CTRL_DELETED ((int8_t)-2)
+
+typedef struct memctx_map_entry {
+    substring key;
+    uint64_t hash;
+    void *value;
+} map_entry;
+
+typedef struct memctx_map {
+    int8_t *ctrl;
+    map_entry *entries;
+    size_t length;
+    size_t capacity;
+    size_t growth_left;
+    MemContext *ctx;
+} map;
+
+/**
+ * Initialize a new map within the specified memory context.
+ * Keys are strings or substrings and are stored as given, without copying,
+ * so the key memory must live as long as the map.
+ *
+ * @param ctx Pointer to the memory context to use for allocations
+ * @return Pointer to the newly created map, or NULL if allocation fails
+ */
+map* map_init(MemContext *ctx);
+
+/**
+ * Inserts a key or replaces the value stored for it.
+ *
+ * @param m Pointer to the map
+ * @param key The key (string, substring or char*)
+ * @param value The value to store
+ * @return true if the value was stored, false if m is NULL or allocation fails
+ */
+#define map_set(m, key, value) __map_set(m, string_hashed(__string_arg(key)), value)
+
+/**
+ * Retrieves the value stored for a key.
+ *
+ * @param m Pointer to the map
+ * @param key The key (string, substring or char*)
+ * @return The stored value, or NULL if m is NULL or the key is not found
+ */
+#define map_get(m, key) __map_get(m, string_hashed(__string_arg(key)))
+
+/**
+ * Checks whether a key is present, even if its value is NULL.
+ *
+ * @param m Pointer to the map
+ * @param key The key (string, substring or char*)
+ * @return true if the key is present
+ */
+#define map_has(m, key) (__map_find(m, string_hashed(__string_arg(key))) != (size_t)-1)
+
+/**
+ * Removes a key and its value.
+ *
+ * @param m Pointer to the map
+ * @param key The key (string, substring or char*)
+ * @return true if the key was present
+ */
+#define map_remove(m, key) __map_remove(m, string_hashed(__string_arg(key)))
+
+/**
+ * Inserts a key with a precomputed hash (see `string_hashed`)
+ * or replaces the value stored for it.
+ */
+bool map_set_hashed(map *m, hashed_string key, void *value);
+
+/**
+ * Retrieves the value stored for a key with a precomputed hash (see `string_hashed`).
+ */
+void* map_get_hashed(map *m, hashed_string key);
+
+/**
+ * Iterates over the entries of a map in unspecified order.
+ * The map must not be modified during iteration.
+ *
+ * @param m Pointer to the map
+ * @param iterator Iteration state, must be set to 0 before the first call
+ * @param key Receives the key of the next entry (can be NULL)
+ * @param value Receives the value of the next entry (can be NULL)
+ * @return true if an entry was produced, false when there are no more entries
+ */
+bool map_next(map *m, size_t *iterator, substring *key, void **value);
+
+/**
+ * Removes all entries from a map. Capacity is preserved.
+ *
+ * @param m Pointer to the map
+ */
+void map_clear(map *m);
+
+bool __map_set(map *m, hashed_string key, void *value);
+
+void* __map_get(map *m, hashed_string key);
+
+bool __map_remove(map *m, hashed_string key);
+
+/**
+ * Returns the slot index of a key, or -1 if the key is not found.
+ */
+size_t __map_find(map *m, hashed_string key);
+
+/**
+ * Returns a bit mask of the slots in a group whose control byte equals `value`.
+ */
+uint32_t __map_group_match(const int8_t *group, int8_t value);
+
+/**
+ * Returns a bit mask of the empty or deleted slots in a group.
+ */
+uint32_t __map_group_available(const int8_t *group);
+
+/**
+ * Rehashes the map into the specified number of slots.
+ */
+bool __map_resize(map *m, size_t capacity);
+
+// - Implementation -
+
+map* map_init(MemContext *ctx) {
+    if (!ctx) return NULL;
+
+    map *m = (map *)memctx_alloc(ctx, sizeof(map));
+    if (!m) return NULL;
+
+    m->ctx = ctx;
+    m->ctrl = NULL;
+    m->entries = NULL;
+    m->length = 0;
+    m->capacity = 0;
+    m->growth_left = 0;
+    if (!__map_resize(m, MAP_INIT_CAPACITY)) return NULL;
+
+    return m;
+}
+
+bool map_set_hashed(map *m, hashed_string key, void *value) {
+    return __map_set(m, key, value);
+}
+
+void* map_get_hashed(map *m, hashed_string key) {
+    return __map_get(m, key);
+}
+
+bool map_next(map *m, size_t *iterator, substring *key, void **value) {
+    if (!m || !iterator) return false;
+
+    while (*iterator < m->capacity) {
+        size_t slot = (*iterator)++;
+        if (m->ctrl[slot] >= 0) {
+            if (key) *key = m->entries[slot].key;
+            if (value) *value = m->entries[slot].value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void map_clear(map *m) {
+    if (!m) return;
+    memset(m->ctrl, MAP_CTRL_EMPTY, m->capacity);
+    m->length = 0;
+    m->growth_left = m->capacity - m->capacity / 8;
+}
+
+bool __map_set(map *m, hashed_string key, void *value) {
+    if (!m || !key.str.value) return false;
+
+    size_t slot = __map_find(m, key);
+    if (slot != (size_t)-1) {
+        m->entries[slot].value = value;
+        return true;
+    }
+
+    int8_t h2 = (int8_t)(key.hash & 0x7F);
+    for (;;) {
+        // Probe groups for the first empty or deleted slot
+        size_t groups = m->capacity / MAP_GROUP_SIZE;
+        size_t group = (size_t)(key.hash >> 7) & (groups - 1);
+        for (size_t step = 1; ; step++) {
+            uint32_t available = __map_group_available(m->ctrl + group * MAP_GROUP_SIZE);
+            if (available) {
+                slot = group * MAP_GROUP_SIZE + __string_ctz(available);
+                break;
+            }
+            group = (group + step) & (groups - 1);
+        }
+
+        if (m->ctrl[slot] == MAP_CTRL_EMPTY && m->growth_left == 0) {
+            // Out of room: grow, or only drop tombstones if they take the space
+            size_t capacity = m->length * 2 >= m->capacity ? m->capacity * 2 : m->capacity;
+            if (!__map_resize(m, capacity)) return false;
+            continue;
+        }
+        break;
+    }
+
+    if (m->ctrl[slot] == MAP_CTRL_EMPTY) {
+        m->growth_left--;
+    }
+    m->ctrl[slot] = h2;
+    m->entries[slot].key = key.str;
+    m->entries[slot].hash = key.hash;
+    m->entries[slot].value = value;
+    m->length++;
+    return true;
+}
+
+void* __map_get(map *m, hashed_string key) {
+    size_t slot = __map_find(m, key);
+    return slot == (size_t)-1 ? NULL : m->entries[slot].value;
+}
+
+bool __map_remove(map *m, hashed_string key) {
+    size_t slot = __map_find(m, key);
+    if (slot == (size_t)-1) return false;
+
+    // A group that still has an empty slot has never been full, so no probe
+    // sequence continues past it and the slot can become empty again
+    const int8_t *group = m->ctrl + (slot & ~(size_t)(MAP_GROUP_SIZE - 1));
+    if (__map_group_match(group, MAP_CTRL_EMPTY)) {
+        m->ctrl[slot] = MAP_CTRL_EMPTY;
+        m->growth_left++;
+    } else {
+        m->ctrl[slot] = MAP_CTRL_DELETED;
+    }
+    m->length--;
+    return true;
+}
+
+size_t __map_find(map *m, hashed_string key) {
+    if (!m || !key.str.value) return (size_t)-1;
+
+    int8_t h2 = (int8_t)(key.hash & 0x7F);
+    size_t groups = m->capacity / MAP_GROUP_SIZE;
+    size_t group = (size_t)(key.hash >> 7) & (groups - 1);
+
+    for (size_t step = 1; step <= groups; step++) {
+        const int8_t *ctrl = m->ctrl + group * MAP_GROUP_SIZE;
+
+        uint32_t candidates = __map_group_match(ctrl, h2);
+        while (candidates) {
+            size_t slot = group * MAP_GROUP_SIZE + __string_ctz(candidates);
+            map_entry *entry = &m->entries[slot];
+            if (entry->hash == key.hash && entry->key.length == key.str.length &&
+                memcmp(entry->key.value, key.str.value, key.str.length) == 0) {
+                return slot;
+            }
+            candidates &= candidates - 1;
+        }
+
+        // An empty slot ends the probe sequence
+        if (__map_group_match(ctrl, MAP_CTRL_EMPTY)) break;
+
+        group = (group + step) & (groups - 1);
+    }
+
+    return (size_t)-1;
+}
+
+uint32_t __map_group_match(const int8_t *group, int8_t value) {
+#if defined(STRING_SIMD_SSE2)
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < MAP_GROUP_SIZE; i++) {
+        if (group[i] == value) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+uint32_t __map_group_available(const int8_t *group) {
+#if defined(STRING_SIMD_SSE2)
+    // Empty and deleted control bytes are the only negative ones
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(ctrl);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < MAP_GROUP_SIZE; i++) {
+        if (group[i] < 0) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+bool __map_resize(map *m, size_t capacity) {
+    int8_t *ctrl = (int8_t *)memctx_alloc(m->ctx, capacity);
+    map_entry *entries = (map_entry *)memctx_alloc(m->ctx, sizeof(map_entry) * capacity);
+    if (!ctrl || !entries) return false;
+    memset(ctrl, MAP_CTRL_EMPTY, capacity);
+
+    // Reinsert full slots using their stored hashes
+    size_t groups = capacity / MAP_GROUP_SIZE;
+    for (size_t i = 0; i < m->capacity; i++) {
+        if (m->ctrl[i] < 0) continue;
+
+        uint64_t hash = m->entries[i].hash;
+        size_t group = (size_t)(hash >> 7) & (groups - 1);
+        size_t slot;
+        for (size_t step = 1; ; step++) {
+            uint32_t available = __map_group_available(ctrl + group * MAP_GROUP_SIZE);
+            if (available) {
+                slot = group * MAP_GROUP_SIZE + __string_ctz(available);
+                break;
+            }
+            group = (group + step) & (groups - 1);
+        }
+        ctrl[slot] = m->ctrl[i];
+        entries[slot] = m->entries[i];
+    }
+
+    m->ctrl = ctrl;
+    m->entries = entries;
+    m->capacity = capacity;
+    m->growth_left = capacity - capacity / 8 - m->length;
+    return true;
+}
+
+#endif
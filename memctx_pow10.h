@@ -0,0 +1,662 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the table of powers of ten shared by the double parser and formatter.
+
+#ifndef _MEMCTX_POW10_H_
+#define _MEMCTX_POW10_H_
+
+#include <stdint.h>
+
+/**
+ * floor(e * log2(10)) for the decimal exponents of doubles.
+ */
+int __memctx_floor_log2_pow10(int e);
+
+// g = floor(10^-k * 2^-r) + 1 split into 63-bit halves, for k from MEMCTX_POW10_K_MIN,
+// where r makes 2^125 <= g < 2^126
+#define MEMCTX_POW10_K_MIN (-324)
+static const uint64_t __memctx_pow10_g[617][2] = {
+    {0x4F0CEDC95A718DD4ULL, 0x5B01E8B09AA0D1B5ULL},
+    {0x7E7B160EF71C1621ULL, 0x119CA780F767B5EEULL},
+    {0x652F44D8C5B011B4ULL, 0x0E16EC672C52F7F2ULL},
+    {0x50F29D7A37C00E29ULL, 0x581256B8F0425FF5ULL},
+    {0x40C21794F96671BAULL, 0x79A84560C0351991ULL},
+    {0x679CF287F570B5F7ULL, 0x75DA089ACD21C281ULL},
+    {0x52E3F5399126F7F9ULL, 0x44AE6D48A41B0201ULL},
+    {0x424FF76140EBF994ULL, 0x36F1F106E9AF34CDULL},
+    {0x6A198BCECE465C20ULL, 0x57E981A4A918547BULL},
+    {0x54E13CA571D1E34DULL, 0x2CBACE1D541376C9ULL},
+    {0x43E763B78E4182A4ULL, 0x23C8A4E44342C56EULL},
+    {0x6CA56C58E39C043AULL, 0x060DD4A06B9E08B0ULL},
+    {0x56EABD13E9499CFBULL, 0x1E7176E6BC7E6D59ULL},
+    {0x458897432107B0C8ULL, 0x7EC12BEBC9FEBDE1ULL},
+    {0x6F40F20501A5E7A7ULL, 0x7E01DFDFA9979635ULL},
+    {0x5900C19D9AEB1FB9ULL, 0x4B34B319547944F7ULL},
+    {0x4733CE17AF227FC7ULL, 0x55C3C27AA9FA9D93ULL},
+    {0x71EC7CF2B1D0CC72ULL, 0x560603F7765DC8EAULL},
+    {0x5B2397288E40A38EULL, 0x7804CFF92B7E3A55ULL},
+    {0x48E945BA0B66E93FULL, 0x13370CC755FE9511ULL},
+    {0x74A86F90123E41FEULL, 0x51F1AE0BBCCA881BULL},
+    {0x5D538C7341CB67FEULL, 0x74C1580963D539AFULL},
+    {0x4AA93D29016F8665ULL, 0x43CDE0078310FAF3ULL},
+    {0x77752EA8024C0A3CULL, 0x0616333F381B2B1EULL},
+    {0x5F90F22001D66E96ULL, 0x3811C298F9AF55B1ULL},
+    {0x4C73F4E667DEBEDEULL, 0x600E35472E25DE28ULL},
+    {0x7A532170A6313164ULL, 0x3349EED849D6303FULL},
+    {0x61DC1AC084F42783ULL, 0x42A18BE03B11C033ULL},
+    {0x4E49AF006A5CEC69ULL, 0x1BB46FE695A7CCF5ULL},
+    {0x7D42B19A43C7E0A8ULL, 0x2C53E63DBC3FAE55ULL},
+    {0x64355AE1CFD31A20ULL, 0x237651CAFCFFBEAAULL},
+    {0x502AAF1B0CA8E1B3ULL, 0x35F8416F30CC9888ULL},
+    {0x402225AF3D53E7C2ULL, 0x5E603458F3D6E06DULL},
+    {0x669D0918621FD937ULL, 0x4A3386F4B957CD7BULL},
+    {0x52173A79E8197A92ULL, 0x6E8F9F2A2DDFD796ULL},
+    {0x41AC2EC7ECE12EDBULL, 0x720C7F54F17FDFABULL},
+    {0x69137E0CAE3517C6ULL, 0x1CE0CBBB1BFFCC45ULL},
+    {0x540F980A24F74638ULL, 0x171A3C95AFFFD69EULL},
+    {0x433FACD4EA5F6B60ULL, 0x127B63AAF3331218ULL},
+    {0x6B991487DD657899ULL, 0x6A5F05DE51EB5026ULL},
+    {0x5614106CB11DFA14ULL, 0x5518D17EA7EF7352ULL},
+    {0x44DCD9F08DB194DDULL, 0x2A7A41321FF2C2A8ULL},
+    {0x6E2E2980E2B5BAFBULL, 0x5D906850331E043FULL},
+    {0x5824EE00B55E2F2FULL, 0x647386A68F4B3699ULL},
+    {0x4683F19A2AB1BF59ULL, 0x36C2D21ED908F87BULL},
+    {0x70D31C29DDE93228ULL, 0x579E1CFE280E5A5DULL},
+    {0x5A427CEE4B20F4EDULL, 0x2C7E7D98200B7B7EULL},
+    {0x483530BEA280C3F1ULL, 0x09FECAE019A2C932ULL},
+    {0x73884DFDD0CE064EULL, 0x43314499C29E0EB6ULL},
+    {0x5C6D0B3173D8050BULL, 0x4F5A9D47CEE4D891ULL},
+    {0x49F0D5C129799DA2ULL, 0x72AEE4397250AD41ULL},
+    {0x764E22CEA8C295D1ULL, 0x377E39F583B44868ULL},
+    {0x5EA4E8A553CEDE41ULL, 0x12CB61913629D387ULL},
+    {0x4BB72084430BE500ULL, 0x756F8140F8217605ULL},
+    {0x792500D39E796E67ULL, 0x6F18CECE59CF233CULL},
+    {0x60EA670FB1FABEB9ULL, 0x3F470BD847D8E8FDULL},
+    {0x4D885272F4C89894ULL, 0x329F3CAD064720CAULL},
+    {0x7C0D50B7EE0DC0EDULL, 0x37652DE1A3A50143ULL},
+    {0x633DDA2CBE716724ULL, 0x2C50F1814FB73436ULL},
+    {0x4F64AE8A31F45283ULL, 0x3D0D8E010C92902BULL},
+    {0x7F077DA9E986EA6BULL, 0x7B48E334E0EA8045ULL},
+    {0x659F97BB2138BB89ULL, 0x49071C2A4D88669DULL},
+    {0x514C796280FA2FA1ULL, 0x20D27CEEA46D1EE4ULL},
+    {0x4109FAB533FB594DULL, 0x670ECA58838A7F1DULL},
+    {0x680FF788532BC216ULL, 0x0B4ADD5A6C10CB62ULL},
+    {0x533FF939DC2301ABULL, 0x22A24AAEBCDA3C4EULL},
+    {0x4299942E49B59AEFULL, 0x354EA22563E1C9D8ULL},
+    {0x6A8F537D42BC2B18ULL, 0x554A9D089FCFA95AULL},
+    {0x553F75FDCEFCEF46ULL, 0x776EE406E63FBAAEULL},
+    {0x4432C4CB0BFD8C38ULL, 0x5F8BE99F1E996225ULL},
+    {0x6D1E07AB466279F4ULL, 0x327975CB64289D08ULL},
+    {0x574B3955D1E86190ULL, 0x28612B091CED4A6DULL},
+    {0x45D5C777DB204E0DULL, 0x06B4226DB0BDD524ULL},
+    {0x6FBC72595E9A167BULL, 0x24536A491AC95506ULL},
+    {0x59638EADE54811FCULL, 0x1D0F883A7BD44405ULL},
+    {0x4782D88B1DD34196ULL, 0x4A72D361FCA9D004ULL},
+    {0x726AF411C952028AULL, 0x43EAEBCFFAA94CD3ULL},
+    {0x5B88C3416DDB353BULL, 0x4FEF230CC88770A9ULL},
+    {0x493A35CDF17C2A96ULL, 0x0CBF4F3D6D3926EEULL},
+    {0x7529EFAFE8C6AA89ULL, 0x61321862485B717CULL},
+    {0x5DBB262653D22207ULL, 0x675B46B506AF8DFDULL},
+    {0x4AFC1E850FDB4E6CULL, 0x52AF6BC405593E64ULL},
+    {0x77F9CA6E7FC54A47ULL, 0x377F12D33BC1FD6DULL},
+    {0x5FFB085866376E9FULL, 0x45FF42429634CABDULL},
+    {0x4CC8D379EB5F8BB2ULL, 0x6B329B68782A3BCBULL},
+    {0x7ADAEBF64565AC51ULL, 0x2B842BDA59DD2C77ULL},
+    {0x6248BCC5045156A7ULL, 0x3C69BCAEAE4A89F9ULL},
+    {0x4EA0970403744552ULL, 0x6387CA25583BA194ULL},
+    {0x7DCDBE6CD253A21EULL, 0x05A6103BC05F68EDULL},
+    {0x64A498570EA94E7EULL, 0x37B80CFC99E5ED8AULL},
+    {0x5083AD1272210B98ULL, 0x2C933D96E184BE08ULL},
+    {0x40695741F4E73C79ULL, 0x7075CADF1AD09807ULL},
+    {0x670EF2032171FA5CULL, 0x4D8944982AE759A4ULL},
+    {0x52725B35B45B2EB0ULL, 0x3E076A135585E150ULL},
+    {0x41F515C49048F226ULL, 0x64D2BB42AAD1810DULL},
+    {0x698822D41A0E503EULL, 0x07B7920444826815ULL},
+    {0x546CE8A9AE71D9CBULL, 0x1FC60E69D0685344ULL},
+    {0x438A53BAF1F4AE3CULL, 0x196B3EBB0D20429DULL},
+    {0x6C1085F7E9877D2DULL, 0x0F11FDF815006A94ULL},
+    {0x56739E5FEE05FDBDULL, 0x58DB319344005543ULL},
+    {0x45294B7FF19E6497ULL, 0x60AF5ADC3666AA9CULL},
+    {0x6EA878CCB5CA3A8CULL, 0x344BC4938A3DDDC7ULL},
+    {0x5886C70A2B082ED6ULL, 0x5D096A0FA1CB17D2ULL},
+    {0x46D238D4EF39BF12ULL, 0x173ABB3FB4A27975ULL},
+    {0x71505AEE4B8F981DULL, 0x0B912B992103F588ULL},
+    {0x5AA6AF25093FACE4ULL, 0x0940EFADB4032AD3ULL},
+    {0x488558EA6DCC8A50ULL, 0x07672624900288A9ULL},
+    {0x74088E43E2E0DD4CULL, 0x723EA36DB337410EULL},
+    {0x5CD3A5031BE71770ULL, 0x5B654F8AF5C5CDA5ULL},
+    {0x4A42EA68E31F45F3ULL, 0x62B772D5916B0AEBULL},
+    {0x76D1770E38320986ULL, 0x0458B7BC1BDE77DDULL},
+    {0x5F0DF8D82CF4D46BULL, 0x1D13C630164B9318ULL},
+    {0x4C0B2D79BD90A9EFULL, 0x30DC9E8CDEA2DC13ULL},
+    {0x79AB7BF5FC1AA97FULL, 0x0160FDAE31049351ULL},
+    {0x6155FCC4C9AEEDFFULL, 0x1AB3FE24F403A90EULL},
+    {0x4DDE63D0A158BE65ULL, 0x6229981D9002EDA5ULL},
+    {0x7C97061A9BC130A2ULL, 0x69DC2695B337E2A1ULL},
+    {0x63AC04E2163426E8ULL, 0x54B01EDE28F9821BULL},
+    {0x4FBCD0B4DE901F20ULL, 0x43C018B1BA6134E2ULL},
+    {0x7F9481216419CB67ULL, 0x1F99C11C5D68549DULL},
+    {0x6610674DE9AE3C52ULL, 0x4C7B00E37DED107EULL},
+    {0x51A6B90B21583042ULL, 0x09FC00B5FE574065ULL},
+    {0x41522DA2811359CEULL, 0x3B3000919845CD1DULL},
+    {0x68837C3734EBC2E3ULL, 0x784CCDB5C06FAE95ULL},
+    {0x539C635F5D8968B6ULL, 0x2D0A3E2B00595877ULL},
+    {0x42E382B2B13ABA2BULL, 0x3DA1CB5599E11393ULL},
+    {0x6B059DEAB52AC378ULL, 0x629C7888F634EC1EULL},
+    {0x559E17EEF755692DULL, 0x3549FA072B5D89B1ULL},
+    {0x447E798BF91120F1ULL, 0x1107FB38EF7E07C1ULL},
+    {0x6D9728DFF4E834B5ULL, 0x01A65EC17F300C68ULL},
+    {0x57AC20B32A535D5DULL, 0x4E1EB23465C009EDULL},
+    {0x46234D5C21DC4AB1ULL, 0x24E55B5D1E333B24ULL},
+    {0x70387BC69C93AAB5ULL, 0x216EF894FD1EC506ULL},
+    {0x59C6C96BB076222AULL, 0x4DF2607730E56A6CULL},
+    {0x47D23ABC8D2B4E88ULL, 0x3E5B805F5A5121F0ULL},
+    {0x72E9F79415121740ULL, 0x63C59A322A1B697FULL},
+    {0x5BEE5FA9AA74DF67ULL, 0x03047B5B54E2BACCULL},
+    {0x498B7FBAEEC3E5ECULL, 0x0269FC4910B5623DULL},
+    {0x75ABFF917E063CACULL, 0x6A432D41B45569FBULL},
+    {0x5E2332DACB38308AULL, 0x21CF5767C37787FCULL},
+    {0x4B4F5BE23C2CF3A1ULL, 0x67D912B9692C6CCAULL},
+    {0x787EF969F9E185CFULL, 0x595B5128A8471476ULL},
+    {0x60659454C7E79E3FULL, 0x6115DA86ED05A9F8ULL},
+    {0x4D1E1043D31FB1CCULL, 0x4DAB1538BD9E2193ULL},
+    {0x7B634D3951CC4FADULL, 0x62AB552795C9CF52ULL},
+    {0x62B5D7610E3D0C8BULL, 0x0222AA86116E3F75ULL},
+    {0x4EF7DF80D830D6D5ULL, 0x4E822204DABE992AULL},
+    {0x7E59659AF38157BCULL, 0x17369CD49130F510ULL},
+    {0x65145148C2CDDFC9ULL, 0x5F5EE3DD40F3F740ULL},
+    {0x50DD0DD3CF0B196EULL, 0x1918B64A9A5CC5CDULL},
+    {0x40B0D7DCA5A27ABEULL, 0x4746F83BAEB09E3EULL},
+    {0x678159610903F797ULL, 0x253E59F91780FD2FULL},
+    {0x52CDE11A6D9CC612ULL, 0x50FEAE60DF9A6426ULL},
+    {0x423E4DAEBE1704DBULL, 0x5A65584D7FAEB685ULL},
+    {0x69FD4917968B3AF9ULL, 0x10A226E265E4573BULL},
+    {0x54CAA0DFABA29594ULL, 0x0D4E8581EB1D1295ULL},
+    {0x43D54D7FBC821143ULL, 0x243ED134BC174211ULL},
+    {0x6C887BFF94034ED2ULL, 0x06CAE85460253682ULL},
+    {0x56D396661002A574ULL, 0x6BD586A9E6842B9BULL},
+    {0x457611EB40021DF7ULL, 0x09779EEE52035616ULL},
+    {0x6F234FDECCD02FF1ULL, 0x5BF297E3B66BBCEFULL},
+    {0x58E90CB23D73598EULL, 0x165BACB62B8963F3ULL},
+    {0x4720D6F4FDF5E13EULL, 0x451623C4EFA11CC2ULL},
+    {0x71CE24BB2FEFCECAULL, 0x3B569FA17F682E03ULL},
+    {0x5B0B5095BFF30BD5ULL, 0x15DEE61ACC535803ULL},
+    {0x48D5DA11665C0977ULL, 0x2B18B8157042ACCFULL},
+    {0x74895CE8A3C6758BULL, 0x5E8DF355806AAE18ULL},
+    {0x5D3AB0BA1C9EC46FULL, 0x653E5C4466BBBE7AULL},
+    {0x4A955A2E7D4BD059ULL, 0x3765169D1EFC9861ULL},
+    {0x77555D172EDFB3C2ULL, 0x256E8A94FE60F3CFULL},
+    {0x5F777DAC257FC301ULL, 0x6ABED543FEB3F63FULL},
+    {0x4C5F97BCEACC9C01ULL, 0x3BCBDDCFFEF65E99ULL},
+    {0x7A328C6177ADC668ULL, 0x5FAC961997F0975BULL},
+    {0x61C209E792F16B86ULL, 0x7FBD44E1465A12AFULL},
+    {0x4E34D4B9425ABC6BULL, 0x7FCA9D810514DBBFULL},
+    {0x7D21545B9D5DFA46ULL, 0x32DDC8CE6E87C5FFULL},
+    {0x641AA9E2E44B2E9EULL, 0x5BE4A0A525396B32ULL},
+    {0x501554B5836F587EULL, 0x7CB6E6EA842DEF5CULL},
+    {0x4011109135F2AD32ULL, 0x30925255368B25E3ULL},
+    {0x6681B41B89844850ULL, 0x4DB6EA21F0DEA304ULL},
+    {0x52015CE2D469D373ULL, 0x57C5881B2718826AULL},
+    {0x419AB0B576BB0F8FULL, 0x5FD139AF527A01EFULL},
+    {0x68F781225791B27FULL, 0x4C81F5E550C3364AULL},
+    {0x53F9341B79415B99ULL, 0x239B2B1DDA35C508ULL},
+    {0x432DC3492DCDE2E1ULL, 0x02E288E4AE916A6DULL},
+    {0x6B7C6BA849496B01ULL, 0x516A74A1174F10AEULL},
+    {0x55FD22ED076DEF34ULL, 0x4121F6E745D8DA25ULL},
+    {0x44CA82573924BF5DULL, 0x1A8192529E4714EBULL},
+    {0x6E10D08B8EA1322EULL, 0x5D9C1D50FD3E87DDULL},
+    {0x580D73A2D880F4F2ULL, 0x17B01773FDCB9FE4ULL},
+    {0x4671294F139A5D8EULL, 0x4626792997D61984ULL},
+    {0x70B50EE4EC2A2F4AULL, 0x3D0A5B75BFBCF59FULL},
+    {0x5A2A7250BCEE8C3BULL, 0x4A6EAF916630C47FULL},
+    {0x4821F50D63F209C9ULL, 0x21F2260DEB5A36CCULL},
+    {0x736988156CB6760EULL, 0x69837016455D247AULL},
+    {0x5C546CDDF091F80BULL, 0x6E02C011D1175062ULL},
+    {0x49DD23E4C074C66FULL, 0x719BCCDB0DAC404EULL},
+    {0x762E9FD467213D7FULL, 0x68F947C4E2AD33B0ULL},
+    {0x5E8BB3105280FDFFULL, 0x6D94396A4EF0F627ULL},
+    {0x4BA2F5A6A8673199ULL, 0x3E102DEEA58D91B9ULL},
+    {0x7904BC3DDA3EB5C2ULL, 0x3019E3176F48E927ULL},
+    {0x60D09697E1CBC49BULL, 0x4014B5AC590720ECULL},
+    {0x4D73ABACB4A303AFULL, 0x4CDD5E237A6C1A57ULL},
+    {0x7BEC45E12104D2B2ULL, 0x47C8969F2A46908AULL},
+    {0x63236B1A80D0A88EULL, 0x6CA0787F5505406FULL},
+    {0x4F4F88E200A6ED3FULL, 0x0A19F9FF773766BFULL},
+    {0x7EE5A7D0010B1531ULL, 0x5CF65CCBF1F23DFEULL},
+    {0x6584864000D5AA8EULL, 0x172B7D6FF4C1CB32ULL},
+    {0x5136D1CCCD77BBA4ULL, 0x78EF978CC3CE3C28ULL},
+    {0x40F8A7D70AC62FB7ULL, 0x13F2DFA3CFD83020ULL},
+    {0x67F43FBE77A37F8BULL, 0x398499061959E699ULL},
+    {0x5329CC985FB5FFA2ULL, 0x6136E0D1ADE18548ULL},
+    {0x4287D6E04C91994FULL, 0x00F8B3DAF181376DULL},
+    {0x6A72F166E0E8F54BULL, 0x1B27862B1C01F247ULL},
+    {0x5528C11F1A53F76FULL, 0x2F52D1BC1667F506ULL},
+    {0x44209A7F48432C59ULL, 0x0C424163451FF738ULL},
+    {0x6D00F7320D3846F4ULL, 0x7A039BD208332526ULL},
+    {0x5733F8F4D76038C3ULL, 0x7B361641A028EA85ULL},
+    {0x45C32D90AC4CFA36ULL, 0x2F5E78348020BB9EULL},
+    {0x6F9EAF4DE07B29F0ULL, 0x4BCA59ED99CDF8FCULL},
+    {0x594BBF71806287F3ULL, 0x563B7B247B0B2D96ULL},
+    {0x476FCC5ACD1B9FF6ULL, 0x11C92F50626F57ACULL},
+    {0x724C7A2AE1C5CCBDULL, 0x02DB7EE703E55912ULL},
+    {0x5B7061BBE7D17097ULL, 0x1BE2CBEC031DE0DCULL},
+    {0x4926B496530DF3ACULL, 0x164F09899C17E716ULL},
+    {0x750ABA8A1E7CB913ULL, 0x3D4B4275C68CA4F0ULL},
+    {0x5DA22ED4E530940FULL, 0x4AA29B916BA3B726ULL},
+    {0x4AE825771DC07672ULL, 0x6EE87C74561C9285ULL},
+    {0x77D9D58B62CD8A51ULL, 0x3173FA53BCFA8408ULL},
+    {0x5FE177A2B5713B74ULL, 0x278FFB7630C869A0ULL},
+    {0x4CB45FB55DF42F90ULL, 0x1FA662C4F3D387B3ULL},
+    {0x7ABA32BBC986B280ULL, 0x32A3D13B1FB8D91FULL},
+    {0x622E8EFCA1388ECDULL, 0x0EE9742F4C93E0E6ULL},
+    {0x4E8BA596E760723DULL, 0x58BAC3590A0FE71EULL},
+    {0x7DAC3C24A5671D2FULL, 0x412AD228101971C9ULL},
+    {0x6489C9B6EAB8E426ULL, 0x00EF0E8673478E3BULL},
+    {0x506E3AF8BBC71CEBULL, 0x1A58D86B8F6C71C9ULL},
+    {0x40582F2D6305B0BCULL, 0x1513E0560C56C16EULL},
+    {0x66F37EAF04D5E793ULL, 0x3B530089AD579BE2ULL},
+    {0x525C6558D0AB1FA9ULL, 0x15DC006E2446164FULL},
+    {0x41E384470D55B2EDULL, 0x5E4999F1B69E783FULL},
+    {0x696C06D81555EB15ULL, 0x7D428FE92430C065ULL},
+    {0x54566BE0111188DEULL, 0x31020CBA835A3384ULL},
+    {0x4378564CDA746D7EULL, 0x5A680A2ECF7B5C69ULL},
+    {0x6BF3BD47C3ED7BFDULL, 0x770CDD17B25EFA42ULL},
+    {0x565C976C9CBDFCCBULL, 0x1270B0DFC1E59502ULL},
+    {0x4516DF8A16FE63D5ULL, 0x5B8D5A4C9B1E10CEULL},
+    {0x6E8AFF4357FD6C89ULL, 0x127BC3ADC4FCE7B0ULL},
+    {0x586F329C466456D4ULL, 0x0EC96957D0CA52F3ULL},
+    {0x46BF5BB038504576ULL, 0x3F07877973D50F29ULL},
+    {0x71322C4D26E6D58AULL, 0x31A5A58F1FBB4B75ULL},
+    {0x5A8E89D75252446EULL, 0x5AEAEAD8E62F6F91ULL},
+    {0x487207DF750E9D25ULL, 0x2F22557A51BF8C74ULL},
+    {0x73E9A63254E42EA2ULL, 0x1836EF2A1C65AD86ULL},
+    {0x5CBAEB5B771CF21BULL, 0x2CF8BF54E3848AD2ULL},
+    {0x4A2F22AF927D8E7CULL, 0x23FA32AA4F9D3BDBULL},
+    {0x76B1D118EA627D93ULL, 0x5329EAAA18FB92F8ULL},
+    {0x5EF4A74721E86476ULL, 0x0F54BBBB472FA8C6ULL},
+    {0x4BF6EC38E7ED1D2BULL, 0x25DD62FC38F2ED6CULL},
+    {0x798B138E3FE1C845ULL, 0x22FBD1938E517BDFULL},
+    {0x613C0FA4FFE7D36AULL, 0x4F2FDADC71DAC97FULL},
+    {0x4DC9A61D998642BBULL, 0x58F3157D27E23ACCULL},
+    {0x7C75D695C2706AC5ULL, 0x74B82261D969F7ADULL},
+    {0x63917877CEC0556BULL, 0x10934EB4ADEE5FBEULL},
+    {0x4FA793930BCD1122ULL, 0x4075D8908B251965ULL},
+    {0x7F7285B812E1B504ULL, 0x00BC8DB411D4F56EULL},
+    {0x65F537C675815D9CULL, 0x66FD3E29A7DD9125ULL},
+    {0x5190F96B91344AE3ULL, 0x6BFDCB54864ADA84ULL},
+    {0x4140C78940F6A24FULL, 0x6FFE3C439EA2486AULL},
+    {0x6867A5A867F103B2ULL, 0x7FFD2D38FDD073DCULL},
+    {0x53861E2053273628ULL, 0x6664242D97D9F64AULL},
+    {0x42D1B1B375B8F820ULL, 0x51E9B68ADFE191D5ULL},
+    {0x6AE91C5255F4C034ULL, 0x1CA924116635B621ULL},
+    {0x558749DB77F70029ULL, 0x63BA83411E915E81ULL},
+    {0x446C3B15F9926687ULL, 0x6962029A7EDAB201ULL},
+    {0x6D79F82328EA3DA6ULL, 0x0F03375D97C45001ULL},
+    {0x5794C6828721CAEBULL, 0x259C2C4ADFD04001ULL},
+    {0x46109ECED2816F22ULL, 0x5149BD08B30D0001ULL},
+    {0x701A97B150CF1837ULL, 0x3542C80DEB480001ULL},
+    {0x59AEDFC10D7279C5ULL, 0x7768A00B22A00001ULL},
+    {0x47BF19673DF52E37ULL, 0x79208008E8800001ULL},
+    {0x72CB5BD86321E38CULL, 0x5B67334174000001ULL},
+    {0x5BD5E313828182D6ULL, 0x7C528F6790000001ULL},
+    {0x4977E8DC68679BDFULL, 0x16A872B940000001ULL},
+    {0x758CA7C70D7292FEULL, 0x5773EAC200000001ULL},
+    {0x5E0A1FD271287598ULL, 0x45F6556800000001ULL},
+    {0x4B3B4CA85A86C47AULL, 0x04C5112000000001ULL},
+    {0x785EE10D5DA46D90ULL, 0x07A1B50000000001ULL},
+    {0x604BE73DE4838AD9ULL, 0x52E7C40000000001ULL},
+    {0x4D0985CB1D3608AEULL, 0x0F1FD00000000001ULL},
+    {0x7B426FAB61F00DE3ULL, 0x31CC800000000001ULL},
+    {0x629B8C891B267182ULL, 0x5B0A000000000001ULL},
+    {0x4EE2D6D415B85ACEULL, 0x7C08000000000001ULL},
+    {0x7E37BE2022C0914BULL, 0x1340000000000001ULL},
+    {0x64F964E68233A76FULL, 0x2900000000000001ULL},
+    {0x50C783EB9B5C85F2ULL, 0x5400000000000001ULL},
+    {0x409F9CBC7C4A04C2ULL, 0x1000000000000001ULL},
+    {0x6765C793FA10079DULL, 0x0000000000000001ULL},
+    {0x52B7D2DCC80CD2E4ULL, 0x0000000000000001ULL},
+    {0x422CA8B0A00A4250ULL, 0x0000000000000001ULL},
+    {0x69E10DE76676D080ULL, 0x0000000000000001ULL},
+    {0x54B40B1F852BDA00ULL, 0x0000000000000001ULL},
+    {0x43C33C1937564800ULL, 0x0000000000000001ULL},
+    {0x6C6B935B8BBD4000ULL, 0x0000000000000001ULL},
+    {0x56BC75E2D6310000ULL, 0x0000000000000001ULL},
+    {0x4563918244F40000ULL, 0x0000000000000001ULL},
+    {0x6F05B59D3B200000ULL, 0x0000000000000001ULL},
+    {0x58D15E1762800000ULL, 0x0000000000000001ULL},
+    {0x470DE4DF82000000ULL, 0x0000000000000001ULL},
+    {0x71AFD498D0000000ULL, 0x0000000000000001ULL},
+    {0x5AF3107A40000000ULL, 0x0000000000000001ULL},
+    {0x48C2739500000000ULL, 0x0000000000000001ULL},
+    {0x746A528800000000ULL, 0x0000000000000001ULL},
+    {0x5D21DBA000000000ULL, 0x0000000000000001ULL},
+    {0x4A817C8000000000ULL, 0x0000000000000001ULL},
+    {0x7735940000000000ULL, 0x0000000000000001ULL},
+    {0x5F5E100000000000ULL, 0x0000000000000001ULL},
+    {0x4C4B400000000000ULL, 0x0000000000000001ULL},
+    {0x7A12000000000000ULL, 0x0000000000000001ULL},
+    {0x61A8000000000000ULL, 0x0000000000000001ULL},
+    {0x4E20000000000000ULL, 0x0000000000000001ULL},
+    {0x7D00000000000000ULL, 0x0000000000000001ULL},
+    {0x6400000000000000ULL, 0x0000000000000001ULL},
+    {0x5000000000000000ULL, 0x0000000000000001ULL},
+    {0x4000000000000000ULL, 0x0000000000000001ULL},
+    {0x6666666666666666ULL, 0x3333333333333334ULL},
+    {0x51EB851EB851EB85ULL, 0x0F5C28F5C28F5C29ULL},
+    {0x4189374BC6A7EF9DULL, 0x5916872B020C49BBULL},
+    {0x68DB8BAC710CB295ULL, 0x74F0D844D013A92BULL},
+    {0x53E2D6238DA3C211ULL, 0x43F3E0370CDC8755ULL},
+    {0x431BDE82D7B634DAULL, 0x698FE69270B06C44ULL},
+    {0x6B5FCA6AF2BD215EULL, 0x0F4CA41D811A46D4ULL},
+    {0x55E63B88C230E77EULL, 0x3F70834ACDAE9F10ULL},
+    {0x44B82FA09B5A52CBULL, 0x4C5A02A23E254C0DULL},
+    {0x6DF37F675EF6EADFULL, 0x2D5CD10396A21347ULL},
+    {0x57F5FF85E592557FULL, 0x3DE3DA69454E75D3ULL},
+    {0x465E6604B7A84465ULL, 0x7E4FE1EDD10B9175ULL},
+    {0x709709A125DA0709ULL, 0x4A19697C81AC1BEFULL},
+    {0x5A126E1A84AE6C07ULL, 0x54E1213067BCE326ULL},
+    {0x480EBE7B9D58566CULL, 0x43E74DC052FD8285ULL},
+    {0x734ACA5F6226F0ADULL, 0x530BAF9A1E626A6DULL},
+    {0x5C3BD5191B525A24ULL, 0x426FBFAE7EB521F1ULL},
+    {0x49C97747490EAE83ULL, 0x4EBFCC8B9890E7F4ULL},
+    {0x760F253EDB4AB0D2ULL, 0x4ACC7A78F41B0CBAULL},
+    {0x5E72843249088D75ULL, 0x223D2EC729AF3D62ULL},
+    {0x4B8ED0283A6D3DF7ULL, 0x34FDBF05BAF29781ULL},
+    {0x78E480405D7B9658ULL, 0x54C931A2C4B758CFULL},
+    {0x60B6CD004AC94513ULL, 0x5D6DC14F03C5E0A5ULL},
+    {0x4D5F0A66A23A9DA9ULL, 0x31249AA59C9E4D51ULL},
+    {0x7BCB43D769F762A8ULL, 0x4EA0F76F60FD4882ULL},
+    {0x63090312BB2C4EEDULL, 0x254D92BF80CAA068ULL},
+    {0x4F3A68DBC8F03F24ULL, 0x1DD7A89933D54D20ULL},
+    {0x7EC3DAF941806506ULL, 0x62F2A75B86221500ULL},
+    {0x65697BFA9ACD1D9FULL, 0x025BB91604E810CDULL},
+    {0x51212FFBAF0A7E18ULL, 0x684960DE6A5340A4ULL},
+    {0x40E7599625A1FE7AULL, 0x203AB3E521DC33B6ULL},
+    {0x67D88F56A29CCA5DULL, 0x19F7863B696052BDULL},
+    {0x5313A5DEE87D6EB0ULL, 0x7B2C6B62BAB37564ULL},
+    {0x42761E4BED31255AULL, 0x2F56BC4EFBC2C450ULL},
+    {0x6A5696DFE1E83BC3ULL, 0x655793B192D13A1AULL},
+    {0x5512124CB4B9C969ULL, 0x377942F475742E7BULL},
+    {0x440E750A2A2E3ABAULL, 0x5F9435905DF68B96ULL},
+    {0x6CE3EE76A9E3912AULL, 0x65B9EF4D63241289ULL},
+    {0x571CBEC554B60DBBULL, 0x6AFB25D782834207ULL},
+    {0x45B0989DDD5E7163ULL, 0x08C8EB12CECF6806ULL},
+    {0x6F80F42FC8971BD1ULL, 0x5ADB11B7B14BD9A3ULL},
+    {0x5933F68CA078E30EULL, 0x157C0E2C8DD647B5ULL},
+    {0x475CC53D4D2D8271ULL, 0x5DFCD823A4AB6C91ULL},
+    {0x722E086215159D82ULL, 0x632E269F6DDF141BULL},
+    {0x5B5806B4DDAAE468ULL, 0x4F581EE5F17F4349ULL},
+    {0x49133890B1558386ULL, 0x72ACE584C1329C3BULL},
+    {0x74EB8DB44EEF38D7ULL, 0x6AAE3C079B842D2AULL},
+    {0x5D893E29D8BF60ACULL, 0x5558300616035755ULL},
+    {0x4AD431BB13CC4D56ULL, 0x7779C004DE6912ABULL},
+    {0x77B9E92B52E07BBEULL, 0x258F99A163DB5111ULL},
+    {0x5FC7EDBC424D2FCBULL, 0x37A614811CAF740DULL},
+    {0x4C9FF163683DBFD5ULL, 0x7951AA00E3BF900BULL},
+    {0x7A998238A6C932EFULL, 0x754F7667D2CC19ABULL},
+    {0x6214682D523A8F26ULL, 0x2AA5F8530F09AE22ULL},
+    {0x4E76B9BDDB620C1EULL, 0x55519375A5A1581BULL},
+    {0x7D8AC2C95F034697ULL, 0x3BB5B8BC3C3559C5ULL},
+    {0x646F023AB2690545ULL, 0x7C9160969691149EULL},
+    {0x5058CE955B87376BULL, 0x16DAB3ABABA743B2ULL},
+    {0x40470BAAAF9F5F88ULL, 0x78AEF622EFB902F5ULL},
+    {0x66D812AAB29898DBULL, 0x0DE4BD04B2C19E54ULL},
+    {0x524675555BAD4715ULL, 0x57EA30D08F014B76ULL},
+    {0x41D1F7777C8A9F44ULL, 0x4654F3DA0C01092CULL},
+    {0x694FF258C7443207ULL, 0x23BB1FC346680EACULL},
+    {0x543FF513D29CF4D2ULL, 0x4FC8E635D1ECD88AULL},
+    {0x43665DA9754A5D75ULL, 0x263A51C4A7F0AD3BULL},
+    {0x6BD6FC425543C8BBULL, 0x56C3B607731AAEC4ULL},
+    {0x5645969B77696D62ULL, 0x789C919F8F488BD0ULL},
+    {0x4504787C5F878AB5ULL, 0x46E3A7B2D906D640ULL},
+    {0x6E6D8D93CC0C1122ULL, 0x3E390C515B3E239AULL},
+    {0x5857A4763CD6741BULL, 0x4B60D6A77C31B615ULL},
+    {0x46AC8391CA4529AFULL, 0x55E7121F968E2B44ULL},
+    {0x711405B6106EA919ULL, 0x0971B698F0E3786DULL},
+    {0x5A766AF80D255414ULL, 0x078E2BAD8D82C6BDULL},
+    {0x485EBBF9A41DDCDCULL, 0x6C71BC8AD79BD231ULL},
+    {0x73CAC65C39C96161ULL, 0x2D82C7448C2C8382ULL},
+    {0x5CA23849C7D44DE7ULL, 0x3E023903A356CF9BULL},
+    {0x4A1B603B06437185ULL, 0x7E682D9C82ABD949ULL},
+    {0x76923391A39F1C09ULL, 0x4A4048FA6AAC8EDBULL},
+    {0x5EDB5C7482E5B007ULL, 0x55003A61EEF07249ULL},
+    {0x4BE2B05D35848CD2ULL, 0x773361E7F259F507ULL},
+    {0x796AB3C855A0E151ULL, 0x3EB89CA6508FEE71ULL},
+    {0x6122296D114D810DULL, 0x7EFA16EB73A6585BULL},
+    {0x4DB4EDF0DAA4673EULL, 0x3261ABEF8FB846AFULL},
+    {0x7C54AFE7C43A3ECAULL, 0x1D691318E5F3A44BULL},
+    {0x6376F31FD02E98A1ULL, 0x64540F471E5C836FULL},
+    {0x4F925C1973587A1BULL, 0x0376729F4B7D35F3ULL},
+    {0x7F50935BEBC0C35EULL, 0x38BD84321261EFEBULL},
+    {0x65DA0F7CBC9A35E5ULL, 0x13CAD0280EB4BFEFULL},
+    {0x517B3F96FD482B1DULL, 0x5CA240200BC3CCBFULL},
+    {0x412F66126439BC17ULL, 0x63B50019A3030A33ULL},
+    {0x684BD683D38F9359ULL, 0x1F88002904D1A9EAULL},
+    {0x536FDECFDC72DC47ULL, 0x32D3335403DAEE55ULL},
+    {0x42BFE57316C249D2ULL, 0x5BDC291003158B77ULL},
+    {0x6ACCA251BE03A951ULL, 0x12F9DB4CD1BC1258ULL},
+    {0x557081DAFE695440ULL, 0x7594AF70A7C9A847ULL},
+    {0x445A017BFEBAA9CDULL, 0x4476F2C0863AED06ULL},
+    {0x6D5CCF2CCAC442E2ULL, 0x3A57EACDA3917B3CULL},
+    {0x577D728A3BD03581ULL, 0x7B7988A482DAC8FDULL},
+    {0x45FDF53B630CF79BULL, 0x15FAD3B6CF156D97ULL},
+    {0x6FFCBB923814BF5EULL, 0x565E1F8AE4EF15BEULL},
+    {0x5996FC74F9AA32B2ULL, 0x11E4E608B725AAFFULL},
+    {0x47ABFD2A6154F55BULL, 0x27EA51A0928488CCULL},
+    {0x72ACC843CEEE555EULL, 0x7310829A84074146ULL},
+    {0x5BBD6D030BF1DDE5ULL, 0x42739BAED005CDD2ULL},
+    {0x49645735A327E4B7ULL, 0x4EC2E2F24004A4A8ULL},
+    {0x756D5855D1D96DF2ULL, 0x4AD16B1D333AA10CULL},
+    {0x5DF11377DB1457F5ULL, 0x2241227DC2954DA3ULL},
+    {0x4B2742C648DD132AULL, 0x4E9A81FE35443E1CULL},
+    {0x783ED13D4161B844ULL, 0x175D9CC9EED39694ULL},
+    {0x603240FDCDE7C69CULL, 0x7917B0A18BDC7876ULL},
+    {0x4CF500CB0B1FD217ULL, 0x1412F3B46FE39392ULL},
+    {0x7B219ADE7832E9BEULL, 0x535185ED7FD285B6ULL},
+    {0x628148B1F9C25498ULL, 0x42A79E57997537C5ULL},
+    {0x4ECDD3C1949B76E0ULL, 0x3552E512E12A9304ULL},
+    {0x7E161F9C20F8BE33ULL, 0x6EEB081E3510EB39ULL},
+    {0x64DE7FB01A609829ULL, 0x3F226CE4F740BC2EULL},
+    {0x50B1FFC0151A1354ULL, 0x3281F0B72C33C9BEULL},
+    {0x408E66334414DC43ULL, 0x42018D5F568FD498ULL},
+    {0x674A3D1ED354939FULL, 0x1CCF48988A7FBA8DULL},
+    {0x52A1CA7F0F76DC7FULL, 0x30A5D3AD3B99620BULL},
+    {0x421B0865A5F8B065ULL, 0x73B7DC8A96144E6FULL},
+    {0x69C4DA3C3CC11A3CULL, 0x52BFC7442353B0B1ULL},
+    {0x549D7B6363CDAE96ULL, 0x756639034F7626F4ULL},
+    {0x43B12F82B63E2545ULL, 0x4451C735D92B525DULL},
+    {0x6C4EB26ABD303BA2ULL, 0x3A1C71EFC1DEEA2EULL},
+    {0x56A55B889759C94EULL, 0x61B05B2634B254F2ULL},
+    {0x45511606DF7B0772ULL, 0x1AF37C1E908EAA5BULL},
+    {0x6EE8233E325E7250ULL, 0x2B1F2CFDB41776F8ULL},
+    {0x58B9B5CB5B7EC1D9ULL, 0x6F4C23FE29AC5F2DULL},
+    {0x46FAF7D5E2CBCE47ULL, 0x72A34FFE87BD18F1ULL},
+    {0x71918C896ADFB073ULL, 0x04387FFDA5FB5B1BULL},
+    {0x5ADAD6D4557FC05CULL, 0x0360666484C915AFULL},
+    {0x48AF1243779966B0ULL, 0x02B3851D3707448CULL},
+    {0x744B506BF28F0AB3ULL, 0x1DEC082EBE720746ULL},
+    {0x5D090D2328726EF5ULL, 0x64BCD358985B3905ULL},
+    {0x4A6DA41C205B8BF7ULL, 0x6A30A913AD15C738ULL},
+    {0x7715D36033C5ACBFULL, 0x5D1AA81F7B560B8CULL},
+    {0x5F44A919C3048A32ULL, 0x7DAEECE5FC44D609ULL},
+    {0x4C36EDAE359D3B5BULL, 0x7E258A51969D7808ULL},
+    {0x79F17C49EF61F893ULL, 0x16A276E8F0FBF33FULL},
+    {0x618DFD07F2B4C6DCULL, 0x121B9253F3FCC299ULL},
+    {0x4E0B30D328909F16ULL, 0x41AFA84329970214ULL},
+    {0x7CDEB4850DB431BDULL, 0x4F7F739EA8F19CEDULL},
+    {0x63E55D373E29C164ULL, 0x3F99294BBA5AE3F1ULL},
+    {0x4FEAB0F8FE87CDE9ULL, 0x7FADBAA2FB7BE98DULL},
+    {0x7FDDE7F4CA72E30FULL, 0x7F7C5DD1925FDC15ULL},
+    {0x664B1FF7085BE8D9ULL, 0x4C637E4141E649ABULL},
+    {0x51D5B32C06AFED7AULL, 0x704F983434B83AEFULL},
+    {0x4177C2899EF32462ULL, 0x26A6135CF6F9C8BFULL},
+    {0x68BF9DA8FE51D3D0ULL, 0x3DD685618B294132ULL},
+    {0x53CC7E20CB74A973ULL, 0x4B12044E08EDCDC2ULL},
+    {0x4309FE80A2C3BAC2ULL, 0x6F419D0B3A57D7CEULL},
+    {0x6B4330CDD1392AD1ULL, 0x320294DEC3BFBFB0ULL},
+    {0x55CF5A3E40FA88A7ULL, 0x419BAA4BCFCC995AULL},
+    {0x44A5E1CB672ED3B9ULL, 0x1AE2EEA30CA3ADE1ULL},
+    {0x6DD636123EB152C1ULL, 0x77D17DD1ADD2AFCFULL},
+    {0x57DE91A832277567ULL, 0x797464A7BE42263FULL},
+    {0x464BA7B9C1B92AB9ULL, 0x4790508631CE84FFULL},
+    {0x70790C5C6928445CULL, 0x0C1A1A704FB0D4CCULL},
+    {0x59FA7049EDB9D049ULL, 0x567B4859D95A43D6ULL},
+    {0x47FB8D07F161736EULL, 0x11FC39E17AAE9CABULL},
+    {0x732C14D98235857DULL, 0x032D2968C44A9445ULL},
+    {0x5C2343E134F79DFDULL, 0x4F575453D03BA9D1ULL},
+    {0x49B5CFE75D92E4CAULL, 0x72AC4376402FBB0EULL},
+    {0x75EFB30BC8EB07ABULL, 0x0446D256CD192B49ULL},
+    {0x5E595C096D88D2EFULL, 0x1D0575123DADBC3AULL},
+    {0x4B7AB0078AD3DBF2ULL, 0x4A6AC40E97BE302FULL},
+    {0x78C44CD8DE1FC650ULL, 0x771139B0F2C9E6B1ULL},
+    {0x609D0A4718196B73ULL, 0x78DA948D8F07EBC1ULL},
+    {0x4D4A6E9F467ABC5CULL, 0x60AEDD3E0C065634ULL},
+    {0x7BAA4A9870C46094ULL, 0x344AFB9679A3BD20ULL},
+    {0x62EEA2138D69E6DDULL, 0x103BFC78614FCA80ULL},
+    {0x4F254E760ABB1F17ULL, 0x26966393810CA200ULL},
+    {0x7EA21723445E9825ULL, 0x2423D2859B476999ULL},
+    {0x654E78E9037EE01DULL, 0x69B642047C392148ULL},
+    {0x510B93ED9C658017ULL, 0x6E2B680396941AA0ULL},
+    {0x40D60FF149EACCDFULL, 0x71BC53361210154DULL},
+    {0x67BCE64EDCAAE166ULL, 0x1C6085235019BBAEULL},
+    {0x52FD850BE3BBE784ULL, 0x7D1A041C40149625ULL},
+    {0x42646A6FE9631F9DULL, 0x4A7B367D0010781DULL},
+    {0x6A3A43E642383295ULL, 0x5D91F0C8001A59C8ULL},
+    {0x54FB698501C68EDEULL, 0x17A7F3D3334847D4ULL},
+    {0x43FC546A67D20BE4ULL, 0x79532975C2A03976ULL},
+    {0x6CC6ED770C83463BULL, 0x0EEB75893766C256ULL},
+    {0x57058AC5A39C382FULL, 0x25892AD42C523512ULL},
+    {0x459E089E1C7CF9BFULL, 0x37A0EF102374F742ULL},
+    {0x6F6340FCFA618F98ULL, 0x59017E8038BB2536ULL},
+    {0x591C33FD951AD946ULL, 0x7A67986693C8EA91ULL},
+    {0x4749C33144157A9FULL, 0x151FAD1EDCA0BBA8ULL},
+    {0x720F9EB539BBF765ULL, 0x0832AE97C76792A5ULL},
+    {0x5B3FB22A94965F84ULL, 0x068EF21305EC7551ULL},
+    {0x48FFC1BBAA11E603ULL, 0x1ED8C1A8D189F774ULL},
+    {0x74CC692C434FD66BULL, 0x4AF4690E1C0FF253ULL},
+    {0x5D705423690CAB89ULL, 0x225D20D816732843ULL},
+    {0x4AC0434F873D5607ULL, 0x35174D79AB8F5369ULL},
+    {0x779A054C0B955672ULL, 0x21BEE25C45B21F0EULL},
+    {0x5FAE6AA33C77785BULL, 0x3498B5169E2818D8ULL},
+    {0x4C8B888296C5F9E2ULL, 0x5D46F7454B534713ULL},
+    {0x7A78DA6A8AD65C9DULL, 0x7BA4BED545520B52ULL},
+    {0x61FA48553BDEB07EULL, 0x2FB6FF110441A2A8ULL},
+    {0x4E61D37763188D31ULL, 0x72F8CC0D9D014EEDULL},
+    {0x7D6952589E8DAEB6ULL, 0x1E5AE015C80217E1ULL},
+    {0x645441E07ED7BEF8ULL, 0x1848B344A001ACB4ULL},
+    {0x504367E6CBDFCBF9ULL, 0x603A2903B3348A2AULL},
+    {0x4035ECB8A3196FFBULL, 0x002E873628F6D4EEULL},
+    {0x66BCADF43828B32BULL, 0x19E40B89DB2487E3ULL},
+    {0x52308B29C686F5BCULL, 0x14B66FA17C1D3983ULL},
+    {0x41C06F549ED25E30ULL, 0x1091F2E7967DC79CULL},
+    {0x6933E554315096B3ULL, 0x341CB7D8F0C93F5FULL},
+    {0x542984435AA6DEF5ULL, 0x767D5FE0C0A0FF80ULL},
+    {0x435469CF7BB8B25EULL, 0x2B977FE70080CC66ULL},
+    {0x6BBA42E592C11D63ULL, 0x5F58CCA4CD9AE0A3ULL},
+    {0x562E9BEADBCDB11CULL, 0x4C470A1D7148B3B6ULL},
+    {0x44F216557CA48DB0ULL, 0x3D05A1B1276D5C92ULL},
+    {0x6E5023BBFAA0E2B3ULL, 0x7B3C35E83F1560E9ULL},
+    {0x58401C96621A4EF6ULL, 0x2F635E5365AAB3EDULL},
+    {0x4699B0784E7B725EULL, 0x591C4B75EAEEF658ULL},
+    {0x70F5E726E3F8B6FDULL, 0x74FA125644B18A26ULL},
+    {0x5A5E5285832D5F31ULL, 0x43FB41DE9D5AD4EBULL},
+    {0x484B75379C244C27ULL, 0x4FFC34B2177BDD89ULL},
+    {0x73ABEEBF603A1372ULL, 0x4CC6BAB68BF96274ULL},
+    {0x5C898BCC4CFB42C2ULL, 0x0A38955ED6611B90ULL},
+    {0x4A07A309D72F689BULL, 0x21C6DDE5784DAFA7ULL},
+    {0x76729E762518A75EULL, 0x693E2FD58D49190BULL},
+    {0x5EC2185E8413B918ULL, 0x5431BFDE0AA0E0D5ULL},
+    {0x4BCE79E536762DADULL, 0x29C1664B3BB3E711ULL},
+    {0x794A5CA1F0BD15E2ULL, 0x0F9BD6DEC5ECA4E8ULL},
+    {0x61084A1B26FDAB1BULL, 0x2616457F04BD50BAULL},
+    {0x4DA03B48EBFE227CULL, 0x1E783798D09773C8ULL},
+    {0x7C33920E46636A60ULL, 0x30C058F480F252D9ULL},
+    {0x635C74D8384F884DULL, 0x0D66AD9067284247ULL},
+    {0x4F7D2A469372D370ULL, 0x711EF14052869B6CULL},
+    {0x7F2EAA0A85848581ULL, 0x34FE4ECD50D75F14ULL},
+    {0x65BEEE6ED136D134ULL, 0x2A650BD773DF7F43ULL},
+    {0x51658B8BDA9240F6ULL, 0x551DA312C319329CULL},
+    {0x411E093CAEDB672BULL, 0x5DB14F4235ADC217ULL},
+    {0x68300EC77E2BD845ULL, 0x7C4EE536BC49368AULL},
+    {0x5359A56C64EFE037ULL, 0x7D0BEA92303A9208ULL},
+    {0x42AE1DF050BFE693ULL, 0x173CBBA8269541A0ULL},
+    {0x6AB02FE6E79970EBULL, 0x3EC792A6A422029AULL},
+    {0x5559BFEBEC7AC0BCULL, 0x3239421EE9B4CEE1ULL},
+    {0x4447CCBCBD2F0096ULL, 0x5B6101B25490A581ULL},
+    {0x6D3FADFAC84B3424ULL, 0x2BCE691D541AA268ULL},
+    {0x576624C8A03C29B6ULL, 0x563EBA7DDCE21B87ULL},
+    {0x45EB50A08030215EULL, 0x78322ECB171B4939ULL},
+    {0x6FDEE76733803564ULL, 0x59E9E47824F87527ULL},
+    {0x597F1F85C2CCF783ULL, 0x6187E9F9B72D2A86ULL},
+    {0x4798E6049BD72C69ULL, 0x346CBB2E2C242205ULL},
+    {0x728E3CD42C8B7A42ULL, 0x20ADF849E039D007ULL},
+    {0x5BA4FD768A092E9BULL, 0x33BE603B19C7D99FULL},
+    {0x4950CAC53B3A8BAFULL, 0x42FEB3627B0647B3ULL},
+    {0x754E113B91F745E5ULL, 0x5197856A5E7072B8ULL},
+    {0x5DD80DC941929E51ULL, 0x27AC6ABB7EC05BC6ULL},
+    {0x4B133E3A9ADBB1DAULL, 0x52F05562CBCD1638ULL},
+    {0x781EC9F75E2C4FC4ULL, 0x1E4D556ADFAE89F3ULL},
+    {0x6018A192B1BD0C9CULL, 0x7EA444557FBED4C3ULL},
+    {0x4CE0814227CA707DULL, 0x4BB69D1132FF109CULL},
+    {0x7B00CED03FAA4D95ULL, 0x5F8A94E851981A93ULL},
+    {0x62670BD9CC883E11ULL, 0x32D543ED0E134875ULL},
+    {0x4EB8D647D6D364DAULL, 0x5BDDCFF0D80F6D2BULL},
+    {0x7DF48A0C8AEBD491ULL, 0x12FC7FE7C018AEABULL},
+    {0x64C3A1A3A25643A7ULL, 0x28C9FFEC99AD5889ULL},
+    {0x509C814FB511CFB9ULL, 0x0707FFF07AF113A1ULL},
+    {0x407D343FC40E3FC7ULL, 0x1F39998D2F2742E7ULL},
+    {0x672EB9FFA016CC71ULL, 0x7EC28F484B7204A4ULL},
+    {0x528BC7FFB345705BULL, 0x189BA5D36F8E6A1DULL},
+    {0x42096CCC8F6AC048ULL, 0x7A161E42BFA521B1ULL},
+    {0x69A8AE1418AACD41ULL, 0x435696D132A1CF81ULL},
+    {0x5486F1A9AD557101ULL, 0x1C454574288172CEULL},
+    {0x439F27BAF1112734ULL, 0x169DD129BA0128A5ULL},
+    {0x6C31D92B1B4EA520ULL, 0x242FB50F9001DAA1ULL},
+    {0x568E4755AF721DB3ULL, 0x368C90D940017BB4ULL},
+    {0x453E9F77BF8E7E29ULL, 0x120A0D7A999AC95DULL},
+    {0x6ECA98BF98E3FD0EULL, 0x50101590F5C47561ULL},
+    {0x58A213CC7A4FFDA5ULL, 0x26734473F7D05DE8ULL},
+    {0x46E80FD6C83FFE1DULL, 0x6B8F69F65FD9E4B9ULL},
+    {0x71734C8AD9FFFCFCULL, 0x45B24323CC8FD45CULL},
+    {0x5AC2A3A247FFFD96ULL, 0x6AF502830A0CA9E3ULL},
+    {0x489BB61B6CCCCADFULL, 0x08C402026E7087E9ULL},
+    {0x742C569247AE1164ULL, 0x746CD003E3E73FDBULL},
+    {0x5CF04541D2F1A783ULL, 0x76BD73364FEC3315ULL},
+    {0x4A59D101758E1F9CULL, 0x5EFDF5C50CBCF5ABULL},
+    {0x76F61B3588E365C7ULL, 0x4B2FEFA1ADFB22ABULL},
+    {0x5F2B48F7A0B5EB06ULL, 0x08F3261AF195B555ULL},
+    {0x4C22A0C61A2B226BULL, 0x20C284E25ADE2AABULL},
+    {0x79D1013CF6AB6A45ULL, 0x1AD0D49D5E304444ULL},
+    {0x617400FD9222BB6AULL, 0x48A7107DE4F369D0ULL},
+    {0x4DF6673141B562BBULL, 0x53B8D9FE50C2BB0DULL},
+    {0x7CBD71E869223792ULL, 0x52C15CCA1AD12B48ULL},
+    {0x63CAC186BA81C60EULL, 0x75677D6E7BDA8906ULL},
+    {0x4FD5679EFB9B04D8ULL, 0x5DEC645863153A6CULL},
+    {0x7FBBD8FE5F5E6E27ULL, 0x497A3A2704EEC3DFULL}
+};
+
+// - Implementation -
+
+int __memctx_floor_log2_pow10(int e) {
+    return (int)((uint64_t)((int64_t)e * 913124641741LL + ((int64_t)1 << 52)) >> 38) - (1 << 14);
+}
+
+#endif
@@ -0,0 +1,1039 @@
+// Copyright (c) 2025 Vladimir Fedorov
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This header file contains the implementation of all regular expression functions.
+
+#ifndef _MEMCTX_REGEX_H_
+#define _MEMCTX_REGEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memctx.h"
+#include "memctx_strings.h"
+
+// Default limit of DFA states built for one regex; past it matching continues on the NFA
+#ifndef REGEX_MAX_STATES
+#define REGEX_MAX_STATES 4096
+#endif
+
+// Limits of the compiled pattern
+#define REGEX_MAX_NFA_STATES 65536
+#define REGEX_MAX_REPEAT 1000
+#define REGEX_MAX_DEPTH 256
+
+#define REGEX_NONE UINT32_MAX
+
+// NFA operations
+enum {
+    REGEX_OP_BYTE,              // consumes a byte from `set`, continues at `out`
+    REGEX_OP_SPLIT,             // continues at both `out` and `out1`
+    REGEX_OP_EMPTY,             // continues at `out`
+    REGEX_OP_BEGIN,             // continues at `out` at the start of the input
+    REGEX_OP_END,               // continues at `out` at the end of the input
+    REGEX_OP_MATCH
+};
+
+// Pattern syntax tree nodes
+enum {
+    REGEX_NODE_EMPTY,
+    REGEX_NODE_SET,
+    REGEX_NODE_CONCAT,
+    REGEX_NODE_ALT,
+    REGEX_NODE_REPEAT,
+    REGEX_NODE_BEGIN,
+    REGEX_NODE_END
+};
+
+typedef struct memctx_regex_nfa_state {
+    uint32_t op;
+    uint32_t set;
+    uint32_t out;
+    uint32_t out1;
+} regex_nfa_state;
+
+// DFA state flags, checked once per byte
+#define REGEX_STATE_MATCH   1
+#define REGEX_STATE_DEAD    2           // no match can follow
+#define REGEX_STATE_UNKNOWN 4           // the transition is not built yet
+
+typedef struct memctx_regex_dfa_state {
+    uint32_t *states;                       // sorted NFA states this state stands for
+    size_t count;
+    uint64_t hash;
+    unsigned flags;
+    bool match_end;                         // matches if the input ends here
+    struct memctx_regex_dfa_state *next[];  // by byte class, `unknown` until first taken
+} regex_dfa_state;
+
+typedef struct memctx_regex {
+    regex_nfa_state *nfa;
+    size_t nfa_count;
+    uint64_t (*sets)[4];        // byte sets of REGEX_OP_BYTE states
+    size_t set_count;
+    uint32_t match;             // the REGEX_OP_MATCH state
+    bool begin_only;            // every match starts at the first byte
+
+    // Bytes no set tells apart share a class, so DFA states only need one transition per class
+    uint8_t classes[256];
+    uint8_t class_bytes[256];   // a byte of each class
+    size_t class_count;
+
+    regex_dfa_state *anchored;  // start states
+    regex_dfa_state *unanchored;
+    regex_dfa_state *unknown;   // target of transitions not built yet
+    regex_dfa_state **table;    // DFA states by NFA state set
+    size_t table_capacity;
+    size_t dfa_count;
+    size_t max_states;
+
+    // Scratch sets for building states and for NFA simulation
+    uint32_t *current;
+    uint32_t *next;
+    uint32_t *closure;
+    uint32_t *stack;
+    uint32_t *marks;
+    uint32_t generation;
+
+    MemContext *ctx;
+} regex;
+
+typedef struct memctx_regex_node {
+    int type;
+    uint32_t set;
+    int min;
+    int max;                    // -1 for no upper bound
+    struct memctx_regex_node *left;
+    struct memctx_regex_node *right;
+} regex_node;
+
+typedef struct memctx_regex_fragment {
+    uint32_t start;
+    uint32_t holes;             // list of unset `out` fields, threaded through them
+} regex_fragment;
+
+typedef struct memctx_regex_parser {
+    const char *pattern;
+    size_t length;
+    size_t position;
+    size_t depth;
+    MemContext *nodes;
+    uint64_t (*sets)[4];
+    size_t set_count;
+    size_t set_capacity;
+    regex_nfa_state *nfa;
+    size_t nfa_count;
+    size_t nfa_capacity;
+    bool failed;
+} regex_parser;
+
+/**
+ * Compiles a regular expression. Matching builds a DFA lazily, one state per new
+ * set of NFA states, so it takes time linear in the input length with no backtracking.
+ * When `max_states` DFA states exist, matching continues by simulating the NFA, which is
+ * still linear but slower.
+ *
+ * Syntax (bytes, not UTF-8 characters):
+ *  - literals; `.` for any byte but '\n'; `[abc]`, `[a-z]`, `[^...]` sets
+ *  - `\d \w \s \D \W \S`, `\n \t \r \f \v`, `\xHH`, and `\` before punctuation for the character itself
+ *  - `(...)` groups, `|` alternation, `*`, `+`, `?`, `{n}`, `{n,}`, `{n,m}` repetition
+ *  - `^` and `$` match at the start and end of the input only
+ *
+ * Parameters:
+ *  - ctx          The memory context for the regex and its DFA states.
+ *  - pattern      The pattern (can be either string or char*).
+ *
+ * Returns the compiled regex, or NULL if the pattern is invalid or allocation fails.
+ * A regex caches DFA states while matching, so it must not be used by several threads at once.
+ */
+#define regex_compile(ctx, pattern) __regex_compile(ctx, __string_arg(pattern))
+
+/**
+ * Checks whether the regex matches a part of the string, like `grep`.
+ *
+ * Parameters:
+ *  - re           The regex.
+ *  - str          The string to search (can be either string or char*), it does not have to be terminated.
+ *
+ * Returns true if some substring matches.
+ */
+#define regex_search(re, str) __regex_search(re, __string_arg(str))
+
+/**
+ * Checks whether the regex matches the whole string.
+ *
+ * Parameters:
+ *  - re           The regex.
+ *  - str          The string to match (can be either string or char*).
+ *
+ * Returns true if the whole string matches.
+ */
+#define regex_match(re, str) __regex_match(re, __string_arg(str))
+
+regex* __regex_compile(MemContext *ctx, substring pattern);
+
+bool __regex_search(regex *re, substring str);
+
+bool __regex_match(regex *re, substring str);
+
+/**
+ * Runs the DFA over the input, building missing states on the way.
+ *
+ * Parameters:
+ *  - anchored     The match starts at the first byte.
+ *  - full         The match ends at the last byte.
+ */
+bool __regex_run(regex *re, const char *value, size_t length, bool anchored, bool full);
+
+/**
+ * Continues matching from a DFA state by simulating the NFA.
+ */
+bool __regex_run_nfa(regex *re, regex_dfa_state *state, const char *value, size_t length, bool full);
+
+/**
+ * Returns the DFA state reached from `state` on bytes of class `byte_class`, or NULL at the state limit.
+ */
+regex_dfa_state* __regex_transition(regex *re, regex_dfa_state *state, size_t byte_class);
+
+/**
+ * Returns the DFA state for the set of NFA states in `re->next`, creating it if needed,
+ * or NULL at the state limit.
+ */
+regex_dfa_state* __regex_dfa_state(regex *re, size_t count);
+
+/**
+ * Allocates a DFA state for the set of NFA states in `re->next`, just computed by `__regex_add`.
+ */
+regex_dfa_state* __regex_new_state(regex *re, size_t count, uint64_t hash, bool at_begin);
+
+/**
+ * Checks whether a set of NFA states matches if the input ends after it.
+ */
+bool __regex_accepts_at_end(regex *re, const uint32_t *states, size_t count, bool at_begin);
+
+int __regex_compare_states(const void *a, const void *b);
+
+/**
+ * Computes the NFA states reached from `from` on `byte`, following empty transitions.
+ *
+ * Returns the number of states written to `to`.
+ */
+size_t __regex_step(regex *re, const uint32_t *from, size_t count, unsigned char byte, uint32_t *to);
+
+/**
+ * Adds `state` and the states reachable from it by empty transitions to `to`.
+ * `^` is passed only if `at_begin`; `$` is passed if `at_end`, and kept in the set otherwise.
+ */
+void __regex_add(regex *re, uint32_t state, uint32_t *to, size_t *count, bool at_begin, bool at_end);
+
+/**
+ * Starts a new generation of visited marks.
+ */
+void __regex_next_generation(regex *re);
+
+/**
+ * Computes byte classes: bytes that belong to exactly the same sets get the same class.
+ */
+void __regex_byte_classes(regex *re);
+
+/**
+ * Recursive descent parser: alternation, concatenation, repetition, atoms.
+ */
+regex_node* __regex_parse_alt(regex_parser *p);
+regex_node* __regex_parse_concat(regex_parser *p);
+regex_node* __regex_parse_repeat(regex_parser *p);
+regex_node* __regex_parse_atom(regex_parser *p);
+regex_node* __regex_parse_class(regex_parser *p);
+
+/**
+ * Parses an escape after '\'. Adds the escaped byte or byte class to `set`.
+ *
+ * Returns the escaped byte, -1 for a class such as `\d`, or -2 for an invalid escape.
+ */
+int __regex_parse_escape(regex_parser *p, uint64_t *set);
+
+/**
+ * Parses a decimal repeat count.
+ */
+bool __regex_parse_count(regex_parser *p, int *value);
+
+regex_node* __regex_node(regex_parser *p, int type, regex_node *left, regex_node *right);
+
+/**
+ * Adds an empty byte set and returns its index, or REGEX_NONE if allocation fails.
+ */
+uint32_t __regex_new_set(regex_parser *p);
+
+void __regex_set_range(uint64_t *set, unsigned char low, unsigned char high);
+
+/**
+ * Thompson construction: emits NFA states for a node.
+ */
+regex_fragment __regex_emit(regex_parser *p, regex_node *node);
+
+uint32_t __regex_emit_state(regex_parser *p, uint32_t op, uint32_t set, uint32_t out, uint32_t out1);
+
+/**
+ * Returns the field of a hole. A hole is (state << 1) | field, where field 1 is `out1`;
+ * until patched, the field holds the next hole of its list.
+ */
+uint32_t* __regex_hole(regex_parser *p, uint32_t hole);
+
+/**
+ * Points every hole of a list to `target`.
+ */
+void __regex_patch(regex_parser *p, uint32_t holes, uint32_t target);
+
+/**
+ * Joins two hole lists.
+ */
+uint32_t __regex_join(regex_parser *p, uint32_t first, uint32_t second);
+
+// - Implementation -
+
+regex* __regex_compile(MemContext *ctx, substring pattern) {
+    if (!ctx || !pattern.value) return NULL;
+
+    regex_parser p;
+    memset(&p, 0, sizeof(p));
+    p.pattern = pattern.value;
+    p.length = pattern.length;
+
+    regex *re = NULL;
+    p.nodes = memctx();
+    regex_node *root = p.nodes ? __regex_parse_alt(&p) : NULL;
+    if (!root || p.failed || p.position != p.length) goto done;
+
+    // Unanchored search starts at `loop`, which consumes any byte and stays, or enters the pattern
+    uint32_t any = __regex_new_set(&p);
+    if (any == REGEX_NONE) goto done;
+    __regex_set_range(p.sets[any], 0, 255);
+
+    regex_fragment body = __regex_emit(&p, root);
+    uint32_t match = __regex_emit_state(&p, REGEX_OP_MATCH, 0, REGEX_NONE, REGEX_NONE);
+    uint32_t any_byte = __regex_emit_state(&p, REGEX_OP_BYTE, any, REGEX_NONE, REGEX_NONE);
+    uint32_t loop = __regex_emit_state(&p, REGEX_OP_SPLIT, 0, any_byte, body.start);
+    if (p.failed) goto done;
+    __regex_patch(&p, body.holes, match);
+    p.nfa[any_byte].out = loop;
+
+    re = (regex *)memctx_alloc(ctx, sizeof(regex));
+    if (!re) goto done;
+    memset(re, 0, sizeof(regex));
+    re->ctx = ctx;
+    re->nfa_count = p.nfa_count;
+    re->match = match;
+    re->max_states = REGEX_MAX_STATES;
+    re->table_capacity = 64;
+
+    re->nfa = (regex_nfa_state *)memctx_alloc(ctx, sizeof(regex_nfa_state) * p.nfa_count);
+    re->sets = (uint64_t (*)[4])memctx_alloc(ctx, sizeof(uint64_t[4]) * p.set_count);
+    re->table = (regex_dfa_state **)memctx_alloc(ctx, sizeof(regex_dfa_state *) * re->table_capacity);
+    re->current = (uint32_t *)memctx_alloc(ctx, sizeof(uint32_t) * p.nfa_count);
+    re->next = (uint32_t *)memctx_alloc(ctx, sizeof(uint32_t) * p.nfa_count);
+    re->closure = (uint32_t *)memctx_alloc(ctx, sizeof(uint32_t) * p.nfa_count);
+    re->stack = (uint32_t *)memctx_alloc(ctx, sizeof(uint32_t) * (2 * p.nfa_count + 1));
+    re->marks = (uint32_t *)memctx_alloc(ctx, sizeof(uint32_t) * p.nfa_count);
+    if (!re->nfa || !re->sets || !re->table || !re->current || !re->next || !re->closure || !re->stack || !re->marks) {
+        re = NULL;
+        goto done;
+    }
+    memcpy(re->nfa, p.nfa, sizeof(regex_nfa_state) * p.nfa_count);
+    memcpy(re->sets, p.sets, sizeof(uint64_t[4]) * p.set_count);
+    memset(re->table, 0, sizeof(regex_dfa_state *) * re->table_capacity);
+    memset(re->marks, 0, sizeof(uint32_t) * p.nfa_count);
+
+    re->set_count = p.set_count;
+    __regex_byte_classes(re);
+
+    re->unknown = (regex_dfa_state *)memctx_alloc(ctx, sizeof(regex_dfa_state));
+    if (!re->unknown) {
+        re = NULL;
+        goto done;
+    }
+    memset(re->unknown, 0, sizeof(regex_dfa_state));
+    re->unknown->flags = REGEX_STATE_UNKNOWN;
+
+    // Start states pass `^`, so they are kept out of the table of states reached later
+    size_t count = 0;
+    __regex_next_generation(re);
+    __regex_add(re, body.start, re->next, &count, true, false);
+    re->anchored = __regex_new_state(re, count, 0, true);
+
+    count = 0;
+    __regex_next_generation(re);
+    __regex_add(re, loop, re->next, &count, true, false);
+    re->unanchored = __regex_new_state(re, count, 0, true);
+
+    // Without `^` nothing can be entered past the first byte: search only from the start
+    count = 0;
+    __regex_next_generation(re);
+    __regex_add(re, body.start, re->next, &count, false, false);
+    re->begin_only = count == 0;
+
+    if (!re->anchored || !re->unanchored) re = NULL;
+
+done:
+    if (p.nodes) memctx_free(p.nodes);
+    free(p.sets);
+    free(p.nfa);
+    return re;
+}
+
+bool __regex_search(regex *re, substring str) {
+    if (!re || !str.value) return false;
+    return __regex_run(re, str.value, str.length, re->begin_only, false);
+}
+
+bool __regex_match(regex *re, substring str) {
+    if (!re || !str.value) return false;
+    return __regex_run(re, str.value, str.length, true, true);
+}
+
+bool __regex_run(regex *re, const char *value, size_t length, bool anchored, bool full) {
+    regex_dfa_state *state = anchored ? re->anchored : re->unanchored;
+    if ((state->flags & REGEX_STATE_MATCH) && !full) return true;
+
+    const unsigned char *bytes = (const unsigned char *)value;
+    for (size_t i = 0; i < length; i++) {
+        regex_dfa_state *next = state->next[re->classes[bytes[i]]];
+        if (next->flags) {
+            if (next->flags & REGEX_STATE_UNKNOWN) {
+                next = __regex_transition(re, state, re->classes[bytes[i]]);
+                if (!next) return __regex_run_nfa(re, state, value + i, length - i, full);
+            }
+            if ((next->flags & REGEX_STATE_MATCH) && !full) return true;
+            if (next->flags & REGEX_STATE_DEAD) return false;
+        }
+        state = next;
+    }
+    return state->match_end;
+}
+
+bool __regex_run_nfa(regex *re, regex_dfa_state *state, const char *value, size_t length, bool full) {
+    uint32_t *current = re->current;
+    uint32_t *next = re->next;
+    size_t count = state->count;
+    if (count > 0) memcpy(current, state->states, sizeof(uint32_t) * count);
+
+    bool match = state->flags & REGEX_STATE_MATCH;
+    for (size_t i = 0; i < length; i++) {
+        count = __regex_step(re, current, count, (unsigned char)value[i], next);
+        match = re->marks[re->match] == re->generation;
+
+        uint32_t *swap = current;
+        current = next;
+        next = swap;
+
+        if (match && !full) return true;
+        if (count == 0) return false;
+    }
+    return match || __regex_accepts_at_end(re, current, count, false);
+}
+
+regex_dfa_state* __regex_transition(regex *re, regex_dfa_state *state, size_t byte_class) {
+    size_t count = __regex_step(re, state->states, state->count, re->class_bytes[byte_class], re->next);
+    regex_dfa_state *next = __regex_dfa_state(re, count);
+    if (next) state->next[byte_class] = next;
+    return next;
+}
+
+int __regex_compare_states(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+regex_dfa_state* __regex_dfa_state(regex *re, size_t count) {
+    uint32_t *states = re->next;
+
+    // The same set reached in a different order is the same state
+    qsort(states, count, sizeof(uint32_t), __regex_compare_states);
+    uint64_t hash = __string_hash_bytes(states, sizeof(uint32_t) * count, 0);
+
+    size_t mask = re->table_capacity - 1;
+    size_t slot = hash & mask;
+    for (regex_dfa_state *found; (found = re->table[slot]) != NULL; slot = (slot + 1) & mask) {
+        if (found->hash == hash && found->count == count &&
+            (count == 0 || memcmp(found->states, states, sizeof(uint32_t) * count) == 0)) {
+            return found;
+        }
+    }
+
+    if (re->dfa_count >= re->max_states) return NULL;
+
+    regex_dfa_state *state = __regex_new_state(re, count, hash, false);
+    if (!state) return NULL;
+
+    // Keep the table at most half full; the old table stays in the context
+    if (2 * (re->dfa_count + 1) > re->table_capacity) {
+        size_t capacity = re->table_capacity * 2;
+        regex_dfa_state **table = (regex_dfa_state **)memctx_alloc(re->ctx, sizeof(regex_dfa_state *) * capacity);
+        if (!table) return NULL;
+        memset(table, 0, sizeof(regex_dfa_state *) * capacity);
+        for (size_t i = 0; i < re->table_capacity; i++) {
+            regex_dfa_state *moved = re->table[i];
+            if (!moved) continue;
+            size_t j = moved->hash & (capacity - 1);
+            while (table[j]) j = (j + 1) & (capacity - 1);
+            table[j] = moved;
+        }
+        re->table = table;
+        re->table_capacity = capacity;
+        mask = capacity - 1;
+        slot = hash & mask;
+        while (table[slot]) slot = (slot + 1) & mask;
+    }
+
+    re->table[slot] = state;
+    re->dfa_count++;
+    return state;
+}
+
+regex_dfa_state* __regex_new_state(regex *re, size_t count, uint64_t hash, bool at_begin) {
+    regex_dfa_state *state = (regex_dfa_state *)memctx_alloc(re->ctx,
+        sizeof(regex_dfa_state) + sizeof(regex_dfa_state *) * re->class_count);
+    if (!state) return NULL;
+    state->states = count > 0 ? (uint32_t *)memctx_alloc(re->ctx, sizeof(uint32_t) * count) : NULL;
+    if (count > 0 && !state->states) return NULL;
+    if (count > 0) memcpy(state->states, re->next, sizeof(uint32_t) * count);
+    for (size_t i = 0; i < re->class_count; i++) {
+        state->next[i] = re->unknown;
+    }
+    state->count = count;
+    state->hash = hash;
+
+    bool match = re->marks[re->match] == re->generation;
+    state->flags = (match ? REGEX_STATE_MATCH : 0) | (count == 0 ? REGEX_STATE_DEAD : 0);
+    state->match_end = match || __regex_accepts_at_end(re, state->states, count, at_begin);
+    return state;
+}
+
+bool __regex_accepts_at_end(regex *re, const uint32_t *states, size_t count, bool at_begin) {
+    __regex_next_generation(re);
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        const regex_nfa_state *state = &re->nfa[states[i]];
+        if (state->op == REGEX_OP_END) {
+            __regex_add(re, state->out, re->closure, &length, at_begin, true);
+        }
+    }
+    return re->marks[re->match] == re->generation;
+}
+
+size_t __regex_step(regex *re, const uint32_t *from, size_t count, unsigned char byte, uint32_t *to) {
+    __regex_next_generation(re);
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        const regex_nfa_state *state = &re->nfa[from[i]];
+        if (state->op == REGEX_OP_BYTE && (re->sets[state->set][byte >> 6] >> (byte & 63) & 1)) {
+            __regex_add(re, state->out, to, &length, false, false);
+        }
+    }
+    return length;
+}
+
+void __regex_add(regex *re, uint32_t state, uint32_t *to, size_t *count, bool at_begin, bool at_end) {
+    // Each state pushes at most two others when it is first visited
+    size_t top = 0;
+    re->stack[top++] = state;
+    while (top > 0) {
+        uint32_t s = re->stack[--top];
+        if (re->marks[s] == re->generation) continue;
+        re->marks[s] = re->generation;
+
+        const regex_nfa_state *nfa = &re->nfa[s];
+        switch (nfa->op) {
+            case REGEX_OP_SPLIT:
+                re->stack[top++] = nfa->out1;
+                re->stack[top++] = nfa->out;
+                break;
+            case REGEX_OP_EMPTY:
+                re->stack[top++] = nfa->out;
+                break;
+            case REGEX_OP_BEGIN:
+                if (at_begin) re->stack[top++] = nfa->out;
+                break;
+            case REGEX_OP_END:
+                if (at_end) {
+                    re->stack[top++] = nfa->out;
+                } else {
+                    to[(*count)++] = s;
+                }
+                break;
+            default:
+                to[(*count)++] = s;
+                break;
+        }
+    }
+}
+
+void __regex_next_generation(regex *re) {
+    if (++re->generation == 0) {
+        memset(re->marks, 0, sizeof(uint32_t) * re->nfa_count);
+        re->generation = 1;
+    }
+}
+
+void __regex_byte_classes(regex *re) {
+    memset(re->classes, 0, sizeof(re->classes));
+    size_t count = 1;
+
+    // Split every class by membership in each set
+    for (size_t s = 0; s < re->set_count; s++) {
+        const uint64_t *set = re->sets[s];
+
+        int16_t split[256][2];
+        memset(split, -1, sizeof(split));
+        size_t next_count = 0;
+        for (int b = 0; b < 256; b++) {
+            int member = (int)(set[b >> 6] >> (b & 63) & 1);
+            int16_t *id = &split[re->classes[b]][member];
+            if (*id < 0) *id = (int16_t)next_count++;
+            re->classes[b] = (uint8_t)*id;
+        }
+        count = next_count;
+    }
+
+    re->class_count = count;
+    for (int b = 255; b >= 0; b--) {
+        re->class_bytes[re->classes[b]] = (uint8_t)b;
+    }
+}
+
+regex_node* __regex_parse_alt(regex_parser *p) {
+    regex_node *left = __regex_parse_concat(p);
+    while (left && p->position < p->length && p->pattern[p->position] == '|') {
+        p->position++;
+        regex_node *right = __regex_parse_concat(p);
+        if (!right) return NULL;
+        left = __regex_node(p, REGEX_NODE_ALT, left, right);
+    }
+    return left;
+}
+
+regex_node* __regex_parse_concat(regex_parser *p) {
+    regex_node *result = NULL;
+    while (p->position < p->length && p->pattern[p->position] != '|' && p->pattern[p->position] != ')') {
+        regex_node *node = __regex_parse_repeat(p);
+        if (!node) return NULL;
+        result = result ? __regex_node(p, REGEX_NODE_CONCAT, result, node) : node;
+        if (!result) return NULL;
+    }
+    return result ? result : __regex_node(p, REGEX_NODE_EMPTY, NULL, NULL);
+}
+
+regex_node* __regex_parse_repeat(regex_parser *p) {
+    regex_node *node = __regex_parse_atom(p);
+    // Stacked quantifiers (a**) nest like groups and share their limit
+    size_t depth = p->depth;
+    while (node && p->position < p->length) {
+        char c = p->pattern[p->position];
+        int min, max;
+        if (c == '*') {
+            min = 0;
+            max = -1;
+        } else if (c == '+') {
+            min = 1;
+            max = -1;
+        } else if (c == '?') {
+            min = 0;
+            max = 1;
+        } else if (c == '{') {
+            p->position++;
+            if (!__regex_parse_count(p, &min)) return NULL;
+            max = min;
+            if (p->position < p->length && p->pattern[p->position] == ',') {
+                p->position++;
+                max = -1;
+                if (p->position < p->length && p->pattern[p->position] != '}') {
+                    if (!__regex_parse_count(p, &max) || max < min) return NULL;
+                }
+            }
+            if (p->position >= p->length || p->pattern[p->position] != '}') return NULL;
+        } else {
+            break;
+        }
+        p->position++;
+        if (++depth > REGEX_MAX_DEPTH) return NULL;
+
+        regex_node *repeat = __regex_node(p, REGEX_NODE_REPEAT, node, NULL);
+        if (!repeat) return NULL;
+        repeat->min = min;
+        repeat->max = max;
+        node = repeat;
+    }
+    return node;
+}
+
+regex_node* __regex_parse_atom(regex_parser *p) {
+    char c = p->pattern[p->position++];
+    switch (c) {
+        case '(': {
+            if (++p->depth > REGEX_MAX_DEPTH) return NULL;
+            regex_node *node = __regex_parse_alt(p);
+            if (!node || p->position >= p->length || p->pattern[p->position] != ')') return NULL;
+            p->position++;
+            p->depth--;
+            return node;
+        }
+        case '[':
+            return __regex_parse_class(p);
+        case '*': case '+': case '?': case '{':
+            return NULL;
+        case '^':
+            return __regex_node(p, REGEX_NODE_BEGIN, NULL, NULL);
+        case '$':
+            return __regex_node(p, REGEX_NODE_END, NULL, NULL);
+        default:
+            break;
+    }
+
+    regex_node *node = __regex_node(p, REGEX_NODE_SET, NULL, NULL);
+    if (!node) return NULL;
+    node->set = __regex_new_set(p);
+    if (node->set == REGEX_NONE) return NULL;
+    uint64_t *set = p->sets[node->set];
+
+    if (c == '.') {
+        __regex_set_range(set, 0, 255);
+        set['\n' >> 6] &= ~((uint64_t)1 << ('\n' & 63));
+    } else if (c == '\\') {
+        int byte = __regex_parse_escape(p, set);
+        if (byte == -2) return NULL;
+        if (byte >= 0) __regex_set_range(set, (unsigned char)byte, (unsigned char)byte);
+    } else {
+        __regex_set_range(set, (unsigned char)c, (unsigned char)c);
+    }
+    return node;
+}
+
+regex_node* __regex_parse_class(regex_parser *p) {
+    regex_node *node = __regex_node(p, REGEX_NODE_SET, NULL, NULL);
+    if (!node) return NULL;
+    node->set = __regex_new_set(p);
+    if (node->set == REGEX_NONE) return NULL;
+
+    bool negate = p->position < p->length && p->pattern[p->position] == '^';
+    if (negate) p->position++;
+
+    // ']' right after '[' or '[^' is a member
+    bool first = true;
+    for (;;) {
+        if (p->position >= p->length) return NULL;
+        char c = p->pattern[p->position++];
+        if (c == ']' && !first) break;
+        first = false;
+
+        int low = (unsigned char)c;
+        if (c == '\\') {
+            low = __regex_parse_escape(p, p->sets[node->set]);
+            if (low == -2) return NULL;
+            if (low == -1) continue;
+        }
+
+        int high = low;
+        if (p->position + 1 < p->length && p->pattern[p->position] == '-' && p->pattern[p->position + 1] != ']') {
+            p->position++;
+            char h = p->pattern[p->position++];
+            high = (unsigned char)h;
+            if (h == '\\') {
+                uint64_t ignored[4] = {0, 0, 0, 0};
+                high = __regex_parse_escape(p, ignored);
+                if (high < 0) return NULL;
+            }
+            if (high < low) return NULL;
+        }
+        __regex_set_range(p->sets[node->set], (unsigned char)low, (unsigned char)high);
+    }
+
+    if (negate) {
+        uint64_t *set = p->sets[node->set];
+        for (int i = 0; i < 4; i++) set[i] = ~set[i];
+    }
+    return node;
+}
+
+int __regex_parse_escape(regex_parser *p, uint64_t *set) {
+    if (p->position >= p->length) return -2;
+    char c = p->pattern[p->position++];
+
+    uint64_t bits[4] = {0, 0, 0, 0};
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'x': {
+            int value = 0;
+            for (int i = 0; i < 2; i++) {
+                if (p->position >= p->length) return -2;
+                char h = p->pattern[p->position++];
+                int digit = h >= '0' && h <= '9' ? h - '0' :
+                            h >= 'a' && h <= 'f' ? h - 'a' + 10 :
+                            h >= 'A' && h <= 'F' ? h - 'A' + 10 : -1;
+                if (digit < 0) return -2;
+                value = value * 16 + digit;
+            }
+            return value;
+        }
+        case 'd': case 'D':
+            __regex_set_range(bits, '0', '9');
+            break;
+        case 'w': case 'W':
+            __regex_set_range(bits, '0', '9');
+            __regex_set_range(bits, 'A', 'Z');
+            __regex_set_range(bits, 'a', 'z');
+            __regex_set_range(bits, '_', '_');
+            break;
+        case 's': case 'S':
+            __regex_set_range(bits, '\t', '\r');
+            __regex_set_range(bits, ' ', ' ');
+            break;
+        default:
+            // Other letters and digits are reserved
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return -2;
+            return (unsigned char)c;
+    }
+
+    bool negate = c >= 'A' && c <= 'Z';
+    for (int i = 0; i < 4; i++) set[i] |= negate ? ~bits[i] : bits[i];
+    return -1;
+}
+
+bool __regex_parse_count(regex_parser *p, int *value) {
+    size_t start = p->position;
+    int result = 0;
+    while (p->position < p->length && p->pattern[p->position] >= '0' && p->pattern[p->position] <= '9') {
+        result = result * 10 + (p->pattern[p->position++] - '0');
+        if (result > REGEX_MAX_REPEAT) return false;
+    }
+    *value = result;
+    return p->position > start;
+}
+
+regex_node* __regex_node(regex_parser *p, int type, regex_node *left, regex_node *right) {
+    regex_node *node = (regex_node *)memctx_alloc(p->nodes, sizeof(regex_node));
+    if (!node) return NULL;
+    node->type = type;
+    node->set = REGEX_NONE;
+    node->min = 0;
+    node->max = 0;
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+uint32_t __regex_new_set(regex_parser *p) {
+    if (p->set_count == p->set_capacity) {
+        size_t capacity = p->set_capacity ? p->set_capacity * 2 : 16;
+        uint64_t (*sets)[4] = (uint64_t (*)[4])realloc(p->sets, sizeof(uint64_t[4]) * capacity);
+        if (!sets) return REGEX_NONE;
+        p->sets = sets;
+        p->set_capacity = capacity;
+    }
+    memset(p->sets[p->set_count], 0, sizeof(uint64_t[4]));
+    return (uint32_t)p->set_count++;
+}
+
+void __regex_set_range(uint64_t *set, unsigned char low, unsigned char high) {
+    for (unsigned b = low; b <= high; b++) {
+        set[b >> 6] |= (uint64_t)1 << (b & 63);
+    }
+}
+
+regex_fragment __regex_emit(regex_parser *p, regex_node *node) {
+    regex_fragment result = {REGEX_NONE, REGEX_NONE};
+    if (p->failed) return result;
+
+    switch (node->type) {
+        case REGEX_NODE_EMPTY: {
+            uint32_t s = __regex_emit_state(p, REGEX_OP_EMPTY, 0, REGEX_NONE, REGEX_NONE);
+            result.start = s;
+            result.holes = s << 1;
+            break;
+        }
+        case REGEX_NODE_BEGIN:
+        case REGEX_NODE_END: {
+            uint32_t op = node->type == REGEX_NODE_BEGIN ? REGEX_OP_BEGIN : REGEX_OP_END;
+            uint32_t s = __regex_emit_state(p, op, 0, REGEX_NONE, REGEX_NONE);
+            result.start = s;
+            result.holes = s << 1;
+            break;
+        }
+        case REGEX_NODE_SET: {
+            uint32_t s = __regex_emit_state(p, REGEX_OP_BYTE, node->set, REGEX_NONE, REGEX_NONE);
+            result.start = s;
+            result.holes = s << 1;
+            break;
+        }
+        case REGEX_NODE_CONCAT: {
+            // Concatenations nest to the left, one level per item; emitting the items
+            // from the last one back walks that chain without recursing per item
+            result = __regex_emit(p, node->right);
+            regex_node *item = node->left;
+            for (;;) {
+                bool first = item->type != REGEX_NODE_CONCAT;
+                regex_fragment left = __regex_emit(p, first ? item : item->right);
+                if (p->failed) break;
+                __regex_patch(p, left.holes, result.start);
+                result.start = left.start;
+                if (first) break;
+                item = item->left;
+            }
+            break;
+        }
+        case REGEX_NODE_ALT: {
+            // Alternatives nest to the left as well: a|b|c is a|(b|c) built from the back
+            result = __regex_emit(p, node->right);
+            regex_node *item = node->left;
+            for (;;) {
+                bool first = item->type != REGEX_NODE_ALT;
+                regex_fragment left = __regex_emit(p, first ? item : item->right);
+                uint32_t s = __regex_emit_state(p, REGEX_OP_SPLIT, 0, left.start, result.start);
+                if (p->failed) break;
+                result.start = s;
+                result.holes = __regex_join(p, left.holes, result.holes);
+                if (first) break;
+                item = item->left;
+            }
+            break;
+        }
+        case REGEX_NODE_REPEAT: {
+            // x{n,m} is n copies of x followed by m - n nested optional copies: x...x(x(x)?)?
+            bool have = false;
+            for (int i = 0; i < node->min; i++) {
+                regex_fragment copy = __regex_emit(p, node->left);
+                if (p->failed) return result;
+                if (i + 1 == node->min && node->max < 0) {
+                    // The last required copy loops: x+
+                    uint32_t s = __regex_emit_state(p, REGEX_OP_SPLIT, 0, copy.start, REGEX_NONE);
+                    if (p->failed) return result;
+                    __regex_patch(p, copy.holes, s);
+                    copy.holes = (s << 1) | 1;
+                }
+                if (have) {
+                    __regex_patch(p, result.holes, copy.start);
+                    result.holes = copy.holes;
+                } else {
+                    result = copy;
+                    have = true;
+                }
+            }
+
+            regex_fragment optional = {REGEX_NONE, REGEX_NONE};
+            if (node->max < 0 && node->min == 0) {
+                // x*
+                regex_fragment copy = __regex_emit(p, node->left);
+                uint32_t s = __regex_emit_state(p, REGEX_OP_SPLIT, 0, copy.start, REGEX_NONE);
+                if (p->failed) return result;
+                __regex_patch(p, copy.holes, s);
+                optional.start = s;
+                optional.holes = (s << 1) | 1;
+            } else if (node->max > node->min) {
+                for (int i = node->min; i < node->max; i++) {
+                    regex_fragment copy = __regex_emit(p, node->left);
+                    if (p->failed) return result;
+                    if (optional.start != REGEX_NONE) {
+                        __regex_patch(p, copy.holes, optional.start);
+                        copy.holes = optional.holes;
+                    }
+                    uint32_t s = __regex_emit_state(p, REGEX_OP_SPLIT, 0, copy.start, REGEX_NONE);
+                    if (p->failed) return result;
+                    optional.start = s;
+                    optional.holes = __regex_join(p, copy.holes, (s << 1) | 1);
+                }
+            }
+
+            if (optional.start != REGEX_NONE) {
+                if (have) {
+                    __regex_patch(p, result.holes, optional.start);
+                    result.holes = optional.holes;
+                } else {
+                    result = optional;
+                    have = true;
+                }
+            }
+            if (!have) {
+                // x{0}
+                uint32_t s = __regex_emit_state(p, REGEX_OP_EMPTY, 0, REGEX_NONE, REGEX_NONE);
+                result.start = s;
+                result.holes = s << 1;
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+uint32_t __regex_emit_state(regex_parser *p, uint32_t op, uint32_t set, uint32_t out, uint32_t out1) {
+    if (p->failed) return REGEX_NONE;
+    if (p->nfa_count == p->nfa_capacity) {
+        if (p->nfa_count >= REGEX_MAX_NFA_STATES) {
+            p->failed = true;
+            return REGEX_NONE;
+        }
+        size_t capacity = p->nfa_capacity ? p->nfa_capacity * 2 : 64;
+        regex_nfa_state *nfa = (regex_nfa_state *)realloc(p->nfa, sizeof(regex_nfa_state) * capacity);
+        if (!nfa) {
+            p->failed = true;
+            return REGEX_NONE;
+        }
+        p->nfa = nfa;
+        p->nfa_capacity = capacity;
+    }
+
+    regex_nfa_state *state = &p->nfa[p->nfa_count];
+    state->op = op;
+    state->set = set;
+    state->out = out;
+    state->out1 = out1;
+    return (uint32_t)p->nfa_count++;
+}
+
+uint32_t* __regex_hole(regex_parser *p, uint32_t hole) {
+    regex_nfa_state *state = &p->nfa[hole >> 1];
+    return (hole & 1) ? &state->out1 : &state->out;
+}
+
+void __regex_patch(regex_parser *p, uint32_t holes, uint32_t target) {
+    while (holes != REGEX_NONE) {
+        uint32_t *field = __regex_hole(p, holes);
+        holes = *field;
+        *field = target;
+    }
+}
+
+uint32_t __regex_join(regex_parser *p, uint32_t first, uint32_t second) {
+    if (first == REGEX_NONE) return second;
+    uint32_t hole = first;
+    for (;;) {
+        uint32_t *field = __regex_hole(p, hole);
+        if (*field == REGEX_NONE) {
+            *field = second;
+            return first;
+        }
+        hole = *field;
+    }
+}
+
+#endif
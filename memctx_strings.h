@@ -26,12 +26,56 @@
 #include <stddef.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <float.h>
+#include <math.h>
 #include "memctx.h"
+#include "memctx_arrays.h"
+#include "memctx_pow10.h"
+
+// SIMD kernels are selected at compile time (-msse2, -mavx2, -march=native).
+// Define STRING_NO_SIMD to force the portable scalar code.
+#if !defined(STRING_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define STRING_SIMD_SSE2 1
+#endif
+#if !defined(STRING_NO_SIMD) && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define STRING_SIMD_SSSE3 1
+#endif
+#if !defined(STRING_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define STRING_SIMD_AVX2 1
+#endif
+
+// Builds for x86-64 without AVX2 (GCC and Clang) still compile the UTF-8 kernels
+// for SSSE3 and AVX2 through target attributes and pick one at run time from cpuid.
+#if !defined(STRING_NO_SIMD) && !defined(STRING_SIMD_AVX2) && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define STRING_SIMD_DISPATCH 1
+#define __STRING_TARGET(isa) __attribute__((target(isa)))
+#else
+#define __STRING_TARGET(isa)
+#endif
 
 #ifndef STRING_INIT_CAPACITY
-#define STRING_INIT_CAPACITY 256
+#define STRING_INIT_CAPACITY 16
+#endif
+
+#ifndef STRING_GROWTH_FACTOR
+#define STRING_GROWTH_FACTOR 2
 #endif
 
+// Needles up to this length are searched with the SIMD filter alone;
+// longer ones switch to the Two-Way algorithm when candidates keep failing
+#ifndef STRING_SEARCH_SIMD_MAX
+#define STRING_SEARCH_SIMD_MAX 32
+#endif
+
+#define STRING_NOT_FOUND ((size_t)-1)
+
 struct memctx_string {
     char *value;
     size_t length;
@@ -41,6 +85,55 @@ struct memctx_string {
 typedef struct memctx_string string;      // call string_free outside memctx
 typedef struct memctx_string substring;   // do not free
 
+// Set of byte values, classified with a bitset in scalar code
+// and with two nibble lookups per 16 bytes in SIMD code
+typedef struct memctx_string_charset {
+    uint64_t bits[4];           // bit c is set for each member c
+    unsigned char low[16];      // bit (c >> 4) of low[c & 15] is set for members below 0x80
+    unsigned char high[16];     // bit (c >> 4) - 8 of high[c & 15] is set for members from 0x80
+    size_t count;
+    char single;                // the member when count is 1
+} string_charset;
+
+typedef struct memctx_string_split {
+    string str;
+    string_charset delims;
+    size_t position;
+    bool skip_empty;
+    bool done;
+} string_split_iterator;
+
+typedef struct memctx_string_lines {
+    string str;
+    size_t position;
+    size_t block;
+    uint64_t mask;
+    bool done;
+} string_line_iterator;
+
+typedef struct memctx_hashed_string {
+    substring str;
+    uint64_t hash;
+} hashed_string;
+
+typedef enum memctx_string_parse_result {
+    STRING_PARSE_OK = 0,
+    STRING_PARSE_EMPTY,         // the input is empty
+    STRING_PARSE_INVALID,       // the input is not a number, or has characters after it
+    STRING_PARSE_OVERFLOW       // the number does not fit the result type
+} string_parse_result;
+
+typedef struct memctx_line_index {
+    string str;
+    size_t *offsets;
+    size_t count;
+} line_index;
+
+typedef struct memctx_string_sort_entry {
+    uint64_t prefix;            // 8 bytes of the string from the current depth, big-endian, zero-padded
+    string *str;
+} string_sort_entry;
+
 /**
  * Initializes a string structure with default values.
  *
@@ -49,18 +142,64 @@ typedef struct memctx_string substring;   // do not free
 string string_init(MemContext *ctx);
 
 /**
- * Creates and returns a string object initialized
- * with the content from a null-terminated string.
+ * Wraps a string literal into a substring without allocating or scanning it.
+ * The length is taken from `sizeof`, so the argument must be a literal.
+ * Like other views it has no context; copy it with `string_make` before appending.
+ */
+#define STR(literal) ((substring){ (char *)("" literal), sizeof(literal) - 1, sizeof(literal) - 1, NULL })
+
+/**
+ * Creates a string object from a buffer of known length.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - value        A pointer to the characters to copy. Need not be null-terminated.
+ *  - length       The number of characters to copy.
+ *
+ * Returns a null-terminated copy of the buffer, or an empty string if value is NULL.
+ */
+string __string_make_n(MemContext *ctx, const char *value, size_t length);
+
+/**
+ * Creates a string object from a null-terminated C string.
+ */
+string __string_make_chars(MemContext *ctx, const char *value);
+
+/**
+ * Creates a string object from another string or substring, using its length.
+ */
+string __string_make_string(MemContext *ctx, string value);
+
+/**
+ * Creates and returns a string object initialized with a copy of a value.
+ * Automatically selects the appropriate function based on the type of value:
+ * strings and substrings (including `STR` literals) are copied using their length,
+ * null-terminated C strings are measured first.
  * 
  * Parameters:
  *  - ctx          The memory context to use for allocation.
- *  - value        A pointer to a null-terminated C string.
+ *  - value        The value to copy (can be either string or char*).
  * 
  * Returns a string object with the value field pointing to a newly allocated
  * memory containing a copy of the input string, and length set
  * to the length of the input string.
  */
-string string_make(MemContext *ctx, const char* value);
+#define string_make(ctx, value) _Generic((value), \
+    string:  __string_make_string, \
+    default: __string_make_chars \
+)(ctx, value)
+
+/**
+ * Appends a buffer of known length to the end of a string.
+ *
+ * Parameters:
+ *  - str          The destination string to append to.
+ *  - value        A pointer to the characters to append. Need not be null-terminated.
+ *  - length       The number of characters to append.
+ *
+ * Returns the modified string with the value appended.
+ */
+string string_append_n(string str, const char *value, size_t length);
 
 /**
  * Appends a value to the end of a string.
@@ -130,162 +269,3033 @@ void string_free_file(string str);
  * 
  * Returns a **substring** that references the same memory as the original string,
  * but with adjusted start position and length to exclude leading and trailing whitespace.
+ * An empty result still points into the original string; only a NULL string gives a NULL value.
  */
 substring string_trim(string str);
 
-// - Implementation -
+/**
+ * Trims whitespace characters from the beginning of a string.
+ *
+ * Returns a **substring** that references the same memory as the original string.
+ */
+substring string_trim_left(string str);
 
-string string_init(MemContext *ctx) {
-    string str;
-    str.ctx = ctx;
-    str.length = 0;
-    str.capacity = STRING_INIT_CAPACITY;
-    str.value = (char *)memctx_alloc(ctx, str.capacity);
-    if (str.value) {
-        str.value[0] = '\0';
-    }
-    return str;
-}
+/**
+ * Trims whitespace characters from the end of a string.
+ *
+ * Returns a **substring** that references the same memory as the original string.
+ */
+substring string_trim_right(string str);
 
-string string_make(MemContext *ctx, const char* value) {
-    string str = string_init(ctx);
-    
-    if (!value) return str;
-    
-    size_t len = strlen(value);
-    if (len >= str.capacity) {
-        // Need more space
-        str.capacity = ((len + 1 + STRING_INIT_CAPACITY - 1) / STRING_INIT_CAPACITY) * STRING_INIT_CAPACITY;
-        str.value = (char *)memctx_alloc(ctx, str.capacity);
-        if (!str.value) {
-            str.length = 0;
-            str.capacity = 0;
-            return str;
-        }
-    }
-    
-    memcpy(str.value, value, len + 1);
-    str.length = len;
-    return str;
-}
+/**
+ * Creates a character set from the characters of a null-terminated string.
+ *
+ * Parameters:
+ *  - chars        The members of the set. NULL gives an empty set.
+ *
+ * Returns the set, to be used with `string_charset_has` and `string_charset_find`.
+ */
+string_charset string_charset_make(const char *chars);
 
-string __string_append_string(string str, string value) {
-    if (!str.value || !value.value) return str;
-    
-    size_t new_length = str.length + value.length;
-    
-    // Check if we need to expand capacity
-    if (new_length >= str.capacity) {
-        size_t new_capacity = ((new_length + 1 + STRING_INIT_CAPACITY - 1) / STRING_INIT_CAPACITY) * STRING_INIT_CAPACITY;
-        char *new_value = (char *)memctx_alloc(str.ctx, new_capacity);
-        if (!new_value) return str;  // Failed to allocate
-        
-        // Copy existing string and append new content
-        memcpy(new_value, str.value, str.length);
-        memcpy(new_value + str.length, value.value, value.length + 1);
-        
-        // Update the string with new buffer and capacity
-        str.value = new_value;
-        str.capacity = new_capacity;
-    } else {
-        // Enough space, just append
-        memcpy(str.value + str.length, value.value, value.length + 1);
-    }
-    
-    str.length = new_length;
-    return str;
-}
+/**
+ * Checks whether a character is a member of a set.
+ */
+bool string_charset_has(const string_charset *set, char c);
 
-string __string_append_chars(string str, const char* value) {
-    if (!str.value || !value) return str;
-    
-    size_t value_length = strlen(value);
-    size_t new_length = str.length + value_length;
-    
-    // Check if we need to expand capacity
-    if (new_length >= str.capacity) {
-        size_t new_capacity = ((new_length + 1 + STRING_INIT_CAPACITY - 1) / STRING_INIT_CAPACITY) * STRING_INIT_CAPACITY;
-        char *new_value = (char *)memctx_alloc(str.ctx, new_capacity);
-        if (!new_value) return str;  // Failed to allocate
-        
-        // Copy existing string and append new content
-        memcpy(new_value, str.value, str.length);
-        memcpy(new_value + str.length, value, value_length + 1);
-        
-        // Update the string with new buffer and capacity
-        str.value = new_value;
-        str.capacity = new_capacity;
-    } else {
-        // Enough space, just append
-        memcpy(str.value + str.length, value, value_length + 1);
-    }
-    
-    str.length = new_length;
-    return str;
-}
+/**
+ * Finds the first character of a string that is a member of a set.
+ *
+ * Parameters:
+ *  - str          The string to search in.
+ *  - set          The character set.
+ *
+ * Returns the offset of the character, or STRING_NOT_FOUND (-1).
+ */
+size_t string_charset_find(string str, const string_charset *set);
 
-string string_read_file(MemContext *ctx, const char *filename) {
-    string str;
-    str.ctx = ctx;
-    str.length = 0;
-    str.capacity = 0;
-    str.value = NULL;
-    
-    if (!ctx || !filename) return str;
-    
-    char *file_content;
-    size_t file_size = memctx_open_file(ctx, &file_content, (char *)filename);
-    
-    if (file_size == 0 || !file_content) {
-        return str;
-    }
-    
-    str.value = file_content;
-    str.length = file_size;
-    str.capacity = file_size + 1;  // +1 for null terminator which is already appended by memctx_open_file
-    
-    return str;
-}
+/**
+ * Wraps a null-terminated C string into a substring without copying it.
+ *
+ * Parameters:
+ *  - value        A pointer to a null-terminated C string.
+ *
+ * Returns a **substring** that references `value`, or an empty substring if value is NULL.
+ */
+substring string_view(const char *value);
 
-void string_free_file(string str) {
-    if (!str.ctx || !str.value) return;
-    memctx_free_file(str.ctx, str.value);
-}
+/**
+ * Finds the first occurrence of a needle in a string, starting at an offset.
+ *
+ * Parameters:
+ *  - str          The string to search in.
+ *  - needle       The value to search for (can be either string or char*).
+ *  - start        Offset to start searching from.
+ *
+ * Returns the offset of the first occurrence,
+ * or STRING_NOT_FOUND (-1) if the needle does not occur after start.
+ */
+#define string_find_from(str, needle, start) __string_find_from(str, __string_arg(needle), start)
 
-substring string_trim(string str) {
-    substring result = {0};
-    if (!str.value || str.length == 0) return result;
-    
-    // Point to the same string
-    result.value = str.value;
-    result.length = str.length;
-    result.capacity = str.capacity;
-    result.ctx = str.ctx;
-    
-    // Find the first non-whitespace character
-    size_t start = 0;
-    while (start < str.length && isspace((unsigned char)str.value[start])) {
-        start++;
-    }
-    
-    // If the string is all whitespace
-    if (start == str.length) {
-        result.value = str.value;
-        result.length = 0;
-        return result;
-    }
-    
-    // Find the last non-whitespace character
-    size_t end = str.length - 1;
-    while (end > start && isspace((unsigned char)str.value[end])) {
-        end--;
-    }
-    
-    // Create the substring
-    result.value = str.value + start;
-    result.length = end - start + 1;
-    
-    return result;
+/**
+ * Finds the first occurrence of a needle in a string.
+ *
+ * Parameters:
+ *  - str          The string to search in.
+ *  - needle       The value to search for (can be either string or char*).
+ *
+ * Returns the offset of the first occurrence, or STRING_NOT_FOUND (-1).
+ */
+#define string_find(str, needle) __string_find_from(str, __string_arg(needle), 0)
+
+/**
+ * Finds all non-overlapping occurrences of a needle in a string.
+ *
+ * Parameters:
+ *  - str          The string to search in.
+ *  - needle       The value to search for (can be either string or char*).
+ *
+ * Returns an array of **substring** pointers referencing the occurrences in `str`,
+ * allocated in the string memory context, or NULL if str has no context.
+ * An empty needle produces an empty array.
+ */
+#define string_find_all(str, needle) __string_find_all(str, __string_arg(needle))
+
+/**
+ * Checks whether a needle occurs in a string.
+ *
+ * Parameters:
+ *  - str          The string to search in.
+ *  - needle       The value to search for (can be either string or char*).
+ *
+ * Returns true if the needle occurs in the string.
+ */
+#define string_contains(str, needle) (__string_find_from(str, __string_arg(needle), 0) != STRING_NOT_FOUND)
+
+/**
+ * Splits a string into fields separated by any of the delimiter characters.
+ * Adjacent delimiters produce empty fields, so n delimiters give n + 1 fields.
+ *
+ * Parameters:
+ *  - str          The string to split.
+ *  - delims       A null-terminated set of delimiter characters.
+ *
+ * Returns an array of **substring** pointers referencing the fields in `str`,
+ * allocated in the string memory context, or NULL if str has no context.
+ * The array is empty if str or delims is NULL.
+ */
+array* string_split(string str, const char *delims);
+
+/**
+ * Creates an iterator over the fields of a string without allocating them.
+ * See `string_split` for the splitting rules.
+ *
+ * Parameters:
+ *  - str          The string to split.
+ *  - delims       A null-terminated set of delimiter characters.
+ *
+ * Returns an iterator to be passed to `string_split_next`.
+ */
+string_split_iterator string_split_iter(string str, const char *delims);
+
+/**
+ * Splits a string into tokens separated by runs of delimiter characters.
+ * Unlike `string_split`, empty tokens are skipped, so leading, trailing
+ * and adjacent delimiters produce nothing.
+ *
+ * Parameters:
+ *  - str          The string to split.
+ *  - delims       A null-terminated set of delimiter characters.
+ *
+ * Returns an array of **substring** pointers referencing the tokens in `str`,
+ * allocated in the string memory context, or NULL if str has no context.
+ * The array is empty if str or delims is NULL.
+ */
+array* string_tokenize(string str, const char *delims);
+
+/**
+ * Creates an iterator over the tokens of a string without allocating them.
+ * See `string_tokenize` for the splitting rules; tokens are read with `string_split_next`.
+ */
+string_split_iterator string_tokenize_iter(string str, const char *delims);
+
+/**
+ * Advances a split iterator to the next field.
+ *
+ * Parameters:
+ *  - it           The iterator.
+ *  - field        Receives a **substring** referencing the next field.
+ *
+ * Returns true if a field was produced, false when there are no more fields.
+ */
+bool string_split_next(string_split_iterator *it, substring *field);
+
+/**
+ * Creates an iterator over the lines of a string.
+ * Lines are separated by '\n', a trailing '\r' is not part of the line,
+ * and a newline at the very end does not start another line.
+ * Newlines are located 64 bytes at a time.
+ *
+ * Parameters:
+ *  - str          The string to iterate over.
+ *
+ * Returns an iterator to be passed to `string_lines_next`.
+ */
+string_line_iterator string_lines(string str);
+
+/**
+ * Advances a line iterator to the next line.
+ *
+ * Parameters:
+ *  - it           The iterator.
+ *  - line         Receives a **substring** referencing the next line.
+ *
+ * Returns true if a line was produced, false when there are no more lines.
+ */
+bool string_lines_next(string_line_iterator *it, substring *line);
+
+/**
+ * Builds an index of line start offsets in one pass over a string,
+ * so that any line can be accessed in constant time with `string_line_at`.
+ * See `string_lines` for the line rules.
+ *
+ * Parameters:
+ *  - str          The string to index.
+ *
+ * Returns a pointer to the index allocated in the string memory context,
+ * or NULL if str has no context or allocation fails.
+ */
+line_index* string_line_index(string str);
+
+/**
+ * Returns a line from a line index.
+ *
+ * Parameters:
+ *  - index        The line index.
+ *  - line         Zero-based line number.
+ *
+ * Returns a **substring** referencing the line,
+ * or an empty substring if index is NULL or line is out of bounds.
+ */
+substring string_line_at(line_index *index, size_t line);
+
+/**
+ * Computes a fast non-cryptographic 64-bit hash of the string content (wyhash).
+ * Only `length` bytes are hashed; the terminator and capacity do not matter.
+ * Hash values are not stable across library versions or byte orders,
+ * do not persist them.
+ *
+ * Parameters:
+ *  - str          The string or substring to hash.
+ *
+ * Returns the hash value.
+ */
+uint64_t string_hash(string str);
+
+/**
+ * Pairs a string with its hash, so that repeated lookups do not rehash it.
+ *
+ * Parameters:
+ *  - str          The string or substring to hash.
+ *
+ * Returns a `hashed_string` referencing str and holding `string_hash(str)`.
+ */
+hashed_string string_hashed(string str);
+
+/**
+ * Checks whether a string is well-formed UTF-8: no overlong encodings,
+ * surrogates, code points above U+10FFFF, or truncated sequences.
+ * Uses the SSSE3/AVX2 lookup-table algorithm when compiled for it.
+ *
+ * Parameters:
+ *  - str          The string to validate.
+ *
+ * Returns true if the string is valid UTF-8. Empty and NULL strings are valid.
+ */
+bool string_utf8_valid(string str);
+
+/**
+ * Counts the code points of a UTF-8 string.
+ * The string is expected to be valid (see `string_utf8_valid`);
+ * for invalid input the result counts the bytes that are not continuation bytes.
+ *
+ * Parameters:
+ *  - str          The string to measure.
+ *
+ * Returns the number of code points.
+ */
+size_t string_utf8_length(string str);
+
+/**
+ * Creates an ASCII lowercase copy of a string. Non-ASCII bytes are copied unchanged.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - str          The string to convert.
+ *
+ * Returns a new string, or an empty `string` object if str is NULL or allocation fails.
+ */
+string string_to_lower(MemContext *ctx, string str);
+
+/**
+ * Creates an ASCII uppercase copy of a string. Non-ASCII bytes are copied unchanged.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - str          The string to convert.
+ *
+ * Returns a new string, or an empty `string` object if str is NULL or allocation fails.
+ */
+string string_to_upper(MemContext *ctx, string str);
+
+/**
+ * Converts ASCII letters of a string to lowercase in place.
+ *
+ * Parameters:
+ *  - str          The string to convert. Must not be a view into read-only memory.
+ */
+void string_to_lower_in_place(string str);
+
+/**
+ * Converts ASCII letters of a string to uppercase in place.
+ *
+ * Parameters:
+ *  - str          The string to convert. Must not be a view into read-only memory.
+ */
+void string_to_upper_in_place(string str);
+
+/**
+ * Compares two values for equality ignoring ASCII case.
+ *
+ * Parameters:
+ *  - a            The first value (can be either string or char*).
+ *  - b            The second value (can be either string or char*).
+ *
+ * Returns true if the values have the same length and equal bytes after lowercasing.
+ */
+#define string_equal_ci(a, b) __string_equal_ci(__string_arg(a), __string_arg(b))
+
+/**
+ * Compares two values lexicographically ignoring ASCII case.
+ *
+ * Parameters:
+ *  - a            The first value (can be either string or char*).
+ *  - b            The second value (can be either string or char*).
+ *
+ * Returns a negative value, zero, or a positive value if a is less than,
+ * equal to, or greater than b after lowercasing.
+ */
+#define string_compare_ci(a, b) __string_compare_ci(__string_arg(a), __string_arg(b))
+
+bool __string_equal_ci(substring a, substring b);
+
+int __string_compare_ci(substring a, substring b);
+
+/**
+ * Encodes bytes as base64 (RFC 4648 standard alphabet, with '=' padding).
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - data         The bytes to encode.
+ *
+ * Returns a new string of exactly 4 * ceil(length / 3) characters,
+ * or an empty `string` object if data is NULL or allocation fails.
+ */
+string string_base64_encode(MemContext *ctx, string data);
+
+/**
+ * Decodes base64 text (RFC 4648 standard alphabet). Padding is optional;
+ * whitespace and other characters outside the alphabet are rejected.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - str          The text to decode.
+ *
+ * Returns a new string with the decoded bytes,
+ * or an empty `string` object with a NULL value if str is NULL or invalid, or allocation fails.
+ */
+string string_base64_decode(MemContext *ctx, string str);
+
+/**
+ * Encodes bytes as lowercase hexadecimal, two characters per byte.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - data         The bytes to encode.
+ *
+ * Returns a new string, or an empty `string` object if data is NULL or allocation fails.
+ */
+string string_hex_encode(MemContext *ctx, string data);
+
+/**
+ * Decodes hexadecimal text, accepting both lowercase and uppercase digits.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - str          The text to decode. Must have an even length.
+ *
+ * Returns a new string with the decoded bytes,
+ * or an empty `string` object with a NULL value if str is NULL or invalid, or allocation fails.
+ */
+string string_hex_decode(MemContext *ctx, string str);
+
+/**
+ * Replaces all non-overlapping occurrences of a value, scanning left to right.
+ * The output size is computed first, so the result is written into a single allocation.
+ *
+ * Parameters:
+ *  - str          The string to search in.
+ *  - from         The value to replace (can be either string or char*).
+ *  - to           The replacement (can be either string or char*).
+ *
+ * Returns a new string allocated in the string memory context,
+ * or an empty `string` object if str is NULL or allocation fails.
+ * An empty `from` gives an unchanged copy.
+ */
+#define string_replace(str, from, to) __string_replace(str, __string_arg(from), __string_arg(to))
+
+/**
+ * Replaces occurrences of several values in a single scan.
+ * At each position the longest matching pattern wins, and replaced text is not scanned again,
+ * so replacements never cascade.
+ *
+ * Parameters:
+ *  - str          The string to search in.
+ *  - from         Array of `count` values to replace. Empty values are ignored.
+ *  - to           Array of `count` replacements, to[i] replaces from[i].
+ *  - count        Number of patterns.
+ *
+ * Returns a new string allocated in the string memory context,
+ * or an empty `string` object if str is NULL or allocation fails.
+ */
+string string_replace_many(string str, const substring *from, const substring *to, size_t count);
+
+string __string_replace(string str, substring from, substring to);
+
+/**
+ * Joins an array of strings with a separator.
+ * The lengths are summed first, so the result is written into a single allocation
+ * and every piece is copied once.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - arr          An array of `string` (or **substring**) pointers, as returned by `string_split`.
+ *                 NULL items are joined as empty strings.
+ *  - sep          The separator (can be either string or char*).
+ *
+ * Returns a new string, or an empty `string` object if arr is NULL or allocation fails.
+ */
+#define string_join(ctx, arr, sep) __string_join(ctx, arr, __string_arg(sep))
+
+/**
+ * Concatenates a fixed list of strings into a single allocation.
+ *
+ * Parameters:
+ *  - ctx          The memory context to use for allocation.
+ *  - ...          The `string` (or **substring**) values to concatenate;
+ *                 wrap C strings with `string_view`.
+ *
+ * Returns a new string, or an empty `string` object if allocation fails.
+ */
+#define string_concat(ctx, ...) __string_concat(ctx, (substring[]){__VA_ARGS__}, \
+    sizeof((substring[]){__VA_ARGS__}) / sizeof(substring))
+
+string __string_join(MemContext *ctx, array *arr, substring sep);
+
+string __string_concat(MemContext *ctx, const substring *parts, size_t count);
+
+/**
+ * Sorts an array of strings in byte order; a string sorts before the strings it is a prefix of.
+ * Uses multikey quicksort on 8-byte keys: each string's next 8 bytes are cached next to its pointer,
+ * so most comparisons do not touch the string data, and common prefixes are compared once
+ * per partition rather than once per comparison.
+ *
+ * Parameters:
+ *  - arr          An array of `string` (or **substring**) pointers. NULL items sort first.
+ *
+ * Returns true if the array was sorted, false if arr is NULL or allocation fails.
+ */
+bool array_sort_strings(array *arr);
+
+/**
+ * Sorts entries that are equal before `depth`.
+ */
+void __string_sort(string_sort_entry *entries, size_t count, size_t depth);
+
+/**
+ * Insertion sort for short ranges.
+ */
+void __string_sort_small(string_sort_entry *entries, size_t count, size_t depth);
+
+/**
+ * Loads 8 bytes of a string starting at `depth` as a big-endian number, padded with zeros.
+ */
+uint64_t __string_sort_prefix(const string *str, size_t depth);
+
+/**
+ * Parses a substring as a signed decimal integer.
+ * The whole substring must be the number: an optional '+' or '-' followed by digits,
+ * without whitespace. Parsing does not depend on the locale or a null terminator.
+ *
+ * Parameters:
+ *  - str          The substring to parse.
+ *  - value        Receives the number. Left unchanged on error.
+ *
+ * Returns STRING_PARSE_OK, or an error code.
+ */
+string_parse_result substring_to_i64(substring str, int64_t *value);
+
+/**
+ * Parses a substring as an unsigned decimal integer.
+ * Same rules as `substring_to_i64`, but a '-' sign is invalid.
+ *
+ * Parameters:
+ *  - str          The substring to parse.
+ *  - value        Receives the number. Left unchanged on error.
+ *
+ * Returns STRING_PARSE_OK, or an error code.
+ */
+string_parse_result substring_to_u64(substring str, uint64_t *value);
+
+/**
+ * Parses a substring as a decimal floating point number, rounded to nearest.
+ * Accepts an optional sign, digits with an optional '.' fraction (at least one digit),
+ * an optional exponent ('e' or 'E', optional sign, digits), and "inf", "infinity" and "nan"
+ * in any case. The decimal point is always '.', whatever the locale.
+ *
+ * Parameters:
+ *  - str          The substring to parse.
+ *  - value        Receives the number. Left unchanged on error,
+ *                 except for STRING_PARSE_OVERFLOW where it receives an infinity.
+ *
+ * Returns STRING_PARSE_OK, or an error code.
+ */
+string_parse_result substring_to_double(substring str, double *value);
+
+/**
+ * Converts a string or a C string argument to a substring.
+ * Used by macros accepting both types.
+ */
+#define __string_arg(value) _Generic((value), \
+    string:      __string_identity, \
+    char*:       string_view, \
+    const char*: string_view \
+)(value)
+
+substring __string_identity(string value);
+
+size_t __string_find_from(string str, substring needle, size_t start);
+
+array* __string_find_all(string str, substring needle);
+
+/**
+ * Returns the smallest buffer capacity that holds `size` bytes
+ * without wasting the memory context alignment padding.
+ */
+size_t __string_fit_capacity(size_t size);
+
+/**
+ * Returns the capacity a string buffer grows to so that it can hold
+ * `size` bytes. Capacity is multiplied by STRING_GROWTH_FACTOR, which keeps
+ * the total cost of repeated appends linear.
+ */
+size_t __string_grow_capacity(size_t capacity, size_t size);
+
+/**
+ * Length-aware substring search kernel.
+ *
+ * Returns the offset of the first occurrence of needle in haystack, or STRING_NOT_FOUND.
+ */
+size_t __string_search(const char *haystack, size_t length, const char *needle, size_t needle_length);
+
+/**
+ * Two-Way substring search (Crochemore-Perrin), linear in the haystack length.
+ */
+size_t __string_search_two_way(const unsigned char *haystack, size_t length, const unsigned char *needle, size_t needle_length);
+
+/**
+ * Adds a byte to a character set, including '\0' which `string_charset_make` cannot express.
+ */
+void __string_charset_add(string_charset *set, char c);
+
+/**
+ * Returns the offset of the first byte whose membership in the set equals `member`,
+ * or `length` if there is none.
+ */
+size_t __string_charset_find(const string_charset *set, const char *value, size_t length, bool member);
+
+/**
+ * Returns the offset of the last byte whose membership in the set equals `member`,
+ * or STRING_NOT_FOUND if there is none.
+ */
+size_t __string_charset_find_last(const string_charset *set, const char *value, size_t length, bool member);
+
+#if defined(STRING_SIMD_SSSE3)
+/**
+ * Returns a mask with bit i set when byte i of the block is a member of the set.
+ */
+uint32_t __string_charset_mask(const string_charset *set, __m128i block);
+#endif
+
+#if defined(STRING_SIMD_AVX2)
+uint32_t __string_charset_mask32(const string_charset *set, __m256i block);
+#endif
+
+/**
+ * Hashes `length` bytes with a seed (wyhash).
+ */
+uint64_t __string_hash_bytes(const void *data, size_t length, uint64_t seed);
+
+/**
+ * Reads 8 or 4 unaligned bytes in native byte order.
+ */
+uint64_t __string_read64(const unsigned char *p);
+uint64_t __string_read32(const unsigned char *p);
+
+/**
+ * Multiplies two 64-bit values into 128 bits, returning the halves XORed together.
+ */
+uint64_t __string_hash_mix(uint64_t a, uint64_t b);
+
+/**
+ * Multiplies two 64-bit values into 128 bits, replacing them with the low and the high half.
+ */
+void __string_hash_multiply(uint64_t *a, uint64_t *b);
+
+/**
+ * Scalar UTF-8 validation, also used for input that the SIMD kernels do not cover.
+ */
+bool __string_utf8_valid_scalar(const unsigned char *value, size_t length);
+
+/**
+ * UTF-8 validation and code point counting kernels. Under STRING_SIMD_DISPATCH
+ * the first call goes through a resolver that checks cpuid and replaces the
+ * function pointer with the best kernel the CPU supports.
+ */
+#if defined(STRING_SIMD_SSSE3) || defined(STRING_SIMD_DISPATCH)
+bool __string_utf8_valid_ssse3(const unsigned char *value, size_t length);
+#endif
+#if defined(STRING_SIMD_AVX2) || defined(STRING_SIMD_DISPATCH)
+bool __string_utf8_valid_avx2(const unsigned char *value, size_t length);
+size_t __string_utf8_length_avx2(const signed char *value, size_t length);
+#endif
+size_t __string_utf8_length_sse2(const signed char *value, size_t length);
+#if defined(STRING_SIMD_DISPATCH)
+bool __string_utf8_valid_resolve(const unsigned char *value, size_t length);
+size_t __string_utf8_length_resolve(const signed char *value, size_t length);
+static bool (*__string_utf8_valid_kernel)(const unsigned char *, size_t) = __string_utf8_valid_resolve;
+static size_t (*__string_utf8_length_kernel)(const signed char *, size_t) = __string_utf8_length_resolve;
+#endif
+
+/**
+ * Returns the number of set bits in a mask.
+ */
+unsigned __string_popcount(uint32_t mask);
+
+/**
+ * Copies `length` bytes from src to dst, flipping the case of bytes in the range first..last.
+ * src and dst may be the same buffer.
+ */
+void __string_convert_case(char *dst, const char *src, size_t length, char first, char last);
+
+/**
+ * Returns the offset of the first byte that differs between a and b after lowercasing,
+ * or `length` if there is none.
+ */
+size_t __string_mismatch_ci(const char *a, const char *b, size_t length);
+
+/**
+ * Base64 and hex kernels. Each returns the number of input bytes it consumed,
+ * processing whole blocks only and stopping early at the first invalid block;
+ * the scalar code finishes the rest and reports errors.
+ * The base64 decoder stores whole vectors, some bytes past what a block
+ * decodes, so it only runs while `dst_length` has room for a full store.
+ */
+size_t __string_base64_encode_blocks(char *dst, const unsigned char *src, size_t length);
+size_t __string_base64_decode_blocks(unsigned char *dst, size_t dst_length, const char *src, size_t length);
+size_t __string_hex_encode_blocks(char *dst, const unsigned char *src, size_t length);
+size_t __string_hex_decode_blocks(unsigned char *dst, const char *src, size_t length);
+
+/**
+ * Allocates a string of `length` bytes with an exact-fit buffer and a terminator.
+ * The content is left for the caller to write.
+ */
+string __string_alloc(MemContext *ctx, size_t length);
+
+/**
+ * Finds the leftmost occurrence of any of the patterns at or after start;
+ * when several patterns occur there, the longest wins.
+ * `first` is the set of first bytes of the non-empty patterns.
+ *
+ * Returns the offset of the occurrence and stores the pattern index in *pattern,
+ * or returns STRING_NOT_FOUND.
+ */
+size_t __string_match_any(string str, size_t start, const string_charset *first,
+                          const substring *patterns, size_t count, size_t *pattern);
+
+/**
+ * Accumulates up to `limit` decimal digits into *value, 8 at a time where possible.
+ * Returns the number of digits consumed.
+ */
+size_t __string_parse_digits(const char *value, size_t length, uint64_t *result, size_t limit);
+
+/**
+ * Parses an unsigned magnitude for `substring_to_i64` and `substring_to_u64`.
+ */
+string_parse_result __string_parse_magnitude(const char *value, size_t length, uint64_t *result);
+
+/**
+ * Eisel-Lemire: rounds w * 10^q to the nearest double from the product of w and a 128-bit power of ten,
+ * for every w from `w_low` to `w_high`. Returns false if the product is too close to a rounding boundary
+ * to decide, or 10^q is outside the table.
+ */
+bool __string_eisel_lemire(uint64_t w_low, uint64_t w_high, int64_t q, double *result);
+
+/**
+ * Returns the upper 64 bits of w * (hi * 2^64 + lo) + 4w * `extra`, with bit 0 set if any lower bit is.
+ */
+uint64_t __string_pow10_product(uint64_t w, uint64_t hi, uint64_t lo, bool extra);
+
+/**
+ * Rounds u * 2^e to the nearest double, ties to even, and returns its bits.
+ * The top bit of u is bit 62 or 63; bit 0 only tells whether anything below was dropped.
+ */
+uint64_t __string_round_bits(uint64_t u, int e);
+
+/**
+ * Parses a double with strtod, for the few inputs Eisel-Lemire cannot decide.
+ * strtod gets the significant digits and a decimal exponent in a stack buffer,
+ * without a decimal point, so the locale does not matter.
+ */
+string_parse_result __string_parse_double_slow(const char *value, size_t length, double *result);
+
+/**
+ * Reads 8 bytes in little-endian byte order.
+ */
+uint64_t __string_read64_le(const char *p);
+
+/**
+ * Returns a mask with bit i set when value[i] is '\n', for up to 64 bytes.
+ */
+uint64_t __string_newline_mask(const char *value, size_t length);
+
+/**
+ * Doubles the offsets of a line index if fewer than `extra` free slots are left.
+ * Returns false if allocation fails.
+ */
+bool __string_line_index_reserve(line_index *index, size_t *capacity, size_t extra);
+
+/**
+ * Returns a view of str between start and end, without a trailing '\r'.
+ */
+substring __string_line_view(string str, size_t start, size_t end);
+
+/**
+ * Returns the number of trailing zero bits of a non-zero mask.
+ */
+unsigned __string_ctz(uint32_t mask);
+
+/**
+ * Returns the number of trailing zero bits of a non-zero 64-bit mask.
+ */
+unsigned __string_ctz64(uint64_t mask);
+
+/**
+ * Returns the number of leading zero bits of a non-zero 64-bit mask.
+ */
+unsigned __string_clz64(uint64_t mask);
+
+/**
+ * Returns the number of leading zero bits of a non-zero mask.
+ */
+unsigned __string_clz(uint32_t mask);
+
+/**
+ * Returns a mask where each bit is the XOR of all bits of `mask` at the same or lower positions.
+ * Applied to a mask of quotes, it marks the bytes from each opening quote up to its closing quote.
+ */
+uint64_t __string_prefix_xor(uint64_t mask);
+
+static const char __string_base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char __string_hex_digits[] = "0123456789abcdef";
+
+// Value of each byte in the base64 alphabet, -1 for bytes outside it
+static const signed char __string_base64_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// Value of each hex digit of either case, -1 for other bytes
+static const signed char __string_hex_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// " \t\n\v\f\r", the characters `isspace` accepts in the "C" locale
+static const string_charset __string_whitespace = {
+    {0x100003E00ULL, 0, 0, 0},
+    {4, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0},
+    {0},
+    6,
+    '\t'
+};
+
+// - Implementation -
+
+string string_init(MemContext *ctx) {
+    string str;
+    str.ctx = ctx;
+    str.length = 0;
+    str.capacity = STRING_INIT_CAPACITY;
+    str.value = (char *)memctx_alloc(ctx, str.capacity);
+    if (str.value) {
+        str.value[0] = '\0';
+    }
+    return str;
+}
+
+string __string_make_n(MemContext *ctx, const char *value, size_t length) {
+    if (!value) return string_init(ctx);
+
+    // Allocate exactly what the value needs: most strings are short
+    // and never appended to, so reserving STRING_INIT_CAPACITY is wasteful.
+    string str;
+    str.ctx = ctx;
+    str.length = 0;
+    str.capacity = __string_fit_capacity(length + 1);
+    str.value = (char *)memctx_alloc(ctx, str.capacity);
+    if (!str.value) {
+        str.capacity = 0;
+        return str;
+    }
+
+    memcpy(str.value, value, length);
+    str.value[length] = '\0';
+    str.length = length;
+    return str;
+}
+
+string __string_make_chars(MemContext *ctx, const char *value) {
+    return __string_make_n(ctx, value, value ? strlen(value) : 0);
+}
+
+string __string_make_string(MemContext *ctx, string value) {
+    return __string_make_n(ctx, value.value, value.length);
+}
+
+string string_append_n(string str, const char *value, size_t length) {
+    if (!str.value || !value) return str;
+    
+    size_t new_length = str.length + length;
+    
+    // Check if we need to expand capacity
+    if (new_length >= str.capacity) {
+        size_t new_capacity = __string_grow_capacity(str.capacity, new_length + 1);
+        char *new_value = (char *)memctx_alloc(str.ctx, new_capacity);
+        if (!new_value) return str;  // Failed to allocate
+        
+        // Copy existing string and append new content
+        memcpy(new_value, str.value, str.length);
+        memcpy(new_value + str.length, value, length);
+        
+        // Update the string with new buffer and capacity
+        str.value = new_value;
+        str.capacity = new_capacity;
+    } else {
+        // Enough space, just append. The value may be a view into a larger
+        // string, so the terminator is written rather than copied.
+        memcpy(str.value + str.length, value, length);
+    }
+    
+    str.value[new_length] = '\0';
+    str.length = new_length;
+    return str;
+}
+
+string __string_append_string(string str, string value) {
+    return string_append_n(str, value.value, value.length);
+}
+
+string __string_append_chars(string str, const char* value) {
+    if (!value) return str;
+    return string_append_n(str, value, strlen(value));
+}
+
+string string_read_file(MemContext *ctx, const char *filename) {
+    string str;
+    str.ctx = ctx;
+    str.length = 0;
+    str.capacity = 0;
+    str.value = NULL;
+    
+    if (!ctx || !filename) return str;
+    
+    char *file_content;
+    size_t file_size = memctx_open_file(ctx, &file_content, (char *)filename);
+    
+    if (file_size == 0 || !file_content) {
+        return str;
+    }
+    
+    str.value = file_content;
+    str.length = file_size;
+    str.capacity = file_size + 1;  // +1 for null terminator which is already appended by memctx_open_file
+    
+    return str;
+}
+
+void string_free_file(string str) {
+    if (!str.ctx || !str.value) return;
+    memctx_free_file(str.ctx, str.value);
+}
+
+substring string_trim(string str) {
+    return string_trim_right(string_trim_left(str));
+}
+
+substring string_trim_left(string str) {
+    substring result = {0};
+    if (!str.value) return result;
+
+    size_t start = str.length ? __string_charset_find(&__string_whitespace, str.value, str.length, false) : 0;
+
+    // Views get capacity equal to length, so appending to them never writes into the source
+    result.value = str.value + start;
+    result.length = str.length - start;
+    result.capacity = result.length;
+    result.ctx = str.ctx;
+    return result;
+}
+
+substring string_trim_right(string str) {
+    substring result = {0};
+    if (!str.value) return result;
+
+    size_t last = str.length ? __string_charset_find_last(&__string_whitespace, str.value, str.length, false)
+                             : STRING_NOT_FOUND;
+
+    result.value = str.value;
+    result.length = last == STRING_NOT_FOUND ? 0 : last + 1;
+    result.capacity = result.length;
+    result.ctx = str.ctx;
+    return result;
+}
+
+string_charset string_charset_make(const char *chars) {
+    string_charset set;
+    memset(&set, 0, sizeof(set));
+    if (!chars) return set;
+
+    for (; *chars; chars++) {
+        __string_charset_add(&set, *chars);
+    }
+    return set;
+}
+
+void __string_charset_add(string_charset *set, char c) {
+    unsigned char byte = (unsigned char)c;
+    if (set->bits[byte >> 6] & (1ULL << (byte & 63))) return;
+
+    set->bits[byte >> 6] |= 1ULL << (byte & 63);
+    if (byte < 0x80) {
+        set->low[byte & 15] |= (unsigned char)(1u << (byte >> 4));
+    } else {
+        set->high[byte & 15] |= (unsigned char)(1u << ((byte >> 4) - 8));
+    }
+    set->single = c;
+    set->count++;
+}
+
+bool string_charset_has(const string_charset *set, char c) {
+    unsigned char byte = (unsigned char)c;
+    return (set->bits[byte >> 6] >> (byte & 63)) & 1;
+}
+
+size_t string_charset_find(string str, const string_charset *set) {
+    if (!str.value || !set) return STRING_NOT_FOUND;
+
+    size_t offset = __string_charset_find(set, str.value, str.length, true);
+    return offset == str.length ? STRING_NOT_FOUND : offset;
+}
+
+substring string_view(const char *value) {
+    substring result = {0};
+    if (!value) return result;
+
+    result.value = (char *)value;
+    result.length = strlen(value);
+    result.capacity = result.length + 1;
+    return result;
+}
+
+substring __string_identity(string value) {
+    return value;
+}
+
+size_t __string_find_from(string str, substring needle, size_t start) {
+    if (!str.value || !needle.value || start > str.length) return STRING_NOT_FOUND;
+
+    size_t offset = __string_search(str.value + start, str.length - start, needle.value, needle.length);
+    return offset == STRING_NOT_FOUND ? STRING_NOT_FOUND : start + offset;
+}
+
+array* __string_find_all(string str, substring needle) {
+    array *result = array_init(str.ctx);
+    if (!result || !str.value || !needle.value || needle.length == 0) return result;
+
+    size_t start = 0;
+    while (start + needle.length <= str.length) {
+        size_t offset = __string_search(str.value + start, str.length - start, needle.value, needle.length);
+        if (offset == STRING_NOT_FOUND) break;
+
+        substring *match = (substring *)memctx_alloc(str.ctx, sizeof(substring));
+        if (!match) break;
+        match->value = str.value + start + offset;
+        match->length = needle.length;
+        match->capacity = needle.length;
+        match->ctx = str.ctx;
+        array_append(result, match);
+
+        start += offset + needle.length;
+    }
+
+    return result;
+}
+
+array* string_split(string str, const char *delims) {
+    array *result = array_init(str.ctx);
+    if (!result) return result;
+
+    string_split_iterator it = string_split_iter(str, delims);
+    substring field;
+    while (string_split_next(&it, &field)) {
+        substring *item = (substring *)memctx_alloc(str.ctx, sizeof(substring));
+        if (!item) break;
+        *item = field;
+        array_append(result, item);
+    }
+
+    return result;
+}
+
+string_split_iterator string_split_iter(string str, const char *delims) {
+    string_split_iterator it;
+    it.str = str;
+    it.delims = string_charset_make(delims);
+    it.position = 0;
+    it.skip_empty = false;
+    it.done = !str.value || !delims;
+    return it;
+}
+
+array* string_tokenize(string str, const char *delims) {
+    array *result = array_init(str.ctx);
+    if (!result) return result;
+
+    string_split_iterator it = string_tokenize_iter(str, delims);
+    substring token;
+    while (string_split_next(&it, &token)) {
+        substring *item = (substring *)memctx_alloc(str.ctx, sizeof(substring));
+        if (!item) break;
+        *item = token;
+        array_append(result, item);
+    }
+
+    return result;
+}
+
+string_split_iterator string_tokenize_iter(string str, const char *delims) {
+    string_split_iterator it = string_split_iter(str, delims);
+    it.skip_empty = true;
+    return it;
+}
+
+bool string_split_next(string_split_iterator *it, substring *field) {
+    if (!it || it->done) return false;
+
+    size_t start = it->position;
+    if (it->skip_empty) {
+        start += __string_charset_find(&it->delims, it->str.value + start, it->str.length - start, false);
+        if (start == it->str.length) {
+            it->done = true;
+            return false;
+        }
+    }
+
+    size_t end = start + __string_charset_find(&it->delims, it->str.value + start, it->str.length - start, true);
+
+    // Views get capacity equal to length, so appending to them never writes into the source
+    field->value = it->str.value + start;
+    field->length = end - start;
+    field->capacity = end - start;
+    field->ctx = it->str.ctx;
+
+    if (end == it->str.length) {
+        it->done = true;
+    } else {
+        it->position = end + 1;
+    }
+    return true;
+}
+
+string_line_iterator string_lines(string str) {
+    string_line_iterator it;
+    it.str = str;
+    it.position = 0;
+    it.block = 0;
+    it.done = !str.value || str.length == 0;
+    it.mask = it.done ? 0 : __string_newline_mask(str.value, str.length < 64 ? str.length : 64);
+    return it;
+}
+
+bool string_lines_next(string_line_iterator *it, substring *line) {
+    if (!it || it->done) return false;
+
+    while (!it->mask) {
+        it->block += 64;
+        if (it->block >= it->str.length) {
+            // Last line without a trailing newline
+            it->done = true;
+            if (it->position >= it->str.length) return false;
+            *line = __string_line_view(it->str, it->position, it->str.length);
+            return true;
+        }
+        size_t remaining = it->str.length - it->block;
+        it->mask = __string_newline_mask(it->str.value + it->block, remaining < 64 ? remaining : 64);
+    }
+
+    size_t end = it->block + __string_ctz64(it->mask);
+    it->mask &= it->mask - 1;
+
+    *line = __string_line_view(it->str, it->position, end);
+    it->position = end + 1;
+    return true;
+}
+
+line_index* string_line_index(string str) {
+    if (!str.ctx) return NULL;
+
+    line_index *index = (line_index *)memctx_alloc(str.ctx, sizeof(line_index));
+    if (!index) return NULL;
+    index->str = str;
+    index->count = 0;
+
+    // Offsets grow geometrically; one extra slot holds the end of the last line
+    size_t capacity = 1024;
+    index->offsets = (size_t *)memctx_alloc(str.ctx, sizeof(size_t) * capacity);
+    if (!index->offsets) return NULL;
+
+    size_t position = 0;
+    for (size_t block = 0; str.value && block < str.length; block += 64) {
+        size_t remaining = str.length - block;
+        uint64_t mask = __string_newline_mask(str.value + block, remaining < 64 ? remaining : 64);
+
+        while (mask) {
+            if (!__string_line_index_reserve(index, &capacity, 1)) return NULL;
+            index->offsets[index->count++] = position;
+            position = block + __string_ctz64(mask) + 1;
+            mask &= mask - 1;
+        }
+    }
+
+    // Room for an unterminated last line and the end offset
+    if (!__string_line_index_reserve(index, &capacity, 2)) return NULL;
+    if (position < str.length) {
+        // Last line without a trailing newline, pretend it has one
+        index->offsets[index->count++] = position;
+        position = str.length + 1;
+    }
+    index->offsets[index->count] = position;
+
+    return index;
+}
+
+bool __string_line_index_reserve(line_index *index, size_t *capacity, size_t extra) {
+    if (index->count + extra <= *capacity) return true;
+
+    size_t *offsets = (size_t *)memctx_alloc(index->str.ctx, sizeof(size_t) * *capacity * 2);
+    if (!offsets) return false;
+    memcpy(offsets, index->offsets, sizeof(size_t) * index->count);
+    index->offsets = offsets;
+    *capacity *= 2;
+    return true;
+}
+
+substring string_line_at(line_index *index, size_t line) {
+    substring result = {0};
+    if (!index || line >= index->count) return result;
+    return __string_line_view(index->str, index->offsets[line], index->offsets[line + 1] - 1);
+}
+
+uint64_t string_hash(string str) {
+    return __string_hash_bytes(str.value, str.value ? str.length : 0, 0);
+}
+
+hashed_string string_hashed(string str) {
+    hashed_string result;
+    result.str = str;
+    result.hash = string_hash(str);
+    return result;
+}
+
+#if defined(STRING_SIMD_SSSE3) || defined(STRING_SIMD_DISPATCH)
+// UTF-8 validation after Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+// Each error class is a bit; the three lookups classify the high nibble of the previous byte,
+// its low nibble, and the high nibble of the current byte; their AND is non-zero only for errors.
+#define __UTF8_TOO_SHORT      (1 << 0)
+#define __UTF8_TOO_LONG       (1 << 1)
+#define __UTF8_OVERLONG_3     (1 << 2)
+#define __UTF8_TOO_LARGE      (1 << 3)
+#define __UTF8_SURROGATE      (1 << 4)
+#define __UTF8_OVERLONG_2     (1 << 5)
+#define __UTF8_TOO_LARGE_1000 (1 << 6)
+#define __UTF8_OVERLONG_4     (1 << 6)
+#define __UTF8_TWO_CONTS      (1 << 7)
+#define __UTF8_CARRY          (__UTF8_TOO_SHORT | __UTF8_TOO_LONG | __UTF8_TWO_CONTS)
+
+#define __UTF8_BYTE_1_HIGH \
+    __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG, \
+    __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG, __UTF8_TOO_LONG, \
+    __UTF8_TWO_CONTS, __UTF8_TWO_CONTS, __UTF8_TWO_CONTS, __UTF8_TWO_CONTS, \
+    __UTF8_TOO_SHORT | __UTF8_OVERLONG_2, \
+    __UTF8_TOO_SHORT, \
+    __UTF8_TOO_SHORT | __UTF8_OVERLONG_3 | __UTF8_SURROGATE, \
+    __UTF8_TOO_SHORT | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000 | __UTF8_OVERLONG_4
+
+#define __UTF8_BYTE_1_LOW \
+    __UTF8_CARRY | __UTF8_OVERLONG_3 | __UTF8_OVERLONG_2 | __UTF8_OVERLONG_4, \
+    __UTF8_CARRY | __UTF8_OVERLONG_2, \
+    __UTF8_CARRY, \
+    __UTF8_CARRY, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000 | __UTF8_SURROGATE, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000, \
+    __UTF8_CARRY | __UTF8_TOO_LARGE | __UTF8_TOO_LARGE_1000
+
+#define __UTF8_BYTE_2_HIGH \
+    __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, \
+    __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, \
+    __UTF8_TOO_LONG | __UTF8_OVERLONG_2 | __UTF8_TWO_CONTS | __UTF8_OVERLONG_3 | __UTF8_TOO_LARGE_1000 | __UTF8_OVERLONG_4, \
+    __UTF8_TOO_LONG | __UTF8_OVERLONG_2 | __UTF8_TWO_CONTS | __UTF8_OVERLONG_3 | __UTF8_TOO_LARGE, \
+    __UTF8_TOO_LONG | __UTF8_OVERLONG_2 | __UTF8_TWO_CONTS | __UTF8_SURROGATE | __UTF8_TOO_LARGE, \
+    __UTF8_TOO_LONG | __UTF8_OVERLONG_2 | __UTF8_TWO_CONTS | __UTF8_SURROGATE | __UTF8_TOO_LARGE, \
+    __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT, __UTF8_TOO_SHORT
+
+static const unsigned char __string_utf8_byte_1_high[16] = { __UTF8_BYTE_1_HIGH };
+static const unsigned char __string_utf8_byte_1_low[16] = { __UTF8_BYTE_1_LOW };
+static const unsigned char __string_utf8_byte_2_high[16] = { __UTF8_BYTE_2_HIGH };
+
+/**
+ * Validates one 16-byte block, given the previous block. Returns a non-zero vector on error.
+ */
+__STRING_TARGET("ssse3")
+__m128i __string_utf8_check_block(__m128i input, __m128i previous) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+
+    __m128i byte_1_high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)__string_utf8_byte_1_high),
+                                           _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte_1_low = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)__string_utf8_byte_1_low),
+                                          _mm_and_si128(prev1, nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)__string_utf8_byte_2_high),
+                                           _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // Continuations required by 3 and 4 byte leads two or three bytes back
+    __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+    __m128i must_continue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must_continue, special);
+}
+
+/**
+ * Returns a non-zero vector if the block ends inside a multi-byte sequence.
+ */
+__STRING_TARGET("ssse3")
+__m128i __string_utf8_incomplete(__m128i input) {
+    const __m128i max = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                      (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm_subs_epu8(input, max);
+}
+#endif
+
+#if defined(STRING_SIMD_AVX2) || defined(STRING_SIMD_DISPATCH)
+/**
+ * 32-byte variant of __string_utf8_check_block.
+ */
+__STRING_TARGET("avx2")
+__m256i __string_utf8_check_block32(__m256i input, __m256i previous) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    // Previous bytes cross the 128-bit lanes
+    __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+    __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+    __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+
+    __m256i byte_1_high = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)__string_utf8_byte_1_high)),
+        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)__string_utf8_byte_1_low)),
+        _mm256_and_si256(prev1, nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)__string_utf8_byte_2_high)),
+        _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must_continue, special);
+}
+
+/**
+ * 32-byte variant of __string_utf8_incomplete.
+ */
+__STRING_TARGET("avx2")
+__m256i __string_utf8_incomplete32(__m256i input) {
+    const __m256i max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                         -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                         (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm256_subs_epu8(input, max);
+}
+#endif
+
+#if defined(STRING_SIMD_AVX2) || defined(STRING_SIMD_DISPATCH)
+__STRING_TARGET("avx2")
+bool __string_utf8_valid_avx2(const unsigned char *value, size_t length) {
+    __m256i previous = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        __m256i input = _mm256_loadu_si256((const __m256i *)(value + i));
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, incomplete);
+            incomplete = _mm256_setzero_si256();
+        } else {
+            error = _mm256_or_si256(error, __string_utf8_check_block32(input, previous));
+            incomplete = __string_utf8_incomplete32(input);
+        }
+        previous = input;
+    }
+
+    if (i < length) {
+        unsigned char tail[32] = {0};
+        memcpy(tail, value + i, length - i);
+        __m256i input = _mm256_loadu_si256((const __m256i *)tail);
+        error = _mm256_or_si256(error, __string_utf8_check_block32(input, previous));
+    } else {
+        error = _mm256_or_si256(error, incomplete);
+    }
+
+    return _mm256_testz_si256(error, error);
+}
+
+__STRING_TARGET("avx2")
+size_t __string_utf8_length_avx2(const signed char *value, size_t length) {
+    const __m256i limit = _mm256_set1_epi8(-65);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(value + i));
+        count += __string_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(block, limit)));
+    }
+    return count + __string_utf8_length_sse2(value + i, length - i);
+}
+#endif
+
+#if defined(STRING_SIMD_SSSE3) || defined(STRING_SIMD_DISPATCH)
+__STRING_TARGET("ssse3")
+bool __string_utf8_valid_ssse3(const unsigned char *value, size_t length) {
+    __m128i previous = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i input = _mm_loadu_si128((const __m128i *)(value + i));
+        if (_mm_movemask_epi8(input) == 0) {
+            // ASCII block: only a sequence left open by the previous block is an error
+            error = _mm_or_si128(error, incomplete);
+            incomplete = _mm_setzero_si128();
+        } else {
+            error = _mm_or_si128(error, __string_utf8_check_block(input, previous));
+            incomplete = __string_utf8_incomplete(input);
+        }
+        previous = input;
+    }
+
+    if (i < length) {
+        // Pad the tail with zeros: a truncated sequence then fails as too short
+        unsigned char tail[16] = {0};
+        memcpy(tail, value + i, length - i);
+        __m128i input = _mm_loadu_si128((const __m128i *)tail);
+        error = _mm_or_si128(error, __string_utf8_check_block(input, previous));
+    } else {
+        error = _mm_or_si128(error, incomplete);
+    }
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+#endif
+
+size_t __string_utf8_length_sse2(const signed char *value, size_t length) {
+    size_t count = 0;
+    size_t i = 0;
+
+    // Count the bytes that are not continuation bytes (0x80..0xBF, -128..-65 signed)
+#if defined(STRING_SIMD_SSE2)
+    const __m128i limit = _mm_set1_epi8(-65);
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(value + i));
+        count += __string_popcount((uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(block, limit)));
+    }
+#endif
+    for (; i < length; i++) {
+        if (value[i] > -65) count++;
+    }
+
+    return count;
+}
+
+#if defined(STRING_SIMD_DISPATCH)
+bool __string_utf8_valid_resolve(const unsigned char *value, size_t length) {
+    if (__builtin_cpu_supports("avx2")) {
+        __string_utf8_valid_kernel = __string_utf8_valid_avx2;
+    } else if (__builtin_cpu_supports("ssse3")) {
+        __string_utf8_valid_kernel = __string_utf8_valid_ssse3;
+    } else {
+        __string_utf8_valid_kernel = __string_utf8_valid_scalar;
+    }
+    return __string_utf8_valid_kernel(value, length);
+}
+
+size_t __string_utf8_length_resolve(const signed char *value, size_t length) {
+    if (__builtin_cpu_supports("avx2")) {
+        __string_utf8_length_kernel = __string_utf8_length_avx2;
+    } else {
+        __string_utf8_length_kernel = __string_utf8_length_sse2;
+    }
+    return __string_utf8_length_kernel(value, length);
+}
+#endif
+
+bool string_utf8_valid(string str) {
+    if (!str.value || str.length == 0) return true;
+
+    const unsigned char *value = (const unsigned char *)str.value;
+#if defined(STRING_SIMD_DISPATCH)
+    return __string_utf8_valid_kernel(value, str.length);
+#elif defined(STRING_SIMD_AVX2)
+    return __string_utf8_valid_avx2(value, str.length);
+#elif defined(STRING_SIMD_SSSE3)
+    return __string_utf8_valid_ssse3(value, str.length);
+#else
+    return __string_utf8_valid_scalar(value, str.length);
+#endif
+}
+
+size_t string_utf8_length(string str) {
+    if (!str.value) return 0;
+
+    const signed char *value = (const signed char *)str.value;
+#if defined(STRING_SIMD_DISPATCH)
+    return __string_utf8_length_kernel(value, str.length);
+#elif defined(STRING_SIMD_AVX2)
+    return __string_utf8_length_avx2(value, str.length);
+#else
+    return __string_utf8_length_sse2(value, str.length);
+#endif
+}
+
+string string_to_lower(MemContext *ctx, string str) {
+    string result = {0};
+    if (!str.value) return result;
+
+    result = __string_alloc(ctx, str.length);
+    if (result.value) {
+        __string_convert_case(result.value, str.value, str.length, 'A', 'Z');
+    }
+    return result;
+}
+
+string string_to_upper(MemContext *ctx, string str) {
+    string result = string_to_lower(ctx, str);
+    if (result.value) {
+        // Lowercase first, so every letter is in a..z, then flip
+        __string_convert_case(result.value, result.value, result.length, 'a', 'z');
+    }
+    return result;
+}
+
+void string_to_lower_in_place(string str) {
+    if (!str.value) return;
+    __string_convert_case(str.value, str.value, str.length, 'A', 'Z');
+}
+
+void string_to_upper_in_place(string str) {
+    if (!str.value) return;
+    __string_convert_case(str.value, str.value, str.length, 'a', 'z');
+}
+
+bool __string_equal_ci(substring a, substring b) {
+    if (!a.value || !b.value) return a.value == b.value;
+    if (a.length != b.length) return false;
+    return __string_mismatch_ci(a.value, b.value, a.length) == a.length;
+}
+
+int __string_compare_ci(substring a, substring b) {
+    size_t a_length = a.value ? a.length : 0;
+    size_t b_length = b.value ? b.length : 0;
+    size_t length = a_length < b_length ? a_length : b_length;
+
+    size_t i = length ? __string_mismatch_ci(a.value, b.value, length) : 0;
+    if (i < length) {
+        unsigned char x = (unsigned char)a.value[i];
+        unsigned char y = (unsigned char)b.value[i];
+        if (x >= 'A' && x <= 'Z') x |= 0x20;
+        if (y >= 'A' && y <= 'Z') y |= 0x20;
+        return (int)x - (int)y;
+    }
+
+    return (a_length > b_length) - (a_length < b_length);
+}
+
+string string_base64_encode(MemContext *ctx, string data) {
+    string result = {0};
+    if (!data.value) return result;
+
+    result = __string_alloc(ctx, (data.length + 2) / 3 * 4);
+    if (!result.value) return result;
+
+    const unsigned char *src = (const unsigned char *)data.value;
+    char *dst = result.value;
+    size_t i = __string_base64_encode_blocks(dst, src, data.length);
+    dst += i / 3 * 4;
+
+    for (; i + 3 <= data.length; i += 3) {
+        uint32_t triple = (uint32_t)src[i] << 16 | (uint32_t)src[i + 1] << 8 | src[i + 2];
+        *dst++ = __string_base64_alphabet[triple >> 18];
+        *dst++ = __string_base64_alphabet[(triple >> 12) & 63];
+        *dst++ = __string_base64_alphabet[(triple >> 6) & 63];
+        *dst++ = __string_base64_alphabet[triple & 63];
+    }
+
+    size_t rest = data.length - i;
+    if (rest > 0) {
+        uint32_t triple = (uint32_t)src[i] << 16 | (rest == 2 ? (uint32_t)src[i + 1] << 8 : 0);
+        *dst++ = __string_base64_alphabet[triple >> 18];
+        *dst++ = __string_base64_alphabet[(triple >> 12) & 63];
+        *dst++ = rest == 2 ? __string_base64_alphabet[(triple >> 6) & 63] : '=';
+        *dst++ = '=';
+    }
+
+    return result;
+}
+
+string string_base64_decode(MemContext *ctx, string str) {
+    string result = {0};
+    if (!str.value) return result;
+
+    // Padding is only valid at the end of a whole quantum
+    size_t length = str.length;
+    if (length % 4 == 0 && length > 0 && str.value[length - 1] == '=') {
+        length--;
+        if (str.value[length - 1] == '=') length--;
+    }
+    if (length % 4 == 1) return result;
+
+    size_t decoded = length / 4 * 3 + (length % 4 ? length % 4 - 1 : 0);
+    result = __string_alloc(ctx, decoded);
+    if (!result.value) return result;
+
+    unsigned char *dst = (unsigned char *)result.value;
+    const unsigned char *src = (const unsigned char *)str.value;
+    size_t i = __string_base64_decode_blocks(dst, decoded, str.value, length);
+    dst += i / 4 * 3;
+
+    uint32_t bits = 0;
+    unsigned count = 0;
+    for (; i < length; i++) {
+        int value = __string_base64_values[src[i]];
+        if (value < 0) return (string){0};
+
+        bits = bits << 6 | (uint32_t)value;
+        if (++count == 4) {
+            *dst++ = (unsigned char)(bits >> 16);
+            *dst++ = (unsigned char)(bits >> 8);
+            *dst++ = (unsigned char)bits;
+            bits = 0;
+            count = 0;
+        }
+    }
+
+    // 2 or 3 characters left carry 1 or 2 bytes
+    if (count >= 2) *dst++ = (unsigned char)(bits >> (count == 2 ? 4 : 10));
+    if (count == 3) *dst++ = (unsigned char)(bits >> 2);
+
+    return result;
+}
+
+string string_hex_encode(MemContext *ctx, string data) {
+    string result = {0};
+    if (!data.value) return result;
+
+    result = __string_alloc(ctx, data.length * 2);
+    if (!result.value) return result;
+
+    const unsigned char *src = (const unsigned char *)data.value;
+    size_t i = __string_hex_encode_blocks(result.value, src, data.length);
+    for (; i < data.length; i++) {
+        result.value[2 * i] = __string_hex_digits[src[i] >> 4];
+        result.value[2 * i + 1] = __string_hex_digits[src[i] & 15];
+    }
+
+    return result;
+}
+
+string string_hex_decode(MemContext *ctx, string str) {
+    string result = {0};
+    if (!str.value || str.length % 2 != 0) return result;
+
+    result = __string_alloc(ctx, str.length / 2);
+    if (!result.value) return result;
+
+    unsigned char *dst = (unsigned char *)result.value;
+    size_t i = __string_hex_decode_blocks(dst, str.value, str.length);
+    for (; i < str.length; i += 2) {
+        int high = __string_hex_values[(unsigned char)str.value[i]];
+        int low = __string_hex_values[(unsigned char)str.value[i + 1]];
+        if ((high | low) < 0) return (string){0};
+        dst[i / 2] = (unsigned char)(high << 4 | low);
+    }
+
+    return result;
+}
+
+string __string_replace(string str, substring from, substring to) {
+    string result = {0};
+    if (!str.value) return result;
+    if (!from.value || from.length == 0) {
+        return string_replace_many(str, NULL, NULL, 0);
+    }
+    if (!to.value) to.length = 0;
+
+    // Count the matches first, to allocate the result once
+    size_t matches = 0;
+    size_t start = 0;
+    while (start + from.length <= str.length) {
+        size_t offset = __string_search(str.value + start, str.length - start, from.value, from.length);
+        if (offset == STRING_NOT_FOUND) break;
+        matches++;
+        start += offset + from.length;
+    }
+
+    result = __string_alloc(str.ctx, str.length - matches * from.length + matches * to.length);
+    if (!result.value || matches == 0) {
+        if (result.value) memcpy(result.value, str.value, str.length);
+        return result;
+    }
+
+    char *out = result.value;
+    start = 0;
+    for (size_t i = 0; i < matches; i++) {
+        size_t offset = __string_search(str.value + start, str.length - start, from.value, from.length);
+        memcpy(out, str.value + start, offset);
+        out += offset;
+        memcpy(out, to.value, to.length);
+        out += to.length;
+        start += offset + from.length;
+    }
+    memcpy(out, str.value + start, str.length - start);
+    return result;
+}
+
+string string_replace_many(string str, const substring *from, const substring *to, size_t count) {
+    string result = {0};
+    if (!str.value) return result;
+
+    // Candidate positions are the bytes that start a pattern
+    string_charset first = string_charset_make(NULL);
+    for (size_t i = 0; i < count; i++) {
+        if (from[i].value && from[i].length > 0) {
+            __string_charset_add(&first, from[i].value[0]);
+        }
+    }
+
+    // First scan: compute the output length
+    size_t length = str.length;
+    size_t pattern;
+    size_t start = 0;
+    if (first.count > 0) {
+        for (;;) {
+            size_t offset = __string_match_any(str, start, &first, from, count, &pattern);
+            if (offset == STRING_NOT_FOUND) break;
+            length = length - from[pattern].length + (to[pattern].value ? to[pattern].length : 0);
+            start = offset + from[pattern].length;
+        }
+    }
+
+    result = __string_alloc(str.ctx, length);
+    if (!result.value) return result;
+
+    // Second scan: copy the text between matches and the replacements
+    char *out = result.value;
+    start = 0;
+    if (first.count > 0) {
+        for (;;) {
+            size_t offset = __string_match_any(str, start, &first, from, count, &pattern);
+            if (offset == STRING_NOT_FOUND) break;
+            memcpy(out, str.value + start, offset - start);
+            out += offset - start;
+            if (to[pattern].value) {
+                memcpy(out, to[pattern].value, to[pattern].length);
+                out += to[pattern].length;
+            }
+            start = offset + from[pattern].length;
+        }
+    }
+    memcpy(out, str.value + start, str.length - start);
+    return result;
+}
+
+string __string_join(MemContext *ctx, array *arr, substring sep) {
+    string result = {0};
+    if (!arr) return result;
+    if (!sep.value) sep.length = 0;
+
+    size_t length = arr->length > 0 ? (arr->length - 1) * sep.length : 0;
+    for (size_t i = 0; i < arr->length; i++) {
+        string *item = (string *)arr->items[i];
+        if (item && item->value) length += item->length;
+    }
+
+    result = __string_alloc(ctx, length);
+    if (!result.value) return result;
+
+    char *out = result.value;
+    for (size_t i = 0; i < arr->length; i++) {
+        if (i > 0 && sep.length > 0) {
+            memcpy(out, sep.value, sep.length);
+            out += sep.length;
+        }
+        string *item = (string *)arr->items[i];
+        if (item && item->value) {
+            memcpy(out, item->value, item->length);
+            out += item->length;
+        }
+    }
+    return result;
+}
+
+string __string_concat(MemContext *ctx, const substring *parts, size_t count) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (parts[i].value) length += parts[i].length;
+    }
+
+    string result = __string_alloc(ctx, length);
+    if (!result.value) return result;
+
+    char *out = result.value;
+    for (size_t i = 0; i < count; i++) {
+        if (parts[i].value) {
+            memcpy(out, parts[i].value, parts[i].length);
+            out += parts[i].length;
+        }
+    }
+    return result;
+}
+
+bool array_sort_strings(array *arr) {
+    if (!arr) return false;
+    if (arr->length < 2) return true;
+
+    string_sort_entry *entries = (string_sort_entry *)malloc(sizeof(string_sort_entry) * arr->length);
+    if (!entries) return false;
+
+    // NULL items go first and are not sorted further
+    size_t nulls = 0;
+    for (size_t i = 0; i < arr->length; i++) {
+        if (!arr->items[i]) nulls++;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < arr->length; i++) {
+        string *str = (string *)arr->items[i];
+        if (!str) continue;
+        entries[count].prefix = __string_sort_prefix(str, 0);
+        entries[count].str = str;
+        count++;
+    }
+
+    __string_sort(entries, count, 0);
+
+    for (size_t i = 0; i < nulls; i++) {
+        arr->items[i] = NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        arr->items[nulls + i] = entries[i].str;
+    }
+    free(entries);
+    return true;
+}
+
+void __string_sort(string_sort_entry *entries, size_t count, size_t depth) {
+    while (count > 1) {
+        if (count < 16) {
+            __string_sort_small(entries, count, depth);
+            return;
+        }
+
+        // Median of three
+        uint64_t a = entries[0].prefix, b = entries[count / 2].prefix, c = entries[count - 1].prefix;
+        uint64_t pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        // Three-way partition on the cached prefixes: [0, lt) < pivot, [lt, gt) == pivot, [gt, count) > pivot
+        size_t lt = 0, i = 0, gt = count;
+        while (i < gt) {
+            string_sort_entry entry = entries[i];
+            if (entry.prefix < pivot) {
+                entries[i++] = entries[lt];
+                entries[lt++] = entry;
+            } else if (entry.prefix > pivot) {
+                entries[i] = entries[--gt];
+                entries[gt] = entry;
+            } else {
+                i++;
+            }
+        }
+        // Equal prefixes: strings that end within them come first, shorter first;
+        // the rest continue with the next 8 bytes
+        string_sort_entry *equal = entries + lt;
+        size_t equal_count = gt - lt;
+        size_t ended = 0;
+        for (size_t length = depth; length <= depth + 8; length++) {
+            for (size_t k = ended; k < equal_count; k++) {
+                if (equal[k].str->length == length) {
+                    string_sort_entry entry = equal[k];
+                    equal[k] = equal[ended];
+                    equal[ended++] = entry;
+                }
+            }
+        }
+        equal += ended;
+        equal_count -= ended;
+        for (size_t k = 0; k < equal_count; k++) {
+            equal[k].prefix = __string_sort_prefix(equal[k].str, depth + 8);
+        }
+
+        // Recurse into the two smaller ranges and loop on the largest, so each call
+        // gets at most half the entries and the stack stays O(log n) deep
+        struct { string_sort_entry *entries; size_t count, depth; } ranges[3] = {
+            { entries, lt, depth }, { entries + gt, count - gt, depth }, { equal, equal_count, depth + 8 },
+        };
+        int largest = ranges[0].count >= ranges[1].count ? 0 : 1;
+        if (ranges[2].count > ranges[largest].count) largest = 2;
+        for (int r = 0; r < 3; r++) {
+            if (r != largest) __string_sort(ranges[r].entries, ranges[r].count, ranges[r].depth);
+        }
+        entries = ranges[largest].entries;
+        count = ranges[largest].count;
+        depth = ranges[largest].depth;
+    }
+}
+
+void __string_sort_small(string_sort_entry *entries, size_t count, size_t depth) {
+    for (size_t i = 1; i < count; i++) {
+        string_sort_entry entry = entries[i];
+        size_t j = i;
+        while (j > 0) {
+            const string_sort_entry *other = &entries[j - 1];
+            int order;
+            if (other->prefix != entry.prefix) {
+                order = other->prefix > entry.prefix ? 1 : -1;
+            } else {
+                // Equal up to depth + 8 (with padding): compare the rest, then the lengths
+                size_t length = other->str->length < entry.str->length ? other->str->length : entry.str->length;
+                order = length > depth ? memcmp(other->str->value + depth, entry.str->value + depth, length - depth) : 0;
+                if (order == 0) order = (other->str->length > entry.str->length) - (other->str->length < entry.str->length);
+            }
+            if (order <= 0) break;
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+}
+
+uint64_t __string_sort_prefix(const string *str, size_t depth) {
+    if (depth >= str->length) return 0;
+
+    const unsigned char *p = (const unsigned char *)str->value + depth;
+    size_t remaining = str->length - depth;
+    uint64_t prefix = 0;
+    if (remaining >= 8) {
+        for (int k = 0; k < 8; k++) prefix = (prefix << 8) | p[k];
+    } else {
+        for (size_t k = 0; k < remaining; k++) prefix |= (uint64_t)p[k] << (56 - 8 * k);
+    }
+    return prefix;
+}
+
+string_parse_result substring_to_i64(substring str, int64_t *value) {
+    if (!str.value || str.length == 0) return STRING_PARSE_EMPTY;
+
+    bool negative = str.value[0] == '-';
+    size_t sign = (str.value[0] == '-' || str.value[0] == '+') ? 1 : 0;
+
+    uint64_t magnitude;
+    string_parse_result result = __string_parse_magnitude(str.value + sign, str.length - sign, &magnitude);
+    if (result != STRING_PARSE_OK) return result;
+
+    if (negative) {
+        if (magnitude > (uint64_t)INT64_MAX + 1) return STRING_PARSE_OVERFLOW;
+        *value = magnitude == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)magnitude;
+    } else {
+        if (magnitude > (uint64_t)INT64_MAX) return STRING_PARSE_OVERFLOW;
+        *value = (int64_t)magnitude;
+    }
+    return STRING_PARSE_OK;
+}
+
+string_parse_result substring_to_u64(substring str, uint64_t *value) {
+    if (!str.value || str.length == 0) return STRING_PARSE_EMPTY;
+
+    size_t sign = str.value[0] == '+' ? 1 : 0;
+    return __string_parse_magnitude(str.value + sign, str.length - sign, value);
+}
+
+// Powers of ten that are exact in a double
+static const double __string_pow10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+string_parse_result substring_to_double(substring str, double *value) {
+    if (!str.value || str.length == 0) return STRING_PARSE_EMPTY;
+
+    const char *p = str.value;
+    size_t length = str.length;
+    size_t i = 0;
+
+    bool negative = p[0] == '-';
+    if (p[0] == '-' || p[0] == '+') i++;
+
+    substring rest = {(char *)p + i, length - i, length - i, NULL};
+    if (__string_equal_ci(rest, string_view("inf")) || __string_equal_ci(rest, string_view("infinity"))) {
+        *value = negative ? -HUGE_VAL : HUGE_VAL;
+        return STRING_PARSE_OK;
+    }
+    if (__string_equal_ci(rest, string_view("nan"))) {
+        *value = negative ? -NAN : NAN;
+        return STRING_PARSE_OK;
+    }
+
+    // Up to 19 significant digits are collected into the mantissa;
+    // if there are more, the value lies between mantissa and mantissa + 1 times 10^exponent
+    uint64_t mantissa = 0;
+    size_t digits = 0;
+    int64_t exponent = 0;
+    bool truncated = false;
+
+    size_t start = i;
+    while (i < length && p[i] == '0') i++;
+    size_t n = __string_parse_digits(p + i, length - i, &mantissa, 19);
+    i += n;
+    digits = n;
+    for (; i < length && p[i] >= '0' && p[i] <= '9'; i++) {
+        truncated = true;
+        exponent++;
+    }
+    bool seen_digits = i > start;
+
+    if (i < length && p[i] == '.') {
+        i++;
+        size_t fraction = i;
+        if (digits == 0) {
+            for (; i < length && p[i] == '0'; i++) exponent--;
+        }
+        n = __string_parse_digits(p + i, length - i, &mantissa, 19 - digits);
+        i += n;
+        digits += n;
+        exponent -= (int64_t)n;
+        for (; i < length && p[i] >= '0' && p[i] <= '9'; i++) {
+            truncated = true;
+        }
+        seen_digits = seen_digits || i > fraction;
+    }
+    if (!seen_digits) return STRING_PARSE_INVALID;
+
+    if (i < length && (p[i] == 'e' || p[i] == 'E')) {
+        i++;
+        bool exponent_negative = false;
+        if (i < length && (p[i] == '-' || p[i] == '+')) {
+            exponent_negative = p[i] == '-';
+            i++;
+        }
+        if (i == length || p[i] < '0' || p[i] > '9') return STRING_PARSE_INVALID;
+
+        int64_t e = 0;
+        for (; i < length && p[i] >= '0' && p[i] <= '9'; i++) {
+            if (e < 100000) e = e * 10 + (p[i] - '0');
+        }
+        exponent += exponent_negative ? -e : e;
+    }
+    if (i != length) return STRING_PARSE_INVALID;
+
+#if FLT_EVAL_METHOD == 0
+    // Clinger's fast path: the mantissa and the power of ten are exact doubles,
+    // so a single correctly rounded multiplication or division gives the result
+    if (!truncated) {
+        if (mantissa == 0) {
+            *value = negative ? -0.0 : 0.0;
+            return STRING_PARSE_OK;
+        }
+        // Move excess exponent into the mantissa while it stays exact, e.g. 1e25 = 1000 * 1e22
+        while (exponent > 22 && mantissa <= ((uint64_t)1 << 53) / 10) {
+            mantissa *= 10;
+            exponent--;
+        }
+        if (mantissa <= ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22) {
+            double d = (double)mantissa;
+            d = exponent < 0 ? d / __string_pow10[-exponent] : d * __string_pow10[exponent];
+            *value = negative ? -d : d;
+            return STRING_PARSE_OK;
+        }
+    }
+#endif
+
+    double d;
+    if (__string_eisel_lemire(mantissa, truncated ? mantissa + 1 : mantissa, exponent, &d)) {
+        *value = negative ? -d : d;
+        return isinf(d) ? STRING_PARSE_OVERFLOW : STRING_PARSE_OK;
+    }
+
+    return __string_parse_double_slow(p, length, value);
+}
+
+size_t __string_fit_capacity(size_t size) {
+    // memctx_alloc aligns every allocation to sizeof(uintptr_t)
+    return (size + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+}
+
+size_t __string_grow_capacity(size_t capacity, size_t size) {
+    size_t new_capacity = capacity < STRING_INIT_CAPACITY ? STRING_INIT_CAPACITY : capacity;
+    while (new_capacity < size) {
+        size_t grown = (size_t)(new_capacity * STRING_GROWTH_FACTOR);
+        if (grown <= new_capacity) return __string_fit_capacity(size); // factor too small or overflow
+        new_capacity = grown;
+    }
+    return __string_fit_capacity(new_capacity);
+}
+
+size_t __string_search(const char *haystack, size_t length, const char *needle, size_t needle_length) {
+    if (needle_length == 0) return 0;
+    if (needle_length > length) return STRING_NOT_FOUND;
+
+    if (needle_length == 1) {
+        const char *found = (const char *)memchr(haystack, needle[0], length);
+        return found ? (size_t)(found - haystack) : STRING_NOT_FOUND;
+    }
+
+#if defined(STRING_SIMD_SSE2)
+    // Compare the first and the last needle bytes with 16/32 candidate positions at once,
+    // verify the middle only where both match. Long needles can make verification
+    // expensive, so once it costs more than a linear budget the rest goes to Two-Way.
+    size_t last = needle_length - 1;
+    size_t i = 0;
+    bool limited = needle_length > STRING_SEARCH_SIMD_MAX;
+    size_t verified = 0;
+#define __STRING_SEARCH_VERIFY(position) \
+    if (memcmp(haystack + (position) + 1, needle + 1, last - 1) == 0) return (position); \
+    if (limited && (verified += needle_length) > 4 * i + 64 * needle_length) goto two_way;
+#if defined(STRING_SIMD_AVX2)
+    const __m256i first32 = _mm256_set1_epi8(needle[0]);
+    const __m256i last32 = _mm256_set1_epi8(needle[last]);
+    for (; i + last + 32 <= length; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i *)(haystack + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i *)(haystack + i + last));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(block_first, first32), _mm256_cmpeq_epi8(block_last, last32)));
+        while (mask) {
+            size_t position = i + __string_ctz(mask);
+            __STRING_SEARCH_VERIFY(position)
+            mask &= mask - 1;
+        }
+    }
+#endif
+    const __m128i first16 = _mm_set1_epi8(needle[0]);
+    const __m128i last16 = _mm_set1_epi8(needle[last]);
+    for (; i + last + 16 <= length; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i *)(haystack + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i *)(haystack + i + last));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(block_first, first16), _mm_cmpeq_epi8(block_last, last16)));
+        while (mask) {
+            size_t position = i + __string_ctz(mask);
+            __STRING_SEARCH_VERIFY(position)
+            mask &= mask - 1;
+        }
+    }
+#undef __STRING_SEARCH_VERIFY
+    for (; i + needle_length <= length; i++) {
+        if (haystack[i] == needle[0] && haystack[i + last] == needle[last] &&
+            memcmp(haystack + i + 1, needle + 1, last - 1) == 0) {
+            return i;
+        }
+    }
+    return STRING_NOT_FOUND;
+
+two_way:;
+    // Every candidate before i was rejected
+    size_t found = __string_search_two_way((const unsigned char *)haystack + i, length - i,
+                                           (const unsigned char *)needle, needle_length);
+    return found == STRING_NOT_FOUND ? found : i + found;
+#endif
+
+    return __string_search_two_way((const unsigned char *)haystack, length,
+                                   (const unsigned char *)needle, needle_length);
+}
+
+size_t __string_search_two_way(const unsigned char *haystack, size_t length, const unsigned char *needle, size_t needle_length) {
+    size_t m = needle_length;
+    size_t max_suffix, max_suffix_rev, j, k, p, period;
+
+    // Critical factorization: maximal suffix for both byte orders
+    max_suffix = SIZE_MAX;
+    j = 0;
+    k = p = 1;
+    while (j + k < m) {
+        unsigned char a = needle[j + k];
+        unsigned char b = needle[max_suffix + k];
+        if (a < b) {
+            j += k;
+            k = 1;
+            p = j - max_suffix;
+        } else if (a == b) {
+            if (k != p) {
+                k++;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            max_suffix = j++;
+            k = p = 1;
+        }
+    }
+    period = p;
+
+    max_suffix_rev = SIZE_MAX;
+    j = 0;
+    k = p = 1;
+    while (j + k < m) {
+        unsigned char a = needle[j + k];
+        unsigned char b = needle[max_suffix_rev + k];
+        if (b < a) {
+            j += k;
+            k = 1;
+            p = j - max_suffix_rev;
+        } else if (a == b) {
+            if (k != p) {
+                k++;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            max_suffix_rev = j++;
+            k = p = 1;
+        }
+    }
+
+    size_t suffix;
+    if (max_suffix_rev + 1 < max_suffix + 1) {
+        suffix = max_suffix + 1;
+    } else {
+        suffix = max_suffix_rev + 1;
+        period = p;
+    }
+
+    size_t i;
+    if (memcmp(needle, needle + period, suffix) == 0) {
+        // Periodic needle: remember how much of the right half already matched
+        size_t memory = 0;
+        j = 0;
+        while (j <= length - m) {
+            i = suffix > memory ? suffix : memory;
+            while (i < m && needle[i] == haystack[i + j]) i++;
+            if (i >= m) {
+                i = suffix - 1;
+                while (memory < i + 1 && needle[i] == haystack[i + j]) i--;
+                if (i + 1 < memory + 1) return j;
+                j += period;
+                memory = m - period;
+            } else {
+                j += i - suffix + 1;
+                memory = 0;
+            }
+        }
+    } else {
+        // Distinct halves: any mismatch gives a maximal shift
+        period = (suffix > m - suffix ? suffix : m - suffix) + 1;
+        j = 0;
+        while (j <= length - m) {
+            i = suffix;
+            while (i < m && needle[i] == haystack[i + j]) i++;
+            if (i >= m) {
+                i = suffix - 1;
+                while (i != SIZE_MAX && needle[i] == haystack[i + j]) i--;
+                if (i == SIZE_MAX) return j;
+                j += period;
+            } else {
+                j += i - suffix + 1;
+            }
+        }
+    }
+
+    return STRING_NOT_FOUND;
+}
+
+size_t __string_charset_find(const string_charset *set, const char *value, size_t length, bool member) {
+    if (member && set->count == 0) return length;
+    if (member && set->count == 1) {
+        const char *found = (const char *)memchr(value, set->single, length);
+        return found ? (size_t)(found - value) : length;
+    }
+
+    size_t i = 0;
+#if defined(STRING_SIMD_AVX2)
+    for (; i + 32 <= length; i += 32) {
+        uint32_t mask = __string_charset_mask32(set, _mm256_loadu_si256((const __m256i *)(value + i)));
+        if (!member) mask = ~mask;
+        if (mask) return i + __string_ctz(mask);
+    }
+#endif
+#if defined(STRING_SIMD_SSSE3)
+    for (; i + 16 <= length; i += 16) {
+        uint32_t mask = __string_charset_mask(set, _mm_loadu_si128((const __m128i *)(value + i)));
+        if (!member) mask = ~mask & 0xFFFF;
+        if (mask) return i + __string_ctz(mask);
+    }
+#endif
+    for (; i < length; i++) {
+        if (string_charset_has(set, value[i]) == member) return i;
+    }
+    return length;
+}
+
+size_t __string_charset_find_last(const string_charset *set, const char *value, size_t length, bool member) {
+    size_t i = length;
+#if defined(STRING_SIMD_AVX2)
+    for (; i >= 32; i -= 32) {
+        uint32_t mask = __string_charset_mask32(set, _mm256_loadu_si256((const __m256i *)(value + i - 32)));
+        if (!member) mask = ~mask;
+        if (mask) return i - 1 - __string_clz(mask);
+    }
+#endif
+#if defined(STRING_SIMD_SSSE3)
+    for (; i >= 16; i -= 16) {
+        uint32_t mask = __string_charset_mask(set, _mm_loadu_si128((const __m128i *)(value + i - 16)));
+        if (!member) mask = ~mask & 0xFFFF;
+        if (mask) return i + 15 - __string_clz(mask);
+    }
+#endif
+    while (i > 0) {
+        i--;
+        if (string_charset_has(set, value[i]) == member) return i;
+    }
+    return STRING_NOT_FOUND;
+}
+
+// 1 << (h & 7) for each high nibble h
+static const unsigned char __string_charset_bit[16] = {
+    1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+};
+
+#if defined(STRING_SIMD_SSSE3)
+uint32_t __string_charset_mask(const string_charset *set, __m128i block) {
+    const __m128i low = _mm_loadu_si128((const __m128i *)set->low);
+    const __m128i high = _mm_loadu_si128((const __m128i *)set->high);
+    const __m128i bit = _mm_loadu_si128((const __m128i *)__string_charset_bit);
+
+    // PSHUFB yields 0 for indexes with the top bit set, so each table
+    // only answers for its own half of the byte range
+    __m128i rows = _mm_or_si128(_mm_shuffle_epi8(low, block),
+                                _mm_shuffle_epi8(high, _mm_xor_si128(block, _mm_set1_epi8((char)0x80))));
+    __m128i column = _mm_shuffle_epi8(bit, _mm_and_si128(_mm_srli_epi16(block, 4), _mm_set1_epi8(0x0F)));
+    __m128i hits = _mm_cmpeq_epi8(_mm_and_si128(rows, column), column);
+    return (uint32_t)_mm_movemask_epi8(hits);
+}
+#endif
+
+#if defined(STRING_SIMD_AVX2)
+uint32_t __string_charset_mask32(const string_charset *set, __m256i block) {
+    const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)set->low));
+    const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)set->high));
+    const __m256i bit = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)__string_charset_bit));
+
+    __m256i rows = _mm256_or_si256(_mm256_shuffle_epi8(low, block),
+                                   _mm256_shuffle_epi8(high, _mm256_xor_si256(block, _mm256_set1_epi8((char)0x80))));
+    __m256i column = _mm256_shuffle_epi8(bit, _mm256_and_si256(_mm256_srli_epi16(block, 4), _mm256_set1_epi8(0x0F)));
+    __m256i hits = _mm256_cmpeq_epi8(_mm256_and_si256(rows, column), column);
+    return (uint32_t)_mm256_movemask_epi8(hits);
+}
+#endif
+
+static const uint64_t __string_hash_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+uint64_t __string_read64(const unsigned char *p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t __string_read32(const unsigned char *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t __string_hash_bytes(const void *data, size_t length, uint64_t seed) {
+    const unsigned char *p = (const unsigned char *)data;
+    const uint64_t *secret = __string_hash_secret;
+    uint64_t a, b;
+
+    seed ^= __string_hash_mix(seed ^ secret[0], secret[1]);
+
+    if (length <= 16) {
+        if (length >= 4) {
+            size_t shift = (length >> 3) << 2;
+            a = (__string_read32(p) << 32) | __string_read32(p + shift);
+            b = (__string_read32(p + length - 4) << 32) | __string_read32(p + length - 4 - shift);
+        } else if (length > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = length;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = __string_hash_mix(__string_read64(p) ^ secret[1], __string_read64(p + 8) ^ seed);
+                see1 = __string_hash_mix(__string_read64(p + 16) ^ secret[2], __string_read64(p + 24) ^ see1);
+                see2 = __string_hash_mix(__string_read64(p + 32) ^ secret[3], __string_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = __string_hash_mix(__string_read64(p) ^ secret[1], __string_read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = __string_read64(p + i - 16);
+        b = __string_read64(p + i - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    __string_hash_multiply(&a, &b);
+    return __string_hash_mix(a ^ secret[0] ^ length, b ^ secret[1]);
+}
+
+uint64_t __string_hash_mix(uint64_t a, uint64_t b) {
+    __string_hash_multiply(&a, &b);
+    return a ^ b;
+}
+
+void __string_hash_multiply(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 product = (uint128)*a * *b;
+    *a = (uint64_t)product;
+    *b = (uint64_t)(product >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+bool __string_utf8_valid_scalar(const unsigned char *value, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        // ASCII fast path, 8 bytes at a time
+        if (i + 8 <= length && (__string_read64(value + i) & 0x8080808080808080ULL) == 0) {
+            i += 8;
+            continue;
+        }
+
+        unsigned char byte = value[i];
+        if (byte < 0x80) {
+            i++;
+            continue;
+        }
+
+        size_t count;
+        unsigned char low = 0x80, high = 0xBF;  // Allowed range of the second byte
+        if (byte >= 0xC2 && byte <= 0xDF) {
+            count = 2;
+        } else if (byte >= 0xE0 && byte <= 0xEF) {
+            count = 3;
+            if (byte == 0xE0) low = 0xA0;       // Overlong
+            if (byte == 0xED) high = 0x9F;      // Surrogates
+        } else if (byte >= 0xF0 && byte <= 0xF4) {
+            count = 4;
+            if (byte == 0xF0) low = 0x90;       // Overlong
+            if (byte == 0xF4) high = 0x8F;      // Above U+10FFFF
+        } else {
+            return false;
+        }
+
+        if (i + count > length) return false;
+        if (value[i + 1] < low || value[i + 1] > high) return false;
+        for (size_t j = 2; j < count; j++) {
+            if ((value[i + j] & 0xC0) != 0x80) return false;
+        }
+        i += count;
+    }
+
+    return true;
+}
+
+unsigned __string_popcount(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_popcount(mask);
+#else
+    unsigned count = 0;
+    while (mask) {
+        mask &= mask - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+void __string_convert_case(char *dst, const char *src, size_t length, char first, char last) {
+    size_t i = 0;
+#if defined(STRING_SIMD_AVX2)
+    const __m256i below32 = _mm256_set1_epi8((char)(first - 1));
+    const __m256i above32 = _mm256_set1_epi8((char)(last + 1));
+    const __m256i flip32 = _mm256_set1_epi8(0x20);
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(src + i));
+        // Bytes >= 0x80 are negative and never fall in the range
+        __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi8(block, below32), _mm256_cmpgt_epi8(above32, block));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(block, _mm256_and_si256(in_range, flip32)));
+    }
+#endif
+#if defined(STRING_SIMD_SSE2)
+    const __m128i below16 = _mm_set1_epi8((char)(first - 1));
+    const __m128i above16 = _mm_set1_epi8((char)(last + 1));
+    const __m128i flip16 = _mm_set1_epi8(0x20);
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(block, below16), _mm_cmplt_epi8(block, above16));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(block, _mm_and_si128(in_range, flip16)));
+    }
+#endif
+    for (; i < length; i++) {
+        char c = src[i];
+        dst[i] = (c >= first && c <= last) ? (char)(c ^ 0x20) : c;
+    }
+}
+
+size_t __string_mismatch_ci(const char *a, const char *b, size_t length) {
+    size_t i = 0;
+    // Shifting 'A' to -128 leaves the upper case letters as the only bytes below -128 + 26,
+    // so one add and one signed compare find them
+#if defined(STRING_SIMD_AVX2)
+    const __m256i shift32 = _mm256_set1_epi8((char)(0x80 - 'A'));
+    const __m256i limit32 = _mm256_set1_epi8(-128 + 26);
+    const __m256i flip32 = _mm256_set1_epi8(0x20);
+    for (; i + 32 <= length; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        x = _mm256_or_si256(x, _mm256_and_si256(_mm256_cmpgt_epi8(limit32, _mm256_add_epi8(x, shift32)), flip32));
+        y = _mm256_or_si256(y, _mm256_and_si256(_mm256_cmpgt_epi8(limit32, _mm256_add_epi8(y, shift32)), flip32));
+        uint32_t equal = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+        if (equal != 0xFFFFFFFF) return i + __string_ctz(~equal);
+    }
+#endif
+#if defined(STRING_SIMD_SSE2)
+    const __m128i shift = _mm_set1_epi8((char)(0x80 - 'A'));
+    const __m128i limit = _mm_set1_epi8(-128 + 26);
+    const __m128i flip = _mm_set1_epi8(0x20);
+    for (; i + 16 <= length; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        x = _mm_or_si128(x, _mm_and_si128(_mm_cmpgt_epi8(limit, _mm_add_epi8(x, shift)), flip));
+        y = _mm_or_si128(y, _mm_and_si128(_mm_cmpgt_epi8(limit, _mm_add_epi8(y, shift)), flip));
+        uint32_t equal = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if (equal != 0xFFFF) return i + __string_ctz(~equal);
+    }
+#endif
+    for (; i < length; i++) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x |= 0x20;
+        if (y >= 'A' && y <= 'Z') y |= 0x20;
+        if (x != y) return i;
+    }
+    return length;
+}
+
+size_t __string_base64_encode_blocks(char *dst, const unsigned char *src, size_t length) {
+    size_t i = 0;
+#if defined(STRING_SIMD_SSSE3)
+    // Spread each 3 input bytes over 4 bytes, shift the 6-bit fields into place
+    // with multiplies, then turn indices into characters with one offset lookup (Mula)
+    const __m128i spread16 = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i mask_ac16 = _mm_set1_epi32(0x0FC0FC00);
+    const __m128i shift_ac16 = _mm_set1_epi32(0x04000040);
+    const __m128i mask_bd16 = _mm_set1_epi32(0x003F03F0);
+    const __m128i shift_bd16 = _mm_set1_epi32(0x01000010);
+    const __m128i offsets16 = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '+' - 62, '/' - 63, 'A', 0, 0);
+#if defined(STRING_SIMD_AVX2)
+    const __m256i spread32 = _mm256_broadcastsi128_si256(spread16);
+    const __m256i mask_ac32 = _mm256_set1_epi32(0x0FC0FC00);
+    const __m256i shift_ac32 = _mm256_set1_epi32(0x04000040);
+    const __m256i mask_bd32 = _mm256_set1_epi32(0x003F03F0);
+    const __m256i shift_bd32 = _mm256_set1_epi32(0x01000010);
+    const __m256i offsets32 = _mm256_broadcastsi128_si256(offsets16);
+    // Each lane loads 16 bytes and uses 12, so the last load must stay in bounds
+    for (; i + 28 <= length; i += 24) {
+        __m256i in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(src + i))),
+            _mm_loadu_si128((const __m128i *)(src + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, spread32);
+        __m256i indices = _mm256_or_si256(
+            _mm256_mulhi_epu16(_mm256_and_si256(in, mask_ac32), shift_ac32),
+            _mm256_mullo_epi16(_mm256_and_si256(in, mask_bd32), shift_bd32));
+        __m256i lookup = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        lookup = _mm256_or_si256(lookup, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+        _mm256_storeu_si256((__m256i *)(dst + i / 3 * 4), _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets32, lookup)));
+    }
+#endif
+    for (; i + 16 <= length; i += 12) {
+        __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)), spread16);
+        __m128i indices = _mm_or_si128(
+            _mm_mulhi_epu16(_mm_and_si128(in, mask_ac16), shift_ac16),
+            _mm_mullo_epi16(_mm_and_si128(in, mask_bd16), shift_bd16));
+        // 0..25 -> 13, 26..51 -> 0, 52..63 -> 1..12
+        __m128i lookup = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        lookup = _mm_or_si128(lookup, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+        _mm_storeu_si128((__m128i *)(dst + i / 3 * 4), _mm_add_epi8(indices, _mm_shuffle_epi8(offsets16, lookup)));
+    }
+#else
+    (void)dst;
+    (void)src;
+    (void)length;
+#endif
+    return i;
+}
+
+size_t __string_base64_decode_blocks(unsigned char *dst, size_t dst_length, const char *src, size_t length) {
+    size_t i = 0;
+#if defined(STRING_SIMD_SSSE3)
+    // Classify characters by their nibbles: a byte is valid when the
+    // low and high nibble lookups share no bit. The high nibble, with a
+    // correction for '/', then selects the offset that maps it to its value.
+    const __m128i lut_lo16 = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi16 = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll16 = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack16 = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+#if defined(STRING_SIMD_AVX2)
+    const __m256i lut_lo32 = _mm256_broadcastsi128_si256(lut_lo16);
+    const __m256i lut_hi32 = _mm256_broadcastsi128_si256(lut_hi16);
+    const __m256i lut_roll32 = _mm256_broadcastsi128_si256(lut_roll16);
+    const __m256i pack32 = _mm256_broadcastsi128_si256(pack16);
+    const __m256i lanes32 = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    for (; i + 32 <= length && i / 4 * 3 + 32 <= dst_length; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0F));
+        __m256i lo = _mm256_and_si256(in, _mm256_set1_epi8(0x0F));
+        __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(lut_lo32, lo), _mm256_shuffle_epi8(lut_hi32, hi));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(invalid, _mm256_setzero_si256())) != -1) return i;
+
+        __m256i slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+        __m256i values = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut_roll32, _mm256_add_epi8(slash, hi)));
+        __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(merged, pack32), lanes32);
+        _mm256_storeu_si256((__m256i *)(dst + i / 4 * 3), merged);
+    }
+#endif
+    for (; i + 16 <= length && i / 4 * 3 + 16 <= dst_length; i += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0F));
+        __m128i lo = _mm_and_si128(in, _mm_set1_epi8(0x0F));
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lut_lo16, lo), _mm_shuffle_epi8(lut_hi16, hi));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF) return i;
+
+        __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+        __m128i values = _mm_add_epi8(in, _mm_shuffle_epi8(lut_roll16, _mm_add_epi8(slash, hi)));
+        // Join 6-bit fields into pairs, then pairs into 24-bit groups, then drop the gaps
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i *)(dst + i / 4 * 3), _mm_shuffle_epi8(merged, pack16));
+    }
+#else
+    (void)dst;
+    (void)dst_length;
+    (void)src;
+    (void)length;
+#endif
+    return i;
+}
+
+size_t __string_hex_encode_blocks(char *dst, const unsigned char *src, size_t length) {
+    size_t i = 0;
+#if defined(STRING_SIMD_SSSE3)
+    const __m128i digits16 = _mm_loadu_si128((const __m128i *)__string_hex_digits);
+#if defined(STRING_SIMD_AVX2)
+    const __m256i digits32 = _mm256_broadcastsi128_si256(digits16);
+    for (; i + 32 <= length; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i hi = _mm256_shuffle_epi8(digits32, _mm256_and_si256(_mm256_srli_epi16(in, 4), _mm256_set1_epi8(0x0F)));
+        __m256i lo = _mm256_shuffle_epi8(digits32, _mm256_and_si256(in, _mm256_set1_epi8(0x0F)));
+        // Unpacking works within lanes, so the halves are reordered afterwards
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i *)(dst + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+#endif
+    for (; i + 16 <= length; i += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_shuffle_epi8(digits16, _mm_and_si128(_mm_srli_epi16(in, 4), _mm_set1_epi8(0x0F)));
+        __m128i lo = _mm_shuffle_epi8(digits16, _mm_and_si128(in, _mm_set1_epi8(0x0F)));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#else
+    (void)dst;
+    (void)src;
+    (void)length;
+#endif
+    return i;
+}
+
+size_t __string_hex_decode_blocks(unsigned char *dst, const char *src, size_t length) {
+    size_t i = 0;
+#if defined(STRING_SIMD_SSSE3)
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i ten = _mm_set1_epi8(10);
+    const __m128i lower_a = _mm_set1_epi8('a');
+    const __m128i six = _mm_set1_epi8(6);
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i minus_one = _mm_set1_epi8(-1);
+    // Each pair of digits becomes high * 16 + low
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    for (; i + 32 <= length; i += 32) {
+        __m128i pairs[2];
+        for (int half = 0; half < 2; half++) {
+            __m128i in = _mm_loadu_si128((const __m128i *)(src + i + 16 * half));
+            // Bytes >= 0x80 stay negative after the subtractions and match neither range
+            __m128i digit = _mm_sub_epi8(in, zero);
+            __m128i letter = _mm_sub_epi8(_mm_or_si128(in, lower), lower_a);
+            __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(digit, minus_one), _mm_cmplt_epi8(digit, ten));
+            __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(letter, minus_one), _mm_cmplt_epi8(letter, six));
+            if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF) return i;
+
+            __m128i values = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                                          _mm_and_si128(is_letter, _mm_add_epi8(letter, ten)));
+            pairs[half] = _mm_maddubs_epi16(values, weights);
+        }
+        _mm_storeu_si128((__m128i *)(dst + i / 2), _mm_packus_epi16(pairs[0], pairs[1]));
+    }
+#else
+    (void)dst;
+    (void)src;
+    (void)length;
+#endif
+    return i;
+}
+
+string __string_alloc(MemContext *ctx, size_t length) {
+    string str;
+    str.ctx = ctx;
+    str.length = length;
+    str.capacity = __string_fit_capacity(length + 1);
+    str.value = (char *)memctx_alloc(ctx, str.capacity);
+    if (!str.value) {
+        str.length = 0;
+        str.capacity = 0;
+        return str;
+    }
+    str.value[length] = '\0';
+    return str;
+}
+
+size_t __string_match_any(string str, size_t start, const string_charset *first,
+                          const substring *patterns, size_t count, size_t *pattern) {
+    while (start < str.length) {
+        size_t offset = start + __string_charset_find(first, str.value + start, str.length - start, true);
+        if (offset == str.length) break;
+
+        size_t best = STRING_NOT_FOUND;
+        for (size_t i = 0; i < count; i++) {
+            const substring *p = &patterns[i];
+            if (!p->value || p->length == 0 || p->length > str.length - offset) continue;
+            if (best != STRING_NOT_FOUND && p->length <= patterns[best].length) continue;
+            if (memcmp(str.value + offset, p->value, p->length) == 0) best = i;
+        }
+        if (best != STRING_NOT_FOUND) {
+            *pattern = best;
+            return offset;
+        }
+        start = offset + 1;
+    }
+    return STRING_NOT_FOUND;
+}
+
+uint64_t __string_read64_le(const char *p) {
+    const unsigned char *bytes = (const unsigned char *)p;
+    return (uint64_t)bytes[0] | (uint64_t)bytes[1] << 8 | (uint64_t)bytes[2] << 16 | (uint64_t)bytes[3] << 24 |
+           (uint64_t)bytes[4] << 32 | (uint64_t)bytes[5] << 40 | (uint64_t)bytes[6] << 48 | (uint64_t)bytes[7] << 56;
+}
+
+size_t __string_parse_digits(const char *value, size_t length, uint64_t *result, size_t limit) {
+    if (length > limit) length = limit;
+
+    uint64_t number = *result;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        // SWAR: check and convert 8 ASCII digits at once
+        uint64_t chunk = __string_read64_le(value + i);
+        if (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+            != 0x3333333333333333ULL) break;
+
+        chunk -= 0x3030303030303030ULL;
+        chunk = chunk * 10 + (chunk >> 8);
+        chunk = ((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)) +
+                 ((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+        number = number * 100000000 + (uint32_t)chunk;
+    }
+    for (; i < length && value[i] >= '0' && value[i] <= '9'; i++) {
+        number = number * 10 + (uint64_t)(value[i] - '0');
+    }
+
+    *result = number;
+    return i;
+}
+
+string_parse_result __string_parse_magnitude(const char *value, size_t length, uint64_t *result) {
+    if (length == 0) return STRING_PARSE_INVALID;
+
+    size_t i = 0;
+    while (i < length && value[i] == '0') i++;
+    bool seen_digits = i > 0;
+
+    // 19 digits always fit, the 20th is checked
+    uint64_t number = 0;
+    size_t n = __string_parse_digits(value + i, length - i, &number, 19);
+    i += n;
+    seen_digits = seen_digits || n > 0;
+    if (!seen_digits) return STRING_PARSE_INVALID;
+
+    bool overflow = false;
+    for (; i < length && value[i] >= '0' && value[i] <= '9'; i++) {
+        uint64_t digit = (uint64_t)(value[i] - '0');
+        if (overflow || number > (UINT64_MAX - digit) / 10) {
+            overflow = true;
+        } else {
+            number = number * 10 + digit;
+        }
+    }
+    if (i != length) return STRING_PARSE_INVALID;
+    if (overflow) return STRING_PARSE_OVERFLOW;
+
+    *result = number;
+    return STRING_PARSE_OK;
+}
+
+bool __string_eisel_lemire(uint64_t w_low, uint64_t w_high, int64_t q, double *result) {
+    if (w_high == 0) {
+        *result = 0.0;
+        return true;
+    }
+    // Below 10^-343 even 2^64 * 10^q is less than half the smallest subnormal
+    if (q < -343) {
+        *result = 0.0;
+        return true;
+    }
+    if (q > 308) {
+        *result = HUGE_VAL;
+        return true;
+    }
+    if (w_low == 0 || -q - MEMCTX_POW10_K_MIN >= 617) return false;
+
+    // The table holds g = floor(10^q * 2^-r) + 1 in 63-bit halves; g - 1 shifted to 128 bits
+    // is a lower bound of 10^q * 2^(2-r) that is less than 4 below it
+    const uint64_t *g = __memctx_pow10_g[-q - MEMCTX_POW10_K_MIN];
+    uint64_t low63 = g[1] - 1;
+    uint64_t high63 = g[0] - (low63 >> 63);
+    low63 &= ((uint64_t)1 << 63) - 1;
+    uint64_t hi = high63 << 1 | low63 >> 62;
+    uint64_t lo = low63 << 2;
+
+    unsigned lz = __string_clz64(w_high);
+    int e = __memctx_floor_log2_pow10((int)q) - 125 + 126 - (int)lz;
+
+    // Every w * 10^q in range lies between these two products, so if both round
+    // to the same double, so does the exact value
+    uint64_t lower = __string_round_bits(__string_pow10_product(w_low << lz, hi, lo, false), e);
+    uint64_t upper = __string_round_bits(__string_pow10_product(w_high << lz, hi, lo, true), e);
+    if (lower != upper) return false;
+
+    memcpy(result, &lower, sizeof(double));
+    return true;
+}
+
+uint64_t __string_pow10_product(uint64_t w, uint64_t hi, uint64_t lo, bool extra) {
+    uint64_t low = lo, low_carry = w;
+    __string_hash_multiply(&low, &low_carry);
+    uint64_t middle = hi, top = w;
+    __string_hash_multiply(&middle, &top);
+
+    middle += low_carry;
+    top += middle < low_carry;
+    if (extra) {
+        uint64_t add = w << 2;
+        low += add;
+        uint64_t carry = (w >> 62) + (low < add);
+        middle += carry;
+        top += middle < carry;
+    }
+    return top | ((middle | low) != 0);
+}
+
+uint64_t __string_round_bits(uint64_t u, int e) {
+    const uint64_t infinity = (uint64_t)0x7FF << 52;
+    int msb = 63 - (int)__string_clz64(u);
+    int exponent = msb + e;
+    if (exponent > 1023) return infinity;
+
+    // 53 significant bits for normal numbers, fewer for subnormals, whose last bit is 2^-1074
+    int shift = exponent >= -1022 ? msb - 52 : -1074 - e;
+    if (shift > 64) return 0;
+    uint64_t m = shift == 64 ? 0 : u >> shift;
+    uint64_t rest = shift == 64 ? u : u & (((uint64_t)1 << shift) - 1);
+    uint64_t half = (uint64_t)1 << (shift - 1);
+    if (rest > half || (rest == half && (m & 1))) m++;
+
+    // A subnormal that rounds up to 2^52 is the smallest normal, which has the same bits
+    if (exponent < -1022) return m;
+
+    if (m >> 53) {
+        m >>= 1;
+        exponent++;
+        if (exponent > 1023) return infinity;
+    }
+    return (uint64_t)(exponent + 1023) << 52 | (m & (((uint64_t)1 << 52) - 1));
+}
+
+string_parse_result __string_parse_double_slow(const char *value, size_t length, double *result) {
+    // 768 digits decide the rounding of any double; further digits only matter
+    // as a sticky non-zero digit after them
+    const size_t max_digits = 768;
+    char buffer[768 + 32];
+    size_t size = 0;
+    size_t i = 0;
+    if (value[0] == '-' || value[0] == '+') buffer[size++] = value[i++];
+
+    int64_t exponent = 0;
+    size_t digits = 0;
+    bool point = false;
+    bool sticky = false;
+    for (; i < length; i++) {
+        char c = value[i];
+        if (c == '.') {
+            point = true;
+            continue;
+        }
+        if (c < '0' || c > '9') break;
+        if (point) exponent--;
+        if (digits == 0 && c == '0') continue;
+        if (digits < max_digits) {
+            buffer[size++] = c;
+            digits++;
+        } else {
+            exponent++;
+            sticky = sticky || c != '0';
+        }
+    }
+    if (digits == 0) buffer[size++] = '0';
+    if (sticky) {
+        buffer[size++] = '1';
+        exponent--;
+    }
+
+    if (i < length) {
+        // The caller has checked the exponent syntax
+        i++;
+        bool exponent_negative = value[i] == '-';
+        if (value[i] == '-' || value[i] == '+') i++;
+        int64_t e = 0;
+        for (; i < length; i++) {
+            if (e < 100000) e = e * 10 + (value[i] - '0');
+        }
+        exponent += exponent_negative ? -e : e;
+    }
+    snprintf(buffer + size, sizeof(buffer) - size, "e%lld", (long long)exponent);
+
+    errno = 0;
+    double number = strtod(buffer, NULL);
+    *result = number;
+    return errno == ERANGE && isinf(number) ? STRING_PARSE_OVERFLOW : STRING_PARSE_OK;
+}
+
+uint64_t __string_newline_mask(const char *value, size_t length) {
+    uint64_t mask = 0;
+    size_t i = 0;
+#if defined(STRING_SIMD_AVX2)
+    const __m256i newline32 = _mm256_set1_epi8('\n');
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(value + i));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline32)) << i;
+    }
+#endif
+#if defined(STRING_SIMD_SSE2)
+    const __m128i newline16 = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(value + i));
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline16)) << i;
+    }
+#endif
+    for (; i < length; i++) {
+        if (value[i] == '\n') mask |= (uint64_t)1 << i;
+    }
+    return mask;
+}
+
+substring __string_line_view(string str, size_t start, size_t end) {
+    if (end > start && str.value[end - 1] == '\r') end--;
+
+    substring line;
+    line.value = str.value + start;
+    line.length = end - start;
+    line.capacity = end - start;
+    line.ctx = str.ctx;
+    return line;
+}
+
+unsigned __string_ctz(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned count = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+unsigned __string_clz(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_clz(mask);
+#else
+    unsigned count = 0;
+    while (!(mask & 0x80000000u)) {
+        mask <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+uint64_t __string_prefix_xor(uint64_t mask) {
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+
+unsigned __string_clz64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_clzll(mask);
+#else
+    unsigned count = 0;
+    while (!(mask >> 63)) {
+        mask <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+unsigned __string_ctz64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(mask);
+#else
+    unsigned count = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        count++;
+    }
+    return count;
+#endif
 }
 
 #endif
@@ -17,6 +17,7 @@ void test_memctx_block_at_invalid_index(void);
 void test_large_allocation(void);
 void test_allocation_alignment(void);
 void test_memctx_description_null(void);
+void test_memctx_search_skips_full_blocks(void);
 
 int main(void) {
     test_basic_allocation();
@@ -34,6 +35,7 @@ int main(void) {
     test_large_allocation();
     test_allocation_alignment();
     test_memctx_description_null();
+    test_memctx_search_skips_full_blocks();
 
     printf("All tests completed successfully.\n");
     return 0;
@@ -220,3 +222,45 @@ void test_memctx_description_null(void) {
     char *desc = memctx_description(NULL);
     assert(desc == NULL);
 }
+
+// Test 16: Full blocks are skipped, free space in recent blocks is still used
+void test_memctx_search_skips_full_blocks(void) {
+    MemContext *ctx = memctx();
+    assert(ctx != NULL);
+
+    // Leave room in the first block, then fill a few more
+    size_t used = MEMCTX_PAGE_SIZE / sizeof(uintptr_t) * sizeof(uintptr_t) - 256;
+    char *first = memctx_alloc(ctx, used);
+    assert(first != NULL);
+    for (int i = 0; i < 26; i++) {
+        char *small = memctx_alloc(ctx, 300);
+        assert(small != NULL);
+        memset(small, i & 0xFF, 300);
+    }
+    assert(ctx->search == ctx);
+
+    // Small allocations use the first block up, then it is skipped
+    char *fits = memctx_alloc(ctx, 200);
+    assert(fits == first + used);
+    memctx_alloc(ctx, 300);
+    assert(ctx->search != ctx);
+
+    // Blocks with room left, but not enough for the request, stop being searched too
+    for (int i = 0; i < 100000; i++) {
+        char *small = memctx_alloc(ctx, 200);
+        assert(small != NULL);
+        memset(small, i & 0xFF, 200);
+    }
+    int searched = 0;
+    for (MemContext *block = ctx->search; block; block = block->next) searched++;
+    assert(searched <= MEMCTX_SEARCH_BLOCKS + 1);
+
+    // Freeing a block resets the search
+    char *file = __memctx_file_block(ctx, 10);
+    assert(file != NULL);
+    memctx_free_file(ctx, file);
+    assert(ctx->search == ctx);
+    assert(memctx_alloc(ctx, 8) != NULL);
+
+    memctx_free(ctx);
+}
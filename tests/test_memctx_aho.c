@@ -0,0 +1,259 @@
+#include "../memctx_aho.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+void test_aho_init(void);
+void test_aho_find_all(void);
+void test_aho_overlapping(void);
+void test_aho_callback(void);
+void test_aho_rebuild(void);
+void test_aho_random(void);
+void test_aho_many_patterns(void);
+void test_aho_null(void);
+
+int main(void) {
+    test_aho_init();
+    test_aho_find_all();
+    test_aho_overlapping();
+    test_aho_callback();
+    test_aho_rebuild();
+    test_aho_random();
+    test_aho_many_patterns();
+    test_aho_null();
+
+    printf("All Aho-Corasick tests completed successfully.\n");
+    return 0;
+}
+
+static aho_match *match_at(array *matches, size_t index) {
+    return (aho_match *)array_item_at(matches, index);
+}
+
+// Test 1: Initialization and adding patterns
+void test_aho_init(void) {
+    MemContext *ctx = memctx();
+
+    aho *ac = aho_init(ctx);
+    assert(ac != NULL);
+    assert(ac->patterns->length == 0);
+    assert(aho_init(NULL) == NULL);
+
+    assert(aho_add(ac, "error"));
+    assert(aho_add(ac, string_make(ctx, "warning")));
+    assert(!aho_add(ac, ""));
+    assert(ac->patterns->length == 2);
+
+    // Patterns are copied
+    char pattern[] = "fatal";
+    assert(aho_add(ac, pattern));
+    pattern[0] = 'x';
+    array *matches = aho_find_all(ac, string_make(ctx, "fatal"));
+    assert(matches->length == 1 && match_at(matches, 0)->pattern == 2);
+
+    // No patterns, no matches
+    aho *empty = aho_init(ctx);
+    assert(aho_find_all(empty, string_make(ctx, "text"))->length == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 2: Finding keywords in a line
+void test_aho_find_all(void) {
+    MemContext *ctx = memctx();
+
+    aho *ac = aho_init(ctx);
+    aho_add(ac, "timeout");
+    aho_add(ac, "refused");
+    aho_add(ac, "error");
+
+    string line = string_make(ctx, "error: connection refused after timeout, error");
+    array *matches = aho_find_all(ac, line);
+    assert(matches->length == 4);
+    assert(match_at(matches, 0)->pattern == 2 && match_at(matches, 0)->start == 0 && match_at(matches, 0)->length == 5);
+    assert(match_at(matches, 1)->pattern == 1 && match_at(matches, 1)->start == 18);
+    assert(match_at(matches, 2)->pattern == 0 && match_at(matches, 2)->start == 32);
+    assert(match_at(matches, 3)->pattern == 2 && match_at(matches, 3)->start == 41);
+
+    assert(aho_find_all(ac, string_make(ctx, "all good"))->length == 0);
+
+    // Substring views are searched up to their length
+    substring view = line;
+    view.length = 5;
+    assert(aho_find_all(ac, view)->length == 1);
+
+    memctx_free(ctx);
+}
+
+// Test 3: Overlapping, nested and repeated patterns
+void test_aho_overlapping(void) {
+    MemContext *ctx = memctx();
+
+    aho *ac = aho_init(ctx);
+    aho_add(ac, "he");
+    aho_add(ac, "she");
+    aho_add(ac, "his");
+    aho_add(ac, "hers");
+    aho_add(ac, "she");
+
+    array *matches = aho_find_all(ac, string_make(ctx, "ushers"));
+    // "she" twice and "he" end at 3, longest first and in the order added; "hers" ends at 5
+    assert(matches->length == 4);
+    assert(match_at(matches, 0)->pattern == 1 && match_at(matches, 0)->start == 1);
+    assert(match_at(matches, 1)->pattern == 4 && match_at(matches, 1)->start == 1);
+    assert(match_at(matches, 2)->pattern == 0 && match_at(matches, 2)->start == 2);
+    assert(match_at(matches, 3)->pattern == 3 && match_at(matches, 3)->start == 2);
+
+    ac = aho_init(ctx);
+    aho_add(ac, "aa");
+    matches = aho_find_all(ac, string_make(ctx, "aaaa"));
+    assert(matches->length == 3);
+    assert(match_at(matches, 2)->start == 2);
+
+    // Binary patterns and all byte values
+    ac = aho_init(ctx);
+    substring zero = {"\0\xff", 2, 2, ctx};
+    aho_add(ac, zero);
+    substring text = {"a\0\xff\0\xff", 5, 5, ctx};
+    assert(aho_find_all(ac, text)->length == 2);
+
+    memctx_free(ctx);
+}
+
+static bool stop_after_two(const aho_match *match, void *context) {
+    (void)match;
+    int *calls = (int *)context;
+    return ++*calls < 2;
+}
+
+// Test 4: Callbacks and stopping early
+void test_aho_callback(void) {
+    MemContext *ctx = memctx();
+
+    aho *ac = aho_init(ctx);
+    aho_add(ac, "x");
+
+    int calls = 0;
+    size_t count = aho_find_each(ac, string_make(ctx, "xxxxx"), stop_after_two, &calls);
+    assert(calls == 2);
+    assert(count == 2);
+
+    memctx_free(ctx);
+}
+
+// Test 5: Adding patterns after searching
+void test_aho_rebuild(void) {
+    MemContext *ctx = memctx();
+
+    aho *ac = aho_init(ctx);
+    aho_add(ac, "cat");
+    string text = string_make(ctx, "cat dog");
+    assert(aho_find_all(ac, text)->length == 1);
+    assert(ac->built);
+
+    aho_add(ac, "dog");
+    assert(!ac->built);
+    array *matches = aho_find_all(ac, text);
+    assert(matches->length == 2);
+    assert(match_at(matches, 1)->pattern == 1 && match_at(matches, 1)->start == 4);
+
+    assert(aho_build(ac));
+    assert(aho_find_all(ac, text)->length == 2);
+
+    memctx_free(ctx);
+}
+
+// Test 6: Agreement with a naive search on random patterns and text
+void test_aho_random(void) {
+    MemContext *ctx = memctx();
+
+    unsigned seed = 9;
+    for (int round = 0; round < 200; round++) {
+        aho *ac = aho_init(ctx);
+        char patterns[20][6];
+        size_t lengths[20];
+        size_t pattern_count = 1 + round % 20;
+        for (size_t p = 0; p < pattern_count; p++) {
+            seed = seed * 1103515245 + 12345;
+            lengths[p] = 1 + (seed >> 16) % 5;
+            for (size_t k = 0; k < lengths[p]; k++) {
+                seed = seed * 1103515245 + 12345;
+                patterns[p][k] = "abc"[(seed >> 16) % 3];
+            }
+            substring pattern = {patterns[p], lengths[p], lengths[p], ctx};
+            aho_add(ac, pattern);
+        }
+
+        char text[300];
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % sizeof(text);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            text[i] = "abcd"[(seed >> 16) % 4];
+        }
+        substring str = {text, length, length, ctx};
+        array *matches = aho_find_all(ac, str);
+
+        // Every match is real, and the count equals the naive count
+        size_t expected = 0;
+        for (size_t p = 0; p < pattern_count; p++) {
+            for (size_t i = 0; i + lengths[p] <= length; i++) {
+                if (memcmp(text + i, patterns[p], lengths[p]) == 0) expected++;
+            }
+        }
+        assert(matches->length == expected);
+
+        size_t previous_end = 0;
+        for (size_t m = 0; m < matches->length; m++) {
+            aho_match *match = match_at(matches, m);
+            assert(match->length == lengths[match->pattern]);
+            assert(memcmp(text + match->start, patterns[match->pattern], match->length) == 0);
+            assert(match->start + match->length >= previous_end);
+            previous_end = match->start + match->length;
+        }
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 7: Hundreds of keywords
+void test_aho_many_patterns(void) {
+    MemContext *ctx = memctx();
+
+    aho *ac = aho_init(ctx);
+    char keyword[32];
+    for (int i = 0; i < 500; i++) {
+        snprintf(keyword, sizeof(keyword), "key%03d", i);
+        assert(aho_add(ac, keyword));
+    }
+    assert(aho_build(ac));
+    assert(ac->state_count <= 1 + 500 * 6);
+
+    string line = string_make(ctx, "key000 key123 key499 key500 kkey250y");
+    array *matches = aho_find_all(ac, line);
+    assert(matches->length == 4);
+    assert(match_at(matches, 0)->pattern == 0);
+    assert(match_at(matches, 1)->pattern == 123);
+    assert(match_at(matches, 2)->pattern == 499);
+    assert(match_at(matches, 3)->pattern == 250 && match_at(matches, 3)->start == 29);
+
+    memctx_free(ctx);
+}
+
+// Test 8: NULL arguments
+void test_aho_null(void) {
+    assert(!aho_add((aho *)NULL, "a"));
+    assert(!aho_build(NULL));
+
+    MemContext *ctx = memctx();
+    aho *ac = aho_init(ctx);
+    const char *null_pattern = NULL;
+    assert(!aho_add(ac, null_pattern));
+
+    string null_str = {0};
+    assert(aho_find_each(ac, null_str, stop_after_two, NULL) == 0);
+    assert(aho_find_all(ac, null_str) == NULL);
+    assert(aho_find_each(NULL, string_make(ctx, "a"), stop_after_two, NULL) == 0);
+    assert(aho_find_each(ac, string_make(ctx, "a"), NULL, NULL) == 0);
+    memctx_free(ctx);
+}
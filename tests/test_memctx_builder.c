@@ -0,0 +1,323 @@
+#include "../memctx_builder.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+void test_string_builder_init(void);
+void test_string_builder_append(void);
+void test_string_builder_build(void);
+void test_string_builder_large_output(void);
+void test_string_builder_iovec(void);
+void test_string_builder_clear(void);
+void test_string_builder_null(void);
+void test_string_builder_writev(void);
+void test_string_write_file(void);
+
+int main(void) {
+    test_string_builder_init();
+    test_string_builder_append();
+    test_string_builder_build();
+    test_string_builder_large_output();
+    test_string_builder_iovec();
+    test_string_builder_clear();
+    test_string_builder_null();
+    test_string_builder_writev();
+    test_string_write_file();
+
+    printf("All string builder tests completed successfully.\n");
+    return 0;
+}
+
+// Test 1: Builder initialization
+void test_string_builder_init(void) {
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+    assert(sb != NULL);
+    assert(sb->length == 0);
+    assert(sb->chunks == 0);
+    assert(sb->ctx == ctx);
+
+    assert(string_builder_init(NULL) == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 2: Appending C strings and strings
+void test_string_builder_append(void) {
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+
+    assert(string_builder_append(sb, "Hello") == 5);
+    assert(string_builder_append(sb, ", ") == 7);
+
+    string world = string_make(ctx, "World!");
+    assert(string_builder_append(sb, world) == 13);
+
+    const char *empty = "";
+    assert(string_builder_append(sb, empty) == 13);
+    assert(sb->chunks == 1);
+
+    string str = string_builder_build(sb);
+    assert(str.length == 13);
+    assert(strcmp(str.value, "Hello, World!") == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 3: Building is done once and does not change earlier results
+void test_string_builder_build(void) {
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+
+    // Empty builder builds an empty string
+    string empty = string_builder_build(sb);
+    assert(empty.value != NULL);
+    assert(empty.length == 0);
+    assert(empty.value[0] == '\0');
+
+    string_builder_append(sb, "abc");
+    string first = string_builder_build(sb);
+    string again = string_builder_build(sb);
+    assert(first.value == again.value);
+    assert(strcmp(first.value, "abc") == 0);
+
+    // Appending after a build leaves the built string intact
+    string_builder_append(sb, "def");
+    assert(strcmp(first.value, "abc") == 0);
+
+    string second = string_builder_build(sb);
+    assert(second.length == 6);
+    assert(strcmp(second.value, "abcdef") == 0);
+
+    // The built string is a regular string
+    second = string_append(second, "!");
+    assert(strcmp(second.value, "abcdef!") == 0);
+
+    // Appending to a built string does not write into the builder buffer
+    string built = string_builder_build(sb);
+    assert(built.capacity == built.length + 1);
+    string appended = string_append(built, "xyz");
+    assert(appended.value != built.value);
+    assert(strcmp(built.value, "abcdef") == 0);
+    string rebuilt = string_builder_build(sb);
+    assert(rebuilt.length == 6);
+    assert(strcmp(rebuilt.value, "abcdef") == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 4: Many fragments spanning many chunks
+void test_string_builder_large_output(void) {
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+
+    char fragment[32];
+    size_t expected = 0;
+    for (int i = 0; i < 100000; i++) {
+        int len = snprintf(fragment, sizeof(fragment), "<li>%d</li>", i);
+        expected += len;
+        assert(string_builder_append(sb, fragment) == expected);
+    }
+    assert(sb->chunks > 1);
+
+    // A fragment larger than any chunk
+    char large[STRING_BUILDER_MAX_CHUNK_SIZE + 10];
+    memset(large, 'x', sizeof(large) - 1);
+    large[sizeof(large) - 1] = '\0';
+    string_builder_append(sb, large);
+    expected += sizeof(large) - 1;
+
+    string str = string_builder_build(sb);
+    assert(str.length == expected);
+    assert(strlen(str.value) == expected);
+    assert(strncmp(str.value, "<li>0</li><li>1</li>", 20) == 0);
+    assert(strstr(str.value, "<li>99999</li>x") != NULL);
+    assert(str.value[expected - 1] == 'x');
+
+    memctx_free(ctx);
+}
+
+// Test 5: Describing chunks as iovec without flattening
+void test_string_builder_iovec(void) {
+#ifdef STRING_BUILDER_IOVEC
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+
+    struct iovec *iov;
+    assert(string_builder_iovec(sb, &iov) == 0);
+    assert(iov == NULL);
+
+    for (int i = 0; i < 1000; i++) {
+        string_builder_append(sb, "0123456789");
+    }
+
+    size_t count = string_builder_iovec(sb, &iov);
+    assert(count == sb->chunks);
+    assert(count > 1);
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char *base = (const char *)iov[i].iov_base;
+        for (size_t j = 0; j < iov[i].iov_len; j++) {
+            assert(base[j] == (char)('0' + (total + j) % 10));
+        }
+        total += iov[i].iov_len;
+    }
+    assert(total == 10000);
+
+    memctx_free(ctx);
+#endif
+}
+
+// Test 6: Clearing a builder
+void test_string_builder_clear(void) {
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+
+    string_builder_append(sb, "discarded");
+    string_builder_build(sb);
+    string_builder_clear(sb);
+    assert(sb->length == 0);
+
+    string_builder_append(sb, "kept");
+    string str = string_builder_build(sb);
+    assert(strcmp(str.value, "kept") == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 7: NULL arguments
+void test_string_builder_null(void) {
+    assert(string_builder_append((string_builder *)NULL, "abc") == 0);
+
+    string str = string_builder_build(NULL);
+    assert(str.value == NULL);
+    assert(str.length == 0);
+
+    string_builder_clear(NULL);
+
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+    const char *null_chars = NULL;
+    assert(string_builder_append(sb, null_chars) == 0);
+    memctx_free(ctx);
+}
+
+// Test 8: Writing strings and builders to file descriptors
+void test_string_builder_writev(void) {
+#ifdef STRING_BUILDER_IOVEC
+    MemContext *ctx = memctx();
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    assert(string_write_fd(fds[1], string_make(ctx, "pipe")));
+    assert(string_write_fd(fds[1], (string){0}));
+    char small[8] = {0};
+    assert(read(fds[0], small, sizeof(small)) == 4);
+    assert(strcmp(small, "pipe") == 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    // More chunks than fit into one writev call
+    string_builder *sb = string_builder_init(ctx);
+    for (int i = 0; i < STRING_BUILDER_IOV_MAX * 3; i++) {
+        __string_builder_add_chunk(sb, 1);
+        string_builder_append(sb, "0123456789");
+    }
+    assert(sb->chunks > STRING_BUILDER_IOV_MAX);
+
+    int fd = open("test_writev.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    assert(string_builder_writev(sb, fd));
+    close(fd);
+
+    string written = string_read_file(ctx, "test_writev.txt");
+    assert(written.length == sb->length);
+    assert(memcmp(written.value, string_builder_build(sb).value, sb->length) == 0);
+    unlink("test_writev.txt");
+
+    assert(!string_builder_writev(NULL, 1));
+    assert(string_builder_writev(string_builder_init(ctx), -1));
+    assert(!string_write_fd(-1, string_make(ctx, "x")));
+
+    memctx_free(ctx);
+#endif
+}
+
+// Test 9: Atomic file replacement
+void test_string_write_file(void) {
+#ifdef STRING_BUILDER_IOVEC
+    MemContext *ctx = memctx();
+
+    assert(string_write_file(ctx, "test_atomic.txt", string_make(ctx, "first")));
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "first") == 0);
+    assert(string_write_file(ctx, "test_atomic.txt", string_make(ctx, "second")));
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "second") == 0);
+
+    string_builder *sb = string_builder_init(ctx);
+    string_builder_append(sb, "from ");
+    string_builder_append(sb, "builder");
+    assert(string_builder_write_file(sb, "test_atomic.txt"));
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "from builder") == 0);
+
+    // Nothing is replaced until the batch is committed
+    string_file_batch *batch = string_file_batch_init(ctx);
+    assert(string_file_batch_add(batch, "test_atomic.txt", string_make(ctx, "batch one")));
+    assert(string_file_batch_add_builder(batch, "test_atomic_2.txt", sb));
+    assert(batch->count == 2);
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "from builder") == 0);
+    assert(string_file_batch_commit(batch));
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "batch one") == 0);
+    assert(strcmp(string_read_file(ctx, "test_atomic_2.txt").value, "from builder") == 0);
+
+    // A failed entry rolls back the whole batch
+    batch = string_file_batch_init(ctx);
+    assert(string_file_batch_add(batch, "test_atomic.txt", string_make(ctx, "lost")));
+    assert(!string_file_batch_add(batch, "missing_dir/test_atomic.txt", string_make(ctx, "x")));
+    assert(!string_file_batch_commit(batch));
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "batch one") == 0);
+
+    // Aborting removes the temporary files
+    batch = string_file_batch_init(ctx);
+    assert(string_file_batch_add(batch, "test_atomic.txt", string_make(ctx, "aborted")));
+    char *temp_path = batch->head->temp_path;
+    string_file_batch_abort(batch);
+    assert(access(temp_path, F_OK) != 0);
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "batch one") == 0);
+
+    // A failed rename restores the files already replaced and removes new ones
+    batch = string_file_batch_init(ctx);
+    assert(string_file_batch_add(batch, "test_atomic.txt", string_make(ctx, "undone")));
+    assert(string_file_batch_add(batch, "test_atomic_3.txt", string_make(ctx, "undone")));
+    assert(string_file_batch_add(batch, "test_atomic_2.txt", string_make(ctx, "undone")));
+    string_file *first = batch->head;
+    unlink(batch->tail->temp_path);
+    assert(!string_file_batch_commit(batch));
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "batch one") == 0);
+    assert(strcmp(string_read_file(ctx, "test_atomic_2.txt").value, "from builder") == 0);
+    assert(access("test_atomic_3.txt", F_OK) != 0);
+    assert(first->temp_path == NULL && first->backup_path == NULL);
+
+    // The replacement keeps the permission bits of the target
+    chmod("test_atomic.txt", 0600);
+    assert(string_write_file(ctx, "test_atomic.txt", string_make(ctx, "private")));
+    struct stat st;
+    assert(stat("test_atomic.txt", &st) == 0 && (st.st_mode & 0777) == 0600);
+    assert(strcmp(string_read_file(ctx, "test_atomic.txt").value, "private") == 0);
+
+    // A directory is never replaced by a file
+    assert(mkdir("test_atomic_dir", 0700) == 0);
+    assert(!string_write_file(ctx, "test_atomic_dir", string_make(ctx, "x")));
+    assert(stat("test_atomic_dir", &st) == 0 && S_ISDIR(st.st_mode));
+    rmdir("test_atomic_dir");
+
+    assert(!string_write_file(ctx, "missing_dir/test_atomic.txt", string_make(ctx, "x")));
+    assert(!string_write_file(ctx, NULL, string_make(ctx, "x")));
+    assert(!string_write_file(NULL, "test_atomic.txt", string_make(ctx, "x")));
+    assert(!string_builder_write_file(NULL, "test_atomic.txt"));
+
+    unlink("test_atomic.txt");
+    unlink("test_atomic_2.txt");
+    memctx_free(ctx);
+#endif
+}
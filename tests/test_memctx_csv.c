@@ -0,0 +1,230 @@
+#include "../memctx_csv.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+void test_csv_parse(void);
+void test_csv_quoted(void);
+void test_csv_line_endings(void);
+void test_csv_long_fields(void);
+void test_csv_random(void);
+void test_csv_null(void);
+
+int main(void) {
+    test_csv_parse();
+    test_csv_quoted();
+    test_csv_line_endings();
+    test_csv_long_fields();
+    test_csv_random();
+    test_csv_null();
+
+    printf("All CSV tests completed successfully.\n");
+    return 0;
+}
+
+static bool field_equals(csv_table *rows, size_t row, size_t column, const char *expected) {
+    substring *field = csv_field(rows, row, column);
+    return field && field->length == strlen(expected) && memcmp(field->value, expected, field->length) == 0;
+}
+
+// Test 1: Plain fields
+void test_csv_parse(void) {
+    MemContext *ctx = memctx();
+    string text = string_make(ctx, "id,name,score\n1,alice,90\n2,,85\n");
+
+    csv_table *rows = csv_parse(text, ',');
+    assert(rows != NULL);
+    assert(rows->length == 3);
+    assert(csv_row_length(rows, 0) == 3);
+    assert(field_equals(rows, 0, 0, "id"));
+    assert(field_equals(rows, 1, 1, "alice"));
+    assert(field_equals(rows, 2, 1, ""));
+    assert(field_equals(rows, 2, 2, "85"));
+
+    // Fields are views into the text
+    assert(csv_field(rows, 1, 1)->value == text.value + 16);
+
+    // No trailing newline, trailing separator, blank line
+    rows = csv_parse(string_make(ctx, "a;b\n\nc;"), ';');
+    assert(rows->length == 3);
+    assert(csv_row_length(rows, 0) == 2);
+    assert(csv_row_length(rows, 1) == 1 && field_equals(rows, 1, 0, ""));
+    assert(csv_row_length(rows, 2) == 2 && field_equals(rows, 2, 0, "c") && field_equals(rows, 2, 1, ""));
+
+    // Tab-separated
+    rows = csv_parse(string_make(ctx, "x\ty\tz"), '\t');
+    assert(rows->length == 1 && csv_row_length(rows, 0) == 3 && field_equals(rows, 0, 2, "z"));
+
+    // Empty text has no rows
+    assert(csv_parse(string_make(ctx, ""), ',')->length == 0);
+
+    // Out of range rows and columns
+    rows = csv_parse(string_make(ctx, "a,b\nc\n"), ',');
+    assert(rows->field_count == 3);
+    assert(csv_field(rows, 0, 2) == NULL && csv_field(rows, 2, 0) == NULL);
+    assert(csv_row_length(rows, 2) == 0);
+    assert(csv_field(NULL, 0, 0) == NULL && csv_row_length(NULL, 0) == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 2: Quoted fields
+void test_csv_quoted(void) {
+    MemContext *ctx = memctx();
+    string text = string_make(ctx,
+        "\"a,b\",\"line\nbreak\",\"say \"\"hi\"\"\",\"\"\n"
+        "\"\"\"\",pla\"in,x\"\n");
+
+    csv_table *rows = csv_parse(text, ',');
+    assert(rows->length == 2);
+    assert(csv_row_length(rows, 0) == 4);
+    assert(field_equals(rows, 0, 0, "a,b"));
+    assert(field_equals(rows, 0, 1, "line\nbreak"));
+    assert(field_equals(rows, 0, 2, "say \"hi\""));
+    assert(field_equals(rows, 0, 3, ""));
+
+    // Quoted fields without escapes are still views
+    substring *field = csv_field(rows, 0, 0);
+    assert(field->value == text.value + 1);
+    // Fields with escapes are copies
+    field = csv_field(rows, 0, 2);
+    assert(field->value < text.value || field->value >= text.value + text.length);
+    assert(field->value[field->length] == '\0');
+
+    assert(csv_row_length(rows, 1) == 2);
+    assert(field_equals(rows, 1, 0, "\""));
+    // Malformed quoting is kept as is; a quote inside a field still starts a quoted region
+    assert(field_equals(rows, 1, 1, "pla\"in,x\""));
+
+    memctx_free(ctx);
+}
+
+// Test 3: CRLF and LF line endings
+void test_csv_line_endings(void) {
+    MemContext *ctx = memctx();
+
+    csv_table *rows = csv_parse(string_make(ctx, "a,b\r\nc,\"d\"\r\n\"e\r\nf\",g\r\n"), ',');
+    assert(rows->length == 3);
+    assert(field_equals(rows, 0, 1, "b"));
+    assert(field_equals(rows, 1, 1, "d"));
+    assert(field_equals(rows, 2, 0, "e\r\nf"));
+    assert(field_equals(rows, 2, 1, "g"));
+
+    // '\r' alone is part of a field
+    rows = csv_parse(string_make(ctx, "a\rb,c"), ',');
+    assert(rows->length == 1 && field_equals(rows, 0, 0, "a\rb"));
+
+    memctx_free(ctx);
+}
+
+// Test 4: Fields and quoted regions crossing 64-byte blocks
+void test_csv_long_fields(void) {
+    MemContext *ctx = memctx();
+
+    string text = string_init(ctx);
+    text = string_append(text, "\"");
+    for (int i = 0; i < 100; i++) text = string_append(text, "x,\n\"\"");
+    text = string_append(text, "\",");
+    for (int i = 0; i < 100; i++) text = string_append(text, "y");
+    text = string_append(text, "\n");
+    for (int i = 0; i < 1000; i++) text = string_append(text, "1,2\n");
+
+    csv_table *rows = csv_parse(text, ',');
+    assert(rows->length == 1001);
+    substring *quoted = csv_field(rows, 0, 0);
+    assert(quoted->length == 400);
+    for (size_t i = 0; i < quoted->length; i += 4) {
+        assert(memcmp(quoted->value + i, "x,\n\"", 4) == 0);
+    }
+    assert(csv_field(rows, 0, 1)->length == 100);
+    for (size_t i = 1; i < rows->length; i++) {
+        assert(csv_row_length(rows, i) == 2);
+        assert(field_equals(rows, i, 0, "1") && field_equals(rows, i, 1, "2"));
+    }
+
+    memctx_free(ctx);
+}
+
+// Byte-wise reference parser: writes fields separated by '|' and rows by '#'
+static size_t reference_parse(const char *text, size_t length, char *out) {
+    size_t o = 0;
+    size_t i = 0;
+    while (i < length) {
+        size_t start = i;
+        bool in_quotes = false;
+        while (i < length && (in_quotes || (text[i] != ',' && text[i] != '\n'))) {
+            if (text[i] == '"') in_quotes = !in_quotes;
+            i++;
+        }
+        size_t end = i;
+        bool end_of_row = i == length || text[i] == '\n';
+        if (end_of_row && end > start && text[end - 1] == '\r') end--;
+        if (end - start >= 2 && text[start] == '"' && text[end - 1] == '"') {
+            for (size_t k = start + 1; k < end - 1; k++) {
+                out[o++] = text[k];
+                if (text[k] == '"' && k + 1 < end - 1 && text[k + 1] == '"') k++;
+            }
+        } else {
+            memcpy(out + o, text + start, end - start);
+            o += end - start;
+        }
+        out[o++] = end_of_row ? '#' : '|';
+        i++;
+        if (i == length && !end_of_row) {
+            // Trailing separator: one more empty field
+            out[o++] = '#';
+        }
+    }
+    return o;
+}
+
+// Test 5: Agreement with a byte-wise reference on random input
+void test_csv_random(void) {
+    MemContext *ctx = memctx();
+
+    const char alphabet[] = {'a', 'b', ',', '\n', '"', '\r'};
+    char text[300];
+    char expected[1200];
+    char actual[1200];
+    unsigned seed = 17;
+    for (int round = 0; round < 5000; round++) {
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % sizeof(text);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            text[i] = alphabet[(seed >> 16) % sizeof(alphabet)];
+        }
+
+        size_t expected_length = reference_parse(text, length, expected);
+
+        substring str = {text, length, length, ctx};
+        csv_table *rows = csv_parse(str, ',');
+        size_t actual_length = 0;
+        for (size_t r = 0; r < rows->length; r++) {
+            size_t columns = csv_row_length(rows, r);
+            for (size_t c = 0; c < columns; c++) {
+                substring *field = csv_field(rows, r, c);
+                memcpy(actual + actual_length, field->value, field->length);
+                actual_length += field->length;
+                actual[actual_length++] = c + 1 == columns ? '#' : '|';
+            }
+        }
+
+        assert(actual_length == expected_length);
+        assert(memcmp(actual, expected, actual_length) == 0);
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 6: NULL arguments
+void test_csv_null(void) {
+    string null_str = {0};
+    assert(csv_parse(null_str, ',') == NULL);
+
+    MemContext *ctx = memctx();
+    null_str.ctx = ctx;
+    csv_table *rows = csv_parse(null_str, ',');
+    assert(rows != NULL && rows->length == 0);
+    memctx_free(ctx);
+}
@@ -0,0 +1,131 @@
+#include "../memctx_intern.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+void test_intern_pool_init(void);
+void test_string_intern(void);
+void test_string_intern_many(void);
+void test_string_intern_binary(void);
+void test_string_intern_null(void);
+
+int main(void) {
+    test_intern_pool_init();
+    test_string_intern();
+    test_string_intern_many();
+    test_string_intern_binary();
+    test_string_intern_null();
+
+    printf("All intern tests completed successfully.\n");
+    return 0;
+}
+
+// Test 1: Pool initialization
+void test_intern_pool_init(void) {
+    MemContext *ctx = memctx();
+    intern_pool *pool = intern_pool_init(ctx);
+    assert(pool != NULL);
+    assert(pool->count == 0);
+    assert(pool->capacity == INTERN_POOL_INIT_CAPACITY);
+
+    assert(intern_pool_init(NULL) == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 2: Equal content maps to the same canonical string
+void test_string_intern(void) {
+    MemContext *ctx = memctx();
+    intern_pool *pool = intern_pool_init(ctx);
+
+    string host1 = string_make(ctx, "example.com");
+    string host2 = string_make(ctx, "example.com");
+    assert(host1.value != host2.value);
+
+    string a = string_intern(pool, host1);
+    string b = string_intern(pool, host2);
+    string c = string_intern(pool, "example.com");
+    string d = string_intern(pool, "example.org");
+
+    assert(a.value != host1.value);
+    assert(a.length == 11);
+    assert(strcmp(a.value, "example.com") == 0);
+    assert(string_interned_equal(a, b));
+    assert(string_interned_equal(a, c));
+    assert(!string_interned_equal(a, d));
+    assert(pool->count == 2);
+
+    assert(string_interned_hash(a) == string_interned_hash(c));
+    assert(string_interned_hash(a) == string_hash(host1));
+
+    // Empty string is a valid value
+    string e1 = string_intern(pool, "");
+    string e2 = string_intern(pool, string_make(ctx, ""));
+    assert(e1.value != NULL);
+    assert(e1.length == 0);
+    assert(string_interned_equal(e1, e2));
+    assert(pool->count == 3);
+
+    memctx_free(ctx);
+}
+
+// Test 3: Pool grows and keeps canonical strings stable
+void test_string_intern_many(void) {
+    MemContext *ctx = memctx();
+    intern_pool *pool = intern_pool_init(ctx);
+
+    char buffer[32];
+    string first[1000];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(buffer, sizeof(buffer), "token-%d", i);
+        first[i] = string_intern(pool, buffer);
+    }
+    assert(pool->count == 1000);
+    assert(pool->capacity > 1000);
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 1000; i++) {
+            snprintf(buffer, sizeof(buffer), "token-%d", i);
+            string again = string_intern(pool, buffer);
+            assert(string_interned_equal(again, first[i]));
+        }
+    }
+    assert(pool->count == 1000);
+
+    memctx_free(ctx);
+}
+
+// Test 4: Values are compared by length, not by terminator
+void test_string_intern_binary(void) {
+    MemContext *ctx = memctx();
+    intern_pool *pool = intern_pool_init(ctx);
+
+    string full = string_make(ctx, "key:value");
+    string prefix = full;
+    prefix.length = 3;
+
+    string a = string_intern(pool, prefix);
+    string b = string_intern(pool, "key");
+    string c = string_intern(pool, full);
+    assert(string_interned_equal(a, b));
+    assert(!string_interned_equal(a, c));
+    assert(strcmp(a.value, "key") == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 5: NULL arguments
+void test_string_intern_null(void) {
+    MemContext *ctx = memctx();
+    intern_pool *pool = intern_pool_init(ctx);
+
+    const char *null_chars = NULL;
+    string a = string_intern(pool, null_chars);
+    assert(a.value == NULL);
+
+    string b = string_intern((intern_pool *)NULL, "value");
+    assert(b.value == NULL);
+    assert(pool->count == 0);
+
+    memctx_free(ctx);
+}
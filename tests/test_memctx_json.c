@@ -0,0 +1,413 @@
+#include "../memctx_json.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <locale.h>
+
+void test_json_scalars(void);
+void test_json_containers(void);
+void test_json_strings(void);
+void test_json_numbers(void);
+void test_json_invalid(void);
+void test_json_large(void);
+void test_json_null(void);
+void test_json_write(void);
+void test_json_write_strings(void);
+void test_json_write_numbers(void);
+
+int main(void) {
+    test_json_scalars();
+    test_json_containers();
+    test_json_strings();
+    test_json_numbers();
+    test_json_invalid();
+    test_json_large();
+    test_json_null();
+    test_json_write();
+    test_json_write_strings();
+    test_json_write_numbers();
+
+    printf("All JSON tests completed successfully.\n");
+    return 0;
+}
+
+static bool string_is(substring str, const char *expected) {
+    return str.length == strlen(expected) && memcmp(str.value, expected, str.length) == 0;
+}
+
+// Test 1: Scalar documents
+void test_json_scalars(void) {
+    MemContext *ctx = memctx();
+
+    json_value *value = json_parse(string_make(ctx, "null"));
+    assert(value && value->type == JSON_NULL);
+    value = json_parse(string_make(ctx, " true "));
+    assert(value && value->type == JSON_BOOL && value->boolean);
+    value = json_parse(string_make(ctx, "false"));
+    assert(value && value->type == JSON_BOOL && !value->boolean);
+    value = json_parse(string_make(ctx, "-12.5e1"));
+    assert(value && value->type == JSON_NUMBER && value->number == -125);
+    value = json_parse(string_make(ctx, "\"text\""));
+    assert(value && value->type == JSON_STRING && string_is(value->string, "text"));
+
+    memctx_free(ctx);
+}
+
+// Test 2: Objects and arrays
+void test_json_containers(void) {
+    MemContext *ctx = memctx();
+    string text = string_make(ctx,
+        "{\n"
+        "  \"name\": \"cutils\",\n"
+        "  \"version\": 2,\n"
+        "  \"tags\": [\"c\", \"arena\", [], {}],\n"
+        "  \"nested\": {\"a\": {\"b\": [1, 2, {\"c\": null}]}},\n"
+        "  \"name\": \"duplicate\"\n"
+        "}");
+
+    json_value *root = json_parse(text);
+    assert(root != NULL);
+    assert(root->type == JSON_OBJECT);
+    assert(root->object.length == 5);
+    assert(string_is(root->object.members[0].key, "name"));
+
+    json_value *name = json_get(root, "name");
+    assert(name && name->type == JSON_STRING && string_is(name->string, "cutils"));
+    // Strings without escapes are views into the text
+    assert(name->string.value > text.value && name->string.value < text.value + text.length);
+
+    json_value *version = json_get(root, "version");
+    assert(version && version->type == JSON_NUMBER && version->number == 2);
+
+    json_value *tags = json_get(root, "tags");
+    assert(tags && tags->type == JSON_ARRAY && tags->array.length == 4);
+    assert(string_is(json_at(tags, 1)->string, "arena"));
+    assert(json_at(tags, 2)->type == JSON_ARRAY && json_at(tags, 2)->array.length == 0);
+    assert(json_at(tags, 3)->type == JSON_OBJECT && json_at(tags, 3)->object.length == 0);
+    assert(json_at(tags, 4) == NULL);
+
+    json_value *b = json_get(json_get(json_get(root, "nested"), "a"), "b");
+    assert(b && b->array.length == 3);
+    assert(json_at(b, 1)->number == 2);
+    assert(json_get(json_at(b, 2), "c")->type == JSON_NULL);
+
+    // Lookup by string key and missing keys
+    string key = string_make(ctx, "version");
+    assert(json_get(root, key) == version);
+    assert(json_get(root, "missing") == NULL);
+    assert(json_get(tags, "name") == NULL);
+    assert(json_at(root, 0) == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 3: String escapes
+void test_json_strings(void) {
+    MemContext *ctx = memctx();
+
+    json_value *value = json_parse(string_make(ctx,
+        "[\"a\\\"b\", \"\\\\\", \"\\/\\b\\f\\n\\r\\t\", \"\\u00e9\\u20AC\", \"\\ud83d\\ude00\", \"caf\xC3\xA9\", \"\\\\\\\"\"]"));
+    assert(value && value->array.length == 7);
+    assert(string_is(json_at(value, 0)->string, "a\"b"));
+    assert(string_is(json_at(value, 1)->string, "\\"));
+    assert(string_is(json_at(value, 2)->string, "/\b\f\n\r\t"));
+    assert(string_is(json_at(value, 3)->string, "\xC3\xA9\xE2\x82\xAC"));
+    assert(string_is(json_at(value, 4)->string, "\xF0\x9F\x98\x80"));
+    assert(string_is(json_at(value, 5)->string, "caf\xC3\xA9"));
+    assert(string_is(json_at(value, 6)->string, "\\\""));
+
+    // Escaped keys are unescaped too
+    value = json_parse(string_make(ctx, "{\"a\\nb\": 1}"));
+    assert(value && json_get(value, "a\nb") != NULL);
+
+    // Backslash runs and quotes across 64-byte blocks
+    string text = string_init(ctx);
+    text = string_append(text, "[\"");
+    for (int i = 0; i < 100; i++) text = string_append(text, "\\\\\\\"x");
+    text = string_append(text, "\", \"");
+    for (int i = 0; i < 61; i++) text = string_append(text, "y");
+    text = string_append(text, "\\\\\"]");
+    value = json_parse(text);
+    assert(value && value->array.length == 2);
+    assert(json_at(value, 0)->string.length == 300);
+    assert(json_at(value, 1)->string.length == 62);
+
+    memctx_free(ctx);
+}
+
+// Test 4: Numbers
+void test_json_numbers(void) {
+    MemContext *ctx = memctx();
+
+    json_value *value = json_parse(string_make(ctx,
+        "[0, -0, 1, -1, 0.5, 1e10, 1E-2, 123456789012345678901234567890, 3.141592653589793, -1.5e+3]"));
+    assert(value && value->array.length == 10);
+    assert(json_at(value, 0)->number == 0);
+    assert(json_at(value, 3)->number == -1);
+    assert(json_at(value, 4)->number == 0.5);
+    assert(json_at(value, 5)->number == 1e10);
+    assert(json_at(value, 6)->number == 0.01);
+    assert(json_at(value, 7)->number == 123456789012345678901234567890.0);
+    assert(json_at(value, 8)->number == 3.141592653589793);
+    assert(json_at(value, 9)->number == -1500);
+
+    const char *invalid[] = {"01", "+1", ".5", "1.", "1e", "-", "1.e5", "0x10", "Infinity", "NaN", "1e999", "--1"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        assert(json_parse(string_make(ctx, invalid[i])) == NULL);
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 5: Invalid documents
+void test_json_invalid(void) {
+    MemContext *ctx = memctx();
+
+    const char *invalid[] = {
+        "", "   ", "{", "}", "[1,]", "[,1]", "[1 2]", "{\"a\" 1}", "{\"a\":}", "{a:1}", "{\"a\":1,}",
+        "\"unterminated", "\"bad \\x escape\"", "\"\\ud800\"", "\"\\udc00\"", "\"\\u12\"",
+        "\"tab\tinside\"", "tru", "truex", "nul", "[true false]", "{\"a\":1}}", "[1]]", "1 2",
+        "\"a\"b", "[\"\xC3\"]", "{\"a\":1 \"b\":2}", "[}", "{]", ":", "[\"a\":1]"
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        assert(json_parse(string_make(ctx, invalid[i])) == NULL);
+    }
+
+    // Nesting limit
+    string deep = string_init(ctx);
+    for (int i = 0; i <= JSON_MAX_DEPTH; i++) deep = string_append(deep, "[");
+    for (int i = 0; i <= JSON_MAX_DEPTH; i++) deep = string_append(deep, "]");
+    assert(json_parse(deep) == NULL);
+
+    string shallow = string_init(ctx);
+    for (int i = 0; i < JSON_MAX_DEPTH; i++) shallow = string_append(shallow, "[");
+    for (int i = 0; i < JSON_MAX_DEPTH; i++) shallow = string_append(shallow, "]");
+    assert(json_parse(shallow) != NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 6: A large document
+void test_json_large(void) {
+    MemContext *ctx = memctx();
+
+    string text = string_init(ctx);
+    text = string_append(text, "{\"items\": [");
+    char item[128];
+    for (int i = 0; i < 10000; i++) {
+        snprintf(item, sizeof(item), "%s{\"id\": %d, \"name\": \"item %d\", \"price\": %d.25, \"ok\": %s}",
+                 i ? "," : "", i, i, i, i % 2 ? "true" : "false");
+        text = string_append(text, item);
+    }
+    text = string_append(text, "]}");
+
+    json_value *root = json_parse(text);
+    assert(root != NULL);
+    json_value *items = json_get(root, "items");
+    assert(items && items->array.length == 10000);
+    for (size_t i = 0; i < items->array.length; i++) {
+        json_value *entry = json_at(items, i);
+        assert(json_get(entry, "id")->number == (double)i);
+        assert(json_get(entry, "price")->number == (double)i + 0.25);
+        assert(json_get(entry, "ok")->boolean == (i % 2 == 1));
+        snprintf(item, sizeof(item), "item %zu", i);
+        assert(string_is(json_get(entry, "name")->string, item));
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 7: NULL arguments
+void test_json_null(void) {
+    string null_str = {0};
+    assert(json_parse(null_str) == NULL);
+    assert(json_get((json_value *)NULL, "a") == NULL);
+    assert(json_at(NULL, 0) == NULL);
+}
+
+// Test 8: Writing a document
+void test_json_write(void) {
+    MemContext *ctx = memctx();
+    string_builder *sb = string_builder_init(ctx);
+    json_writer *w = json_writer_init(sb);
+    assert(w != NULL);
+
+    json_write_object_begin(w);
+    json_write_key(w, "name");
+    json_write_string(w, "cutils");
+    json_write_key(w, string_make(ctx, "tags"));
+    json_write_array_begin(w);
+    json_write_string(w, "c");
+    json_write_array_begin(w);
+    json_write_array_end(w);
+    json_write_object_begin(w);
+    json_write_object_end(w);
+    json_write_null(w);
+    json_write_array_end(w);
+    json_write_key(w, "ok");
+    json_write_bool(w, true);
+    json_write_key(w, "count");
+    json_write_i64(w, -42);
+    json_write_key(w, "size");
+    json_write_u64(w, UINT64_MAX);
+    json_write_key(w, "ratio");
+    json_write_double(w, 0.25);
+    json_write_object_end(w);
+
+    string text = string_builder_build(sb);
+    assert(strcmp(text.value,
+        "{\"name\":\"cutils\",\"tags\":[\"c\",[],{},null],\"ok\":true,"
+        "\"count\":-42,\"size\":18446744073709551615,\"ratio\":0.25}") == 0);
+
+    json_value *root = json_parse(text);
+    assert(root && root->object.length == 6);
+    assert(json_get(root, "tags")->array.length == 4);
+
+    // Integer limits
+    sb = string_builder_init(ctx);
+    w = json_writer_init(sb);
+    json_write_array_begin(w);
+    json_write_i64(w, INT64_MIN);
+    json_write_i64(w, INT64_MAX);
+    json_write_i64(w, 0);
+    json_write_u64(w, 9);
+    json_write_u64(w, 10);
+    json_write_array_end(w);
+    text = string_builder_build(sb);
+    assert(strcmp(text.value, "[-9223372036854775808,9223372036854775807,0,9,10]") == 0);
+
+    // A scalar document
+    sb = string_builder_init(ctx);
+    w = json_writer_init(sb);
+    json_write_bool(w, false);
+    assert(strcmp(string_builder_build(sb).value, "false") == 0);
+
+    assert(json_writer_init(NULL) == NULL);
+    json_write_null(NULL);
+    json_write_string((json_writer *)NULL, "a");
+
+    memctx_free(ctx);
+}
+
+// Test 9: Escaping strings
+void test_json_write_strings(void) {
+    MemContext *ctx = memctx();
+
+    string_builder *sb = string_builder_init(ctx);
+    json_writer *w = json_writer_init(sb);
+    json_write_array_begin(w);
+    json_write_string(w, "a\"b\\c/\b\f\n\r\t\x01\x1f caf\xC3\xA9");
+    json_write_string(w, "");
+    json_write_string(w, (const char *)NULL);
+    json_write_array_end(w);
+    string text = string_builder_build(sb);
+    assert(strcmp(text.value, "[\"a\\\"b\\\\c/\\b\\f\\n\\r\\t\\u0001\\u001f caf\xC3\xA9\",\"\",null]") == 0);
+
+    // Random strings with special bytes at every offset read back unchanged
+    unsigned seed = 5;
+    char value[200];
+    for (int round = 0; round < 2000; round++) {
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % sizeof(value);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            unsigned r = (seed >> 16) % 40;
+            value[i] = r < 26 ? (char)('a' + r) : r < 30 ? '"' : r < 34 ? '\\' : (char)(r - 33);
+        }
+
+        sb = string_builder_init(ctx);
+        w = json_writer_init(sb);
+        substring str = {value, length, length, ctx};
+        json_write_string(w, str);
+
+        json_value *parsed = json_parse(string_builder_build(sb));
+        assert(parsed && parsed->type == JSON_STRING);
+        assert(parsed->string.length == length && memcmp(parsed->string.value, value, length) == 0);
+    }
+
+    memctx_free(ctx);
+}
+
+static string write_double(MemContext *ctx, double value) {
+    string_builder *sb = string_builder_init(ctx);
+    json_write_double(json_writer_init(sb), value);
+    return string_builder_build(sb);
+}
+
+// Counts the digits of a number from the first non-zero one, without trailing zeros and the exponent
+static int significant_digits(const char *text) {
+    char digits[32];
+    int count = 0;
+    for (const char *c = text; *c && *c != 'e'; c++) {
+        if (*c >= '0' && *c <= '9' && (count > 0 || *c != '0')) digits[count++] = *c;
+    }
+    while (count > 0 && digits[count - 1] == '0') count--;
+    return count;
+}
+
+// Test 10: Formatting doubles
+void test_json_write_numbers(void) {
+    MemContext *ctx = memctx();
+
+    assert(strcmp(write_double(ctx, 0).value, "0") == 0);
+    assert(strcmp(write_double(ctx, -0.0).value, "-0") == 0);
+    assert(strcmp(write_double(ctx, 1).value, "1") == 0);
+    assert(strcmp(write_double(ctx, -2.5).value, "-2.5") == 0);
+    assert(strcmp(write_double(ctx, 0.1).value, "0.1") == 0);
+    assert(strcmp(write_double(ctx, 0.001).value, "0.001") == 0);
+    assert(strcmp(write_double(ctx, 3.141592653589793).value, "3.141592653589793") == 0);
+    assert(strcmp(write_double(ctx, 1e15).value, "1000000000000000") == 0);
+    assert(strcmp(write_double(ctx, 1e300).value, "1e+300") == 0);
+
+    // Shortest digits that read back, without printf
+    assert(strcmp(write_double(ctx, 0.1 + 0.2).value, "0.30000000000000004") == 0);
+    assert(strcmp(write_double(ctx, 1.0 / 3).value, "0.3333333333333333") == 0);
+    assert(strcmp(write_double(ctx, 19.99).value, "19.99") == 0);
+    assert(strcmp(write_double(ctx, 1e-7).value, "0.0000001") == 0);
+    assert(strcmp(write_double(ctx, 1e23).value, "1e+23") == 0);
+    assert(strcmp(write_double(ctx, 5e-324).value, "5e-324") == 0);
+    assert(strcmp(write_double(ctx, 9e-323).value, "9e-323") == 0);
+    assert(strcmp(write_double(ctx, 2.2250738585072014e-308).value, "2.2250738585072014e-308") == 0);
+    assert(strcmp(write_double(ctx, 1.7976931348623157e308).value, "1.7976931348623157e+308") == 0);
+    assert(strcmp(write_double(ctx, 8909546814257.207).value, "8909546814257.207") == 0);
+    assert(strcmp(write_double(ctx, NAN).value, "null") == 0);
+    assert(strcmp(write_double(ctx, -INFINITY).value, "null") == 0);
+
+    // Random doubles read back exactly
+    uint64_t seed = 11;
+    for (int round = 0; round < 20000; round++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        double value;
+        if (round % 2) {
+            uint64_t bits = seed;
+            memcpy(&value, &bits, sizeof(value));
+            if (!isfinite(value)) continue;
+        } else {
+            value = (double)(int64_t)(seed >> 20) / 1000.0;
+        }
+
+        string text = write_double(ctx, value);
+        json_value *parsed = json_parse(text);
+        assert(parsed && parsed->type == JSON_NUMBER);
+        assert(parsed->number == value && signbit(parsed->number) == signbit(value));
+
+        // No more significant digits than the shortest %.*e that reads back
+        char shortest[32];
+        int precision = 1;
+        for (; precision < 17; precision++) {
+            snprintf(shortest, sizeof(shortest), "%.*e", precision - 1, value);
+            if (strtod(shortest, NULL) == value) break;
+        }
+        assert(significant_digits(text.value) <= precision);
+    }
+
+    // The decimal point does not follow the locale
+    if (setlocale(LC_NUMERIC, "de_DE.UTF-8")) {
+        assert(strchr(write_double(ctx, 1.5e-300).value, ',') == NULL);
+        assert(strcmp(write_double(ctx, 2.5).value, "2.5") == 0);
+        setlocale(LC_NUMERIC, "C");
+    }
+
+    memctx_free(ctx);
+}
@@ -0,0 +1,285 @@
+// Small reads, so larger files take several requests
+#define FILE_LOADER_READ_MAX 4096
+
+#include "../memctx_loader.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+void test_file_loader_init(void);
+void test_file_loader_load(void);
+void test_file_loader_many_files(void);
+void test_file_loader_errors(void);
+void test_file_loader_close(void);
+void test_file_loader_null(void);
+void test_file_loader_ring_error(void);
+
+static const file_loader_backend backends[] = {FILE_LOADER_AUTO, FILE_LOADER_THREADS};
+
+int main(void) {
+    test_file_loader_init();
+    test_file_loader_load();
+    test_file_loader_many_files();
+    test_file_loader_errors();
+    test_file_loader_close();
+    test_file_loader_null();
+    test_file_loader_ring_error();
+
+    printf("All file loader tests completed successfully.\n");
+    return 0;
+}
+
+static void write_test_file(const char *filename, size_t size, unsigned seed) {
+    FILE *f = fopen(filename, "wb");
+    assert(f != NULL);
+    for (size_t i = 0; i < size; i++) {
+        fputc((int)((i * 31 + seed) % 251), f);
+    }
+    fclose(f);
+}
+
+static bool check_test_file(string content, size_t size, unsigned seed) {
+    if (!content.value || content.length != size || content.value[size] != '\0') return false;
+    for (size_t i = 0; i < size; i++) {
+        if ((unsigned char)content.value[i] != (i * 31 + seed) % 251) return false;
+    }
+    return true;
+}
+
+// Test 1: Loader initialization
+void test_file_loader_init(void) {
+    MemContext *ctx = memctx();
+
+    file_loader *loader = file_loader_init(ctx, 0, FILE_LOADER_AUTO);
+    assert(loader != NULL);
+    assert(loader->depth > 0);
+    assert(loader->backend == FILE_LOADER_IO_URING || loader->backend == FILE_LOADER_THREADS);
+    file_loader_close(loader);
+
+    loader = file_loader_init(ctx, 4, FILE_LOADER_THREADS);
+    assert(loader != NULL);
+    assert(loader->backend == FILE_LOADER_THREADS);
+    assert(loader->thread_count == 4);
+    file_loader_close(loader);
+
+    // Requiring io_uring fails cleanly where it is not available
+    loader = file_loader_init(ctx, 4, FILE_LOADER_IO_URING);
+    if (loader) {
+        assert(loader->backend == FILE_LOADER_IO_URING);
+        file_loader_close(loader);
+    }
+
+    assert(file_loader_init(NULL, 4, FILE_LOADER_AUTO) == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 2: Loading a few files of different sizes
+void test_file_loader_load(void) {
+    write_test_file("loader_small.bin", 100, 1);
+    write_test_file("loader_large.bin", 100000, 2);
+    write_test_file("loader_empty.bin", 0, 3);
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        MemContext *ctx = memctx();
+        file_loader *loader = file_loader_init(ctx, 2, backends[b]);
+        assert(loader != NULL);
+
+        assert(file_loader_add(loader, "loader_small.bin"));
+        assert(file_loader_add(loader, "loader_large.bin"));
+        assert(file_loader_add(loader, "loader_empty.bin"));
+
+        bool seen[3] = {false, false, false};
+        loaded_file file;
+        while (file_loader_next(loader, &file)) {
+            assert(file.index < 3);
+            assert(!seen[file.index]);
+            seen[file.index] = true;
+            assert(file.error == 0);
+            assert(file.content.ctx == ctx);
+
+            if (file.index == 0) {
+                assert(strcmp(file.filename, "loader_small.bin") == 0);
+                assert(check_test_file(file.content, 100, 1));
+            } else if (file.index == 1) {
+                assert(check_test_file(file.content, 100000, 2));
+                // Each file has its own block and can be released early
+                string_free_file(file.content);
+            } else {
+                assert(file.content.value != NULL);
+                assert(file.content.length == 0);
+            }
+        }
+        assert(seen[0] && seen[1] && seen[2]);
+        assert(!file_loader_next(loader, &file));
+
+        file_loader_close(loader);
+        memctx_free(ctx);
+    }
+
+    remove("loader_small.bin");
+    remove("loader_large.bin");
+    remove("loader_empty.bin");
+}
+
+// Test 3: More files than the queue depth
+void test_file_loader_many_files(void) {
+    char filename[64];
+    for (unsigned i = 0; i < 50; i++) {
+        snprintf(filename, sizeof(filename), "loader_many_%u.bin", i);
+        write_test_file(filename, i * 997, i);
+    }
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        MemContext *ctx = memctx();
+        file_loader *loader = file_loader_init(ctx, 8, backends[b]);
+        assert(loader != NULL);
+
+        for (unsigned i = 0; i < 50; i++) {
+            snprintf(filename, sizeof(filename), "loader_many_%u.bin", i);
+            assert(file_loader_add(loader, filename));
+            assert(loader->in_flight <= loader->depth);
+        }
+
+        size_t count = 0;
+        bool seen[50] = {false};
+        loaded_file file;
+        while (file_loader_next(loader, &file)) {
+            assert(file.error == 0);
+            assert(!seen[file.index]);
+            seen[file.index] = true;
+            assert(check_test_file(file.content, file.index * 997, (unsigned)file.index));
+            assert(loader->in_flight <= loader->depth);
+            count++;
+        }
+        assert(count == 50);
+
+        file_loader_close(loader);
+        memctx_free(ctx);
+    }
+
+    for (unsigned i = 0; i < 50; i++) {
+        snprintf(filename, sizeof(filename), "loader_many_%u.bin", i);
+        remove(filename);
+    }
+}
+
+// Test 4: Files that cannot be loaded are reported with an error
+void test_file_loader_errors(void) {
+    write_test_file("loader_ok.bin", 10, 4);
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        MemContext *ctx = memctx();
+        file_loader *loader = file_loader_init(ctx, 4, backends[b]);
+        assert(loader != NULL);
+
+        assert(file_loader_add(loader, "loader_missing.bin"));
+        assert(file_loader_add(loader, "."));
+        assert(file_loader_add(loader, "loader_ok.bin"));
+
+        size_t count = 0;
+        loaded_file file;
+        while (file_loader_next(loader, &file)) {
+            if (file.index == 0) {
+                assert(file.error == ENOENT);
+                assert(file.content.value == NULL);
+            } else if (file.index == 1) {
+                assert(file.error == EISDIR);
+                assert(file.content.value == NULL);
+            } else {
+                assert(file.error == 0);
+                assert(check_test_file(file.content, 10, 4));
+            }
+            count++;
+        }
+        assert(count == 3);
+
+        file_loader_close(loader);
+        memctx_free(ctx);
+    }
+
+    remove("loader_ok.bin");
+}
+
+// Test 5: Closing a loader with reads in progress
+void test_file_loader_close(void) {
+    write_test_file("loader_close.bin", 50000, 5);
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        MemContext *ctx = memctx();
+        file_loader *loader = file_loader_init(ctx, 4, backends[b]);
+        assert(loader != NULL);
+
+        for (int i = 0; i < 20; i++) {
+            assert(file_loader_add(loader, "loader_close.bin"));
+        }
+        loaded_file file;
+        assert(file_loader_next(loader, &file));
+        assert(check_test_file(file.content, 50000, 5));
+
+        file_loader_close(loader);
+        assert(!file_loader_next(loader, &file));
+        memctx_free(ctx);
+    }
+
+    remove("loader_close.bin");
+}
+
+// Test 6: NULL arguments
+void test_file_loader_null(void) {
+    MemContext *ctx = memctx();
+    file_loader *loader = file_loader_init(ctx, 4, FILE_LOADER_AUTO);
+
+    loaded_file file;
+    assert(!file_loader_add(NULL, "loader.bin"));
+    assert(!file_loader_add(loader, NULL));
+    assert(!file_loader_next(NULL, &file));
+    assert(!file_loader_next(loader, NULL));
+    assert(!file_loader_next(loader, &file));
+    file_loader_close(NULL);
+
+    file_loader_close(loader);
+    memctx_free(ctx);
+}
+
+// Test 7: A ring that cannot be waited on fails the reads it holds
+void test_file_loader_ring_error(void) {
+#ifdef FILE_LOADER_IO_URING_SUPPORTED
+    MemContext *ctx = memctx();
+    file_loader *loader = file_loader_init(ctx, 4, FILE_LOADER_IO_URING);
+    if (!loader) {
+        memctx_free(ctx);
+        return;
+    }
+    write_test_file("loader_ring.bin", 50000, 7);
+
+    for (int i = 0; i < 20; i++) {
+        assert(file_loader_add(loader, "loader_ring.bin"));
+    }
+    loaded_file file;
+    assert(file_loader_next(loader, &file));
+    assert(check_test_file(file.content, 50000, 7));
+
+    // io_uring_enter now fails with EBADF, while reads are still queued in the ring
+    int ring_fd = loader->ring_fd;
+    loader->ring_fd = -1;
+
+    bool seen[20] = {false};
+    seen[file.index] = true;
+    size_t returned = 1;
+    while (file_loader_next(loader, &file)) {
+        assert(file.index < 20 && !seen[file.index]);
+        seen[file.index] = true;
+        assert(file.error == EBADF || (file.error == 0 && check_test_file(file.content, 50000, 7)));
+        if (file.error) assert(file.content.value == NULL);
+        returned++;
+    }
+    assert(returned == 20);
+    assert(loader->in_flight == 0);
+
+    file_loader_close(loader);
+    close(ring_fd);
+    memctx_free(ctx);
+    remove("loader_ring.bin");
+#endif
+}
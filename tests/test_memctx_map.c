@@ -0,0 +1,258 @@
+#include "../memctx_map.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+void test_map_init(void);
+void test_map_set_get(void);
+void test_map_remove(void);
+void test_map_grow(void);
+void test_map_random_operations(void);
+void test_map_iterate(void);
+void test_map_hashed(void);
+void test_map_clear(void);
+void test_map_null(void);
+
+int main(void) {
+    test_map_init();
+    test_map_set_get();
+    test_map_remove();
+    test_map_grow();
+    test_map_random_operations();
+    test_map_iterate();
+    test_map_hashed();
+    test_map_clear();
+    test_map_null();
+
+    printf("All map tests completed successfully.\n");
+    return 0;
+}
+
+// Test 1: Map initialization
+void test_map_init(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+    assert(m != NULL);
+    assert(m->length == 0);
+    assert(m->capacity == MAP_INIT_CAPACITY);
+    assert(m->ctx == ctx);
+
+    assert(map_init(NULL) == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 2: Inserting, replacing and looking up values
+void test_map_set_get(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+
+    int one = 1, two = 2, three = 3;
+    assert(map_set(m, "one", &one));
+    assert(map_set(m, "two", &two));
+    assert(m->length == 2);
+
+    assert(map_get(m, "one") == &one);
+    assert(map_get(m, "two") == &two);
+    assert(map_get(m, "three") == NULL);
+
+    // Lookup by string and by substring view
+    string key = string_make(ctx, "two");
+    assert(map_get(m, key) == &two);
+    string text = string_make(ctx, "one two three");
+    substring view = text;
+    view.length = 3;
+    assert(map_get(m, view) == &one);
+
+    // Replace
+    assert(map_set(m, "two", &three));
+    assert(m->length == 2);
+    assert(map_get(m, "two") == &three);
+
+    // NULL values are stored
+    assert(map_set(m, "null", NULL));
+    assert(map_has(m, "null"));
+    assert(!map_has(m, "missing"));
+
+    // Empty key is a valid key
+    assert(map_set(m, "", &one));
+    assert(map_get(m, "") == &one);
+
+    memctx_free(ctx);
+}
+
+// Test 3: Removing keys
+void test_map_remove(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+
+    int value = 42;
+    map_set(m, "a", &value);
+    map_set(m, "b", &value);
+
+    assert(map_remove(m, "a"));
+    assert(!map_remove(m, "a"));
+    assert(!map_has(m, "a"));
+    assert(map_get(m, "b") == &value);
+    assert(m->length == 1);
+
+    // Insert after remove
+    assert(map_set(m, "a", &value));
+    assert(map_get(m, "a") == &value);
+    assert(m->length == 2);
+
+    memctx_free(ctx);
+}
+
+// Test 4: Growing past many groups
+void test_map_grow(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+
+    enum { COUNT = 100000 };
+    static char keys[COUNT][16];
+    static int values[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key-%d", i);
+        values[i] = i;
+        assert(map_set(m, keys[i], &values[i]));
+    }
+    assert(m->length == COUNT);
+    assert(m->capacity >= COUNT);
+
+    for (int i = 0; i < COUNT; i++) {
+        int *found = map_get(m, keys[i]);
+        assert(found != NULL);
+        assert(*found == i);
+    }
+    assert(map_get(m, "key-100000") == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 5: Random inserts and removals agree with a reference
+void test_map_random_operations(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+
+    enum { KEYS = 2000 };
+    static char keys[KEYS][16];
+    static bool present[KEYS];
+    static int values[KEYS];
+    for (int i = 0; i < KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "%d", i * 7919);
+        present[i] = false;
+        values[i] = i;
+    }
+
+    unsigned seed = 1;
+    size_t expected_length = 0;
+    for (int op = 0; op < 200000; op++) {
+        seed = seed * 1103515245 + 12345;
+        int k = (int)((seed >> 16) % KEYS);
+        if ((seed >> 8) % 3 == 0) {
+            assert(map_remove(m, keys[k]) == present[k]);
+            if (present[k]) expected_length--;
+            present[k] = false;
+        } else {
+            assert(map_set(m, keys[k], &values[k]));
+            if (!present[k]) expected_length++;
+            present[k] = true;
+        }
+
+        if (op % 1000 == 0) {
+            for (int i = 0; i < KEYS; i++) {
+                assert(map_has(m, keys[i]) == present[i]);
+            }
+        }
+        assert(m->length == expected_length);
+    }
+
+    // Tombstones did not make the table grow without bound
+    assert(m->capacity <= 8 * KEYS);
+
+    memctx_free(ctx);
+}
+
+// Test 6: Iterating over entries
+void test_map_iterate(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+
+    static char keys[100][12];
+    for (int i = 0; i < 100; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "%d", i);
+        map_set(m, keys[i], keys[i]);
+    }
+    map_remove(m, "50");
+
+    size_t iterator = 0;
+    substring key;
+    void *value;
+    size_t count = 0;
+    bool seen[100] = {false};
+    while (map_next(m, &iterator, &key, &value)) {
+        assert(key.value == value);
+        int index = atoi(key.value);
+        assert(!seen[index]);
+        seen[index] = true;
+        count++;
+    }
+    assert(count == 99);
+    assert(!seen[50]);
+
+    memctx_free(ctx);
+}
+
+// Test 7: Precomputed hashes
+void test_map_hashed(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+
+    int value = 7;
+    hashed_string key = string_hashed(string_make(ctx, "content-type"));
+    assert(map_set_hashed(m, key, &value));
+    assert(map_get_hashed(m, key) == &value);
+    assert(map_get(m, "content-type") == &value);
+
+    memctx_free(ctx);
+}
+
+// Test 8: Clearing a map
+void test_map_clear(void) {
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+
+    int value = 1;
+    map_set(m, "a", &value);
+    map_set(m, "b", &value);
+    map_clear(m);
+    assert(m->length == 0);
+    assert(!map_has(m, "a"));
+
+    map_set(m, "c", &value);
+    assert(map_get(m, "c") == &value);
+
+    memctx_free(ctx);
+}
+
+// Test 9: NULL arguments
+void test_map_null(void) {
+    int value = 1;
+    assert(!map_set((map *)NULL, "a", &value));
+    assert(map_get((map *)NULL, "a") == NULL);
+    assert(!map_has((map *)NULL, "a"));
+    assert(!map_remove((map *)NULL, "a"));
+    map_clear(NULL);
+
+    MemContext *ctx = memctx();
+    map *m = map_init(ctx);
+    const char *null_key = NULL;
+    assert(!map_set(m, null_key, &value));
+    assert(map_get(m, null_key) == NULL);
+
+    size_t iterator = 0;
+    assert(!map_next(m, &iterator, NULL, NULL));
+    assert(!map_next(NULL, &iterator, NULL, NULL));
+    memctx_free(ctx);
+}
@@ -0,0 +1,392 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../memctx_regex.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <regex.h>
+
+void test_regex_compile(void);
+void test_regex_literals(void);
+void test_regex_sets(void);
+void test_regex_repeat(void);
+void test_regex_anchors(void);
+void test_regex_views(void);
+void test_regex_posix(void);
+void test_regex_state_limit(void);
+void test_regex_linear(void);
+void test_regex_null(void);
+void test_regex_long_patterns(void);
+
+int main(void) {
+    test_regex_compile();
+    test_regex_literals();
+    test_regex_sets();
+    test_regex_repeat();
+    test_regex_anchors();
+    test_regex_views();
+    test_regex_posix();
+    test_regex_state_limit();
+    test_regex_linear();
+    test_regex_null();
+    test_regex_long_patterns();
+
+    printf("All regex tests completed successfully.\n");
+    return 0;
+}
+
+// Test 1: Valid and invalid patterns
+void test_regex_compile(void) {
+    MemContext *ctx = memctx();
+
+    const char *valid[] = {
+        "", "a", "a|", "()", "(a|b)*c", "[]a]", "[^]a]", "[a-]", "a{2}", "a{2,}", "a{2,5}", "a{0}",
+        "\\.", "\\[", "\\\\", "x]", "}", "^", "$", "^$", "a\\$", "[$^]", "\\x41", "((((a))))",
+        "a^", "$a", "^^", "(^a|b$)+"
+    };
+    for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+        assert(regex_compile(ctx, valid[i]) != NULL);
+    }
+
+    const char *invalid[] = {
+        "(", ")", "(a", "a)", "*", "a|*", "+a", "?", "[", "[a", "[b-a]", "a{", "a{x}", "a{3,2}", "a{1001}",
+        "\\", "\\q", "\\1", "\\x4", "[a-\\d]"
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        assert(regex_compile(ctx, invalid[i]) == NULL);
+    }
+
+    // Patterns as strings
+    string pattern = string_make(ctx, "b+");
+    regex *re = regex_compile(ctx, pattern);
+    assert(re && regex_search(re, "abbc"));
+
+    memctx_free(ctx);
+}
+
+// Test 2: Literals, alternation and groups
+void test_regex_literals(void) {
+    MemContext *ctx = memctx();
+
+    regex *re = regex_compile(ctx, "error");
+    assert(regex_search(re, "an error occurred"));
+    assert(regex_search(re, "error"));
+    assert(!regex_search(re, "errxr"));
+    assert(!regex_search(re, ""));
+    assert(!regex_match(re, "an error"));
+    assert(regex_match(re, "error"));
+
+    re = regex_compile(ctx, "GET|POST /api/(users|orders)");
+    assert(regex_search(re, "GET /"));
+    assert(regex_search(re, "x POST /api/orders"));
+    assert(!regex_search(re, "POST /api/items"));
+
+    // Empty pattern matches everywhere, empty alternative matches the empty string
+    re = regex_compile(ctx, "");
+    assert(regex_search(re, "") && regex_search(re, "abc"));
+    assert(regex_match(re, "") && !regex_match(re, "a"));
+    re = regex_compile(ctx, "a|");
+    assert(regex_match(re, "a") && regex_match(re, "") && !regex_match(re, "b"));
+
+    // '.' is any byte but a newline
+    re = regex_compile(ctx, "a.c");
+    assert(regex_search(re, "abc") && regex_search(re, "a\xff" "c"));
+    assert(!regex_search(re, "a\nc"));
+
+    memctx_free(ctx);
+}
+
+// Test 3: Sets and escapes
+void test_regex_sets(void) {
+    MemContext *ctx = memctx();
+
+    regex *re = regex_compile(ctx, "^[a-c_]+$");
+    assert(regex_search(re, "abc_cab"));
+    assert(!regex_search(re, "abcd"));
+
+    re = regex_compile(ctx, "[^0-9]");
+    assert(regex_search(re, "12a3"));
+    assert(!regex_search(re, "123"));
+
+    re = regex_compile(ctx, "\\d{3}-\\w+\\s\\S");
+    assert(regex_search(re, "id 123-ab_9 x"));
+    assert(!regex_search(re, "id 12-ab x"));
+    assert(!regex_search(re, "id 123-ab  "));
+
+    re = regex_compile(ctx, "[\\d.]+");
+    assert(regex_match(re, "3.14"));
+    assert(!regex_match(re, "3,14"));
+
+    re = regex_compile(ctx, "\\D\\W\\S");
+    assert(regex_match(re, "a-b"));
+    assert(!regex_match(re, "1-b"));
+
+    re = regex_compile(ctx, "\\t\\x41\\.\\*\\[\\]");
+    assert(regex_match(re, "\tA.*[]"));
+
+    // Special characters in sets
+    re = regex_compile(ctx, "[]^.*-]+");
+    assert(regex_match(re, "]^.*-"));
+    assert(!regex_match(re, "a"));
+
+    memctx_free(ctx);
+}
+
+// Test 4: Repetition
+void test_regex_repeat(void) {
+    MemContext *ctx = memctx();
+
+    regex *re = regex_compile(ctx, "ab{2,4}c");
+    assert(!regex_match(re, "abc"));
+    assert(regex_match(re, "abbc"));
+    assert(regex_match(re, "abbbbc"));
+    assert(!regex_match(re, "abbbbbc"));
+
+    re = regex_compile(ctx, "(ab){2,}");
+    assert(!regex_match(re, "ab"));
+    assert(regex_match(re, "abab"));
+    assert(regex_match(re, "abababab"));
+    assert(!regex_match(re, "ababa"));
+
+    re = regex_compile(ctx, "x{3}");
+    assert(regex_match(re, "xxx") && !regex_match(re, "xx") && !regex_match(re, "xxxx"));
+
+    re = regex_compile(ctx, "x{0}y");
+    assert(regex_match(re, "y") && !regex_match(re, "xy"));
+
+    re = regex_compile(ctx, "a?b+c*");
+    assert(regex_match(re, "b") && regex_match(re, "abbcc") && !regex_match(re, "aab"));
+
+    // Nested and empty loops
+    re = regex_compile(ctx, "(a*)*b");
+    assert(regex_match(re, "aaab") && regex_match(re, "b") && !regex_match(re, "aaa"));
+    re = regex_compile(ctx, "(a|b?)+c");
+    assert(regex_match(re, "c") && regex_match(re, "ababbac"));
+
+    memctx_free(ctx);
+}
+
+// Test 5: Anchors
+void test_regex_anchors(void) {
+    MemContext *ctx = memctx();
+
+    regex *re = regex_compile(ctx, "^INFO");
+    assert(regex_search(re, "INFO started"));
+    assert(!regex_search(re, "[INFO] started"));
+
+    re = regex_compile(ctx, "done$");
+    assert(regex_search(re, "all done"));
+    assert(!regex_search(re, "done twice"));
+
+    re = regex_compile(ctx, "^$");
+    assert(regex_search(re, ""));
+    assert(!regex_search(re, "x"));
+
+    // An escaped '$' is a literal, an escaped backslash before it is not an escape
+    re = regex_compile(ctx, "a\\$");
+    assert(regex_search(re, "a$b") && !regex_search(re, "a"));
+    re = regex_compile(ctx, "a\\\\$");
+    assert(regex_search(re, "xa\\") && !regex_search(re, "a\\x"));
+
+    // Anchors bind to their alternative, and never match inside the input
+    re = regex_compile(ctx, "^a|b$");
+    assert(regex_search(re, "ax") && regex_search(re, "xb"));
+    assert(!regex_search(re, "xa") && !regex_search(re, "bx"));
+    re = regex_compile(ctx, "a$b");
+    assert(!regex_search(re, "ab") && !regex_search(re, "a\nb"));
+    re = regex_compile(ctx, "(^|,)id(,|$)");
+    assert(regex_search(re, "id,x") && regex_search(re, "x,id") && regex_search(re, "x,id,y"));
+    assert(!regex_search(re, "xid") && !regex_search(re, "idx"));
+    re = regex_compile(ctx, "x*$^");
+    assert(regex_search(re, "") && !regex_search(re, "x"));
+
+    memctx_free(ctx);
+}
+
+// Test 6: Substrings and bytes
+void test_regex_views(void) {
+    MemContext *ctx = memctx();
+
+    // Only `length` bytes are matched
+    string text = string_make(ctx, "key=value; other");
+    substring view = text;
+    view.length = 9;
+    regex *re = regex_compile(ctx, "=value$");
+    assert(regex_search(re, view));
+    assert(!regex_search(re, text));
+
+    // NUL bytes are ordinary bytes
+    substring binary = {"a\0b", 3, 3, ctx};
+    re = regex_compile(ctx, "a\\x00b");
+    assert(regex_match(re, binary));
+    re = regex_compile(ctx, "^a.b$");
+    assert(regex_search(re, binary));
+
+    memctx_free(ctx);
+}
+
+// Random pattern generator for the POSIX comparison
+static unsigned seed = 3;
+
+static unsigned next_random(unsigned n) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % n;
+}
+
+static void random_alt(char *out, size_t *length, int depth);
+
+static void random_atom(char *out, size_t *length, int depth) {
+    static const char *atoms[] = {"a", "b", "c", ".", "[ab]", "[^a]", "[b-c]"};
+    if (depth < 3 && next_random(4) == 0) {
+        out[(*length)++] = '(';
+        random_alt(out, length, depth + 1);
+        out[(*length)++] = ')';
+    } else {
+        const char *atom = atoms[next_random(sizeof(atoms) / sizeof(atoms[0]))];
+        memcpy(out + *length, atom, strlen(atom));
+        *length += strlen(atom);
+    }
+
+    static const char *quantifiers[] = {"", "", "", "*", "+", "?", "{2}", "{1,3}", "{0,2}", "{2,}"};
+    const char *quantifier = quantifiers[next_random(sizeof(quantifiers) / sizeof(quantifiers[0]))];
+    memcpy(out + *length, quantifier, strlen(quantifier));
+    *length += strlen(quantifier);
+}
+
+static void random_alt(char *out, size_t *length, int depth) {
+    do {
+        unsigned count = 1 + next_random(3);
+        for (unsigned i = 0; i < count; i++) random_atom(out, length, depth);
+        if (next_random(3) != 0) break;
+        out[(*length)++] = '|';
+    } while (true);
+}
+
+// Test 7: Agreement with POSIX extended regular expressions
+void test_regex_posix(void) {
+    MemContext *ctx = memctx();
+
+    char pattern[512];
+    char subject[32];
+    for (int round = 0; round < 500; round++) {
+        size_t length = 0;
+        if (next_random(4) == 0) pattern[length++] = '^';
+        random_alt(pattern, &length, 0);
+        if (next_random(4) == 0) pattern[length++] = '$';
+        pattern[length] = '\0';
+
+        regex_t posix;
+        assert(regcomp(&posix, pattern, REG_EXTENDED | REG_NOSUB) == 0);
+        regex *re = regex_compile(ctx, pattern);
+        assert(re != NULL);
+
+        for (int i = 0; i < 40; i++) {
+            size_t subject_length = next_random(sizeof(subject));
+            for (size_t k = 0; k < subject_length; k++) subject[k] = "abcd"[next_random(4)];
+            subject[subject_length] = '\0';
+
+            bool expected = regexec(&posix, subject, 0, NULL, 0) == 0;
+            assert(regex_search(re, subject) == expected);
+        }
+        regfree(&posix);
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 8: Falling back to the NFA when the DFA state limit is reached
+void test_regex_state_limit(void) {
+    MemContext *ctx = memctx();
+
+    // The DFA for "an 'a' 12 bytes before the end" needs 2^13 states
+    regex *re = regex_compile(ctx, "a[ab]{12}$");
+    regex *limited = regex_compile(ctx, "a[ab]{12}$");
+    limited->max_states = 16;
+
+    char subject[200];
+    for (int round = 0; round < 300; round++) {
+        size_t length = next_random(sizeof(subject));
+        for (size_t k = 0; k < length; k++) subject[k] = "ab"[next_random(2)];
+        substring str = {subject, length, length, ctx};
+
+        bool expected = length >= 13 && subject[length - 13] == 'a';
+        assert(regex_search(re, str) == expected);
+        assert(regex_search(limited, str) == expected);
+    }
+    assert(re->dfa_count <= REGEX_MAX_STATES);
+    assert(limited->dfa_count <= 16);
+
+    memctx_free(ctx);
+}
+
+// Test 9: Patterns that make backtracking engines exponential
+void test_regex_linear(void) {
+    MemContext *ctx = memctx();
+
+    string text = string_init(ctx);
+    for (int i = 0; i < 100000; i++) text = string_append(text, "a");
+
+    regex *re = regex_compile(ctx, "^(a|aa)*b$");
+    assert(!regex_search(re, text));
+    re = regex_compile(ctx, "(a+a+)+b");
+    assert(!regex_search(re, text));
+    re = regex_compile(ctx, "(a*)*$");
+    assert(regex_search(re, text));
+
+    memctx_free(ctx);
+}
+
+// Test 10: NULL arguments
+void test_regex_null(void) {
+    const char *null_pattern = NULL;
+    assert(__regex_compile(NULL, string_view("a")) == NULL);
+
+    MemContext *ctx = memctx();
+    assert(regex_compile(ctx, null_pattern) == NULL);
+
+    regex *re = regex_compile(ctx, "a");
+    assert(!regex_search(re, null_pattern));
+    assert(!regex_match(re, null_pattern));
+    assert(!regex_search((regex *)NULL, "a"));
+    memctx_free(ctx);
+}
+
+// Test 11: Long literals and alternations compile without deep recursion
+void test_regex_long_patterns(void) {
+    MemContext *ctx = memctx();
+
+    // One NFA state per byte, within REGEX_MAX_NFA_STATES
+    size_t length = 60000;
+    char *pattern = malloc(length * 2 + 1);
+    for (size_t i = 0; i < length; i++) pattern[i] = (char)('a' + i % 26);
+    substring literal = {pattern, length, length, NULL};
+    regex *re = regex_compile(ctx, literal);
+    assert(re != NULL);
+    assert(regex_match(re, literal));
+    pattern[length - 1] = '!';
+    assert(!regex_match(re, literal));
+
+    // Past the state limit the pattern is rejected
+    for (size_t i = 0; i < length * 2; i++) pattern[i] = (char)('a' + i % 26);
+    substring too_long = {pattern, length * 2, length * 2, NULL};
+    assert(regex_compile(ctx, too_long) == NULL);
+
+    // 20000 alternatives
+    size_t n = 0;
+    for (int i = 0; i < 20000; i++) {
+        pattern[n++] = (char)('a' + i % 26);
+        pattern[n++] = '|';
+    }
+    pattern[n++] = '0';
+    re = regex_compile(ctx, ((substring){pattern, n, n, NULL}));
+    assert(re != NULL);
+    assert(regex_match(re, "0") && regex_match(re, "q") && !regex_match(re, "1"));
+
+    // Stacked quantifiers count towards the nesting limit
+    memset(pattern, '*', REGEX_MAX_DEPTH + 2);
+    pattern[0] = 'a';
+    assert(regex_compile(ctx, ((substring){pattern, REGEX_MAX_DEPTH + 1, 0, NULL})) != NULL);
+    assert(regex_compile(ctx, ((substring){pattern, REGEX_MAX_DEPTH + 2, 0, NULL})) == NULL);
+
+    free(pattern);
+    memctx_free(ctx);
+}
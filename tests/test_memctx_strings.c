@@ -2,21 +2,102 @@
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <pthread.h>
 
 void test_string_init(void);
 void test_string_make(void);
 void test_string_append(void);
+void test_string_append_growth(void);
 void test_string_read_file(void);
 void test_string_trim(void);
 void test_string_free_file(void);
+void test_string_view(void);
+void test_string_find(void);
+void test_string_find_random(void);
+void test_string_find_all(void);
+void test_string_contains(void);
+void test_string_split(void);
+void test_string_split_iter(void);
+void test_string_lines(void);
+void test_string_line_index(void);
+void test_string_hash(void);
+void test_string_hash_collisions(void);
+void test_string_hash_avalanche(void);
+void test_string_utf8_valid(void);
+void test_string_utf8_random(void);
+void test_string_utf8_length(void);
+void test_string_case(void);
+void test_string_case_random(void);
+void test_string_compare_ci(void);
+void test_string_trim_sides(void);
+void test_string_charset(void);
+void test_string_charset_random(void);
+void test_string_tokenize(void);
+void test_substring_to_int(void);
+void test_substring_to_int_random(void);
+void test_substring_to_double(void);
+void test_substring_to_double_random(void);
+void test_string_replace(void);
+void test_string_replace_many(void);
+void test_string_replace_random(void);
+void test_string_join(void);
+void test_string_concat(void);
+void test_array_sort_strings(void);
+void test_string_append_n(void);
+void test_string_base64(void);
+void test_string_hex(void);
+void test_string_encoding_random(void);
 
 int main(void) {
     test_string_init();
     test_string_make();
     test_string_append();
+    test_string_append_growth();
     test_string_read_file();
     test_string_trim();
     test_string_free_file();
+    test_string_view();
+    test_string_find();
+    test_string_find_random();
+    test_string_find_all();
+    test_string_contains();
+    test_string_split();
+    test_string_split_iter();
+    test_string_lines();
+    test_string_line_index();
+    test_string_hash();
+    test_string_hash_collisions();
+    test_string_hash_avalanche();
+    test_string_utf8_valid();
+    test_string_utf8_random();
+    test_string_utf8_length();
+    test_string_case();
+    test_string_case_random();
+    test_string_compare_ci();
+    test_string_trim_sides();
+    test_string_charset();
+    test_string_charset_random();
+    test_string_tokenize();
+    test_substring_to_int();
+    test_substring_to_int_random();
+    test_substring_to_double();
+    test_substring_to_double_random();
+    test_string_replace();
+    test_string_replace_many();
+    test_string_replace_random();
+    test_string_join();
+    test_string_concat();
+    test_array_sort_strings();
+    test_string_append_n();
+    test_string_base64();
+    test_string_hex();
+    test_string_encoding_random();
 
     printf("All string tests completed successfully.\n");
     return 0;
@@ -46,6 +127,13 @@ void test_string_make(void) {
     assert(str1.capacity >= 14);  // At least length + null terminator
     assert(strcmp(str1.value, "Hello, World!") == 0);
 
+    // The buffer is sized to fit the value
+    assert(str1.capacity < str1.length + 1 + sizeof(uintptr_t));
+    string str1b = string_append(str1, " Again");
+    assert(str1b.length == 19);
+    assert(strcmp(str1b.value, "Hello, World! Again") == 0);
+    assert(strcmp(str1.value, "Hello, World!") == 0);
+
     // Empty string
     string str2 = string_make(ctx, "");
     assert(str2.value != NULL);
@@ -120,6 +208,26 @@ void test_string_append(void) {
     memctx_free(ctx3);
 }
 
+// Test 3a: Repeated appends grow capacity geometrically
+void test_string_append_growth(void) {
+    MemContext *ctx = memctx();
+    string str = string_init(ctx);
+
+    // 1M small appends must reallocate O(log n) times, not O(n)
+    size_t reallocations = 0;
+    for (int i = 0; i < 1000000; i++) {
+        char *before = str.value;
+        str = string_append(str, "abc");
+        if (str.value != before) reallocations++;
+    }
+    assert(str.length == 3000000);
+    assert(str.capacity > str.length);
+    assert(reallocations < 64);
+    assert(memcmp(str.value + str.length - 6, "abcabc", 7) == 0);
+
+    memctx_free(ctx);
+}
+
 // Test 4: Reading a file
 void test_string_read_file(void) {
     // Write a test file first
@@ -168,6 +276,8 @@ void test_string_trim(void) {
     string str2 = string_make(ctx, "   \t\n  ");
     substring trimmed2 = string_trim(str2);
     assert(trimmed2.length == 0);
+    assert(trimmed2.value >= str2.value && trimmed2.value <= str2.value + str2.length);
+    assert(trimmed2.ctx == ctx);
 
     // Test with no whitespace
     string str3 = string_make(ctx, "NoWhitespace");
@@ -178,7 +288,11 @@ void test_string_trim(void) {
     // Test with empty string
     string str4 = string_make(ctx, "");
     substring trimmed4 = string_trim(str4);
-    assert(trimmed4.length == 0);
+    assert(trimmed4.length == 0 && trimmed4.capacity == 0);
+    assert(trimmed4.value == str4.value);
+    assert(trimmed4.ctx == ctx);
+    assert(string_trim_left(str4).value == str4.value && string_trim_left(str4).ctx == ctx);
+    assert(string_trim_right(str4).value == str4.value && string_trim_right(str4).ctx == ctx);
 
     // Test with NULL
     string str5 = {0};
@@ -217,3 +331,1614 @@ void test_string_free_file(void) {
     // Clean up test file
     remove("test_file_free.txt");
 }
+
+// Test 7: Wrapping C strings without copying
+void test_string_view(void) {
+    const char *text = "Hello";
+    substring view = string_view(text);
+    assert(view.value == text);
+    assert(view.length == 5);
+    assert(view.ctx == NULL);
+
+    substring empty = string_view(NULL);
+    assert(empty.value == NULL);
+    assert(empty.length == 0);
+}
+
+// Test 8: Finding substrings
+void test_string_find(void) {
+    MemContext *ctx = memctx();
+    string str = string_make(ctx, "The quick brown fox jumps over the lazy dog");
+
+    assert(string_find(str, "The") == 0);
+    assert(string_find(str, "quick") == 4);
+    assert(string_find(str, "dog") == 40);
+    assert(string_find(str, "the") == 31);
+    assert(string_find(str, "o") == 12);
+    assert(string_find(str, "cat") == STRING_NOT_FOUND);
+    assert(string_find(str, "dogs") == STRING_NOT_FOUND);
+    assert(string_find(str, "") == 0);
+    assert(string_find(str, "brown fox jumps over the lazy dog") == 10);
+    assert(string_find(str, "The quick brown fox jumps over the lazy dog!") == STRING_NOT_FOUND);
+
+    string needle = string_make(ctx, "fox");
+    assert(string_find(str, needle) == 16);
+
+    assert(string_find_from(str, "o", 13) == 17);
+    assert(string_find_from(str, "o", 43) == STRING_NOT_FOUND);
+    assert(string_find_from(str, "o", 100) == STRING_NOT_FOUND);
+
+    // Search respects length, not the terminator
+    substring prefix = str;
+    prefix.length = 10;
+    assert(string_find(prefix, "brown") == STRING_NOT_FOUND);
+    assert(string_find(prefix, "quick") == 4);
+
+    // NULL strings
+    string null_str = {0};
+    assert(string_find(null_str, "a") == STRING_NOT_FOUND);
+    const char *null_needle = NULL;
+    assert(string_find(str, null_needle) == STRING_NOT_FOUND);
+
+    memctx_free(ctx);
+}
+
+// Test 9: Search kernels agree with a naive search
+void test_string_find_random(void) {
+    MemContext *ctx = memctx();
+    unsigned seed = 12345;
+
+    char haystack[2048];
+    char needle[128];
+    for (int round = 0; round < 3000; round++) {
+        // Small alphabets produce many partial matches and periodic needles
+        int alphabet = 2 + round % 3;
+        size_t length = (size_t)(round % 7 == 0 ? 2000 : round % 200);
+        size_t needle_length = 1 + (size_t)(round % 100);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            haystack[i] = (char)('a' + (seed >> 16) % alphabet);
+        }
+        for (size_t i = 0; i < needle_length; i++) {
+            seed = seed * 1103515245 + 12345;
+            needle[i] = (char)('a' + (seed >> 16) % alphabet);
+        }
+        // Plant the needle sometimes
+        if (round % 2 == 0 && needle_length <= length) {
+            memcpy(haystack + (length - needle_length) / 2, needle, needle_length);
+        }
+
+        size_t expected = STRING_NOT_FOUND;
+        for (size_t i = 0; i + needle_length <= length; i++) {
+            if (memcmp(haystack + i, needle, needle_length) == 0) {
+                expected = i;
+                break;
+            }
+        }
+
+        assert(__string_search(haystack, length, needle, needle_length) == expected);
+        if (needle_length > 1 && needle_length <= length) {
+            assert(__string_search_two_way((unsigned char *)haystack, length,
+                                           (unsigned char *)needle, needle_length) == expected);
+        }
+    }
+
+    // Long needle whose first and last bytes match everywhere: the filter gives up for Two-Way
+    size_t big_length = 1 << 20;
+    char *big = memctx_alloc(ctx, big_length);
+    memset(big, 'a', big_length);
+    char periodic[61];
+    memset(periodic, 'a', sizeof(periodic));
+    periodic[30] = 'b';
+    assert(__string_search(big, big_length, periodic, sizeof(periodic)) == STRING_NOT_FOUND);
+    memcpy(big + big_length - 100, periodic, sizeof(periodic));
+    assert(__string_search(big, big_length, periodic, sizeof(periodic)) == big_length - 100);
+
+    memctx_free(ctx);
+}
+
+// Test 10: Finding all occurrences
+void test_string_find_all(void) {
+    MemContext *ctx = memctx();
+    string str = string_make(ctx, "abababab, ab");
+
+    array *matches = string_find_all(str, "ab");
+    assert(matches != NULL);
+    assert(matches->length == 5);
+    substring *first = array_item_at(matches, 0);
+    substring *last = array_item_at(matches, 4);
+    assert(first->value == str.value);
+    assert(first->length == 2);
+    assert(last->value == str.value + 10);
+
+    // Non-overlapping
+    array *overlapping = string_find_all(str, "aba");
+    assert(overlapping->length == 2);
+    assert(((substring *)array_item_at(overlapping, 1))->value == str.value + 4);
+
+    array *none = string_find_all(str, "xyz");
+    assert(none != NULL);
+    assert(none->length == 0);
+
+    array *empty = string_find_all(str, "");
+    assert(empty != NULL);
+    assert(empty->length == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 11: Checking for substrings
+void test_string_contains(void) {
+    MemContext *ctx = memctx();
+    string str = string_make(ctx, "GET /index.html HTTP/1.1");
+
+    assert(string_contains(str, "HTTP/1.1"));
+    assert(string_contains(str, "/index"));
+    assert(!string_contains(str, "POST"));
+    assert(string_contains(str, ""));
+
+    memctx_free(ctx);
+}
+
+// Test 12: Splitting into substring views
+void test_string_split(void) {
+    MemContext *ctx = memctx();
+    string str = string_make(ctx, "id,name;;value,");
+
+    array *fields = string_split(str, ",;");
+    assert(fields != NULL);
+    assert(fields->length == 5);
+
+    const char *expected[] = {"id", "name", "", "value", ""};
+    for (size_t i = 0; i < fields->length; i++) {
+        substring *field = array_item_at(fields, i);
+        assert(field->length == strlen(expected[i]));
+        assert(strncmp(field->value, expected[i], field->length) == 0);
+        // Fields reference the original buffer
+        assert(field->value >= str.value && field->value <= str.value + str.length);
+    }
+
+    // No delimiters: the whole string
+    array *whole = string_split(str, "|");
+    assert(whole->length == 1);
+    assert(((substring *)array_item_at(whole, 0))->length == str.length);
+
+    // Empty string gives one empty field
+    array *empty = string_split(string_make(ctx, ""), ",");
+    assert(empty->length == 1);
+    assert(((substring *)array_item_at(empty, 0))->length == 0);
+
+    // Appending to a field does not modify the source
+    substring *first = array_item_at(fields, 0);
+    string appended = string_append(*first, "X");
+    assert(strcmp(appended.value, "idX") == 0);
+    assert(strcmp(str.value, "id,name;;value,") == 0);
+
+    // Long input crosses SIMD blocks
+    string_split_iterator it;
+    string long_str = string_init(ctx);
+    for (int i = 0; i < 100; i++) {
+        long_str = string_append(long_str, "field\t0123456789abcdefghij\n");
+    }
+    array *cells = string_split(long_str, "\t\n");
+    assert(cells->length == 201);
+    it = string_split_iter(long_str, "\n");
+    size_t count = 0;
+    substring line;
+    while (string_split_next(&it, &line)) {
+        if (count < 100) assert(line.length == 26);
+        count++;
+    }
+    assert(count == 101);
+
+    // NULL arguments
+    string null_str = {0};
+    null_str.ctx = ctx;
+    assert(string_split(null_str, ",")->length == 0);
+    assert(string_split(str, NULL)->length == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 13: Lazy split iterator
+void test_string_split_iter(void) {
+    MemContext *ctx = memctx();
+    string str = string_make(ctx, "a b  c");
+
+    string_split_iterator it = string_split_iter(str, " ");
+    substring field;
+    assert(string_split_next(&it, &field));
+    assert(field.length == 1 && field.value[0] == 'a');
+    assert(string_split_next(&it, &field));
+    assert(field.length == 1 && field.value[0] == 'b');
+    assert(string_split_next(&it, &field));
+    assert(field.length == 0);
+    assert(string_split_next(&it, &field));
+    assert(field.length == 1 && field.value[0] == 'c');
+    assert(!string_split_next(&it, &field));
+    assert(!string_split_next(&it, &field));
+    assert(!string_split_next(NULL, &field));
+
+    memctx_free(ctx);
+}
+
+// Test 14: Iterating over lines
+void test_string_lines(void) {
+    MemContext *ctx = memctx();
+
+    string str = string_make(ctx, "first\r\nsecond\n\nlast");
+    string_line_iterator it = string_lines(str);
+    substring line;
+    assert(string_lines_next(&it, &line));
+    assert(line.length == 5 && strncmp(line.value, "first", 5) == 0);
+    assert(string_lines_next(&it, &line));
+    assert(line.length == 6 && strncmp(line.value, "second", 6) == 0);
+    assert(string_lines_next(&it, &line));
+    assert(line.length == 0);
+    assert(string_lines_next(&it, &line));
+    assert(line.length == 4 && strncmp(line.value, "last", 4) == 0);
+    assert(!string_lines_next(&it, &line));
+
+    // A trailing newline does not start another line
+    it = string_lines(string_make(ctx, "a\nb\n"));
+    size_t count = 0;
+    while (string_lines_next(&it, &line)) count++;
+    assert(count == 2);
+
+    // Empty string has no lines, a single newline is one empty line
+    it = string_lines(string_make(ctx, ""));
+    assert(!string_lines_next(&it, &line));
+    it = string_lines(string_make(ctx, "\n"));
+    assert(string_lines_next(&it, &line));
+    assert(line.length == 0);
+    assert(!string_lines_next(&it, &line));
+
+    string null_str = {0};
+    it = string_lines(null_str);
+    assert(!string_lines_next(&it, &line));
+
+    memctx_free(ctx);
+}
+
+// Test 15: Random access to lines
+void test_string_line_index(void) {
+    MemContext *ctx = memctx();
+    unsigned seed = 42;
+
+    // Lines of random length, crossing 64-byte blocks
+    for (int round = 0; round < 50; round++) {
+        string str = string_init(ctx);
+        int lines = round * 7;
+        for (int i = 0; i < lines; i++) {
+            seed = seed * 1103515245 + 12345;
+            int length = (int)((seed >> 16) % 150);
+            char buffer[160];
+            memset(buffer, 'a' + i % 26, (size_t)length);
+            buffer[length] = '\0';
+            str = string_append(str, buffer);
+            if (i + 1 < lines || round % 2) {
+                str = string_append(str, (seed & 1) ? "\r\n" : "\n");
+            }
+        }
+
+        line_index *index = string_line_index(str);
+        assert(index != NULL);
+        assert(index->count == (size_t)lines);
+
+        string_line_iterator it = string_lines(str);
+        substring line;
+        for (size_t i = 0; i < index->count; i++) {
+            assert(string_lines_next(&it, &line));
+            substring indexed = string_line_at(index, i);
+            assert(indexed.value == line.value);
+            assert(indexed.length == line.length);
+            for (size_t j = 0; j < line.length; j++) {
+                assert(line.value[j] == 'a' + (char)(i % 26));
+            }
+        }
+        assert(!string_lines_next(&it, &line));
+    }
+
+    // Index grows past its initial capacity
+    string many = string_init(ctx);
+    for (int i = 0; i < 3000; i++) {
+        many = string_append(many, "line\n");
+    }
+    line_index *large = string_line_index(many);
+    assert(large->count == 3000);
+    assert(string_line_at(large, 2999).value == many.value + 2999 * 5);
+
+    // Newlines that exactly fill the initial capacity, with and without an unterminated last line
+    for (int newlines = 1022; newlines <= 1024; newlines++) {
+        for (int tail = 0; tail < 2; tail++) {
+            string boundary = string_init(ctx);
+            for (int i = 0; i < newlines; i++) {
+                boundary = string_append(boundary, "a\n");
+            }
+            if (tail) boundary = string_append(boundary, "x");
+
+            line_index *edge = string_line_index(boundary);
+            assert(edge != NULL);
+            assert(edge->count == (size_t)(newlines + tail));
+            substring last_line = string_line_at(edge, edge->count - 1);
+            assert(last_line.length == 1);
+            assert(last_line.value[0] == (tail ? 'x' : 'a'));
+        }
+    }
+
+    line_index *index = string_line_index(string_make(ctx, "one\ntwo"));
+    assert(index->count == 2);
+    assert(string_line_at(index, 1).length == 3);
+    assert(string_line_at(index, 2).value == NULL);
+    assert(string_line_at(NULL, 0).value == NULL);
+
+    string no_ctx = {0};
+    assert(string_line_index(no_ctx) == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 16: Hashing depends on content and length only
+void test_string_hash(void) {
+    MemContext *ctx = memctx();
+
+    string a = string_make(ctx, "hostname.example.com");
+    string b = string_make(ctx, "hostname.example.com");
+    assert(a.value != b.value);
+    assert(string_hash(a) == string_hash(b));
+
+    // Length-aware: a prefix view hashes like the prefix
+    substring prefix = a;
+    prefix.length = 8;
+    assert(string_hash(prefix) == string_hash(string_make(ctx, "hostname")));
+    assert(string_hash(prefix) != string_hash(a));
+
+    // Embedded zero bytes count
+    char with_zero[2] = {'a', '\0'};
+    assert(__string_hash_bytes(with_zero, 1, 0) != __string_hash_bytes(with_zero, 2, 0));
+
+    // Every length up to several blocks, at unaligned offsets
+    char buffer[256];
+    for (size_t i = 0; i < sizeof(buffer); i++) buffer[i] = (char)(i * 7);
+    for (size_t length = 0; length < 200; length++) {
+        char copy[256];
+        memcpy(copy + 3, buffer, length);
+        assert(__string_hash_bytes(buffer, length, 0) == __string_hash_bytes(copy + 3, length, 0));
+        if (length > 0) {
+            assert(__string_hash_bytes(buffer, length, 0) != __string_hash_bytes(buffer, length - 1, 0));
+        }
+    }
+
+    // Cached hash
+    hashed_string key = string_hashed(a);
+    assert(key.hash == string_hash(a));
+    assert(key.str.value == a.value);
+
+    // Empty and NULL strings hash the same
+    string null_str = {0};
+    assert(string_hash(null_str) == string_hash(string_make(ctx, "")));
+
+    memctx_free(ctx);
+}
+
+int __compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Test 17: No collisions on similar keys, even spread over buckets
+void test_string_hash_collisions(void) {
+    enum { KEYS = 200000, BUCKETS = 1024 };
+    uint64_t *hashes = malloc(sizeof(uint64_t) * KEYS);
+    size_t *buckets = calloc(BUCKETS, sizeof(size_t));
+    assert(hashes && buckets);
+
+    char key[32];
+    for (int i = 0; i < KEYS; i++) {
+        int length = snprintf(key, sizeof(key), "key-%d", i);
+        hashes[i] = __string_hash_bytes(key, (size_t)length, 0);
+        buckets[hashes[i] % BUCKETS]++;
+    }
+
+    qsort(hashes, KEYS, sizeof(uint64_t), __compare_u64);
+    for (int i = 1; i < KEYS; i++) {
+        assert(hashes[i] != hashes[i - 1]);
+    }
+
+    // Each bucket expects ~195 keys; allow a wide margin
+    for (int i = 0; i < BUCKETS; i++) {
+        assert(buckets[i] > 120 && buckets[i] < 280);
+    }
+
+    free(hashes);
+    free(buckets);
+}
+
+// Test 18: Flipping one input bit flips about half of the output bits
+void test_string_hash_avalanche(void) {
+    size_t lengths[] = {3, 8, 16, 40, 100};
+    unsigned seed = 7;
+
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        size_t length = lengths[l];
+        unsigned char input[128];
+        size_t flips[64] = {0};
+        size_t trials = 0;
+        double total = 0;
+
+        for (int sample = 0; sample < 64; sample++) {
+            for (size_t i = 0; i < length; i++) {
+                seed = seed * 1103515245 + 12345;
+                input[i] = (unsigned char)(seed >> 16);
+            }
+            uint64_t base = __string_hash_bytes(input, length, 0);
+            for (size_t bit = 0; bit < length * 8; bit++) {
+                input[bit / 8] ^= (unsigned char)(1 << (bit % 8));
+                uint64_t diff = base ^ __string_hash_bytes(input, length, 0);
+                input[bit / 8] ^= (unsigned char)(1 << (bit % 8));
+
+                for (int out = 0; out < 64; out++) {
+                    if (diff >> out & 1) {
+                        flips[out]++;
+                        total++;
+                    }
+                }
+                trials++;
+            }
+        }
+
+        double average = total / (double)trials;
+        assert(average > 31.0 && average < 33.0);
+        for (int out = 0; out < 64; out++) {
+            double probability = (double)flips[out] / (double)trials;
+            assert(probability > 0.42 && probability < 0.58);
+        }
+    }
+}
+
+// Validates a byte sequence placed at several offsets, so it crosses SIMD block boundaries
+bool __utf8_valid_at_offsets(const char *bytes, size_t length) {
+    char buffer[128];
+    bool result = true;
+    for (size_t offset = 0; offset < 40; offset += 3) {
+        memset(buffer, 'a', sizeof(buffer));
+        memcpy(buffer + offset, bytes, length);
+        substring str = {buffer, offset + length + (offset % 2 ? 20 : 0), 0, NULL};
+        bool valid = string_utf8_valid(str);
+        assert(valid == __string_utf8_valid_scalar((unsigned char *)str.value, str.length));
+        if (offset == 0) result = valid;
+        assert(valid == result);
+    }
+    return result;
+}
+
+// Test 19: UTF-8 validation of known valid and invalid sequences
+void test_string_utf8_valid(void) {
+    MemContext *ctx = memctx();
+
+    assert(string_utf8_valid(string_make(ctx, "")));
+    assert(string_utf8_valid(string_make(ctx, "plain ASCII text")));
+    assert(string_utf8_valid(string_make(ctx, "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80")));
+    string null_str = {0};
+    assert(string_utf8_valid(null_str));
+
+    // Boundaries
+    assert(__utf8_valid_at_offsets("\xC2\x80", 2));             // U+0080
+    assert(__utf8_valid_at_offsets("\xDF\xBF", 2));             // U+07FF
+    assert(__utf8_valid_at_offsets("\xE0\xA0\x80", 3));         // U+0800
+    assert(__utf8_valid_at_offsets("\xED\x9F\xBF", 3));         // U+D7FF
+    assert(__utf8_valid_at_offsets("\xEE\x80\x80", 3));         // U+E000
+    assert(__utf8_valid_at_offsets("\xEF\xBF\xBF", 3));         // U+FFFF
+    assert(__utf8_valid_at_offsets("\xF0\x90\x80\x80", 4));     // U+10000
+    assert(__utf8_valid_at_offsets("\xF4\x8F\xBF\xBF", 4));     // U+10FFFF
+
+    // Errors
+    assert(!__utf8_valid_at_offsets("\x80", 1));                 // Lone continuation
+    assert(!__utf8_valid_at_offsets("\xC3", 1));                 // Truncated
+    assert(!__utf8_valid_at_offsets("\xC3\x28", 2));             // Bad continuation
+    assert(!__utf8_valid_at_offsets("\xC0\x80", 2));             // Overlong 2
+    assert(!__utf8_valid_at_offsets("\xC1\xBF", 2));             // Overlong 2
+    assert(!__utf8_valid_at_offsets("\xE0\x9F\xBF", 3));         // Overlong 3
+    assert(!__utf8_valid_at_offsets("\xED\xA0\x80", 3));         // Surrogate
+    assert(!__utf8_valid_at_offsets("\xF0\x8F\xBF\xBF", 4));     // Overlong 4
+    assert(!__utf8_valid_at_offsets("\xF4\x90\x80\x80", 4));     // Above U+10FFFF
+    assert(!__utf8_valid_at_offsets("\xF5\x80\x80\x80", 4));     // Invalid lead
+    assert(!__utf8_valid_at_offsets("\xFF", 1));                 // Invalid byte
+    assert(!__utf8_valid_at_offsets("\xE2\x82\xAC\xAC", 4));     // Extra continuation
+
+    // Truncated at the very end of the input
+    string truncated = string_make(ctx, "0123456789abcde\xE2\x82");
+    assert(!string_utf8_valid(truncated));
+    string truncated16 = string_make(ctx, "0123456789abcd\xE2\x82");
+    assert(!string_utf8_valid(truncated16));
+
+    memctx_free(ctx);
+}
+
+// Test 20: SIMD and scalar validation agree on random input
+void test_string_utf8_random(void) {
+    unsigned seed = 99;
+    unsigned char buffer[512];
+    const unsigned code_points[] = {0x41, 0x7F, 0xE9, 0x7FF, 0x800, 0x20AC, 0xD7FF, 0xE000, 0xFFFD, 0x10000, 0x1F600, 0x10FFFF};
+
+    for (int round = 0; round < 20000; round++) {
+        size_t length = 0;
+        size_t target = (size_t)(round % 300);
+        while (length + 4 <= target) {
+            seed = seed * 1103515245 + 12345;
+            unsigned cp = code_points[(seed >> 16) % (sizeof(code_points) / sizeof(code_points[0]))];
+            if (cp < 0x80) {
+                buffer[length++] = (unsigned char)cp;
+            } else if (cp < 0x800) {
+                buffer[length++] = (unsigned char)(0xC0 | cp >> 6);
+                buffer[length++] = (unsigned char)(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                buffer[length++] = (unsigned char)(0xE0 | cp >> 12);
+                buffer[length++] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+                buffer[length++] = (unsigned char)(0x80 | (cp & 0x3F));
+            } else {
+                buffer[length++] = (unsigned char)(0xF0 | cp >> 18);
+                buffer[length++] = (unsigned char)(0x80 | (cp >> 12 & 0x3F));
+                buffer[length++] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+                buffer[length++] = (unsigned char)(0x80 | (cp & 0x3F));
+            }
+        }
+
+        substring str = {(char *)buffer, length, 0, NULL};
+        assert(string_utf8_valid(str));
+
+        // Corrupt some inputs
+        if (length > 0 && round % 2) {
+            seed = seed * 1103515245 + 12345;
+            buffer[(seed >> 8) % length] = (unsigned char)(seed >> 20);
+            if (round % 4 == 1) str.length = (seed >> 4) % length;
+        }
+        bool valid = __string_utf8_valid_scalar(buffer, str.length);
+        assert(string_utf8_valid(str) == valid);
+#if defined(STRING_SIMD_DISPATCH)
+        // The resolver picks one kernel; check the others the CPU can run as well
+        if (__builtin_cpu_supports("ssse3")) assert(__string_utf8_valid_ssse3(buffer, str.length) == valid);
+        if (__builtin_cpu_supports("avx2")) {
+            assert(__string_utf8_valid_avx2(buffer, str.length) == valid);
+            assert(__string_utf8_length_avx2((signed char *)buffer, str.length) ==
+                   __string_utf8_length_sse2((signed char *)buffer, str.length));
+        }
+#endif
+    }
+}
+
+// Test 21: Counting code points
+void test_string_utf8_length(void) {
+    MemContext *ctx = memctx();
+
+    assert(string_utf8_length(string_make(ctx, "")) == 0);
+    assert(string_utf8_length(string_make(ctx, "abc")) == 3);
+    assert(string_utf8_length(string_make(ctx, "caf\xC3\xA9")) == 4);
+    assert(string_utf8_length(string_make(ctx, "\xE2\x82\xAC\xF0\x9F\x98\x80")) == 2);
+
+    string long_str = string_init(ctx);
+    for (int i = 0; i < 100; i++) {
+        long_str = string_append(long_str, "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+    }
+    assert(string_utf8_length(long_str) == 400);
+
+    string null_str = {0};
+    assert(string_utf8_length(null_str) == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 22: ASCII case conversion
+void test_string_case(void) {
+    MemContext *ctx = memctx();
+
+    string str = string_make(ctx, "Hello, World! caf\xC3\xA9 @[`{");
+    string lower = string_to_lower(ctx, str);
+    string upper = string_to_upper(ctx, str);
+    assert(strcmp(lower.value, "hello, world! caf\xC3\xA9 @[`{") == 0);
+    assert(strcmp(upper.value, "HELLO, WORLD! CAF\xC3\xA9 @[`{") == 0);
+    assert(lower.length == str.length);
+    assert(strcmp(str.value, "Hello, World! caf\xC3\xA9 @[`{") == 0);
+
+    // Result is a regular string
+    lower = string_append(lower, "!");
+    assert(strcmp(lower.value, "hello, world! caf\xC3\xA9 @[`{!") == 0);
+
+    string_to_upper_in_place(str);
+    assert(strcmp(str.value, "HELLO, WORLD! CAF\xC3\xA9 @[`{") == 0);
+    string_to_lower_in_place(str);
+    assert(strcmp(str.value, "hello, world! caf\xC3\xA9 @[`{") == 0);
+
+    string empty = string_to_lower(ctx, string_make(ctx, ""));
+    assert(empty.value != NULL && empty.length == 0 && empty.value[0] == '\0');
+
+    string null_str = {0};
+    assert(string_to_lower(ctx, null_str).value == NULL);
+    string_to_upper_in_place(null_str);
+
+    memctx_free(ctx);
+}
+
+// Test 23: Vectorized case conversion agrees with a byte-wise reference
+void test_string_case_random(void) {
+    MemContext *ctx = memctx();
+
+    unsigned seed = 7;
+    char buffer[200];
+    for (int round = 0; round < 2000; round++) {
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % sizeof(buffer);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            buffer[i] = (char)(seed >> 16);
+        }
+        substring str = {buffer, length, 0, NULL};
+
+        string lower = string_to_lower(ctx, str);
+        string upper = string_to_upper(ctx, str);
+        assert(lower.length == length && upper.length == length);
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = (unsigned char)buffer[i];
+            unsigned char l = (c >= 'A' && c <= 'Z') ? c + 32 : c;
+            unsigned char u = (c >= 'a' && c <= 'z') ? c - 32 : c;
+            assert((unsigned char)lower.value[i] == l);
+            assert((unsigned char)upper.value[i] == u);
+        }
+
+        assert(string_equal_ci(lower, upper));
+        assert(string_compare_ci(lower, upper) == 0);
+        if (length > 0) {
+            // Change one byte and check that the difference is found
+            size_t at = (seed >> 8) % length;
+            upper.value[at] = (char)(upper.value[at] ^ 0x01);
+            unsigned char x = (unsigned char)lower.value[at];
+            unsigned char y = (unsigned char)upper.value[at];
+            if (x >= 'A' && x <= 'Z') x |= 0x20;
+            if (y >= 'A' && y <= 'Z') y |= 0x20;
+            assert(string_equal_ci(lower, upper) == (x == y));
+            int cmp = string_compare_ci(lower, upper);
+            assert(x == y ? cmp == 0 : (cmp < 0) == (x < y));
+        }
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 24: Case-insensitive comparison
+void test_string_compare_ci(void) {
+    MemContext *ctx = memctx();
+
+    string str = string_make(ctx, "Content-Type");
+    assert(string_equal_ci(str, "content-type"));
+    assert(string_equal_ci("CONTENT-TYPE", str));
+    assert(!string_equal_ci(str, "content-typ"));
+    assert(!string_equal_ci(str, "content_type"));
+    assert(string_equal_ci("", ""));
+
+    // Only ASCII letters fold: '[' and '{' differ
+    assert(!string_equal_ci("[", "{"));
+
+    assert(string_compare_ci("abc", "ABC") == 0);
+    assert(string_compare_ci("abc", "ABD") < 0);
+    assert(string_compare_ci("ABD", "abc") > 0);
+    assert(string_compare_ci("ab", "ABC") < 0);
+    assert(string_compare_ci("abc", "AB") > 0);
+    // Letters compare as lowercase, so '_' (0x5F) sorts before 'a'
+    assert(string_compare_ci("_", "A") < 0);
+
+    // Long inputs cross vector blocks
+    string a = string_init(ctx);
+    string b = string_init(ctx);
+    for (int i = 0; i < 50; i++) {
+        a = string_append(a, "The Quick Brown Fox ");
+        b = string_append(b, "tHE qUICK bROWN fOX ");
+    }
+    assert(string_equal_ci(a, b));
+    b.value[777] = '~';
+    assert(!string_equal_ci(a, b));
+    assert(string_compare_ci(a, b) < 0);
+
+    // Every byte pair, inside the 32 and 16 byte blocks and the scalar tail
+    char x[56], y[56];
+    memset(x, 'q', sizeof(x));
+    memset(y, 'Q', sizeof(y));
+    const size_t positions[] = {5, 40, 50};
+    for (size_t p = 0; p < 3; p++) {
+        size_t at = positions[p];
+        for (int i = 0; i < 256; i++) {
+            for (int j = 0; j < 256; j++) {
+                x[at] = (char)i;
+                y[at] = (char)j;
+                int fi = i >= 'A' && i <= 'Z' ? i | 0x20 : i;
+                int fj = j >= 'A' && j <= 'Z' ? j | 0x20 : j;
+                substring sx = {x, sizeof(x), 0, NULL};
+                substring sy = {y, sizeof(y), 0, NULL};
+                assert(string_equal_ci(sx, sy) == (fi == fj));
+                int order = string_compare_ci(sx, sy);
+                assert(fi < fj ? order < 0 : fi > fj ? order > 0 : order == 0);
+            }
+        }
+        x[at] = 'q';
+        y[at] = 'Q';
+    }
+
+    string null_str = {0};
+    assert(string_equal_ci(null_str, null_str));
+    assert(!string_equal_ci(null_str, ""));
+    assert(string_compare_ci(null_str, "a") < 0);
+
+    memctx_free(ctx);
+}
+
+// Test 25: Trimming one side, long whitespace runs
+void test_string_trim_sides(void) {
+    MemContext *ctx = memctx();
+
+    string str = string_make(ctx, " \t\r\n\v\fword word\f\v\n\r\t ");
+    substring left = string_trim_left(str);
+    assert(left.length == 15 && strncmp(left.value, "word word", 9) == 0);
+    substring right = string_trim_right(str);
+    assert(right.value == str.value && right.length == 15);
+    substring both = string_trim(str);
+    assert(both.length == 9 && strncmp(both.value, "word word", 9) == 0);
+
+    // Trimmed views are not appended to in place
+    string appended = string_append(both, "!");
+    assert(strcmp(appended.value, "word word!") == 0);
+    assert(str.value[15] == '\f');
+
+    // Whitespace runs longer than a SIMD block, non-ASCII bytes are not whitespace
+    string padded = string_init(ctx);
+    for (int i = 0; i < 70; i++) padded = string_append(padded, " ");
+    padded = string_append(padded, "\xC2\xA0x\xA0");
+    for (int i = 0; i < 70; i++) padded = string_append(padded, "\t");
+    substring trimmed = string_trim(padded);
+    assert(trimmed.length == 4 && trimmed.value == padded.value + 70);
+
+    string blank = string_init(ctx);
+    for (int i = 0; i < 100; i++) blank = string_append(blank, " \n");
+    assert(string_trim_left(blank).length == 0);
+    assert(string_trim_right(blank).length == 0);
+
+    string null_str = {0};
+    assert(string_trim_left(null_str).length == 0);
+    assert(string_trim_right(null_str).length == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 26: Character sets
+void test_string_charset(void) {
+    MemContext *ctx = memctx();
+
+    string_charset set = string_charset_make(",;\xFF");
+    assert(set.count == 3);
+    assert(string_charset_has(&set, ','));
+    assert(string_charset_has(&set, ';'));
+    assert(string_charset_has(&set, (char)0xFF));
+    assert(!string_charset_has(&set, 'a'));
+    assert(!string_charset_has(&set, '\0'));
+
+    string str = string_make(ctx, "abcdefghijklmnopqrstuvwxyz0123456789;");
+    assert(string_charset_find(str, &set) == 36);
+    assert(string_charset_find(string_make(ctx, "abc"), &set) == STRING_NOT_FOUND);
+
+    string_charset empty = string_charset_make(NULL);
+    assert(empty.count == 0);
+    assert(string_charset_find(str, &empty) == STRING_NOT_FOUND);
+
+    // The built-in whitespace set matches isspace in the "C" locale
+    for (int c = 0; c < 256; c++) {
+        assert(string_charset_has(&__string_whitespace, (char)c) == (isspace(c) != 0));
+    }
+    string_charset whitespace = string_charset_make(" \t\n\v\f\r");
+    assert(memcmp(&whitespace.bits, &__string_whitespace.bits, sizeof(whitespace.bits)) == 0);
+    assert(memcmp(whitespace.low, __string_whitespace.low, sizeof(whitespace.low)) == 0);
+    assert(memcmp(whitespace.high, __string_whitespace.high, sizeof(whitespace.high)) == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 27: SIMD classification agrees with the bitset on random sets and input
+void test_string_charset_random(void) {
+    unsigned seed = 11;
+    char members[8];
+    char buffer[150];
+    for (int round = 0; round < 3000; round++) {
+        seed = seed * 1103515245 + 12345;
+        size_t count = 1 + (seed >> 16) % (sizeof(members) - 1);
+        for (size_t i = 0; i < count; i++) {
+            seed = seed * 1103515245 + 12345;
+            members[i] = (char)(1 + (seed >> 16) % 255);
+        }
+        members[count] = '\0';
+        string_charset set = string_charset_make(members);
+
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % sizeof(buffer);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            // Mostly members, so both polarities have matches to find
+            buffer[i] = (seed >> 28) < 12 ? members[(seed >> 16) % count] : (char)(seed >> 16);
+        }
+
+        for (int member = 0; member < 2; member++) {
+            size_t first = length, last = STRING_NOT_FOUND;
+            for (size_t i = 0; i < length; i++) {
+                if ((memchr(members, buffer[i], count) != NULL) == (bool)member) {
+                    if (first == length) first = i;
+                    last = i;
+                }
+            }
+            assert(__string_charset_find(&set, buffer, length, member) == first);
+            assert(__string_charset_find_last(&set, buffer, length, member) == last);
+        }
+    }
+}
+
+// Test 28: Tokenizing skips empty tokens
+void test_string_tokenize(void) {
+    MemContext *ctx = memctx();
+
+    string str = string_make(ctx, "  GET   /index.html\tHTTP/1.1 \r\n");
+    array *tokens = string_tokenize(str, " \t\r\n");
+    assert(tokens->length == 3);
+    const char *expected[] = {"GET", "/index.html", "HTTP/1.1"};
+    for (size_t i = 0; i < tokens->length; i++) {
+        substring *token = array_item_at(tokens, i);
+        assert(token->length == strlen(expected[i]));
+        assert(strncmp(token->value, expected[i], token->length) == 0);
+    }
+
+    string_split_iterator it = string_tokenize_iter(string_make(ctx, "a,,b,"), ",");
+    substring token;
+    assert(string_split_next(&it, &token) && token.length == 1 && token.value[0] == 'a');
+    assert(string_split_next(&it, &token) && token.length == 1 && token.value[0] == 'b');
+    assert(!string_split_next(&it, &token));
+    assert(!string_split_next(&it, &token));
+
+    assert(string_tokenize(string_make(ctx, ""), ",")->length == 0);
+    assert(string_tokenize(string_make(ctx, ",,,"), ",")->length == 0);
+    assert(string_tokenize(string_make(ctx, "abc"), ",")->length == 1);
+    assert(string_tokenize(str, NULL)->length == 0);
+
+    // Long input crosses SIMD blocks
+    string long_str = string_init(ctx);
+    for (int i = 0; i < 100; i++) {
+        long_str = string_append(long_str, "word \t\t  \n");
+    }
+    array *words = string_tokenize(long_str, " \t\n");
+    assert(words->length == 100);
+    for (size_t i = 0; i < words->length; i++) {
+        assert(((substring *)array_item_at(words, i))->length == 4);
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 29: Parsing integers
+void test_substring_to_int(void) {
+    int64_t i = 42;
+    uint64_t u = 42;
+
+    assert(substring_to_i64(string_view("0"), &i) == STRING_PARSE_OK && i == 0);
+    assert(substring_to_i64(string_view("-17"), &i) == STRING_PARSE_OK && i == -17);
+    assert(substring_to_i64(string_view("+17"), &i) == STRING_PARSE_OK && i == 17);
+    assert(substring_to_i64(string_view("9223372036854775807"), &i) == STRING_PARSE_OK && i == INT64_MAX);
+    assert(substring_to_i64(string_view("-9223372036854775808"), &i) == STRING_PARSE_OK && i == INT64_MIN);
+    assert(substring_to_i64(string_view("0000000000000000000000001234"), &i) == STRING_PARSE_OK && i == 1234);
+    assert(substring_to_u64(string_view("18446744073709551615"), &u) == STRING_PARSE_OK && u == UINT64_MAX);
+    assert(substring_to_u64(string_view("12345678"), &u) == STRING_PARSE_OK && u == 12345678);
+    assert(substring_to_u64(string_view("1234567890123456789"), &u) == STRING_PARSE_OK && u == 1234567890123456789ULL);
+
+    // Errors leave the value unchanged
+    i = 42;
+    u = 42;
+    assert(substring_to_i64(string_view("9223372036854775808"), &i) == STRING_PARSE_OVERFLOW);
+    assert(substring_to_i64(string_view("-9223372036854775809"), &i) == STRING_PARSE_OVERFLOW);
+    assert(substring_to_u64(string_view("18446744073709551616"), &u) == STRING_PARSE_OVERFLOW);
+    assert(substring_to_u64(string_view("99999999999999999999999"), &u) == STRING_PARSE_OVERFLOW);
+    assert(substring_to_i64(string_view(""), &i) == STRING_PARSE_EMPTY);
+    assert(substring_to_i64(string_view("-"), &i) == STRING_PARSE_INVALID);
+    assert(substring_to_i64(string_view(" 1"), &i) == STRING_PARSE_INVALID);
+    assert(substring_to_i64(string_view("1 "), &i) == STRING_PARSE_INVALID);
+    assert(substring_to_i64(string_view("12a45678"), &i) == STRING_PARSE_INVALID);
+    assert(substring_to_i64(string_view("1.5"), &i) == STRING_PARSE_INVALID);
+    assert(substring_to_u64(string_view("-1"), &u) == STRING_PARSE_INVALID);
+    assert(substring_to_u64(string_view("99999999999999999999x"), &u) == STRING_PARSE_INVALID);
+    assert(i == 42 && u == 42);
+
+    string null_str = {0};
+    assert(substring_to_i64(null_str, &i) == STRING_PARSE_EMPTY);
+
+    // Fields of a split line, not null-terminated
+    MemContext *ctx = memctx();
+    array *fields = string_split(string_make(ctx, "10,-20,30"), ",");
+    int64_t sum = 0;
+    for (size_t k = 0; k < fields->length; k++) {
+        assert(substring_to_i64(*(substring *)array_item_at(fields, k), &i) == STRING_PARSE_OK);
+        sum += i;
+    }
+    assert(sum == 20);
+    memctx_free(ctx);
+}
+
+// Test 30: Integer parsing agrees with strtoll and strtoull
+void test_substring_to_int_random(void) {
+    char buffer[32];
+    uint64_t seed = 3;
+    for (int round = 0; round < 100000; round++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t number = seed >> (seed & 63);
+        if (round % 3 == 0) {
+            snprintf(buffer, sizeof(buffer), "%lld", (long long)number);
+        } else {
+            snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)number);
+        }
+
+        int64_t i;
+        uint64_t u;
+        errno = 0;
+        long long expected_i = strtoll(buffer, NULL, 10);
+        bool range_i = errno == ERANGE;
+        assert(substring_to_i64(string_view(buffer), &i) == (range_i ? STRING_PARSE_OVERFLOW : STRING_PARSE_OK));
+        if (!range_i) assert(i == expected_i);
+
+        if (buffer[0] != '-') {
+            assert(substring_to_u64(string_view(buffer), &u) == STRING_PARSE_OK);
+            assert(u == strtoull(buffer, NULL, 10));
+        }
+    }
+}
+
+// Test 31: Parsing doubles
+void test_substring_to_double(void) {
+    double d = 7;
+
+    assert(substring_to_double(string_view("0"), &d) == STRING_PARSE_OK && d == 0);
+    assert(substring_to_double(string_view("-0.0"), &d) == STRING_PARSE_OK && d == 0 && signbit(d));
+    assert(substring_to_double(string_view("1.5"), &d) == STRING_PARSE_OK && d == 1.5);
+    assert(substring_to_double(string_view("-.25"), &d) == STRING_PARSE_OK && d == -0.25);
+    assert(substring_to_double(string_view("3."), &d) == STRING_PARSE_OK && d == 3);
+    assert(substring_to_double(string_view("1e3"), &d) == STRING_PARSE_OK && d == 1000);
+    assert(substring_to_double(string_view("1E+25"), &d) == STRING_PARSE_OK && d == 1e25);
+    assert(substring_to_double(string_view("2.5e-3"), &d) == STRING_PARSE_OK && d == 2.5e-3);
+    assert(substring_to_double(string_view("0.1"), &d) == STRING_PARSE_OK && d == 0.1);
+    assert(substring_to_double(string_view("0.000000000000000000000000001"), &d) == STRING_PARSE_OK && d == 1e-27);
+    assert(substring_to_double(string_view("123456789012345678901234567890"), &d) == STRING_PARSE_OK && d == 123456789012345678901234567890.0);
+    assert(substring_to_double(string_view("1.7976931348623157e308"), &d) == STRING_PARSE_OK && d == DBL_MAX);
+    assert(substring_to_double(string_view("4.9406564584124654e-324"), &d) == STRING_PARSE_OK && d > 0);
+    assert(substring_to_double(string_view("1e-400"), &d) == STRING_PARSE_OK && d == 0);
+    assert(substring_to_double(string_view("Infinity"), &d) == STRING_PARSE_OK && isinf(d) && d > 0);
+    assert(substring_to_double(string_view("-inf"), &d) == STRING_PARSE_OK && isinf(d) && d < 0);
+    assert(substring_to_double(string_view("NaN"), &d) == STRING_PARSE_OK && isnan(d));
+
+    d = 7;
+    assert(substring_to_double(string_view(""), &d) == STRING_PARSE_EMPTY);
+    assert(substring_to_double(string_view("."), &d) == STRING_PARSE_INVALID);
+    assert(substring_to_double(string_view("-"), &d) == STRING_PARSE_INVALID);
+    assert(substring_to_double(string_view("1e"), &d) == STRING_PARSE_INVALID);
+    assert(substring_to_double(string_view("1e+"), &d) == STRING_PARSE_INVALID);
+    assert(substring_to_double(string_view("1,5"), &d) == STRING_PARSE_INVALID);
+    assert(substring_to_double(string_view("0x10"), &d) == STRING_PARSE_INVALID);
+    assert(substring_to_double(string_view(" 1"), &d) == STRING_PARSE_INVALID);
+    assert(substring_to_double(string_view("infinit"), &d) == STRING_PARSE_INVALID);
+    assert(d == 7);
+
+    assert(substring_to_double(string_view("1e999"), &d) == STRING_PARSE_OVERFLOW && isinf(d));
+    assert(substring_to_double(string_view("-1.8e308"), &d) == STRING_PARSE_OVERFLOW && isinf(d) && d < 0);
+
+    // Halfway between two doubles: ties to even, any later non-zero digit rounds up
+    assert(substring_to_double(string_view("9007199254740993"), &d) == STRING_PARSE_OK && d == 9007199254740992.0);
+    assert(substring_to_double(string_view("9007199254740993.000000000000000000001"), &d) == STRING_PARSE_OK && d == 9007199254740994.0);
+    assert(substring_to_double(string_view("2.4703282292062327e-324"), &d) == STRING_PARSE_OK && d == 0);
+    assert(substring_to_double(string_view("2.4703282292062328e-324"), &d) == STRING_PARSE_OK && d == 4.9406564584124654e-324);
+    assert(substring_to_double(string_view("2.2250738585072011e-308"), &d) == STRING_PARSE_OK && d == 2.2250738585072009e-308);
+
+    // More digits than any rounding needs: the rest only count as a sticky digit
+    char digits[1200] = "0.";
+    for (int i = 2; i < 1100; i++) digits[i] = i == 2 ? '1' : '0';
+    digits[1099] = '1';
+    assert(substring_to_double(string_view(digits), &d) == STRING_PARSE_OK && d == 0.1);
+
+    // The substring length is respected
+    substring field = string_view("2.75,9");
+    field.length = 4;
+    assert(substring_to_double(field, &d) == STRING_PARSE_OK && d == 2.75);
+
+    // The decimal point is '.' even if the locale uses ','
+    if (setlocale(LC_NUMERIC, "de_DE.UTF-8") || setlocale(LC_NUMERIC, "fr_FR.UTF-8")) {
+        assert(substring_to_double(string_view("0.1000000000000000000000001"), &d) == STRING_PARSE_OK && d == 0.1);
+        assert(substring_to_double(string_view("1,5"), &d) == STRING_PARSE_INVALID);
+        setlocale(LC_NUMERIC, "C");
+    }
+}
+
+// Test 32: Double parsing agrees with strtod bit for bit
+void test_substring_to_double_random(void) {
+    // Long digit strings, which fill the 19-digit mantissa and leave a truncated rest
+    char digits[64];
+    uint64_t state = 9;
+    for (int round = 0; round < 200000; round++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t count = 17 + (state >> 59);
+        size_t length = 0;
+        for (size_t i = 0; i < count; i++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            digits[length++] = (char)('0' + (state >> 33) % 10);
+            if (i == 0) digits[length++] = '.';
+        }
+        length += (size_t)snprintf(digits + length, sizeof(digits) - length, "e%d", (int)((state >> 40) % 700) - 350);
+
+        double expected = strtod(digits, NULL);
+        double parsed;
+        string_parse_result result = substring_to_double(string_view(digits), &parsed);
+        assert(result == (isinf(expected) ? STRING_PARSE_OVERFLOW : STRING_PARSE_OK));
+        assert(memcmp(&parsed, &expected, sizeof(double)) == 0);
+    }
+
+    const char *formats[] = {"%.17g", "%.3f", "%.6e", "%.1f", "%g", "%.20e"};
+    char buffer[64];
+    uint64_t seed = 5;
+    for (int round = 0; round < 200000; round++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        double number;
+        if (round % 2) {
+            // Any finite bit pattern
+            uint64_t bits = seed;
+            memcpy(&number, &bits, sizeof(number));
+            if (!isfinite(number)) continue;
+        } else {
+            // CSV-like values: prices, counts, ratios
+            number = (double)(seed >> 40) / __string_pow10[(seed >> 8) % 8];
+        }
+        snprintf(buffer, sizeof(buffer), formats[(seed >> 4) % 6], number);
+
+        double expected = strtod(buffer, NULL);
+        double parsed;
+        string_parse_result result = substring_to_double(string_view(buffer), &parsed);
+        if (isinf(expected)) {
+            assert(result == STRING_PARSE_OVERFLOW);
+        } else {
+            assert(result == STRING_PARSE_OK);
+            assert(memcmp(&parsed, &expected, sizeof(double)) == 0);
+        }
+    }
+}
+
+// Test 33: Replacing a value
+void test_string_replace(void) {
+    MemContext *ctx = memctx();
+
+    string str = string_make(ctx, "Hello, {name}! Bye, {name}.");
+    string result = string_replace(str, "{name}", "World");
+    assert(strcmp(result.value, "Hello, World! Bye, World.") == 0);
+    assert(result.length == strlen(result.value));
+    assert(result.capacity < result.length + 1 + sizeof(uintptr_t));
+    assert(strcmp(str.value, "Hello, {name}! Bye, {name}.") == 0);
+
+    string longer = string_replace(str, "{name}", string_make(ctx, "a much longer name"));
+    assert(strcmp(longer.value, "Hello, a much longer name! Bye, a much longer name.") == 0);
+
+    assert(strcmp(string_replace(str, "{name}", "").value, "Hello, ! Bye, .") == 0);
+    assert(strcmp(string_replace(str, "missing", "x").value, str.value) == 0);
+    assert(strcmp(string_replace(str, "", "x").value, str.value) == 0);
+
+    // Non-overlapping, left to right
+    assert(strcmp(string_replace(string_make(ctx, "aaaaa"), "aa", "b").value, "bba") == 0);
+
+    // The result is a new string, never the source
+    string copy = string_replace(str, "missing", "x");
+    assert(copy.value != str.value);
+
+    // Many matches in a long string
+    string long_str = string_init(ctx);
+    for (int i = 0; i < 1000; i++) {
+        long_str = string_append(long_str, "a\r\n");
+    }
+    string unix_str = string_replace(long_str, "\r\n", "\n");
+    assert(unix_str.length == 2000);
+    assert(!string_contains(unix_str, "\r"));
+
+    string null_str = {0};
+    assert(string_replace(null_str, "a", "b").value == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 34: Replacing several values in one scan
+void test_string_replace_many(void) {
+    MemContext *ctx = memctx();
+
+    substring from[] = {string_view("&"), string_view("<"), string_view(">"), string_view("\"")};
+    substring to[] = {string_view("&amp;"), string_view("&lt;"), string_view("&gt;"), string_view("&quot;")};
+    string html = string_replace_many(string_make(ctx, "<a href=\"x\">Tom & Jerry</a>"), from, to, 4);
+    assert(strcmp(html.value, "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&lt;/a&gt;") == 0);
+
+    // Replacements are not scanned again: swapping works
+    substring swap_from[] = {string_view("a"), string_view("b")};
+    substring swap_to[] = {string_view("b"), string_view("a")};
+    assert(strcmp(string_replace_many(string_make(ctx, "abba"), swap_from, swap_to, 2).value, "baab") == 0);
+
+    // The longest pattern at a position wins
+    substring prefix_from[] = {string_view("a"), string_view("abc")};
+    substring prefix_to[] = {string_view("1"), string_view("3")};
+    assert(strcmp(string_replace_many(string_make(ctx, "abcab"), prefix_from, prefix_to, 2).value, "31b") == 0);
+
+    // Empty patterns are ignored, no patterns give a copy
+    substring empty_from[] = {string_view(""), string_view("x")};
+    substring empty_to[] = {string_view("?"), string_view("y")};
+    assert(strcmp(string_replace_many(string_make(ctx, "xox"), empty_from, empty_to, 2).value, "yoy") == 0);
+    assert(strcmp(string_replace_many(string_make(ctx, "xox"), NULL, NULL, 0).value, "xox") == 0);
+
+    // Patterns may contain '\0' when built as substrings
+    string binary = string_make(ctx, "a b");
+    binary.value[1] = '\0';
+    substring zero_from[] = {{(char *)"\0", 1, 1, NULL}};
+    substring zero_to[] = {string_view("\\0")};
+    string escaped = string_replace_many(binary, zero_from, zero_to, 1);
+    assert(escaped.length == 4 && memcmp(escaped.value, "a\\0b", 4) == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 35: Replacement agrees with a naive reference on random input
+void test_string_replace_random(void) {
+    MemContext *ctx = memctx();
+
+    unsigned seed = 13;
+    char text[300];
+    char result[4000];
+    char patterns[3][4];
+    char replacements[3][6];
+    for (int round = 0; round < 2000; round++) {
+        // Small alphabet, so patterns occur often
+        seed = seed * 1103515245 + 12345;
+        size_t length = (seed >> 16) % sizeof(text);
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            text[i] = (char)('a' + (seed >> 16) % 3);
+        }
+        substring from[3], to[3];
+        for (int k = 0; k < 3; k++) {
+            seed = seed * 1103515245 + 12345;
+            size_t pattern_length = 1 + (seed >> 16) % 3;
+            size_t replacement_length = (seed >> 20) % 6;
+            for (size_t i = 0; i < pattern_length; i++) patterns[k][i] = (char)('a' + (seed >> (i * 2 + 4)) % 3);
+            for (size_t i = 0; i < replacement_length; i++) replacements[k][i] = (char)('0' + k);
+            from[k] = (substring){patterns[k], pattern_length, pattern_length, NULL};
+            to[k] = (substring){replacements[k], replacement_length, replacement_length, NULL};
+        }
+        substring str = {text, length, length, ctx};
+
+        // Naive reference: at each position try the longest matching pattern
+        size_t out = 0;
+        for (size_t i = 0; i < length;) {
+            int best = -1;
+            for (int k = 0; k < 3; k++) {
+                if (from[k].length <= length - i && memcmp(text + i, from[k].value, from[k].length) == 0 &&
+                    (best < 0 || from[k].length > from[best].length)) best = k;
+            }
+            if (best < 0) {
+                result[out++] = text[i++];
+            } else {
+                memcpy(result + out, to[best].value, to[best].length);
+                out += to[best].length;
+                i += from[best].length;
+            }
+        }
+        string replaced = string_replace_many(str, from, to, 3);
+        assert(replaced.length == out && memcmp(replaced.value, result, out) == 0);
+
+        // A single pattern takes the search path
+        out = 0;
+        for (size_t i = 0; i < length;) {
+            if (from[0].length <= length - i && memcmp(text + i, from[0].value, from[0].length) == 0) {
+                memcpy(result + out, to[0].value, to[0].length);
+                out += to[0].length;
+                i += from[0].length;
+            } else {
+                result[out++] = text[i++];
+            }
+        }
+        replaced = string_replace(str, from[0], to[0]);
+        assert(replaced.length == out && memcmp(replaced.value, result, out) == 0);
+    }
+
+    memctx_free(ctx);
+}
+
+// Test 36: Joining an array of strings
+void test_string_join(void) {
+    MemContext *ctx = memctx();
+
+    array *fields = string_split(string_make(ctx, "a,bb,,ccc"), ",");
+    string joined = string_join(ctx, fields, " | ");
+    assert(strcmp(joined.value, "a | bb |  | ccc") == 0);
+    assert(joined.length == 15);
+    assert(joined.capacity < joined.length + 1 + sizeof(uintptr_t));
+
+    // Split and join round trip
+    string sep = string_make(ctx, ",");
+    assert(strcmp(string_join(ctx, fields, sep).value, "a,bb,,ccc") == 0);
+    assert(strcmp(string_join(ctx, fields, "").value, "abbccc") == 0);
+
+    // Strings owned by the caller
+    array *words = array_init(ctx);
+    string hello = string_make(ctx, "hello");
+    string world = string_make(ctx, "world");
+    array_append(words, &hello);
+    array_append(words, &world);
+    assert(strcmp(string_join(ctx, words, " ").value, "hello world") == 0);
+
+    // One item has no separator, no items give an empty string
+    array *single = array_init(ctx);
+    array_append(single, &hello);
+    assert(strcmp(string_join(ctx, single, ", ").value, "hello") == 0);
+    string empty = string_join(ctx, array_init(ctx), ", ");
+    assert(empty.value != NULL && empty.length == 0 && empty.value[0] == '\0');
+
+    // Many items
+    array *many = array_init(ctx);
+    for (int i = 0; i < 1000; i++) array_append(many, &hello);
+    string long_str = string_join(ctx, many, "-");
+    assert(long_str.length == 1000 * 5 + 999);
+    assert(strncmp(long_str.value + 5993, "-hello", 6) == 0);
+
+    assert(string_join(ctx, (array *)NULL, ",").value == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 37: Concatenating a fixed list of strings
+void test_string_concat(void) {
+    MemContext *ctx = memctx();
+
+    string name = string_make(ctx, "World");
+    string greeting = string_concat(ctx, string_view("Hello, "), name, string_view("!"));
+    assert(strcmp(greeting.value, "Hello, World!") == 0);
+    assert(greeting.length == 13);
+    assert(greeting.ctx == ctx);
+
+    // The result is a regular string
+    greeting = string_append(greeting, " Bye.");
+    assert(strcmp(greeting.value, "Hello, World! Bye.") == 0);
+
+    string single = string_concat(ctx, name);
+    assert(strcmp(single.value, "World") == 0 && single.value != name.value);
+
+    string null_str = {0};
+    assert(strcmp(string_concat(ctx, name, null_str, name).value, "WorldWorld") == 0);
+
+    memctx_free(ctx);
+}
+
+static void* __sort_strings_thread(void *arr) {
+    return array_sort_strings((array *)arr) ? arr : NULL;
+}
+
+static int compare_strings(const void *a, const void *b) {
+    const string *x = *(const string *const *)a;
+    const string *y = *(const string *const *)b;
+    size_t length = x->length < y->length ? x->length : y->length;
+    int order = length > 0 ? memcmp(x->value, y->value, length) : 0;
+    if (order != 0) return order;
+    return (x->length > y->length) - (x->length < y->length);
+}
+
+// Test 38: Sorting an array of strings
+void test_array_sort_strings(void) {
+    MemContext *ctx = memctx();
+
+    const char *words[] = {"pear", "apple", "", "apples", "app", "banana", "apple", "\xff", "Zebra"};
+    size_t word_count = sizeof(words) / sizeof(words[0]);
+    array *arr = array_init(ctx);
+    for (size_t i = 0; i < word_count; i++) {
+        string *str = memctx_alloc(ctx, sizeof(string));
+        *str = string_make(ctx, words[i]);
+        array_append(arr, str);
+    }
+    array_append(arr, NULL);
+    assert(array_sort_strings(arr));
+
+    const char *expected[] = {NULL, "", "Zebra", "app", "apple", "apple", "apples", "banana", "pear", "\xff"};
+    assert(arr->length == 10);
+    assert(arr->items[0] == NULL);
+    for (size_t i = 1; i < arr->length; i++) {
+        assert(strcmp(((string *)arr->items[i])->value, expected[i]) == 0);
+    }
+
+    // Embedded zero bytes: a string sorts before its extensions, even with trailing zeros
+    substring zeros[] = {
+        {"ab\0\0\0\0\0\0\0\0x", 11, 11, ctx}, {"ab\0", 3, 3, ctx}, {"ab", 2, 2, ctx},
+        {"ab\0\0\0\0\0\0\0\0", 10, 10, ctx}, {"ab\0\0\0\0\0\0", 8, 8, ctx}
+    };
+    array *binary = array_init(ctx);
+    for (size_t i = 0; i < 5; i++) array_append(binary, &zeros[i]);
+    for (int round = 0; round < 6; round++) array_append(binary, &zeros[round % 5]);
+    assert(array_sort_strings(binary));
+    for (size_t i = 1; i < binary->length; i++) {
+        assert(compare_strings(&binary->items[i - 1], &binary->items[i]) <= 0);
+    }
+    assert(((string *)binary->items[0])->length == 2);
+
+    // Random keys with long shared prefixes, compared with qsort
+    enum { COUNT = 20000 };
+    static string keys[COUNT];
+    static char buffer[COUNT][40];
+    array *random_keys = array_init(ctx);
+    array *reference = array_init(ctx);
+    unsigned seed = 21;
+    for (size_t i = 0; i < COUNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned kind = (seed >> 16) % 3;
+        size_t length;
+        if (kind == 0) {
+            length = (size_t)snprintf(buffer[i], sizeof(buffer[i]), "user-%u", (seed >> 8) % 5000);
+        } else if (kind == 1) {
+            length = (size_t)snprintf(buffer[i], sizeof(buffer[i]), "/var/log/service/%u.log", (seed >> 8) % 300);
+        } else {
+            length = (seed >> 10) % 20;
+            for (size_t k = 0; k < length; k++) {
+                seed = seed * 1103515245 + 12345;
+                buffer[i][k] = "ab\0"[(seed >> 16) % 3];
+            }
+        }
+        keys[i].value = buffer[i];
+        keys[i].length = length;
+        keys[i].capacity = length;
+        keys[i].ctx = ctx;
+        array_append(random_keys, &keys[i]);
+        array_append(reference, &keys[i]);
+    }
+
+    assert(array_sort_strings(random_keys));
+    qsort(reference->items, reference->length, sizeof(void *), compare_strings);
+    for (size_t i = 0; i < COUNT; i++) {
+        assert(compare_strings(&random_keys->items[i], &reference->items[i]) == 0);
+    }
+
+    // Already sorted and all-equal input
+    assert(array_sort_strings(random_keys));
+    for (size_t i = 0; i < COUNT; i++) {
+        assert(compare_strings(&random_keys->items[i], &reference->items[i]) == 0);
+    }
+    array *same = array_init(ctx);
+    for (size_t i = 0; i < 1000; i++) array_append(same, &keys[0]);
+    assert(array_sort_strings(same));
+
+    // Organ-pipe keys make the median of three pick poor pivots; on a small stack
+    // the recursion must stay logarithmic
+    enum { PIPE = 200000 };
+    static string pipe_keys[PIPE];
+    static unsigned char pipe_buffer[PIPE][8];
+    array *organ = array_init(ctx);
+    for (size_t i = 0; i < PIPE; i++) {
+        uint64_t value = i < PIPE / 2 ? i : PIPE - i;
+        for (int k = 0; k < 8; k++) pipe_buffer[i][k] = (unsigned char)(value >> (56 - 8 * k));
+        pipe_keys[i].value = (char *)pipe_buffer[i];
+        pipe_keys[i].length = 8;
+        pipe_keys[i].capacity = 8;
+        pipe_keys[i].ctx = ctx;
+        array_append(organ, &pipe_keys[i]);
+    }
+    pthread_attr_t attr;
+    pthread_t thread;
+    assert(pthread_attr_init(&attr) == 0);
+    assert(pthread_attr_setstacksize(&attr, 128 * 1024) == 0);
+    assert(pthread_create(&thread, &attr, __sort_strings_thread, organ) == 0);
+    void *sorted = NULL;
+    assert(pthread_join(thread, &sorted) == 0 && sorted == organ);
+    pthread_attr_destroy(&attr);
+    for (size_t i = 1; i < PIPE; i++) {
+        assert(compare_strings(&organ->items[i - 1], &organ->items[i]) <= 0);
+    }
+
+    assert(array_sort_strings(array_init(ctx)));
+    assert(!array_sort_strings(NULL));
+
+    memctx_free(ctx);
+}
+
+// Test 39: Length-aware append and literal views
+void test_string_append_n(void) {
+    MemContext *ctx = memctx();
+
+    substring hello = STR("Hello");
+    assert(hello.length == 5);
+    assert(hello.ctx == NULL);
+    assert(memcmp(hello.value, "Hello", 6) == 0);
+    assert(STR("").length == 0);
+
+    // Literals with embedded zeros keep their full length
+    substring binary = STR("a\0b");
+    assert(binary.length == 3);
+    assert(string_make(ctx, binary).length == 3);
+
+    string str = string_make(ctx, STR("Hello"));
+    assert(str.ctx == ctx);
+    assert(str.value != hello.value);
+    str = string_append(str, STR(", "));
+    str = string_append_n(str, "World!!!", 6);
+    assert(str.length == 13);
+    assert(strcmp(str.value, "Hello, World!") == 0);
+
+    // Appending a view that is not null-terminated at its length
+    string source = string_make(ctx, "abcdef");
+    substring middle = { source.value + 1, 3, 3, ctx };
+    string target = string_make(ctx, "x");
+    target = string_append(target, middle);
+    assert(strcmp(target.value, "xbcd") == 0);
+    assert(strcmp(source.value, "abcdef") == 0);
+    assert(strcmp(string_make(ctx, middle).value, "bcd") == 0);
+
+    // Appending in place and growing past the capacity
+    string grow = string_init(ctx);
+    for (int i = 0; i < 100; i++) {
+        grow = string_append_n(grow, "0123456789", (size_t)(i % 10) + 1);
+    }
+    assert(grow.length == 550);
+    assert(grow.value[grow.length] == '\0');
+    assert(memcmp(grow.value, "0010120123", 10) == 0);
+
+    // Views have no context, so they cannot be appended to
+    substring view = STR("view");
+    view = string_append(view, "!");
+    assert(view.length == 4);
+
+    assert(string_append_n(str, NULL, 3).length == 13);
+    assert(string_append_n(str, "abc", 0).length == 13);
+    assert(string_make(ctx, (const char *)NULL).length == 0);
+    assert(string_make(ctx, (substring){0}).length == 0);
+
+    memctx_free(ctx);
+}
+
+// Test 40: Base64 encoding and decoding
+void test_string_base64(void) {
+    MemContext *ctx = memctx();
+
+    // RFC 4648 test vectors
+    const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char *encoded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    for (int i = 0; i < 7; i++) {
+        string e = string_base64_encode(ctx, string_make(ctx, plain[i]));
+        assert(e.value != NULL);
+        assert(e.length == strlen(encoded[i]));
+        assert(strcmp(e.value, encoded[i]) == 0);
+
+        string d = string_base64_decode(ctx, string_make(ctx, encoded[i]));
+        assert(d.value != NULL);
+        assert(strcmp(d.value, plain[i]) == 0);
+    }
+
+    // Padding is optional
+    assert(strcmp(string_base64_decode(ctx, string_make(ctx, "Zm9vYg")).value, "foob") == 0);
+    assert(strcmp(string_base64_decode(ctx, string_make(ctx, "Zm9vYmE")).value, "fooba") == 0);
+
+    // Both special characters, across a block boundary
+    string special = string_base64_decode(ctx, string_make(ctx, "+/+/+/+/+/+/+/+/+/+/+/+/+/+/+/+/+/+/+/+/"));
+    assert(special.length == 30);
+    for (size_t i = 0; i < special.length; i += 3) {
+        assert(memcmp(special.value + i, "\xfb\xff\xbf", 3) == 0);
+    }
+
+    const char *invalid[] = {"Z", "Zm9vY", "Zg=", "Zg===", "=Zg=", "Zm9v\nYmFy", "Zm 9v", "Zm9v-_==",
+                             "Zm9vYmFyZm9vYmFyZm9vYmFyZm9vYmF*Zm9vYmFy", "Zm9vYmFyZm9vYmFy====", "===="};
+    for (int i = 0; i < 11; i++) {
+        assert(string_base64_decode(ctx, string_make(ctx, invalid[i])).value == NULL);
+    }
+
+    // Binary data with zero bytes
+    substring binary = {"\0\x01\x02\xff", 4, 4, NULL};
+    string e = string_base64_encode(ctx, binary);
+    assert(strcmp(e.value, "AAEC/w==") == 0);
+    string d = string_base64_decode(ctx, e);
+    assert(d.length == 4);
+    assert(memcmp(d.value, binary.value, 4) == 0);
+
+    assert(string_base64_encode(ctx, (string){0}).value == NULL);
+    assert(string_base64_decode(ctx, (string){0}).value == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 41: Hex encoding and decoding
+void test_string_hex(void) {
+    MemContext *ctx = memctx();
+
+    substring bytes = {"\x00\x01\x7f\x80\xab\xff", 6, 6, NULL};
+    string e = string_hex_encode(ctx, bytes);
+    assert(e.length == 12);
+    assert(strcmp(e.value, "00017f80abff") == 0);
+
+    string d = string_hex_decode(ctx, e);
+    assert(d.length == 6);
+    assert(memcmp(d.value, bytes.value, 6) == 0);
+
+    // Uppercase and mixed case, long enough for the SIMD kernels
+    string upper = string_hex_decode(ctx, string_make(ctx, "DEADBEEFdeadbeefDeAdBeEf0123456789ABCDEFabcdef0123456789"));
+    assert(upper.length == 28);
+    assert(memcmp(upper.value, "\xde\xad\xbe\xef\xde\xad\xbe\xef\xde\xad\xbe\xef\x01\x23", 14) == 0);
+
+    string empty = string_hex_decode(ctx, string_make(ctx, ""));
+    assert(empty.value != NULL);
+    assert(empty.length == 0);
+
+    const char *invalid[] = {"a", "abc", "0g", "g0", "0x", " 0", "0123456789abcdef0123456789abcdeg",
+                             "0123456789abcdef0123456789abcde\xb0", "0123456789abcdef0123456789abcde:"};
+    for (int i = 0; i < 9; i++) {
+        assert(string_hex_decode(ctx, string_make(ctx, invalid[i])).value == NULL);
+    }
+
+    assert(string_hex_encode(ctx, (string){0}).value == NULL);
+    assert(string_hex_decode(ctx, (string){0}).value == NULL);
+
+    memctx_free(ctx);
+}
+
+// Test 42: Encoding random data of every length around the SIMD block sizes
+void test_string_encoding_random(void) {
+    MemContext *ctx = memctx();
+
+    const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    unsigned seed = 17;
+    unsigned char data[200];
+    char expected[300];
+    for (size_t length = 0; length < sizeof(data); length++) {
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            data[i] = (unsigned char)(seed >> 16);
+        }
+        substring bytes = {(char *)data, length, length, NULL};
+
+        // Reference base64 encoding, bit by bit
+        size_t out = 0;
+        for (size_t bit = 0; bit < length * 8; bit += 6) {
+            unsigned value = 0;
+            for (size_t k = 0; k < 6; k++) {
+                size_t b = bit + k;
+                unsigned set = b < length * 8 ? (data[b / 8] >> (7 - b % 8)) & 1 : 0;
+                value = value << 1 | set;
+            }
+            expected[out++] = alphabet[value];
+        }
+        while (out % 4) expected[out++] = '=';
+
+        string e = string_base64_encode(ctx, bytes);
+        assert(e.length == out);
+        assert(memcmp(e.value, expected, out) == 0);
+        assert(e.value[out] == '\0');
+
+        string d = string_base64_decode(ctx, e);
+        assert(d.length == length);
+        assert(memcmp(d.value, data, length) == 0);
+
+        // A bad character anywhere is rejected
+        if (length >= 3) {
+            seed = seed * 1103515245 + 12345;
+            e.value[(seed >> 16) % (length / 3 * 4)] = '.';
+            assert(string_base64_decode(ctx, e).value == NULL);
+        }
+
+        string h = string_hex_encode(ctx, bytes);
+        assert(h.length == length * 2);
+        for (size_t i = 0; i < length; i++) {
+            assert(h.value[2 * i] == "0123456789abcdef"[data[i] >> 4]);
+            assert(h.value[2 * i + 1] == "0123456789abcdef"[data[i] & 15]);
+        }
+
+        string_to_upper_in_place(h);
+        d = string_hex_decode(ctx, h);
+        assert(d.length == length);
+        assert(memcmp(d.value, data, length) == 0);
+
+        if (length > 0) {
+            seed = seed * 1103515245 + 12345;
+            h.value[(seed >> 16) % h.length] = 'x';
+            assert(string_hex_decode(ctx, h).value == NULL);
+        }
+    }
+
+    memctx_free(ctx);
+}